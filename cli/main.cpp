@@ -188,6 +188,7 @@ void printUsage(const char* program) {
     std::cout << C(Green) << "    export" << C(Reset) << "      Export trace to Perfetto or other formats\n";
     std::cout << C(Green) << "    analyze" << C(Reset) << "     Analyze trace for performance insights\n";
     std::cout << C(Green) << "    replay" << C(Reset) << "      Replay a captured trace\n";
+    std::cout << C(Green) << "    diff" << C(Reset) << "        Compare the operation order of two trace files\n";
     std::cout << C(Green) << "    benchmark" << C(Reset) << "   Run 10K GPU call stacks benchmark\n";
     std::cout << C(Green) << "    devices" << C(Reset) << "     List available GPU devices\n";
     std::cout << C(Green) << "    version" << C(Reset) << "     Show version information\n";
@@ -337,6 +338,8 @@ void printAnalyzeUsage(const char* program) {
     std::cout << "    --kernels                Show kernel performance analysis\n";
     std::cout << "    --streams                Show stream activity analysis\n";
     std::cout << "    --hotspots               Identify performance hotspots\n";
+    std::cout << "    --critical-path          Critical path, slack and what-if speedups\n";
+    std::cout << "    --speedup <FACTOR>       Speedup used for what-if analysis (default: 2.0)\n";
     std::cout << "    --all                    Run all analyses (default)\n";
     std::cout << "    -o, --output <FILE>      Save report to file\n";
     std::cout << "    -h, --help               Show this help message\n";
@@ -348,9 +351,18 @@ void printReplayUsage(const char* program) {
     std::cout << "    " << program << " replay [OPTIONS] <FILE>\n\n";
     
     std::cout << C(Bold) << "OPTIONS:" << C(Reset) << "\n";
-    std::cout << "    --mode <MODE>            Replay mode: full, partial, dry-run (default: dry-run)\n";
-    std::cout << "    --speed <FACTOR>         Replay speed factor (default: 1.0)\n";
+    std::cout << "    --mode <MODE>            Replay mode: full, partial, dry-run, simulate (default: dry-run)\n";
+    std::cout << "    --policy <POLICY>        Scheduling: round-robin, priority, timing (default: round-robin)\n";
+    std::cout << "    --speed <FACTOR>         Replay speed factor for timing policy (default: 1.0)\n";
+    std::cout << "    --priority <ID=N>        Stream priority for priority policy (repeatable)\n";
     std::cout << "    --stream <ID>            Replay only specific stream\n";
+    std::cout << "    --parallel               One worker thread per (device, stream)\n";
+    std::cout << "    --streaming              Replay from the file in windows without loading it\n";
+    std::cout << "    --window <N>             Streaming: events per window (default: 65536)\n";
+    std::cout << "    --scale <NAME=F>         Simulate: scale durations of ops named NAME (repeatable)\n";
+    std::cout << "    --compute-slots <N>      Simulate: concurrent kernels per device\n";
+    std::cout << "    --copy-engines <N>       Simulate: concurrent copies per device\n";
+    std::cout << "    --timeline <FILE>        Simulate: export predicted timeline (Perfetto JSON)\n";
     std::cout << "    --validate               Validate determinism\n";
     std::cout << "    -v, --verbose            Verbose output\n";
     std::cout << "    -h, --help               Show this help message\n";
@@ -1874,6 +1886,29 @@ int cmdInfo(int argc, char* argv[]) {
     return 0;
 }
 
+// =============================================================================
+// Command: diff - Compare Operation Order of Two Traces
+// =============================================================================
+int cmdDiff(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " diff <original> <replayed>\n";
+        return 1;
+    }
+    
+    std::string original_file = argv[2];
+    std::string replayed_file = argv[3];
+    
+    DeterminismDiff diff;
+    std::string error;
+    if (!DeterminismChecker::compareFiles(original_file, replayed_file, diff, &error)) {
+        printError(error);
+        return 1;
+    }
+    
+    std::cout << diff.summary();
+    return diff.identical() ? 0 : 2;
+}
+
 // =============================================================================
 // Command: export - Export Trace
 // =============================================================================
@@ -1989,6 +2024,8 @@ int cmdExport(int argc, char* argv[]) {
 // =============================================================================
 int cmdAnalyze(int argc, char* argv[]) {
     std::string input_file;
+    bool critical_path = false;
+    double speedup = 2.0;
     
     for (int i = 2; i < argc; ++i) {
         std::string arg = argv[i];
@@ -1996,6 +2033,10 @@ int cmdAnalyze(int argc, char* argv[]) {
         if (arg == "-h" || arg == "--help") {
             printAnalyzeUsage(argv[0]);
             return 0;
+        } else if (arg == "--critical-path") {
+            critical_path = true;
+        } else if (arg == "--speedup" && i + 1 < argc) {
+            speedup = std::stod(argv[++i]);
         } else if (arg[0] != '-') {
             input_file = arg;
         }
@@ -2070,6 +2111,48 @@ int cmdAnalyze(int argc, char* argv[]) {
         }
     }
     
+    // Critical path analysis over the dependency DAG
+    if (critical_path) {
+        InstructionStreamBuilder graph;
+        graph.addEvents(record.events());
+        graph.analyze();
+        
+        CriticalPathAnalyzer analyzer(graph);
+        auto cp = analyzer.analyze();
+        
+        std::cout << "\n" << C(Bold) << "Critical Path:" << C(Reset) << "\n";
+        std::cout << "  End-to-end:     " << formatTimeDuration(cp.makespan) << "\n";
+        std::cout << "  Operations:     " << cp.path.size() << " of " << graph.nodeCount() << "\n";
+        std::cout << "  Busy time:      " << formatTimeDuration(cp.path_busy_time) << "\n";
+        std::cout << "  Gap time:       " << formatTimeDuration(cp.path_gap_time) << "\n";
+        
+        size_t zero_slack = std::count(cp.slack.begin(), cp.slack.end(), Timestamp(0));
+        std::cout << "  Zero-slack ops: " << zero_slack << "\n";
+        if (cp.unreachable_nodes > 0) {
+            printWarning(std::to_string(cp.unreachable_nodes) + " operations are in a dependency cycle");
+        }
+        
+        auto ranked = analyzer.rankSpeedups(speedup, 10);
+        if (!ranked.empty()) {
+            std::cout << "\n" << C(Bold) << "What-if (" << std::setprecision(1) << speedup
+                      << "x faster):" << C(Reset) << "\n";
+            std::cout << "  " << std::left << std::setw(35) << "Operation"
+                      << std::setw(10) << "Count"
+                      << std::setw(15) << "Saves"
+                      << "End-to-end\n";
+            std::cout << "  " << std::string(70, '-') << "\n";
+            
+            for (const auto& what_if : ranked) {
+                std::string short_name = what_if.name.length() > 32 ?
+                    what_if.name.substr(0, 32) + "..." : what_if.name;
+                std::cout << "  " << std::left << std::setw(35) << short_name
+                          << std::setw(10) << what_if.affected_operations
+                          << std::setw(15) << formatTimeDuration(what_if.reduction())
+                          << "-" << std::setprecision(1) << what_if.reductionPercent() << "%\n";
+            }
+        }
+    }
+    
     std::cout << "\n";
     printSuccess("Analysis complete");
     
@@ -2082,7 +2165,20 @@ int cmdAnalyze(int argc, char* argv[]) {
 int cmdReplay(int argc, char* argv[]) {
     std::string input_file;
     std::string mode = "dry-run";
+    std::string policy = "round-robin";
+    double speed = 1.0;
+    std::map<uint32_t, int> priorities;
+    std::optional<uint32_t> stream;
     bool validate = false;
+    bool verbose = false;
+    bool parallel = false;
+    bool streaming = false;
+    size_t window = 65536;
+    auto cost_model = std::make_shared<ScaledCostModel>();
+    bool has_scales = false;
+    uint32_t compute_slots = 0;
+    uint32_t copy_engines = 0;
+    std::string timeline_file;
     
     for (int i = 2; i < argc; ++i) {
         std::string arg = argv[i];
@@ -2092,6 +2188,43 @@ int cmdReplay(int argc, char* argv[]) {
             return 0;
         } else if (arg == "--mode" && i + 1 < argc) {
             mode = argv[++i];
+        } else if (arg == "--policy" && i + 1 < argc) {
+            policy = argv[++i];
+        } else if (arg == "--speed" && i + 1 < argc) {
+            speed = std::stod(argv[++i]);
+        } else if (arg == "--priority" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            auto eq = spec.find('=');
+            if (eq == std::string::npos) {
+                printError("Invalid --priority value (expected ID=N): " + spec);
+                return 1;
+            }
+            priorities[static_cast<uint32_t>(std::stoul(spec.substr(0, eq)))] = std::stoi(spec.substr(eq + 1));
+        } else if (arg == "--stream" && i + 1 < argc) {
+            stream = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--parallel") {
+            parallel = true;
+        } else if (arg == "--streaming") {
+            streaming = true;
+        } else if (arg == "--window" && i + 1 < argc) {
+            window = std::stoul(argv[++i]);
+        } else if (arg == "--scale" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            auto eq = spec.rfind('=');
+            if (eq == std::string::npos) {
+                printError("Invalid --scale value (expected NAME=F): " + spec);
+                return 1;
+            }
+            cost_model->setNameScale(spec.substr(0, eq), std::stod(spec.substr(eq + 1)));
+            has_scales = true;
+        } else if (arg == "--compute-slots" && i + 1 < argc) {
+            compute_slots = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--copy-engines" && i + 1 < argc) {
+            copy_engines = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--timeline" && i + 1 < argc) {
+            timeline_file = argv[++i];
+        } else if (arg == "-v" || arg == "--verbose") {
+            verbose = true;
         } else if (arg == "--validate") {
             validate = true;
         } else if (arg[0] != '-') {
@@ -2108,7 +2241,8 @@ int cmdReplay(int argc, char* argv[]) {
     printSection("Replay Trace");
     
     std::cout << "File: " << C(Cyan) << input_file << C(Reset) << "\n";
-    std::cout << "Mode: " << mode << "\n\n";
+    std::cout << "Mode: " << mode << "\n";
+    std::cout << "Policy: " << policy << "\n\n";
     
     // Read trace
     SBTReader reader(input_file);
@@ -2117,10 +2251,7 @@ int cmdReplay(int argc, char* argv[]) {
         return 1;
     }
     
-    TraceRecord record;
-    reader.readAll(record);
-    
-    printInfo("Loaded " + std::to_string(record.size()) + " events");
+    printInfo("Trace has " + std::to_string(reader.eventCount()) + " events");
     
     // Create replay engine
     ReplayEngine engine;
@@ -2132,16 +2263,46 @@ int cmdReplay(int argc, char* argv[]) {
         config.mode = ReplayMode::Full;
     } else if (mode == "partial") {
         config.mode = ReplayMode::Partial;
+    } else if (mode == "simulate") {
+        config.mode = ReplayMode::Simulate;
+    }
+    if (stream) {
+        config.mode = ReplayMode::StreamSpecific;
+        config.stream_id = stream;
+    }
+    
+    if (policy == "round-robin") {
+        config.scheduling = SchedulingPolicy::RoundRobin;
+    } else if (policy == "priority") {
+        config.scheduling = SchedulingPolicy::Priority;
+    } else if (policy == "timing") {
+        config.scheduling = SchedulingPolicy::OriginalTiming;
+    } else {
+        printError("Unknown scheduling policy: " + policy);
+        return 1;
     }
+    config.time_scale = speed;
+    config.stream_priorities = priorities;
     config.validate_dependencies = validate;
+    config.verbose = verbose;
+    config.parallel_streams = parallel;
+    config.streaming_window = window;
+    config.simulation.compute_slots = compute_slots;
+    config.simulation.copy_engines = copy_engines;
+    if (has_scales) {
+        config.simulation.cost_model = cost_model;
+    }
     
-    if (!engine.loadTrace(input_file)) {
+    if (!streaming && !engine.loadTrace(input_file)) {
         printError("Failed to load trace for replay");
         return 1;
     }
     
     std::cout << "Replaying...\n";
-    auto result = engine.replay(config);
+    auto result = streaming ? engine.replayStreaming(input_file, config) : engine.replay(config);
+    for (const auto& warning : result.warnings) {
+        printWarning(warning);
+    }
     
     std::cout << "\n" << C(Bold) << "Replay Results:" << C(Reset) << "\n";
     std::cout << "  Success:      " << (result.success ? C(Green) : C(Red)) 
@@ -2150,6 +2311,33 @@ int cmdReplay(int argc, char* argv[]) {
               << result.operations_total << "\n";
     std::cout << "  Deterministic: " << (result.deterministic ? "Yes" : "No") << "\n";
     std::cout << "  Duration:     " << formatTimeDuration(result.replay_duration) << "\n";
+    if (result.worker_threads > 0) {
+        std::cout << "  Workers:      " << result.worker_threads << "\n";
+    }
+    if (result.windows > 0) {
+        std::cout << "  Windows:      " << result.windows << "\n";
+    }
+    std::cout << "  Overlap:      " << std::fixed << std::setprecision(1)
+              << result.achieved_overlap * 100.0 << "% achieved / "
+              << result.original_overlap * 100.0 << "% original\n";
+    if (config.mode == ReplayMode::Simulate) {
+        std::cout << "  Captured:     " << formatTimeDuration(result.captured_makespan) << "\n";
+        std::cout << "  Predicted:    " << formatTimeDuration(result.simulated_makespan) << "\n";
+        
+        if (!timeline_file.empty()) {
+            PerfettoExporter exporter;
+            if (exporter.exportToFile(engine.getSimulatedTimeline(), timeline_file)) {
+                printSuccess("Predicted timeline exported to " + timeline_file);
+            } else {
+                printError("Failed to export predicted timeline");
+            }
+        }
+    }
+    if (result.dispatch_jitter.samples > 0) {
+        std::cout << "  Jitter:       mean " << formatTimeDuration(result.dispatch_jitter.mean)
+                  << ", p99 " << formatTimeDuration(result.dispatch_jitter.p99)
+                  << ", max " << formatTimeDuration(result.dispatch_jitter.max) << "\n";
+    }
     
     if (result.success) {
         printSuccess("Replay completed");
@@ -2510,6 +2698,8 @@ int main(int argc, char* argv[]) {
         return cmdAnalyze(argc, argv);
     } else if (command == "replay") {
         return cmdReplay(argc, argv);
+    } else if (command == "diff") {
+        return cmdDiff(argc, argv);
     } else if (command == "benchmark") {
         return cmdBenchmark(argc, argv);
     } else if (command == "devices") {
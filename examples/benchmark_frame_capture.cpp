@@ -0,0 +1,109 @@
+/**
+ * TraceSmith Benchmark: Frame Capture Resource Snapshots
+ * 
+ * Captures frames with many draw calls over a set of buffers with
+ * buffer contents capture enabled. Each draw call rewrites a few buffers
+ * (whole-buffer uploads that differ in one byte); the rest stay unchanged.
+ * Reports time per draw call, the number of resource versions, bytes
+ * stored by the deduplicating chunk store and its ingest cost per MB,
+ * versus the bytes a full per-draw snapshot would hold.
+ * 
+ * Usage: benchmark_frame_capture [draws] [buffers] [buffer_kb] [updates_per_draw] [frames]
+ */
+
+#include "tracesmith/replay/frame_capture.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace tracesmith;
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char* argv[]) {
+    size_t num_draws = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+    size_t num_buffers = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200;
+    size_t buffer_kb = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 256;
+    size_t updates_per_draw = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 1;
+    size_t num_frames = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 2;
+    
+    const size_t buffer_size = buffer_kb * 1024;
+    const double total_mb = num_buffers * buffer_size / (1024.0 * 1024.0);
+    
+    std::cout << "Frame capture snapshot benchmark\n";
+    std::cout << "  Draw calls:       " << num_draws << "\n";
+    std::cout << "  Buffers:          " << num_buffers << " x " << buffer_kb << " KB ("
+              << std::fixed << std::setprecision(1) << total_mb << " MB)\n";
+    std::cout << "  Updates per draw: " << updates_per_draw << "\n";
+    std::cout << "  Frames:           " << num_frames << "\n\n";
+    
+    FrameCaptureConfig config;
+    config.capture_buffer_contents = true;
+    config.frames_to_capture = static_cast<uint32_t>(num_frames);
+    FrameCapture capture(config);
+    
+    std::vector<uint8_t> contents(buffer_size);
+    for (size_t id = 0; id < num_buffers; ++id) {
+        ResourceState buffer;
+        buffer.resource_id = id;
+        buffer.type = ResourceType::Buffer;
+        buffer.name = "buffer_" + std::to_string(id);
+        buffer.size = buffer_size;
+        capture.recordResourceCreate(buffer);
+        
+        std::fill(contents.begin(), contents.end(), static_cast<uint8_t>(id));
+        capture.recordResourceUpdate(id, contents.data(), contents.size());
+    }
+    
+    capture.triggerCapture();
+    capture.onFrameEnd();
+    
+    // Every frame repeats the same uploads, so later frames dedup fully
+    // against the first
+    auto t0 = Clock::now();
+    size_t versions = 0;
+    for (size_t frame = 0; frame < num_frames; ++frame) {
+        for (size_t draw = 0; draw < num_draws; ++draw) {
+            for (size_t u = 0; u < updates_per_draw; ++u) {
+                size_t id = (draw * 7 + u * 13) % num_buffers;
+                contents[0] = static_cast<uint8_t>(draw);
+                capture.recordResourceUpdate(id, contents.data(), contents.size());
+            }
+            
+            DrawCallInfo info;
+            info.call_id = draw;
+            info.name = "draw";
+            capture.recordDrawCall(info);
+        }
+        capture.onFrameEnd();
+    }
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    
+    for (const auto& frame : capture.getCapturedFrames()) {
+        versions += frame.resource_versions;
+    }
+    if (capture.getCapturedFrames().empty()) {
+        std::cerr << "No frame captured\n";
+        return 1;
+    }
+    
+    auto stats = capture.getChunkStore().getStatistics();
+    double logical_mb = stats.logical_bytes / (1024.0 * 1024.0);
+    double stored_mb = stats.stored_bytes / (1024.0 * 1024.0);
+    double full_mb = total_mb * (num_draws + 2) * num_frames;  // Per-draw deep copies + initial/final
+    
+    std::cout << std::setprecision(3);
+    std::cout << "Time per draw call:      " << (ms * 1000.0) / (num_draws * num_frames) << " us\n";
+    std::cout << "Resource versions:       " << versions << "\n";
+    std::cout << "Ingest overhead:         " << stats.overheadNsPerMB() / 1e6 << " ms/MB\n";
+    std::cout << std::setprecision(1);
+    std::cout << "Uploaded contents:       " << logical_mb << " MB\n";
+    std::cout << "Stored chunks:           " << stored_mb << " MB ("
+              << stats.unique_chunks << " unique, " << stats.duplicate_chunks << " duplicate, "
+              << stats.dedupRatio() << "x dedup)\n";
+    std::cout << "Full snapshots would be: " << full_mb << " MB ("
+              << full_mb / std::max(stored_mb, 1e-9) << "x)\n";
+    
+    return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * TraceSmith Benchmark: Multi-threaded Memory Profiler Hooks
+ * 
+ * N threads each run an allocator-hook workload (recordAlloc/recordFree
+ * with a rolling window of live blocks, like a caching allocator under a
+ * training loop) against one MemoryProfiler. Reports hook throughput for
+ * the string API, the pre-interned ID API, and a reference tracker with
+ * one global mutex and per-call string copies (the previous design).
+ * 
+ * Usage: benchmark_memory_profiler [threads] [ops_per_thread] [live_window]
+ */
+
+#include "tracesmith/capture/memory_profiler.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace tracesmith;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+/// Global-lock tracker equivalent to the previous MemoryProfiler hot path
+class GlobalLockTracker {
+public:
+    void recordAlloc(uint64_t ptr, uint64_t size, const std::string& allocator,
+                     const std::string& tag) {
+        MemoryAllocation alloc;
+        alloc.ptr = ptr;
+        alloc.size = size;
+        alloc.device_id = 0;
+        alloc.alloc_time = getCurrentTimestamp();
+        alloc.free_time = 0;
+        alloc.allocator = allocator;
+        alloc.tag = tag;
+        alloc.call_stack_hash = 0;
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        live_[ptr] = alloc;
+    }
+    
+    void recordFree(uint64_t ptr) {
+        Timestamp free_time = getCurrentTimestamp();
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = live_.find(ptr);
+        if (it == live_.end()) return;
+        it->second.free_time = free_time;
+        freed_.push_back(std::move(it->second));
+        live_.erase(it);
+    }
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, MemoryAllocation> live_;
+    std::vector<MemoryAllocation> freed_;
+};
+
+template<typename AllocFn, typename FreeFn>
+double runThreads(size_t num_threads, size_t ops, size_t window,
+                  AllocFn&& alloc, FreeFn&& release) {
+    auto t0 = Clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            uint64_t base = static_cast<uint64_t>(t + 1) << 40;
+            for (size_t i = 0; i < ops; ++i) {
+                alloc(base + i * 512, 512 + (i % 7) * 256);
+                if (i >= window) {
+                    release(base + (i - window) * 512);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    return (num_threads * ops * 2) / seconds / 1e6;  // Hook calls per second (M)
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t num_threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8;
+    size_t ops = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 500000;
+    size_t window = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1024;
+    
+    std::cout << "Memory profiler hook benchmark\n";
+    std::cout << "  Threads:          " << num_threads << "\n";
+    std::cout << "  Allocs/thread:    " << ops << " (+ frees)\n";
+    std::cout << "  Live window:      " << window << " per thread\n";
+    std::cout << "  Shards:           " << MemoryProfiler::shardCount() << "\n\n";
+    
+    const std::string allocator = "cuda_caching_allocator";
+    const std::string tag = "activations";
+    
+    double legacy_mops;
+    {
+        GlobalLockTracker tracker;
+        legacy_mops = runThreads(num_threads, ops, window,
+            [&](uint64_t ptr, uint64_t size) { tracker.recordAlloc(ptr, size, allocator, tag); },
+            [&](uint64_t ptr) { tracker.recordFree(ptr); });
+    }
+    
+    double string_mops;
+    {
+        MemoryProfiler profiler;
+        profiler.start();
+        string_mops = runThreads(num_threads, ops, window,
+            [&](uint64_t ptr, uint64_t size) { profiler.recordAlloc(ptr, size, 0, allocator, tag); },
+            [&](uint64_t ptr) { profiler.recordFree(ptr); });
+        profiler.stop();
+    }
+    
+    double interned_mops;
+    {
+        MemoryProfiler profiler;
+        uint32_t allocator_id = profiler.internName(allocator);
+        uint32_t tag_id = profiler.internName(tag);
+        profiler.start();
+        interned_mops = runThreads(num_threads, ops, window,
+            [&](uint64_t ptr, uint64_t size) {
+                profiler.recordAlloc(ptr, size, 0, allocator_id, tag_id);
+            },
+            [&](uint64_t ptr) { profiler.recordFree(ptr); });
+        profiler.stop();
+        
+        if (profiler.getLiveAllocationCount() != num_threads * std::min(ops, window)) {
+            std::cerr << "Live allocation count mismatch\n";
+            return 1;
+        }
+    }
+    
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Global lock + string copies: " << legacy_mops << " M hooks/s\n";
+    std::cout << "Sharded, string API:         " << string_mops << " M hooks/s ("
+              << string_mops / legacy_mops << "x)\n";
+    std::cout << "Sharded, interned IDs:       " << interned_mops << " M hooks/s ("
+              << interned_mops / legacy_mops << "x)\n";
+    
+    return 0;
+}
@@ -0,0 +1,188 @@
+/**
+ * TraceSmith Benchmark: Parallel Per-Stream State Reconstruction
+ * 
+ * Measures how GPUStateMachine::processEvents and
+ * InstructionStreamBuilder::analyze scale with worker threads on a
+ * synthetic 64-stream trace, and verifies that every parallel run is
+ * identical to the serial result. The analyze() column times the whole
+ * call: per-stream sequential edges, the per-device sync frontier sweep
+ * and the CSR build. Also times a critical-path pass over the resulting
+ * dependency graph.
+ * 
+ * Usage: benchmark_parallel_state [events] [max_threads]
+ */
+
+#include "tracesmith/common/types.hpp"
+#include "tracesmith/common/parallel.hpp"
+#include "tracesmith/state/gpu_state_machine.hpp"
+#include "tracesmith/state/instruction_stream.hpp"
+#include "tracesmith/state/critical_path.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace tracesmith;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr uint32_t kNumStreams = 64;
+constexpr uint32_t kNumDevices = 4;
+
+std::vector<TraceEvent> generateTrace(size_t num_events) {
+    std::vector<TraceEvent> events;
+    events.reserve(num_events);
+    
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint32_t> stream_dist(0, kNumStreams - 1);
+    std::uniform_int_distribution<int> type_dist(0, 9);
+    std::uniform_int_distribution<Timestamp> duration_dist(1000, 50000);
+    
+    Timestamp now = 1000000;
+    for (size_t i = 0; i < num_events; ++i) {
+        TraceEvent event;
+        uint32_t stream = stream_dist(gen);
+        int kind = type_dist(gen);
+        
+        if (kind < 6) {
+            event.type = EventType::KernelLaunch;
+            event.name = "kernel_" + std::to_string(i % 128);
+        } else if (kind < 8) {
+            event.type = EventType::KernelComplete;
+            event.name = "kernel_" + std::to_string(i % 128);
+        } else {
+            event.type = EventType::MemcpyH2D;
+            event.name = "memcpy";
+        }
+        // Sparse device-wide syncs exercise the per-device sync sweep
+        if (i % 20000 == 19999) {
+            event.type = EventType::DeviceSync;
+            event.name = "cudaDeviceSynchronize";
+        }
+        
+        event.timestamp = now;
+        event.duration = duration_dist(gen);
+        event.device_id = stream % kNumDevices;
+        event.stream_id = stream;
+        event.correlation_id = i + 1;
+        events.push_back(std::move(event));
+        now += 500;
+    }
+    
+    return events;
+}
+
+bool sameHistory(const GPUStateMachine& a, const GPUStateMachine& b) {
+    auto ha = a.exportHistory();
+    auto hb = b.exportHistory();
+    if (ha.size() != hb.size()) return false;
+    for (size_t i = 0; i < ha.size(); ++i) {
+        if (ha[i].device_id != hb[i].device_id || ha[i].stream_id != hb[i].stream_id ||
+            ha[i].transitions.size() != hb[i].transitions.size()) {
+            return false;
+        }
+        for (size_t j = 0; j < ha[i].transitions.size(); ++j) {
+            const auto& x = ha[i].transitions[j];
+            const auto& y = hb[i].transitions[j];
+            if (x.from != y.from || x.to != y.to || x.when != y.when ||
+                x.correlation_id != y.correlation_id || x.reason != y.reason) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool sameDependencies(const InstructionStreamBuilder& a, const InstructionStreamBuilder& b) {
+    auto da = a.getDependencies();
+    auto db = b.getDependencies();
+    if (da.size() != db.size()) return false;
+    for (size_t i = 0; i < da.size(); ++i) {
+        if (da[i].from_correlation_id != db[i].from_correlation_id ||
+            da[i].to_correlation_id != db[i].to_correlation_id ||
+            da[i].type != db[i].type || da[i].description != db[i].description) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t num_events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t max_threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : resolveThreadCount(0);
+    
+    std::cout << "Parallel state reconstruction benchmark\n";
+    std::cout << "  Events:  " << num_events << "\n";
+    std::cout << "  Streams: " << kNumStreams << " across " << kNumDevices << " devices\n\n";
+    
+    auto events = generateTrace(num_events);
+    
+    GPUStateMachine serial_sm;
+    InstructionStreamBuilder serial_isb;
+    serial_isb.addEvents(events);
+    
+    auto t0 = Clock::now();
+    serial_sm.processEvents(events);
+    double serial_sm_ms = elapsedMs(t0);
+    
+    t0 = Clock::now();
+    serial_isb.analyze();
+    double serial_isb_ms = elapsedMs(t0);
+    
+    std::cout << std::left << std::setw(10) << "Threads"
+              << std::setw(18) << "StateMachine ms"
+              << std::setw(10) << "Speedup"
+              << std::setw(18) << "analyze() ms"
+              << std::setw(10) << "Speedup"
+              << "Identical\n";
+    std::cout << std::string(76, '-') << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(10) << 1
+              << std::setw(18) << serial_sm_ms << std::setw(10) << 1.0
+              << std::setw(18) << serial_isb_ms << std::setw(10) << 1.0
+              << "-\n";
+    
+    bool all_identical = true;
+    for (size_t threads = 2; threads <= max_threads; threads *= 2) {
+        GPUStateMachine sm;
+        sm.setParallelism(threads);
+        t0 = Clock::now();
+        sm.processEvents(events);
+        double sm_ms = elapsedMs(t0);
+        
+        InstructionStreamBuilder isb;
+        isb.setParallelism(threads);
+        isb.addEvents(events);
+        t0 = Clock::now();
+        isb.analyze();
+        double isb_ms = elapsedMs(t0);
+        
+        bool identical = sameHistory(serial_sm, sm) && sameDependencies(serial_isb, isb);
+        all_identical = all_identical && identical;
+        
+        std::cout << std::setw(10) << threads
+                  << std::setw(18) << sm_ms << std::setw(10) << serial_sm_ms / sm_ms
+                  << std::setw(18) << isb_ms << std::setw(10) << serial_isb_ms / isb_ms
+                  << (identical ? "yes" : "NO") << "\n";
+    }
+    
+    t0 = Clock::now();
+    CriticalPathAnalyzer critical_path(serial_isb);
+    auto critical = critical_path.analyze();
+    double cp_ms = elapsedMs(t0);
+    std::cout << "\nCritical path: " << critical.path.size() << " of "
+              << serial_isb.nodeCount() << " ops in " << cp_ms << " ms\n";
+    
+    std::cout << "\n" << (all_identical ? "All parallel runs match the serial result\n"
+                                        : "MISMATCH between serial and parallel results\n");
+    return all_identical ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+/**
+ * TraceSmith Benchmark: Perfetto Export
+ * 
+ * Exports a synthetic GPU trace (kernels, copies, allocations, correlated
+ * launches and a few counter tracks) with the JSON exporter (pretty,
+ * compact and gzip-compressed) and with the native protobuf writer.
+ * Reports events/s and output size for each, then the scaling of
+ * parallel in-memory export (compact JSON and protobuf) from 1 up to
+ * max_threads workers, checking output is byte-identical to serial.
+ * 
+ * Usage: benchmark_perfetto_export [events] [output_dir] [max_threads]
+ */
+
+#include "tracesmith/state/perfetto_exporter.hpp"
+#include "tracesmith/state/perfetto_proto_exporter.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace tracesmith;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+std::vector<TraceEvent> makeEvents(size_t count) {
+    const char* kernels[] = {"gemm_fp16_128x128", "layernorm_fwd", "softmax_fwd",
+                             "attention_fwd", "elementwise_add", "nccl_allreduce"};
+    std::vector<TraceEvent> events;
+    events.reserve(count);
+    
+    Timestamp ts = 1000000000;
+    for (size_t i = 0; i < count; ++i) {
+        TraceEvent event;
+        event.device_id = static_cast<uint32_t>(i % 4);
+        event.stream_id = static_cast<uint32_t>(i % 8);
+        event.timestamp = ts;
+        ts += 2500;
+        
+        switch (i % 10) {
+            case 0:
+                event.type = EventType::MemcpyH2D;
+                event.name = "cudaMemcpyAsync";
+                event.duration = 8000;
+                event.memory_params = MemoryParams();
+                event.memory_params->size_bytes = 1 << 20;
+                break;
+            case 1:
+                event.type = EventType::MemAlloc;
+                event.name = "cudaMalloc";
+                event.memory_params = MemoryParams();
+                event.memory_params->size_bytes = 4096;
+                break;
+            default:
+                event.type = EventType::KernelLaunch;
+                event.name = kernels[i % 6];
+                event.duration = 2000 + (i % 13) * 100;
+                event.kernel_params = KernelParams();
+                event.kernel_params->grid_x = 128;
+                event.kernel_params->block_x = 256;
+                event.correlation_id = i / 2 + 1;  // Launch pairs share an ID
+                event.thread_id = 1234;
+                break;
+        }
+        events.push_back(std::move(event));
+    }
+    return events;
+}
+
+std::vector<CounterEvent> makeCounters(size_t count) {
+    std::vector<CounterEvent> counters;
+    counters.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        counters.emplace_back(i % 2 ? "SM Occupancy" : "GPU Memory Usage",
+                              static_cast<double>(i % 100), 1000000000 + i * 25000,
+                              i % 2 ? "%" : "GB");
+    }
+    return counters;
+}
+
+uint64_t fileSize(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return in ? static_cast<uint64_t>(in.tellg()) : 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t num_events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::string dir = argc > 2 ? argv[2] : ".";
+    size_t max_threads = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 32;
+    
+    auto events = makeEvents(num_events);
+    auto counters = makeCounters(num_events / 100);
+    size_t total = events.size() + counters.size();
+    
+    std::cout << "Perfetto export benchmark\n";
+    std::cout << "  Events:   " << events.size() << "\n";
+    std::cout << "  Counters: " << counters.size() << "\n\n";
+    
+    struct Result {
+        const char* label;
+        double seconds;
+        uint64_t bytes;
+    };
+    std::vector<Result> results;
+    
+    auto run_json = [&](const char* label, bool compact, const std::string& path) {
+        PerfettoExporter exporter;
+        exporter.setCompact(compact);
+        auto t0 = Clock::now();
+        bool ok = exporter.exportToFile(events, counters, path);
+        double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+        if (ok) {
+            results.push_back({label, seconds, fileSize(path)});
+        }
+        std::remove(path.c_str());
+        return ok;
+    };
+    
+    bool ok = run_json("JSON (pretty)", false, dir + "/benchmark_export.json");
+    ok = run_json("JSON (compact)", true, dir + "/benchmark_export_compact.json") && ok;
+    if (PerfettoExporter::isGzipAvailable()) {
+        ok = run_json("JSON (compact, gzip)", true, dir + "/benchmark_export.json.gz") && ok;
+    }
+    
+    std::string proto_path = dir + "/benchmark_export.perfetto-trace";
+    auto t0 = Clock::now();
+    PerfettoProtoExporter proto_exporter(PerfettoProtoExporter::Format::PROTOBUF);
+    bool proto_ok = proto_exporter.exportToFile(events, counters, proto_path);
+    double proto_seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    if (proto_ok) {
+        results.push_back({"Protobuf", proto_seconds, fileSize(proto_path)});
+    }
+    std::remove(proto_path.c_str());
+    
+    if (!ok || !proto_ok) {
+        std::cerr << "Export failed\n";
+        return 1;
+    }
+    
+    // Speedup and size ratio are relative to pretty JSON
+    const Result& baseline = results.front();
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& result : results) {
+        std::cout << std::left << std::setw(22) << result.label << std::right
+                  << std::setw(7) << total / result.seconds / 1e6 << " M events/s, "
+                  << std::setw(8) << result.bytes / (1024.0 * 1024.0) << " MB ("
+                  << baseline.seconds / result.seconds << "x faster, "
+                  << static_cast<double>(baseline.bytes) / result.bytes << "x smaller)\n";
+    }
+    
+    // Parallel scaling; speedup is relative to one thread of the same format
+    std::cout << "\nParallel export (in memory)\n";
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "JSON M ev/s"
+              << std::setw(10) << "speedup" << std::setw(16) << "Proto M ev/s"
+              << std::setw(10) << "speedup" << "\n";
+    
+    PerfettoExporter json_exporter;
+    json_exporter.setCompact(true);
+    PerfettoProtoExporter scaling_exporter(PerfettoProtoExporter::Format::PROTOBUF);
+    std::string json_serial;
+    std::vector<uint8_t> proto_serial;
+    double json_base = 0.0;
+    double proto_base = 0.0;
+    bool identical = true;
+    
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        json_exporter.setParallelism(threads);
+        auto start = Clock::now();
+        std::string json = json_exporter.exportToString(events, counters);
+        double json_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        
+        scaling_exporter.setParallelism(threads);
+        start = Clock::now();
+        std::vector<uint8_t> proto = scaling_exporter.exportToProto(events, counters);
+        double proto_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        
+        if (threads == 1) {
+            json_serial = std::move(json);
+            proto_serial = std::move(proto);
+            json_base = json_seconds;
+            proto_base = proto_seconds;
+        } else {
+            identical = identical && json == json_serial && proto == proto_serial;
+        }
+        
+        std::cout << std::setw(8) << threads
+                  << std::setw(16) << total / json_seconds / 1e6
+                  << std::setw(9) << json_base / json_seconds << "x"
+                  << std::setw(16) << total / proto_seconds / 1e6
+                  << std::setw(9) << proto_base / proto_seconds << "x\n";
+    }
+    
+    std::cout << "Output identical to serial: " << (identical ? "yes" : "NO") << "\n";
+    return identical ? 0 : 1;
+}
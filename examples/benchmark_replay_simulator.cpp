@@ -0,0 +1,123 @@
+/**
+ * TraceSmith Benchmark: Discrete-Event Replay Simulation
+ * 
+ * Simulates a synthetic 16-stream trace (kernels, copies, periodic device
+ * syncs) with ReplaySimulator and reports simulated operations per second
+ * for a few what-if cost models.
+ * 
+ * Usage: benchmark_replay_simulator [ops] [streams]
+ */
+
+#include "tracesmith/common/types.hpp"
+#include "tracesmith/replay/replay_simulator.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace tracesmith;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+std::vector<StreamOperation> generateOperations(size_t num_ops, uint32_t num_streams) {
+    std::vector<StreamOperation> ops;
+    ops.reserve(num_ops);
+    std::vector<size_t> last_on_stream(num_streams, SIZE_MAX);
+    
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<Timestamp> duration_dist(2000, 40000);
+    std::uniform_int_distribution<int> kind_dist(0, 9);
+    
+    Timestamp now = 1000000;
+    for (size_t i = 0; i < num_ops; ++i) {
+        TraceEvent event;
+        uint32_t stream = static_cast<uint32_t>(i % num_streams);
+        int kind = kind_dist(gen);
+        
+        if (i % 5000 == 4999) {
+            event.type = EventType::DeviceSync;
+            event.name = "cudaDeviceSynchronize";
+        } else if (kind < 7) {
+            event.type = EventType::KernelLaunch;
+            event.name = "kernel";
+        } else {
+            event.type = kind == 7 ? EventType::MemcpyH2D : EventType::MemcpyD2H;
+            event.name = "memcpy";
+        }
+        event.timestamp = now;
+        event.duration = duration_dist(gen);
+        event.stream_id = stream;
+        now += 3000;
+        
+        StreamOperation op(event, i);
+        if (last_on_stream[stream] != SIZE_MAX) {
+            op.depends_on.push_back(last_on_stream[stream]);
+        }
+        if (event.type == EventType::DeviceSync) {
+            for (uint32_t s = 0; s < num_streams; ++s) {
+                if (s != stream && last_on_stream[s] != SIZE_MAX) {
+                    op.depends_on.push_back(last_on_stream[s]);
+                }
+            }
+        }
+        last_on_stream[stream] = i;
+        ops.push_back(std::move(op));
+    }
+    
+    return ops;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t num_ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    uint32_t num_streams = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 16;
+    
+    std::cout << "Replay simulation benchmark\n";
+    std::cout << "  Operations: " << num_ops << "\n";
+    std::cout << "  Streams:    " << num_streams << "\n\n";
+    
+    auto ops = generateOperations(num_ops, num_streams);
+    
+    auto faster_copies = std::make_shared<ScaledCostModel>();
+    faster_copies->setTypeScale(EventType::MemcpyH2D, 0.5);
+    faster_copies->setTypeScale(EventType::MemcpyD2H, 0.5);
+    
+    struct Scenario {
+        const char* name;
+        SimulationConfig config;
+    };
+    std::vector<Scenario> scenarios(4);
+    scenarios[0].name = "captured";
+    scenarios[1].name = "1 copy engine";
+    scenarios[1].config.copy_engines = 1;
+    scenarios[2].name = "4 compute slots";
+    scenarios[2].config.compute_slots = 4;
+    scenarios[3].name = "2x faster copies";
+    scenarios[3].config.cost_model = faster_copies;
+    
+    std::cout << std::left << std::setw(20) << "Scenario"
+              << std::setw(16) << "Makespan ms"
+              << std::setw(12) << "Sim ms"
+              << "Mops/s\n";
+    std::cout << std::string(60, '-') << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    
+    for (const auto& scenario : scenarios) {
+        ReplaySimulator simulator(scenario.config);
+        auto t0 = Clock::now();
+        auto result = simulator.run(ops);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        
+        std::cout << std::setw(20) << scenario.name
+                  << std::setw(16) << result.makespan / 1e6
+                  << std::setw(12) << ms
+                  << (num_ops / 1e3) / ms << "\n";
+    }
+    
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * TraceSmith Benchmark: Stream Scheduler Scaling
+ * 
+ * Schedules synthetic multi-stream traces of increasing size through
+ * StreamScheduler (add, select, complete) and reports time per operation.
+ * Per-op cost should stay roughly flat as the trace grows; the old
+ * vector-scan scheduler grew linearly per op (quadratic overall).
+ * 
+ * Usage: benchmark_stream_scheduler [max_ops] [streams]
+ */
+
+#include "tracesmith/common/types.hpp"
+#include "tracesmith/replay/stream_scheduler.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace tracesmith;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct RunResult {
+    double add_ms = 0.0;
+    double schedule_ms = 0.0;
+    size_t executed = 0;
+};
+
+RunResult runScheduler(size_t num_ops, uint32_t num_streams) {
+    RunResult result;
+    StreamScheduler scheduler(SchedulingPolicy::Priority);
+    scheduler.reserve(num_ops);
+    std::vector<size_t> last_on_stream(num_streams, SIZE_MAX);
+    
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < num_ops; ++i) {
+        TraceEvent event;
+        event.type = (i % 1000 == 999) ? EventType::DeviceSync : EventType::KernelLaunch;
+        event.timestamp = 1000 + i * 100;
+        event.duration = 1000;
+        event.stream_id = static_cast<uint32_t>((i * 7) % num_streams);
+        
+        StreamOperation op(event, i);
+        uint32_t stream = event.stream_id;
+        if (last_on_stream[stream] != SIZE_MAX) {
+            op.depends_on.push_back(last_on_stream[stream]);
+        }
+        // Device syncs wait for every other stream, like ReplayEngine
+        if (event.type == EventType::DeviceSync) {
+            for (uint32_t s = 0; s < num_streams; ++s) {
+                if (s != stream && last_on_stream[s] != SIZE_MAX) {
+                    op.depends_on.push_back(last_on_stream[s]);
+                }
+            }
+        }
+        last_on_stream[stream] = i;
+        scheduler.addOperation(std::move(op));
+    }
+    result.add_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    
+    // Same loop shape as ReplayEngine::executeReplay
+    t0 = Clock::now();
+    while (!scheduler.allCompleted()) {
+        StreamOperation* op = scheduler.getNextOperation();
+        if (!op) {
+            break;
+        }
+        scheduler.markCompleted(op->operation_id);
+        result.executed++;
+    }
+    result.schedule_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t max_ops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    uint32_t num_streams = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 16;
+    
+    std::cout << "Stream scheduler scaling benchmark\n";
+    std::cout << "  Streams: " << num_streams << "\n\n";
+    
+    std::cout << std::left << std::setw(12) << "Ops"
+              << std::setw(14) << "Add ms"
+              << std::setw(14) << "Schedule ms"
+              << std::setw(14) << "ns/op"
+              << "Complete\n";
+    std::cout << std::string(62, '-') << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    
+    bool all_complete = true;
+    for (size_t ops = 10000; ops <= max_ops; ops *= 10) {
+        RunResult r = runScheduler(ops, num_streams);
+        double ns_per_op = (r.add_ms + r.schedule_ms) * 1e6 / static_cast<double>(ops);
+        bool complete = r.executed == ops;
+        all_complete = all_complete && complete;
+        
+        std::cout << std::setw(12) << ops
+                  << std::setw(14) << r.add_ms
+                  << std::setw(14) << r.schedule_ms
+                  << std::setw(14) << ns_per_op
+                  << (complete ? "yes" : "NO") << "\n";
+    }
+    
+    return all_complete ? 0 : 1;
+}
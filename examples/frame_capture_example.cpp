@@ -203,10 +203,10 @@ int main() {
     std::cout << "═══════════════════════════════════════════════════\n\n";
     
     for (const auto& [id, state] : capture.getResources()) {
-        std::cout << "  " << state.name << " (" 
-                  << resourceTypeToString(state.type) << ")\n";
-        std::cout << "    Address: 0x" << std::hex << state.address << std::dec << "\n";
-        std::cout << "    Size: " << state.size << " bytes\n";
+        std::cout << "  " << state->name << " (" 
+                  << resourceTypeToString(state->type) << ")\n";
+        std::cout << "    Address: 0x" << std::hex << state->address << std::dec << "\n";
+        std::cout << "    Size: " << state->size << " bytes\n";
     }
     
     std::cout << "\n✅ Frame capture example complete!\n";
@@ -0,0 +1,159 @@
+#pragma once
+
+/**
+ * Capture-time event filtering and sampling
+ *
+ * Every platform profiler passes its events through an EventSampler
+ * before the event callback and its buffer, so that under very high
+ * kernel launch rates load is shed by rule instead of by buffer drops.
+ *
+ * Events are first checked against the ProfilerConfig type switches
+ * (capture_kernels, capture_memcpy, ...), then against the sampling
+ * rules. The first rule whose glob matches the event name decides:
+ *
+ *   1. exclude drops the event.
+ *   2. Events lasting at least keep_slower_than_ns are kept.
+ *   3. 1-in-N sampling (sample_every), counted per name.
+ *   4. A per-name rate limit (max_per_second), measured on event
+ *      timestamps so it follows the device rather than host delivery.
+ *
+ * Events that match no rule are kept. Globs are compiled once in
+ * configure(), and each distinct (type, name) pair is matched once; later
+ * events with that name cost a hash lookup under a lock on the shard that
+ * holds the name, so threads sampling different names rarely contend.
+ * Without rules, admit() takes no lock and only bumps atomic counters.
+ *
+ * Every decision is counted exactly, per name and in total, so analysis
+ * can scale sampled statistics back up (see SamplingCounters::weight()).
+ *
+ * Usage:
+ *   ProfilerConfig config;
+ *   SamplingRule rule;
+ *   rule.pattern = "elementwise_*";
+ *   rule.sample_every = 100;
+ *   rule.keep_slower_than_ns = 50000;
+ *   config.sampling.rules.push_back(rule);
+ *   profiler->initialize(config);
+ */
+
+#include "tracesmith/common/types.hpp"
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tracesmith {
+
+struct ProfilerConfig;
+
+/// One filtering/sampling rule, applied per event name
+struct SamplingRule {
+    std::string pattern = "*";          // Name glob: '*' any run, '?' any character
+    EventType type = EventType::Unknown;  // Only this type (Unknown = any)
+    bool exclude = false;               // Drop every matching event
+    uint32_t sample_every = 1;          // Keep 1 in N per name (0 or 1 = all)
+    double max_per_second = 0.0;        // Per-name rate limit (0 = unlimited)
+    uint64_t keep_slower_than_ns = 0;   // Always keep events this long (0 = off)
+};
+
+/// Capture-time sampling configuration
+struct SamplingConfig {
+    std::vector<SamplingRule> rules;    // First match applies; others are kept
+};
+
+/// Exact counts of sampling decisions
+struct SamplingCounters {
+    uint64_t seen = 0;                  // Events offered
+    uint64_t kept = 0;                  // Events passed on (includes kept_slow)
+    uint64_t kept_slow = 0;             // Kept by keep_slower_than_ns
+    uint64_t filtered = 0;              // Dropped by type switches or exclude
+    uint64_t sampled_out = 0;           // Dropped by 1-in-N sampling
+    uint64_t rate_limited = 0;          // Dropped by max_per_second
+    uint64_t dropped_duration_ns = 0;   // Total duration of sampled_out + rate_limited
+
+    /**
+     * How many events each kept event stands for
+     * Slow-kept events always stand for themselves; the others share the
+     * sampled-out population.
+     */
+    double weight() const {
+        uint64_t sampled_kept = kept - kept_slow;
+        return sampled_kept == 0 ? 1.0
+            : static_cast<double>(sampled_kept + sampled_out + rate_limited) /
+              static_cast<double>(sampled_kept);
+    }
+};
+
+class EventSampler {
+public:
+    EventSampler() = default;
+
+    EventSampler(const EventSampler&) = delete;
+    EventSampler& operator=(const EventSampler&) = delete;
+
+    /// Take type switches and rules from a profiler configuration; call
+    /// before capture starts, not concurrently with admit()
+    void configure(const ProfilerConfig& config);
+
+    /// Decide whether to keep an event; thread-safe
+    bool admit(const TraceEvent& event);
+
+    /// Clear counters and per-name state, keeping the configuration
+    void reset();
+
+    /// Totals over all events
+    SamplingCounters totals() const;
+
+    /// Counters per event name, summed over event types (names seen
+    /// while rules are configured)
+    std::unordered_map<std::string, SamplingCounters> countersByName() const;
+
+    /// Whether any rule or type switch can drop events
+    bool isActive() const { return !rules_.empty() || !type_filter_.empty(); }
+
+private:
+    /// Glob split at '*': segments[0] is anchored at the start and, unless
+    /// the pattern ends in '*', segments.back() at the end
+    struct CompiledRule {
+        SamplingRule rule;
+        std::vector<std::string> segments;
+        bool trailing_star = false;
+
+        bool matches(const std::string& name) const;
+    };
+
+    /// Per-name decision state, created the first time a name is seen
+    struct NameState {
+        const CompiledRule* rule = nullptr;     // nullptr: no rule matched
+        uint64_t sample_counter = 0;
+        double tokens = 0.0;
+        Timestamp last_refill = 0;
+        SamplingCounters counters;
+    };
+
+    /// Per-name state for the names that map to this shard
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<EventType, std::unordered_map<std::string, NameState>> names;
+        SamplingCounters totals;                // Events that reached the rules
+    };
+    static constexpr unsigned kShardBits = 4;
+    static constexpr size_t kShards = size_t(1) << kShardBits;
+
+    std::vector<CompiledRule> rules_;
+    std::vector<EventType> type_filter_;        // Types the switches drop
+
+    // Events decided without the rules; kept = seen - filtered
+    std::atomic<uint64_t> unruled_seen_{0};
+    std::atomic<uint64_t> unruled_filtered_{0};
+
+    mutable std::array<Shard, kShards> shards_;
+
+    static size_t shardOf(const std::string& name);
+    NameState& stateFor(Shard& shard, const TraceEvent& event) const;
+    void clearState();
+};
+
+} // namespace tracesmith
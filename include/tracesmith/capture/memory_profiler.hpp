@@ -19,16 +19,24 @@
  */
 
 #include "tracesmith/common/types.hpp"
+#include <array>
 #include <vector>
 #include <map>
+#include <set>
 #include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
 #include <atomic>
 #include <string>
 #include <functional>
+#include <memory>
+#include <thread>
+#include <condition_variable>
 
 namespace tracesmith {
 
+class SBTWriter;
+
 /// Memory allocation record
 struct MemoryAllocation {
     uint64_t ptr;                   // Memory address
@@ -46,6 +54,46 @@ struct MemoryAllocation {
     }
 };
 
+/// Memory fragmentation info
+struct FragmentationInfo {
+    uint64_t total_free_bytes = 0;      // Total free memory
+    uint64_t largest_free_block = 0;    // Largest contiguous free block
+    uint64_t free_block_count = 0;      // Number of free blocks
+    double fragmentation_ratio = 0.0;   // 1 - (largest_free / total_free)
+};
+
+/**
+ * Address-ordered model of one allocator's address range.
+ * 
+ * Live blocks are kept in a balanced tree keyed by address and the holes
+ * between neighbouring blocks in a sorted multiset, both updated on every
+ * insert/erase in O(log n). Free space is the holes inside the span of
+ * live blocks; the allocator's untouched reserve is not visible here.
+ * Not thread-safe.
+ */
+class AddressSpaceMap {
+public:
+    /// Add a live block [ptr, ptr + size); replaces any block at ptr
+    void insert(uint64_t ptr, uint64_t size);
+    
+    /// Remove the live block at ptr (no-op if unknown)
+    void erase(uint64_t ptr);
+    
+    /// Current free-space summary (O(log n))
+    FragmentationInfo info() const;
+    
+    size_t blockCount() const { return blocks_.size(); }
+    void clear();
+    
+private:
+    std::map<uint64_t, uint64_t> blocks_;   // ptr -> end address
+    std::multiset<uint64_t> holes_;         // Sizes of gaps between blocks
+    uint64_t hole_bytes_ = 0;
+    
+    void addHole(uint64_t begin, uint64_t end);
+    void removeHole(uint64_t begin, uint64_t end);
+};
+
 /// Memory usage snapshot at a point in time
 struct MemorySnapshot {
     Timestamp timestamp;
@@ -60,14 +108,36 @@ struct MemorySnapshot {
     
     // Per-allocator breakdown  
     std::map<std::string, uint64_t> allocator_usage;
+    
+    // Free space across all device/allocator pools
+    FragmentationInfo fragmentation;
 };
 
-/// Memory fragmentation info
-struct FragmentationInfo {
-    uint64_t total_free_bytes;      // Total free memory
-    uint64_t largest_free_block;    // Largest contiguous free block
-    uint64_t free_block_count;      // Number of free blocks
-    double fragmentation_ratio;     // 1 - (largest_free / total_free)
+/**
+ * Log-linear histogram with a fixed bucket array (HDR-style).
+ * 
+ * Each power of two is split into 2^kSubBucketBits linear sub-buckets, so
+ * any recorded value is reported within 12.5% and memory never grows.
+ */
+struct LogHistogram {
+    static constexpr int kSubBucketBits = 3;
+    static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+    static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+    
+    std::array<uint64_t, kBucketCount> counts{};
+    uint64_t total_count = 0;
+    uint64_t min_value = UINT64_MAX;
+    uint64_t max_value = 0;
+    
+    void record(uint64_t value, uint64_t count = 1);
+    void merge(const LogHistogram& other);
+    
+    /// Upper bound of the bucket holding the given percentile (0-100)
+    uint64_t valueAtPercentile(double percentile) const;
+    
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketLowerBound(size_t index);
+    static uint64_t bucketUpperBound(size_t index);
 };
 
 /// Potential memory leak
@@ -100,6 +170,7 @@ struct MemoryReport {
     // Potential issues
     std::vector<MemoryLeak> potential_leaks;
     FragmentationInfo fragmentation;
+    std::map<std::string, FragmentationInfo> pool_fragmentation;  // "device:allocator"
     
     // Timeline (sampled snapshots)
     std::vector<MemorySnapshot> timeline;
@@ -117,6 +188,16 @@ struct MemoryReport {
     };
     std::map<std::string, AllocatorStats> allocator_stats;
     
+    // Per-tag stats (same counters, keyed by tag)
+    std::map<std::string, AllocatorStats> tag_stats;
+    
+    // Fixed-size distributions: sizes of all allocations, lifetimes of freed ones
+    LogHistogram size_histogram;
+    LogHistogram lifetime_histogram;
+    
+    // Uniform sample of freed allocation records (streaming mode)
+    std::vector<MemoryAllocation> freed_samples;
+    
     /// Generate text summary
     std::string summary() const;
     
@@ -127,16 +208,42 @@ struct MemoryReport {
 /// Memory event callback
 using MemoryEventCallback = std::function<void(const MemoryEvent&)>;
 
-/// GPU Memory Profiler
+/// Timeline sample callback (runs on the sampler thread)
+using MemorySnapshotCallback = std::function<void(const MemorySnapshot&)>;
+
+/**
+ * GPU Memory Profiler
+ * 
+ * Live allocations are kept in a table sharded by pointer hash, each shard
+ * with its own lock, so allocator hooks on many threads rarely contend.
+ * Allocator and tag names are interned; records store 32-bit IDs.
+ * 
+ * Freed allocations are always folded into per-shard aggregates. With
+ * streaming_stats set, the individual records are then dropped (only a
+ * reservoir sample is kept), so memory stays bounded on long runs, and
+ * freed_spill_path can stream every record to an SBT file instead.
+ * 
+ * track_fragmentation keeps an AddressSpaceMap per device/allocator pool.
+ * Every hook on a pool takes that pool's lock, so it is off by default.
+ * 
+ * While active, a sampler thread appends a timeline sample every
+ * snapshot_interval_ms (0 = only at start/stop). Samples read the
+ * per-shard atomic counters without taking shard locks, so they carry
+ * totals only; takeSnapshot() adds the per-device/allocator breakdown.
+ */
 class MemoryProfiler {
 public:
     /// Configuration
     struct Config {
-        uint32_t snapshot_interval_ms = 100;  // Timeline snapshot interval
+        uint32_t snapshot_interval_ms = 100;  // Timeline sampling interval (0 = off)
         uint64_t leak_threshold_ns = 5000000000ULL;  // 5 seconds
         bool track_call_stacks = false;
         bool detect_double_free = true;
-        size_t max_timeline_samples = 1000;
+        bool track_fragmentation = false;     // Address-ordered model per device/allocator (one lock per pool)
+        size_t max_timeline_samples = 1000;   // Timeline ring capacity
+        bool streaming_stats = false;         // Keep aggregates, not every freed record
+        size_t freed_sample_size = 1024;      // Reservoir size in streaming mode
+        std::string freed_spill_path;         // Streaming mode: SBT file for full freed history
         
         Config() = default;
     };
@@ -163,6 +270,19 @@ public:
                      const std::string& allocator = "default",
                      const std::string& tag = "");
     
+    /// Record memory allocation with allocator/tag IDs from internName()
+    void recordAlloc(uint64_t ptr, uint64_t size, uint32_t device_id,
+                     uint32_t allocator_id, uint32_t tag_id);
+    
+    /**
+     * Intern an allocator or tag name. IDs stay valid for the profiler's
+     * lifetime (clear() keeps them), so hooks can intern once up front.
+     */
+    uint32_t internName(const std::string& name);
+    
+    /// Name of an interned ID ("" if unknown)
+    std::string nameOf(uint32_t id) const;
+    
     /// Record memory free
     void recordFree(uint64_t ptr, uint32_t device_id = 0);
     
@@ -178,12 +298,18 @@ public:
     /// Get live allocation count
     uint64_t getLiveAllocationCount() const;
     
+    /// Number of live-allocation shards
+    static constexpr size_t shardCount() { return kShardCount; }
+    
     /// Get all live allocations
     std::vector<MemoryAllocation> getLiveAllocations() const;
     
     /// Take a memory snapshot
     MemorySnapshot takeSnapshot() const;
     
+    /// Timeline samples, oldest first
+    std::vector<MemorySnapshot> getTimeline() const;
+    
     /// Generate full report
     MemoryReport generateReport() const;
     
@@ -193,43 +319,149 @@ public:
     /// Set callback for memory events
     void setCallback(MemoryEventCallback callback) { callback_ = std::move(callback); }
     
+    /**
+     * Set callback for each timeline sample, e.g. to forward
+     * snapshotCounters() to Tracy plots live. Set it before start().
+     */
+    void setSnapshotCallback(MemorySnapshotCallback callback) {
+        snapshot_callback_ = std::move(callback);
+    }
+    
     /// Convert to CounterEvents for Perfetto export
     std::vector<CounterEvent> toCounterEvents() const;
     
-    /// Convert to MemoryEvents
+    /// Counter events for one timeline sample
+    static std::vector<CounterEvent> snapshotCounters(const MemorySnapshot& snapshot);
+    
+    /// Convert to MemoryEvents (freed allocations are sampled in streaming mode)
     std::vector<MemoryEvent> toMemoryEvents() const;
     
     /// Detect potential memory leaks based on leak threshold
     std::vector<MemoryLeak> detectLeaks() const;
     
+    /// Free-space summary of one device/allocator pool
+    FragmentationInfo getFragmentation(uint32_t device_id, const std::string& allocator) const;
+    
 private:
+    static constexpr size_t kShardBits = 6;
+    static constexpr size_t kShardCount = size_t(1) << kShardBits;
+    
+    /// Live allocation (pointer is the table key)
+    struct LiveAllocation {
+        uint64_t size;
+        Timestamp alloc_time;
+        uint32_t device_id;
+        uint32_t allocator_id;
+        uint32_t tag_id;
+        uint32_t call_stack_hash;
+    };
+    
+    /// Freed allocation
+    struct FreedAllocation {
+        uint64_t ptr;
+        uint64_t size;
+        Timestamp alloc_time;
+        Timestamp free_time;
+        uint32_t device_id;
+        uint32_t allocator_id;
+        uint32_t tag_id;
+    };
+    
+    /// Per-name counters for freed allocations
+    struct FreedCounters {
+        uint64_t frees = 0;
+        uint64_t bytes_freed = 0;
+    };
+    
+    /// Fixed-size aggregates of everything freed in a shard
+    struct FreedStats {
+        LogHistogram size;
+        LogHistogram lifetime;
+        std::array<uint64_t, 64> size_pow2{};  // Index = log2 of rounded-up size
+        uint64_t total_size = 0;
+        uint64_t total_lifetime = 0;
+        std::unordered_map<uint32_t, FreedCounters> by_allocator;
+        std::unordered_map<uint32_t, FreedCounters> by_tag;
+        std::vector<FreedAllocation> samples;   // Reservoir (Algorithm R)
+        uint64_t rng_state;
+    };
+    
+    /// One lock per shard; counters are written under it but are atomic
+    /// so the timeline sampler can read them without locking
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, LiveAllocation> live;
+        std::vector<FreedAllocation> freed;     // Full history, or spill batch
+        std::unique_ptr<FreedStats> freed_stats;  // Created on first free
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> frees{0};
+        std::atomic<uint64_t> bytes_allocated{0};
+        std::atomic<uint64_t> bytes_freed{0};
+    };
+    
     Config config_;
     std::atomic<bool> active_{false};
     Timestamp start_time_ = 0;
     Timestamp stop_time_ = 0;
     
     // Allocation tracking
-    mutable std::mutex mutex_;
-    std::unordered_map<uint64_t, MemoryAllocation> live_allocations_;
-    std::vector<MemoryAllocation> freed_allocations_;
+    std::array<Shard, kShardCount> shards_;
+    
+    // Interned allocator and tag names (index = ID)
+    mutable std::shared_mutex names_mutex_;
+    std::unordered_map<std::string, uint32_t> name_ids_;
+    std::vector<std::string> names_;
+    uint64_t instance_id_;              // Keys the per-thread name cache
+    uint32_t default_allocator_id_;
+    uint32_t empty_tag_id_;
     
     // Statistics
     std::atomic<uint64_t> current_usage_{0};
     std::atomic<uint64_t> peak_usage_{0};
-    std::atomic<uint64_t> total_allocations_{0};
-    std::atomic<uint64_t> total_frees_{0};
-    std::atomic<uint64_t> total_bytes_allocated_{0};
-    std::atomic<uint64_t> total_bytes_freed_{0};
     
-    // Timeline
+    /// Address model of one device/allocator pool, with its own lock
+    struct Pool {
+        mutable std::mutex mutex;
+        AddressSpaceMap map;
+    };
+    
+    // Fragmentation pools keyed by (device_id << 32 | allocator_id)
+    mutable std::shared_mutex pools_mutex_;
+    std::unordered_map<uint64_t, std::unique_ptr<Pool>> pools_;
+    
+    // Optional on-disk freed history
+    std::mutex spill_mutex_;
+    std::unique_ptr<SBTWriter> spill_writer_;
+    
+    // Timeline ring: timeline_count_ samples ending before timeline_head_
+    mutable std::mutex timeline_mutex_;
     std::vector<MemorySnapshot> timeline_;
+    size_t timeline_head_ = 0;
+    size_t timeline_count_ = 0;
+    
+    // Periodic sampler
+    std::thread sampler_thread_;
+    std::mutex sampler_mutex_;
+    std::condition_variable sampler_cv_;
+    bool sampler_stop_ = false;
     
-    // Callback
+    // Callbacks
     MemoryEventCallback callback_;
+    MemorySnapshotCallback snapshot_callback_;
     
     // Internal helpers
-    void updatePeakUsage();
+    Shard& shardFor(uint64_t ptr);
+    uint32_t cachedNameId(const std::string& name, int slot);
+    std::vector<std::string> nameTable() const;
+    void foldFreed(Shard& shard, size_t shard_index, const FreedAllocation& record);
+    void spillFreed(std::vector<FreedAllocation>& batch);
+    void flushSpill();
+    size_t samplesPerShard() const;
+    void updatePeakUsage(uint64_t current);
+    MemorySnapshot sampleCounters() const;
     void takeTimelineSnapshot();
+    void samplerLoop();
+    Pool& poolFor(uint32_t device_id, uint32_t allocator_id);
     FragmentationInfo calculateFragmentation() const;
 };
 
@@ -2,6 +2,7 @@
 
 #include "tracesmith/common/types.hpp"
 #include "tracesmith/common/ring_buffer.hpp"
+#include "tracesmith/capture/event_sampler.hpp"
 #include <functional>
 #include <memory>
 #include <string>
@@ -25,6 +26,9 @@ struct ProfilerConfig {
     bool capture_memset = true;
     bool capture_sync = true;
     bool capture_alloc = true;
+    
+    // Name-based filtering and sampling, applied before buffering
+    SamplingConfig sampling;
 };
 
 /// Callback type for event notification
@@ -97,6 +101,17 @@ public:
     /// Get statistics
     virtual uint64_t eventsCaptured() const = 0;
     virtual uint64_t eventsDropped() const = 0;
+    
+    /// Counts of events removed by capture-time filtering and sampling
+    /// (not included in eventsCaptured() or eventsDropped())
+    SamplingCounters samplingTotals() const { return sampler_.totals(); }
+    std::unordered_map<std::string, SamplingCounters> samplingByName() const {
+        return sampler_.countersByName();
+    }
+
+protected:
+    /// Configured in initialize(); every event goes through admit() first
+    EventSampler sampler_;
 };
 
 /**
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tracesmith {
+
+/**
+ * Resolve a requested worker count.
+ * 
+ * @param requested 0 = use hardware concurrency, otherwise the exact count
+ * @return Number of worker threads to use (always >= 1)
+ */
+inline size_t resolveThreadCount(size_t requested) {
+    if (requested != 0) {
+        return requested;
+    }
+    size_t hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+}
+
+/**
+ * Run fn(i) for every i in [0, count) on up to num_threads threads.
+ * 
+ * Work items are handed out dynamically, so uneven items (e.g. streams
+ * with very different event counts) still balance across workers. The
+ * calling thread participates as one of the workers. The first exception
+ * thrown by any item is rethrown on the calling thread after all workers
+ * have joined.
+ * 
+ * @param count Number of work items
+ * @param num_threads Worker count (0 = hardware concurrency)
+ * @param fn Callable invoked as fn(size_t index)
+ */
+template<typename Fn>
+void parallelFor(size_t count, size_t num_threads, Fn&& fn) {
+    size_t workers = std::min(resolveThreadCount(num_threads), count);
+    
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+    
+    std::atomic<size_t> next_index{0};
+    std::exception_ptr first_error;
+    std::mutex error_mutex;
+    
+    auto worker = [&]() {
+        for (;;) {
+            size_t i = next_index.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count) {
+                return;
+            }
+            try {
+                fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!first_error) {
+                    first_error = std::current_exception();
+                }
+            }
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t t = 1; t < workers; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    if (first_error) {
+        std::rethrow_exception(first_error);
+    }
+}
+
+} // namespace tracesmith
@@ -16,6 +16,13 @@
  * - FDR (Flight Data Recorder) format
  * - Basic mode entries
  * 
+ * Files are memory-mapped and decoded without copying. Enter/exit
+ * records are matched per thread in record order (FDR buffers of one
+ * thread are independent of other threads' buffers, so threads decode in
+ * parallel), and the per-thread results are merged by timestamp. Apart
+ * from the returned events, memory grows with the number of threads and
+ * the call depth, not with the file size.
+ * 
  * Usage:
  *   // Build target with -fxray-instrument
  *   // Run: XRAY_OPTIONS="patch_premain=true xray_mode=xray-basic" ./target
@@ -92,7 +99,9 @@ public:
         bool include_custom_events = true;  // Include custom events
         bool filter_short_calls = false;    // Filter calls < min_duration_ns
         uint64_t min_duration_ns = 0;       // Minimum duration filter
-        std::string symbol_file;            // Path to debug symbols
+        std::string symbol_file;            // Instrumented binary, for function names
+        bool use_symbol_cache = true;       // Reuse/write <symbol_file>.xray-symbols
+        bool keep_raw_records = false;      // Retain records for getRawRecords()
         
         Config() = default;
     };
@@ -123,7 +132,8 @@ public:
     /// @return Vector of TraceSmith events
     std::vector<TraceEvent> importBuffer(const uint8_t* data, size_t size);
     
-    /// Get raw XRay records (before conversion)
+    /// Get raw XRay records (before conversion), grouped by thread
+    /// Only filled when Config::keep_raw_records is set
     const std::vector<XRayFunctionRecord>& getRawRecords() const { 
         return raw_records_; 
     }
@@ -140,15 +150,36 @@ public:
     /// Set configuration
     void setConfig(const Config& config) { config_ = config; }
     
+    /**
+     * Set worker threads used for decoding
+     * 
+     * FDR logs hold one buffer sequence per thread; with more than one
+     * worker, threads are decoded and converted concurrently. Results are
+     * identical to the serial path.
+     * 
+     * @param num_threads 1 = serial (default), 0 = hardware concurrency
+     */
+    void setParallelism(size_t num_threads) { num_threads_ = num_threads; }
+    size_t parallelism() const { return num_threads_; }
+    
     /// Check if XRay support is available
     /// (Always true - XRay parsing doesn't require external dependencies)
     static bool isAvailable() { return true; }
 
 private:
+    // Matched calls of one thread, defined in xray_importer.cpp
+    struct ThreadCalls;
+    
     Config config_;
     Statistics stats_;
     XRayFileHeader header_;
     std::vector<XRayFunctionRecord> raw_records_;
+    size_t num_threads_ = 1;
+    
+    // Layout found by parseHeader()
+    size_t data_offset_ = 0;          // First byte after the file header
+    bool llvm_header_ = false;        // 32-byte LLVM header (vs legacy/none)
+    uint64_t fdr_buffer_size_ = 0;    // Fixed buffer size of FDR version 1
     
     // Function ID -> name mapping
     std::unordered_map<uint32_t, std::string> function_map_;
@@ -157,19 +188,18 @@ private:
     bool parseHeader(const uint8_t* data, size_t size);
     
     // Parse basic mode records
-    bool parseBasicMode(const uint8_t* data, size_t size);
+    bool parseBasicMode(const uint8_t* data, size_t size,
+                        std::vector<ThreadCalls>& threads);
     
     // Parse FDR (Flight Data Recorder) mode records
-    bool parseFDRMode(const uint8_t* data, size_t size);
+    bool parseFDRMode(const uint8_t* data, size_t size,
+                      std::vector<ThreadCalls>& threads);
     
-    // Convert XRay records to TraceEvents
-    std::vector<TraceEvent> convertToEvents();
+    // Convert matched calls to TraceEvents, merged by timestamp
+    std::vector<TraceEvent> convertToEvents(std::vector<ThreadCalls>& threads);
     
     // Resolve function symbols
-    void resolveSymbols();
-    
-    // Match function enter/exit pairs
-    void matchPairs(std::vector<TraceEvent>& events);
+    void resolveSymbols(const std::vector<ThreadCalls>& threads);
     
     // Convert TSC to nanoseconds
     uint64_t tscToNanoseconds(uint64_t tsc) const;
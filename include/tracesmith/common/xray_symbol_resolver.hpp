@@ -0,0 +1,101 @@
+#pragma once
+
+/**
+ * XRay function ID resolution from an instrumented binary
+ *
+ * XRay numbers instrumented functions by their order in the binary's
+ * xray_instr_map section: the sleds of one function are contiguous, and
+ * IDs start at 1. The resolver reads that section and the ELF symbol
+ * tables once, names every function by binary search over the
+ * address-sorted symbols, and keeps the result as a table indexed by
+ * function ID.
+ *
+ * The table can be saved next to the binary (<binary>.xray-symbols) and
+ * is reused while the binary's size and modification time (to the
+ * nanosecond where the filesystem records it) match, so
+ * importing one log per rank does not repeat the ELF work. Within a
+ * process, forBinary() shares one resolver per binary.
+ *
+ * Supports 64-bit little-endian ELF (x86-64, AArch64), with both the
+ * PC-relative sled layout of current LLVM and the older absolute layout.
+ * Table sizes in the binary and the cache are checked against the file
+ * size before anything is allocated, so corrupt input just fails to load.
+ *
+ * Usage:
+ *   auto resolver = XRaySymbolResolver::forBinary("./app");
+ *   if (resolver) {
+ *       const std::string* name = resolver->functionName(function_id);
+ *   }
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tracesmith {
+
+class XRaySymbolResolver {
+public:
+    /// An instrumented function
+    struct Function {
+        uint64_t address = 0;
+        std::string name;           // Demangled; empty if no symbol covers it
+    };
+
+    /// Build the table from an ELF binary
+    bool loadBinary(const std::string& binary_path);
+
+    /// Read a saved table; fails if it was built from a different binary
+    bool loadCache(const std::string& cache_path, const std::string& binary_path);
+
+    /// Save the table for binary_path (written to a temporary, then renamed)
+    bool saveCache(const std::string& cache_path, const std::string& binary_path) const;
+
+    /// Load from the cache next to the binary, else from the binary
+    /// (then saving the cache where the directory is writable)
+    bool load(const std::string& binary_path, bool use_cache = true);
+
+    /// Where load() keeps the cache for a binary
+    static std::string cachePath(const std::string& binary_path) {
+        return binary_path + ".xray-symbols";
+    }
+
+    /**
+     * Resolver for a binary, built once per process and shared
+     * Rebuilt if the binary changes. Returns nullptr if it cannot be read.
+     */
+    static std::shared_ptr<const XRaySymbolResolver> forBinary(const std::string& binary_path,
+                                                                bool use_cache = true);
+
+    /// Name of a function ID, or nullptr if the ID or its symbol is unknown
+    const std::string* functionName(uint32_t function_id) const {
+        if (function_id == 0 || function_id > functions_.size() ||
+            functions_[function_id - 1].name.empty()) {
+            return nullptr;
+        }
+        return &functions_[function_id - 1].name;
+    }
+
+    /// Entry address of a function ID (0 if unknown)
+    uint64_t functionAddress(uint32_t function_id) const {
+        if (function_id == 0 || function_id > functions_.size()) {
+            return 0;
+        }
+        return functions_[function_id - 1].address;
+    }
+
+    /// Functions in the instrumentation map; IDs are 1..functionCount()
+    size_t functionCount() const { return functions_.size(); }
+
+    /// Why the last load failed
+    const std::string& error() const { return error_; }
+
+private:
+    std::vector<Function> functions_;   // Index = function ID - 1
+    std::string error_;
+
+    bool fail(const std::string& message);
+};
+
+} // namespace tracesmith
@@ -179,7 +179,14 @@ public:
     /// Read only metadata
     SBTResult readMetadata(TraceMetadata& metadata);
     
-    /// Read events in batches (for large files)
+    /**
+     * Read events in batches (for large files)
+     * 
+     * Appends up to `count` events starting at event index `offset`.
+     * Consecutive calls that continue where the previous batch ended
+     * resume from the current file position, so reading a file batch by
+     * batch is a single sequential pass.
+     */
     SBTResult readEvents(std::vector<TraceEvent>& events, 
                          size_t offset, size_t count);
     
@@ -193,6 +200,12 @@ private:
     std::vector<std::string> string_table_;
     bool header_read_;
     
+    // Batch read cursor (event index and stream position of the next event)
+    bool cursor_valid_ = false;
+    uint64_t cursor_index_ = 0;
+    uint64_t cursor_timestamp_ = 0;
+    std::streampos cursor_pos_;
+    
     // Internal methods
     uint64_t readVarInt();
     std::string readString();
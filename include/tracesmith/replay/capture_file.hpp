@@ -0,0 +1,226 @@
+#pragma once
+
+#include "tracesmith/replay/frame_capture.hpp"
+#include "tracesmith/format/sbt_format.hpp"
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tracesmith {
+
+/// Frame capture file format constants
+namespace fcap {
+    constexpr char MAGIC[4] = {'T', 'S', 'F', 'C'};
+    constexpr uint16_t FORMAT_VERSION_MAJOR = 0;
+    constexpr uint16_t FORMAT_VERSION_MINOR = 1;
+    
+    // Flags
+    constexpr uint32_t FLAG_LITTLE_ENDIAN = 0x01;
+}
+
+#pragma pack(push, 1)
+/// Frame capture file header (fixed size: 64 bytes)
+struct CaptureFileHeader {
+    char magic[4];              // "TSFC"
+    uint16_t version_major;
+    uint16_t version_minor;
+    uint32_t flags;
+    uint32_t header_size;
+    uint32_t chunk_size;        // Chunk size of the capture's ChunkStore
+    uint64_t index_offset;      // Offset to the index (end of file)
+    uint64_t index_size;
+    uint64_t frame_count;
+    uint64_t chunk_count;
+    uint64_t version_count;     // Distinct resource versions
+    uint8_t reserved[4];
+    
+    CaptureFileHeader() {
+        std::memcpy(magic, fcap::MAGIC, 4);
+        version_major = fcap::FORMAT_VERSION_MAJOR;
+        version_minor = fcap::FORMAT_VERSION_MINOR;
+        flags = fcap::FLAG_LITTLE_ENDIAN;
+        header_size = sizeof(CaptureFileHeader);
+        chunk_size = 0;
+        index_offset = 0;
+        index_size = 0;
+        frame_count = 0;
+        chunk_count = 0;
+        version_count = 0;
+        std::memset(reserved, 0, sizeof(reserved));
+    }
+    
+    bool isValid() const {
+        return std::memcmp(magic, fcap::MAGIC, 4) == 0;
+    }
+};
+#pragma pack(pop)
+
+/**
+ * Frame capture file writer
+ * 
+ * File layout:
+ *   header | chunk data | resource version records | per frame: events,
+ *   draw call records | index
+ * 
+ * Each distinct chunk and each distinct resource version is written once,
+ * however many draw calls and frames share it. Draw call records hold the
+ * draw parameters and the versions changed by that draw. The index at the
+ * end holds fixed-size tables only (chunk locations sorted by ID, version
+ * offsets, per-frame draw offsets, initial/final states and version
+ * chains), so a reader opens a file by reading the header and the index.
+ * 
+ * Usage:
+ *   CaptureFileWriter writer("frame.tsfc");
+ *   writer.writeCapture(capture);
+ */
+class CaptureFileWriter {
+public:
+    explicit CaptureFileWriter(const std::string& filename);
+    
+    /// Check if the writer is ready
+    bool isOpen() const { return file_.is_open(); }
+    
+    /// Write all captured frames with their resource versions and contents
+    SBTResult writeCapture(const FrameCapture& capture);
+    
+    /// Get the number of bytes written
+    uint64_t fileSize() const { return position_; }
+
+private:
+    std::ofstream file_;
+    std::string filename_;
+    uint64_t position_ = 0;
+    
+    void writeBytes(const void* data, size_t size);
+};
+
+/**
+ * Frame capture file reader with lazy loading
+ * 
+ * Opening reads only the header and the index. Draw calls, resource
+ * versions, contents and events are read from the file on request, so a
+ * single draw call's state costs a few seeks regardless of capture size.
+ * 
+ * Not thread-safe (reads share one file position).
+ * 
+ * Usage:
+ *   CaptureFileReader reader("frame.tsfc");
+ *   auto state = reader.readResourceStateAt(1, draw_id, buffer_id);
+ *   reader.readResourceData(*state, bytes);
+ */
+class CaptureFileReader {
+public:
+    /// Per-frame information held in the index
+    struct FrameSummary {
+        uint64_t frame_number = 0;
+        Timestamp start_time = 0;
+        Timestamp end_time = 0;
+        uint64_t total_draw_calls = 0;
+        uint64_t total_dispatches = 0;
+        uint64_t total_memory_ops = 0;
+        uint64_t total_sync_ops = 0;
+        uint64_t resource_versions = 0;
+        uint64_t event_count = 0;
+        uint64_t draw_count = 0;
+    };
+    
+    explicit CaptureFileReader(const std::string& filename);
+    
+    /// Check if the file was opened and its index loaded
+    bool isValid() const { return valid_; }
+    
+    /// Reason the file could not be opened or the last read failed
+    const std::string& lastError() const { return last_error_; }
+    
+    /// Get the file header
+    const CaptureFileHeader& header() const { return header_; }
+    
+    /// Frames in the file, in capture order
+    std::vector<FrameSummary> frames() const;
+    
+    /// Get a frame's summary (nullptr if not in the file)
+    const FrameSummary* frame(uint64_t frame_number) const;
+    
+    /// Draw call IDs of a frame, in draw order
+    std::vector<uint64_t> drawCallIds(uint64_t frame_number) const;
+    
+    /**
+     * Read one draw call and, optionally, the resource versions it changed
+     */
+    bool readDrawCall(uint64_t frame_number, uint64_t draw_call_id,
+                      DrawCallInfo& draw,
+                      std::vector<ResourceState>* changed = nullptr);
+    
+    /**
+     * Get resource state at a draw call (same semantics as
+     * FrameCapture::getResourceStateAt)
+     */
+    std::optional<ResourceState> readResourceStateAt(
+        uint64_t frame_number, uint64_t draw_call_id, uint64_t resource_id);
+    
+    /// Reassemble captured contents of a resource version
+    bool readResourceData(const ResourceState& state, std::vector<uint8_t>& out);
+    
+    /// Read a frame's trace events
+    bool readEvents(uint64_t frame_number, std::vector<TraceEvent>& events);
+    
+    /**
+     * Load a whole frame. Resource contents stay in the file; read them
+     * with readResourceData().
+     */
+    bool loadFrame(uint64_t frame_number, CapturedFrame& frame);
+
+private:
+    struct DrawEntry {
+        uint64_t call_id;
+        uint64_t offset;
+        uint64_t size;
+    };
+    
+    struct ChainEntry {
+        uint64_t resource_id;
+        uint64_t draw_index;
+        uint64_t version;
+    };
+    
+    struct FrameIndex {
+        FrameSummary summary;
+        uint64_t events_offset = 0;
+        uint64_t events_size = 0;
+        std::vector<DrawEntry> draws;
+        std::unordered_map<uint64_t, uint32_t> draw_lookup;         // call_id -> draw index
+        std::vector<std::pair<uint64_t, uint64_t>> initial_state;   // (resource_id, version), sorted
+        std::vector<std::pair<uint64_t, uint64_t>> final_state;
+        std::vector<ChainEntry> chains;                             // Sorted by (resource, draw)
+    };
+    
+    struct ChunkEntry {
+        uint64_t id;
+        uint64_t offset;
+        uint64_t size;
+    };
+    
+    std::ifstream file_;
+    CaptureFileHeader header_;
+    bool valid_ = false;
+    std::string last_error_;
+    uint64_t file_size_ = 0;                        // Bound for every offset read from the index
+    
+    std::vector<ChunkEntry> chunks_;                // Sorted by ID
+    std::vector<uint64_t> version_offsets_;         // version_count + 1 entries
+    std::vector<FrameIndex> frames_;
+    
+    bool readIndex();
+    bool readBlock(uint64_t offset, uint64_t size, std::vector<uint8_t>& out);
+    bool readVersion(uint64_t version, ResourceState& state);
+    bool readDrawRecord(const DrawEntry& entry, DrawCallInfo& draw,
+                        std::vector<uint64_t>* changed, bool& has_delta);
+    FrameIndex* findFrame(uint64_t frame_number);
+    const FrameIndex* findFrame(uint64_t frame_number) const;
+    bool fail(const std::string& error);
+};
+
+} // namespace tracesmith
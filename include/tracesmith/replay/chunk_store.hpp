@@ -0,0 +1,135 @@
+#pragma once
+
+#include "tracesmith/common/types.hpp"
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tracesmith {
+
+/// 64-bit content hash (XXH64 algorithm)
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+/// Contents of a buffer as a list of content-addressed chunks
+struct ChunkList {
+    std::vector<uint64_t> chunks;   // Chunk IDs, in buffer order
+    uint64_t size = 0;              // Total bytes
+    
+    bool empty() const { return size == 0; }
+    
+    bool operator==(const ChunkList& other) const {
+        return size == other.size && chunks == other.chunks;
+    }
+    bool operator!=(const ChunkList& other) const { return !(*this == other); }
+};
+
+/**
+ * Content-Addressed Chunk Store
+ * 
+ * Splits buffer contents into fixed-size chunks and stores each distinct
+ * chunk once, keyed by its hash. Rewriting a buffer with identical or
+ * mostly identical contents only stores the chunks that changed, across
+ * draw calls and frames alike. Hash matches are verified byte-for-byte;
+ * colliding chunks get a different ID.
+ * 
+ * With a resident limit and a spill path, the oldest chunks are appended
+ * to a spill file and read back on demand, so captures larger than memory
+ * stay usable.
+ * 
+ * Thread-safe.
+ */
+class ChunkStore {
+public:
+    struct Config {
+        size_t chunk_size = 64 * 1024;      // Bytes per chunk (last chunk may be shorter)
+        size_t max_resident_bytes = 0;      // Spill above this (0 = keep everything in memory)
+        std::string spill_path;             // Spill file (required for spilling)
+    };
+    
+    struct Statistics {
+        uint64_t logical_bytes = 0;         // Bytes submitted
+        uint64_t stored_bytes = 0;          // Bytes of distinct chunks
+        uint64_t unique_chunks = 0;
+        uint64_t duplicate_chunks = 0;      // Submitted chunks that were already stored
+        uint64_t resident_bytes = 0;        // Chunk bytes held in memory
+        uint64_t spilled_bytes = 0;         // Chunk bytes written to the spill file
+        uint64_t ingest_time_ns = 0;        // Time spent in put()/patch()
+        
+        /// Logical bytes per stored byte (1.0 = no duplication found)
+        double dedupRatio() const {
+            return stored_bytes > 0 ? static_cast<double>(logical_bytes) / stored_bytes : 1.0;
+        }
+        
+        /// Ingest cost per MB submitted (ns)
+        double overheadNsPerMB() const {
+            return logical_bytes > 0 ?
+                static_cast<double>(ingest_time_ns) * (1024.0 * 1024.0) / logical_bytes : 0.0;
+        }
+    };
+    
+    ChunkStore();
+    explicit ChunkStore(Config config);
+    ~ChunkStore();
+    
+    ChunkStore(const ChunkStore&) = delete;
+    ChunkStore& operator=(const ChunkStore&) = delete;
+    
+    /**
+     * Store a buffer
+     */
+    ChunkList put(const void* data, size_t size);
+    
+    /**
+     * Store `base` with [offset, offset + size) overwritten by `data`
+     * 
+     * Only the chunks overlapping the range are read and rehashed. The
+     * buffer grows if the range extends past its end.
+     */
+    ChunkList patch(const ChunkList& base, uint64_t offset, const void* data, size_t size);
+    
+    /**
+     * Reassemble a buffer
+     * @return false if a chunk is unknown or cannot be read back
+     */
+    bool read(const ChunkList& list, std::vector<uint8_t>& out) const;
+    
+    /**
+     * Read one chunk
+     */
+    bool readChunk(uint64_t id, std::vector<uint8_t>& out) const;
+    
+    /// Check if a chunk is stored
+    bool contains(uint64_t id) const;
+    
+    Statistics getStatistics() const;
+    const Config& getConfig() const { return config_; }
+    
+    /// Drop all chunks and truncate the spill file
+    void clear();
+
+private:
+    struct Chunk {
+        std::vector<uint8_t> data;          // Empty once spilled
+        uint64_t spill_offset = 0;
+        uint32_t size = 0;
+        bool spilled = false;
+    };
+    
+    Config config_;
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, Chunk> chunks_;
+    std::deque<uint64_t> resident_order_;   // Spill candidates, oldest first
+    mutable std::fstream spill_;
+    Statistics stats_;
+    
+    // Caller holds mutex_
+    uint64_t storeChunk(const uint8_t* data, size_t size);
+    bool loadChunk(const Chunk& chunk, std::vector<uint8_t>& out) const;
+    void spillIfNeeded();
+};
+
+} // namespace tracesmith
@@ -2,15 +2,63 @@
 
 #include "tracesmith/replay/replay_config.hpp"
 #include "tracesmith/common/types.hpp"
-#include <vector>
+#include <cstdint>
+#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace tracesmith {
 
+/**
+ * Structured comparison of an original and a replayed operation sequence
+ * 
+ * Operations are matched by identity (operation ID for replays, name /
+ * type / device / stream plus occurrence number for trace files). The
+ * longest common subsequence is taken over matched operations, so every
+ * matched operation outside it was reordered.
+ */
+struct DeterminismDiff {
+    static constexpr size_t kNoDivergence = SIZE_MAX;
+    
+    size_t original_count = 0;
+    size_t replayed_count = 0;
+    
+    /// Index of the first position where the sequences differ
+    size_t first_divergence = kNoDivergence;
+    std::string expected;                    // Original op at first_divergence ("" past the end)
+    std::string actual;                      // Replayed op at first_divergence ("" past the end)
+    
+    size_t matched_operations = 0;
+    size_t missing_operations = 0;           // Original ops never replayed
+    size_t extra_operations = 0;             // Replayed ops absent from the original
+    
+    /// Longest common subsequence, as indices into the original sequence
+    std::vector<size_t> common_subsequence;
+    
+    /// Matched ops per stream that are out of order within their stream
+    std::map<uint32_t, size_t> stream_reorders;
+    
+    bool identical() const {
+        return first_divergence == kNoDivergence;
+    }
+    
+    /// Matched ops outside the common subsequence (cross-stream interleaving included)
+    size_t reorderedOperations() const {
+        return matched_operations - common_subsequence.size();
+    }
+    
+    std::string summary() const;
+};
+
 /**
  * Determinism Checker
  * 
  * Validates that replay execution matches the original captured trace.
+ * 
+ * Only compact per-operation records are kept: replayed operations are
+ * indexed by operation ID with their execution sequence number, so order
+ * and dependency validation are single linear passes.
  */
 class DeterminismChecker {
 public:
@@ -22,12 +70,13 @@ public:
     void recordOriginal(const StreamOperation& op);
     
     /**
-     * Record replayed operation
+     * Record replayed operation (in execution order)
      */
     void recordReplayed(const StreamOperation& op);
     
     /**
-     * Validate operation order matches
+     * Validate that every stream replayed its operations in captured
+     * order (interleaving across streams is free)
      */
     bool validateOrder();
     
@@ -36,6 +85,26 @@ public:
      */
     bool validateDependencies();
     
+    /**
+     * Compare the recorded sequences: first divergence, longest common
+     * subsequence and per-stream reorder counts
+     */
+    DeterminismDiff diff() const;
+    
+    /**
+     * Compare two SBT files event by event
+     * 
+     * Both files are read in batches of `batch_size` events; only a
+     * 64-bit key and stream ID per event are kept in memory.
+     * 
+     * @return false if either file cannot be read
+     */
+    static bool compareFiles(const std::string& original_file,
+                             const std::string& replayed_file,
+                             DeterminismDiff& diff,
+                             std::string* error = nullptr,
+                             size_t batch_size = 65536);
+    
     /**
      * Get validation report
      */
@@ -58,11 +127,43 @@ public:
     void reset();
 
 private:
-    std::vector<StreamOperation> original_ops_;
-    std::vector<StreamOperation> replayed_ops_;
+    static constexpr size_t kNotReplayed = SIZE_MAX;
+    
+    /// Compact operation identity (no event copy)
+    struct OpRecord {
+        size_t operation_id = 0;
+        uint32_t name_id = 0;
+        uint32_t device_id = 0;
+        uint32_t stream_id = 0;
+        EventType type = EventType::Unknown;
+        bool executed = false;
+        Timestamp execution_time = 0;
+    };
+    
+    std::vector<OpRecord> original_ops_;
+    std::vector<OpRecord> replayed_ops_;
+    
+    // Dependencies of replayed ops (CSR: replayed_ops_[i] owns
+    // dep_ids_[dep_offsets_[i] .. dep_offsets_[i + 1]))
+    std::vector<size_t> dep_offsets_{0};
+    std::vector<size_t> dep_ids_;
+    
+    // Operation ID -> replay sequence number (dense array indexed by
+    // ID - id_base_, hash map for outliers)
+    size_t id_base_ = 0;
+    std::vector<size_t> replay_seq_;
+    std::unordered_map<size_t, size_t> sparse_replay_seq_;
+    
+    // Interned operation names
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, uint32_t> name_index_;
+    
     Violations violations_;
     
-    bool checkOperationMatch(const StreamOperation& orig, const StreamOperation& replay);
+    uint32_t internName(const std::string& name);
+    OpRecord makeRecord(const StreamOperation& op);
+    size_t replaySequence(size_t operation_id) const;
+    bool checkOperationMatch(const OpRecord& orig, const OpRecord& replay) const;
 };
 
 } // namespace tracesmith
@@ -17,11 +17,14 @@
  */
 
 #include "tracesmith/common/types.hpp"
+#include "tracesmith/replay/chunk_store.hpp"
 #include <vector>
 #include <map>
 #include <memory>
 #include <functional>
 #include <optional>
+#include <unordered_map>
+#include <utility>
 
 namespace tracesmith {
 
@@ -54,7 +57,7 @@ struct ResourceState {
     // Memory state
     uint64_t address;
     uint64_t size;
-    std::vector<uint8_t> data;  // Optional: actual data snapshot
+    ChunkList contents;     // Optional: contents snapshot (chunks in FrameCapture's ChunkStore)
     
     // Texture-specific
     uint32_t width = 0;
@@ -76,6 +79,16 @@ struct ResourceState {
                       address(0), size(0), last_modified(0) {}
 };
 
+/// Immutable, reference-counted snapshot of one resource. Unchanged
+/// resources share one version across draw calls and frames.
+using ResourceVersion = std::shared_ptr<const ResourceState>;
+
+/// Resources modified since the previous draw call (or frame start)
+struct DrawStateDelta {
+    uint64_t call_id = 0;
+    std::vector<ResourceVersion> changed;
+};
+
 /// Draw call information
 struct DrawCallInfo {
     uint64_t call_id;
@@ -124,28 +137,48 @@ struct CapturedFrame {
     std::vector<DrawCallInfo> draw_calls;
     
     // Resource states at frame start
-    std::map<uint64_t, ResourceState> initial_state;
+    std::map<uint64_t, ResourceVersion> initial_state;
     
     // Resource states at frame end
-    std::map<uint64_t, ResourceState> final_state;
+    std::map<uint64_t, ResourceVersion> final_state;
     
-    // Per-draw-call resource changes
-    std::map<uint64_t, std::map<uint64_t, ResourceState>> state_history;
+    // Per-draw-call resource changes, in draw order
+    std::vector<DrawStateDelta> state_deltas;
+    
+    // Lookup indexes over state_deltas: draw call -> delta index, and
+    // resource -> (delta index, version) in draw order
+    std::unordered_map<uint64_t, uint32_t> draw_index;
+    std::unordered_map<uint64_t, std::vector<std::pair<uint32_t, ResourceVersion>>> version_chains;
     
     // Statistics
     uint64_t total_draw_calls = 0;
     uint64_t total_dispatches = 0;
     uint64_t total_memory_ops = 0;
     uint64_t total_sync_ops = 0;
+    uint64_t resource_versions = 0;     // Versions recorded in state_deltas
     
     CapturedFrame() : frame_number(0), start_time(0), end_time(0) {}
     
     /// Get duration in nanoseconds
     Timestamp duration() const { return end_time - start_time; }
     
+    /// Check if a draw call has recorded state
+    bool hasDrawCall(uint64_t draw_call_id) const {
+        return draw_index.count(draw_call_id) > 0;
+    }
+    
+    /**
+     * Get the resource version current at a draw call (O(log changes)).
+     * Unknown draw calls fall back to the frame's initial state.
+     */
+    ResourceVersion getResourceVersionAt(uint64_t resource_id, uint64_t draw_call_id) const;
+    
     /// Get resource state at a specific draw call
     std::optional<ResourceState> getResourceStateAt(
         uint64_t resource_id, uint64_t draw_call_id) const;
+    
+    /// Append a draw call's delta and index it
+    void addDelta(DrawStateDelta delta);
 };
 
 /// Frame capture configuration
@@ -165,6 +198,9 @@ struct FrameCaptureConfig {
     size_t max_buffer_capture_size = 64 * 1024 * 1024;  // 64MB
     size_t max_texture_capture_size = 256 * 1024 * 1024; // 256MB
     
+    // Deduplicated storage for captured contents (chunk size, spill file)
+    ChunkStore::Config chunk_store;
+    
     FrameCaptureConfig() = default;
 };
 
@@ -192,8 +228,8 @@ public:
     FrameCapture(const FrameCapture&) = delete;
     FrameCapture& operator=(const FrameCapture&) = delete;
     
-    /// Configure capture
-    void setConfig(const FrameCaptureConfig& config) { config_ = config; }
+    /// Configure capture (chunk store settings are ignored once it holds chunks)
+    void setConfig(const FrameCaptureConfig& config);
     const FrameCaptureConfig& getConfig() const { return config_; }
     
     /// Trigger capture (like pressing F12 in RenderDoc)
@@ -225,6 +261,11 @@ public:
     void recordResourceUpdate(uint64_t resource_id, 
                               const void* data, size_t size);
     
+    /// Record a partial update of [offset, offset + size); only the
+    /// chunks overlapping the range are rehashed
+    void recordResourceUpdate(uint64_t resource_id, uint64_t offset,
+                              const void* data, size_t size);
+    
     /// Record a resource binding
     void recordResourceBind(uint64_t resource_id, 
                            bool as_input, bool as_output);
@@ -247,11 +288,19 @@ public:
     /// Get resource by ID
     const ResourceState* getResource(uint64_t resource_id) const;
     
-    /// Get all resources
-    const std::map<uint64_t, ResourceState>& getResources() const {
+    /// Get all resources (current versions)
+    const std::map<uint64_t, ResourceVersion>& getResources() const {
         return resources_;
     }
     
+    /// Reassemble captured contents of a resource version
+    bool readResourceData(const ResourceState& state, std::vector<uint8_t>& out) const {
+        return chunk_store_->read(state.contents, out);
+    }
+    
+    /// Deduplicated contents storage (dedup ratio, capture overhead)
+    const ChunkStore& getChunkStore() const { return *chunk_store_; }
+    
     // ========================================================================
     // Replay Support
     // ========================================================================
@@ -287,9 +336,12 @@ public:
     /// Export captured frame to RenderDoc-compatible format (RDC)
     bool exportToRDC(const std::string& filename, uint64_t frame_number);
     
-    /// Export to Perfetto trace
+    /// Export to Perfetto trace (frame events plus one marker per draw call)
     bool exportToPerfetto(const std::string& filename, uint64_t frame_number);
     
+    /// Save all captured frames to a frame capture file (see CaptureFileReader)
+    bool saveCapture(const std::string& filename) const;
+    
 private:
     FrameCaptureConfig config_;
     CaptureState state_ = CaptureState::Idle;
@@ -301,7 +353,14 @@ private:
     
     // Captured data
     std::vector<CapturedFrame> captured_frames_;
-    std::map<uint64_t, ResourceState> resources_;
+    std::map<uint64_t, ResourceVersion> resources_;
+    
+    // Versions modified since the last snapshot. No frame references them
+    // yet, so they are updated in place; published versions are copied.
+    std::map<uint64_t, std::shared_ptr<ResourceState>> unpublished_;
+    
+    // Buffer contents, shared across versions, draws and frames
+    std::unique_ptr<ChunkStore> chunk_store_;
     
     // Callbacks
     FrameCaptureCallback on_frame_captured_;
@@ -311,7 +370,13 @@ private:
     void beginCapture();
     void endCapture();
     void finalizeFrame();
-    void snapshotResources(std::map<uint64_t, ResourceState>& out);
+    void snapshotResources(std::map<uint64_t, ResourceVersion>& out);
+    
+    // Writable version of a resource (copy-on-write), nullptr if unknown
+    ResourceState* mutableResource(uint64_t resource_id);
+    
+    // Move unpublished versions into a draw call delta
+    DrawStateDelta takeDelta(uint64_t call_id);
 };
 
 /// Resource tracker for monitoring GPU resource lifecycle
@@ -2,6 +2,7 @@
 
 #include "tracesmith/replay/replay_config.hpp"
 #include "tracesmith/common/types.hpp"
+#include <functional>
 
 namespace tracesmith {
 
@@ -31,6 +32,11 @@ public:
      */
     bool isDryRun() const { return dry_run_; }
     
+    /**
+     * Extra check run after each operation (see ReplayConfig::on_execute)
+     */
+    void setHook(std::function<bool(const StreamOperation&)> hook) { hook_ = std::move(hook); }
+    
     /**
      * Get execution metrics
      */
@@ -52,6 +58,7 @@ public:
 private:
     bool dry_run_;
     Metrics metrics_;
+    std::function<bool(const StreamOperation&)> hook_;
     
     // Execution handlers
     bool executeKernel(const TraceEvent& event);
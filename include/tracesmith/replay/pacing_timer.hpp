@@ -0,0 +1,89 @@
+#pragma once
+
+#include "tracesmith/replay/replay_config.hpp"
+#include "tracesmith/common/types.hpp"
+#include <array>
+#include <chrono>
+
+namespace tracesmith {
+
+/**
+ * Pacing Timer
+ * 
+ * Maps captured timestamps onto a monotonic replay clock and blocks until
+ * each operation is due. Waits sleep until shortly before the deadline and
+ * busy-spin for the final stretch, so dispatch jitter stays well below the
+ * OS sleep granularity at the cost of a little CPU per dispatch.
+ * 
+ * Lateness of every dispatch relative to its deadline is summarized by
+ * jitterStats(). Only the count, sum, maximum and a log-linear histogram
+ * (16 buckets per power of two, so percentiles are within 1/16) are kept,
+ * so memory stays fixed however many operations are replayed.
+ */
+class PacingTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    /**
+     * @param time_scale Replay speed (2.0 = twice as fast); <= 0 disables waiting
+     * @param spin_threshold_ns Final stretch of each wait that is spun, not slept
+     */
+    explicit PacingTimer(double time_scale = 1.0, Timestamp spin_threshold_ns = 200000);
+    
+    /**
+     * Anchor captured timestamp `origin` to the current replay clock time
+     */
+    void start(Timestamp origin);
+    
+    /**
+     * Replay-clock offset (ns since start) at which `captured` is due
+     */
+    Timestamp targetOffset(Timestamp captured) const;
+    
+    /**
+     * Block until `captured` is due and record dispatch lateness
+     * @return Lateness of this dispatch (ns)
+     */
+    Timestamp waitUntil(Timestamp captured);
+    
+    /**
+     * Nanoseconds since start()
+     */
+    Timestamp elapsed() const;
+    
+    /**
+     * Add another timer's lateness statistics (e.g. per-worker copies)
+     */
+    void merge(const PacingTimer& other);
+    
+    /**
+     * Summarize recorded dispatch lateness
+     */
+    DispatchJitterStats jitterStats() const;
+    
+    /**
+     * Hybrid sleep/spin wait until `deadline`
+     */
+    static void sleepUntil(Clock::time_point deadline, Timestamp spin_threshold_ns);
+
+private:
+    double time_scale_;
+    Timestamp spin_threshold_ns_;
+    Timestamp origin_ = 0;
+    Clock::time_point start_;
+    
+    // Lateness statistics
+    static constexpr size_t kSubBuckets = 16;
+    static constexpr size_t kBuckets = kSubBuckets + 60 * kSubBuckets;
+    size_t samples_ = 0;
+    long double total_ = 0;
+    Timestamp max_ = 0;
+    std::array<uint64_t, kBuckets> histogram_{};
+    
+    void record(Timestamp late);
+    static size_t bucketOf(Timestamp value);
+    static Timestamp bucketUpperBound(size_t bucket);
+    Timestamp percentile(double fraction) const;
+};
+
+} // namespace tracesmith
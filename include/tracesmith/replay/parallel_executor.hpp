@@ -0,0 +1,89 @@
+#pragma once
+
+#include "tracesmith/replay/replay_config.hpp"
+#include "tracesmith/replay/operation_executor.hpp"
+#include "tracesmith/common/types.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tracesmith {
+
+/**
+ * Parallel Replay Executor
+ * 
+ * Replays operations with one worker thread per (device, stream), so
+ * independent streams run concurrently like they did on the GPU.
+ * 
+ * - Each worker executes its stream's operations in operation order.
+ * - A dependency on another stream's operation waits on that operation's
+ *   completion event (an atomic flag; waiters spin briefly, then park).
+ * - Workers report completions through per-worker lock-free SPSC rings
+ *   that the calling thread drains, so the scheduler and checker are only
+ *   touched from one thread. The drainer parks while all rings are empty.
+ * - An operation whose dependency failed (or was itself blocked) is not
+ *   executed and is counted as blocked, as in serial replay. With
+ *   pause_on_error the first failure stops dispatch on every worker.
+ * 
+ * The dependency graph is checked before any worker starts; unknown
+ * dependency IDs or cycles (including ones formed with per-stream order)
+ * make run() fail without executing anything.
+ */
+class ParallelReplayExecutor {
+public:
+    /// Invoked on the calling thread with the index of every executed operation
+    using CompletionCallback = std::function<void(size_t index, bool success)>;
+    
+    explicit ParallelReplayExecutor(bool dry_run = false);
+    
+    /**
+     * Execute all operations
+     * 
+     * With SchedulingPolicy::OriginalTiming each worker paces its own
+     * dispatches against the shared replay clock (see PacingTimer).
+     * 
+     * @param operations Operations with depends_on filled in
+     * @param config Replay configuration (scheduling, time_scale, pause_on_error)
+     * @param on_complete Completion callback, in completion order; every
+     *        operation is reported after the operations it depends on
+     * @return false if the dependency graph cannot be executed
+     */
+    bool run(std::vector<StreamOperation>& operations,
+             const ReplayConfig& config,
+             const CompletionCallback& on_complete);
+    
+    /// Number of workers used by the last run
+    size_t workerCount() const { return worker_count_; }
+    
+    /// Operations skipped in the last run because a dependency failed
+    size_t blockedCount() const { return blocked_count_; }
+    
+    /// Operations skipped in the last run after pause_on_error stopped dispatch
+    size_t cancelledCount() const { return cancelled_count_; }
+    
+    /// Execution metrics summed over workers
+    const OperationExecutor::Metrics& getMetrics() const { return metrics_; }
+    
+    /// Dispatch lateness over all workers (OriginalTiming only)
+    const DispatchJitterStats& jitterStats() const { return jitter_; }
+    
+    /// Measured execution start/end (getCurrentTimestamp) per operation index
+    const std::vector<Timestamp>& startTimes() const { return start_times_; }
+    const std::vector<Timestamp>& endTimes() const { return end_times_; }
+    
+    /// Reason for the last run() failure
+    const std::string& lastError() const { return last_error_; }
+
+private:
+    bool dry_run_;
+    size_t worker_count_ = 0;
+    size_t blocked_count_ = 0;
+    size_t cancelled_count_ = 0;
+    OperationExecutor::Metrics metrics_;
+    DispatchJitterStats jitter_;
+    std::vector<Timestamp> start_times_;
+    std::vector<Timestamp> end_times_;
+    std::string last_error_;
+};
+
+} // namespace tracesmith
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "tracesmith/common/types.hpp"
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <optional>
@@ -12,7 +15,8 @@ enum class ReplayMode {
     Full,           // Replay entire trace
     Partial,        // Replay specific time/operation range
     DryRun,         // Simulate without execution
-    StreamSpecific  // Replay specific stream(s)
+    StreamSpecific, // Replay specific stream(s)
+    Simulate        // Discrete-event simulation on a virtual clock (see ReplaySimulator)
 };
 
 /// Scheduling policy for stream execution
@@ -22,6 +26,20 @@ enum class SchedulingPolicy {
     OriginalTiming  // Match original captured timing
 };
 
+class CostModel;
+struct StreamOperation;
+
+/// Discrete-event simulation options (ReplayMode::Simulate)
+struct SimulationConfig {
+    std::shared_ptr<CostModel> cost_model;  // nullptr = captured durations
+    uint32_t compute_slots = 0;             // Concurrent kernels per device (0 = unlimited)
+    uint32_t copy_engines = 0;              // Concurrent copies per device (0 = unlimited)
+    bool preserve_gaps = true;              // Keep captured launch gaps between dependent ops
+    
+    /// Optional stream remapping applied before dependencies are built
+    std::function<uint32_t(const StreamOperation&)> stream_assignment;
+};
+
 /// Replay configuration
 struct ReplayConfig {
     ReplayMode mode = ReplayMode::Full;
@@ -43,11 +61,33 @@ struct ReplayConfig {
     // Execution options
     bool verbose = false;                 // Verbose output
     bool pause_on_error = false;          // Pause when validation fails
-    double time_scale = 1.0;              // Time scaling factor (1.0 = realtime)
+    double time_scale = 1.0;              // Time scaling factor (1.0 = realtime, 2.0 = twice as fast)
+    
+    /// Called after each operation executes (also in DryRun); returning
+    /// false marks it failed. Runs on worker threads with parallel_streams.
+    std::function<bool(const StreamOperation&)> on_execute;
+    
+    // Scheduling options
+    std::map<uint32_t, int> stream_priorities;  // Priority policy: higher runs first (default 0)
+    Timestamp timer_spin_ns = 200000;     // OriginalTiming: spin (not sleep) for the last N ns of each wait
+    bool parallel_streams = false;        // One worker thread per (device, stream)
+    size_t streaming_window = 65536;      // replayStreaming: events decoded and replayed per window
+    
+    // Simulation options (ReplayMode::Simulate)
+    SimulationConfig simulation;
     
     ReplayConfig() = default;
 };
 
+/// Dispatch lateness against the paced timeline (OriginalTiming)
+struct DispatchJitterStats {
+    size_t samples = 0;
+    Timestamp mean = 0;  // ns
+    Timestamp p50 = 0;
+    Timestamp p99 = 0;
+    Timestamp max = 0;
+};
+
 /// Replay result
 struct ReplayResult {
     bool success = false;
@@ -66,6 +106,19 @@ struct ReplayResult {
     size_t dependency_violations = 0;
     size_t timing_violations = 0;
     
+    // Pacing results (OriginalTiming only)
+    DispatchJitterStats dispatch_jitter;
+    
+    // Stream concurrency: fraction of the span with two or more ops in flight
+    double original_overlap = 0.0;
+    double achieved_overlap = 0.0;
+    size_t worker_threads = 0;            // Parallel replay workers (0 = serial)
+    size_t windows = 0;                   // Streaming replay windows (0 = not streamed)
+    
+    // Simulation results (ReplayMode::Simulate)
+    Timestamp captured_makespan = 0;      // First captured start to last captured end (ns)
+    Timestamp simulated_makespan = 0;     // Predicted end-to-end time (ns)
+    
     std::vector<std::string> errors;
     std::vector<std::string> warnings;
     
@@ -83,6 +136,23 @@ struct ReplayResult {
         if (dependency_violations > 0) {
             s += "  Dependency violations: " + std::to_string(dependency_violations) + "\n";
         }
+        if (windows > 0) {
+            s += "  Windows: " + std::to_string(windows) + "\n";
+        }
+        if (worker_threads > 0 || original_overlap > 0.0) {
+            s += "  Overlap: " + std::to_string(static_cast<int>(achieved_overlap * 100.0 + 0.5)) +
+                 "% achieved, " + std::to_string(static_cast<int>(original_overlap * 100.0 + 0.5)) +
+                 "% original\n";
+        }
+        if (simulated_makespan > 0) {
+            s += "  Simulated makespan: " + std::to_string(simulated_makespan) +
+                 " ns (captured " + std::to_string(captured_makespan) + " ns)\n";
+        }
+        if (dispatch_jitter.samples > 0) {
+            s += "  Dispatch jitter: mean " + std::to_string(dispatch_jitter.mean) +
+                 " ns, p99 " + std::to_string(dispatch_jitter.p99) +
+                 " ns, max " + std::to_string(dispatch_jitter.max) + " ns\n";
+        }
         return s;
     }
 };
@@ -4,12 +4,16 @@
 #include "tracesmith/replay/stream_scheduler.hpp"
 #include "tracesmith/replay/operation_executor.hpp"
 #include "tracesmith/replay/determinism_checker.hpp"
+#include "tracesmith/replay/replay_simulator.hpp"
 #include "tracesmith/format/sbt_format.hpp"
+#include <map>
 #include <string>
 #include <memory>
 
 namespace tracesmith {
 
+class PacingTimer;
+
 /**
  * Replay Engine
  * 
@@ -36,10 +40,37 @@ public:
      */
     ReplayResult replay(const ReplayConfig& config);
     
+    /**
+     * Replay an SBT file without loading it
+     * 
+     * Events are decoded in batches of config.streaming_window and replayed
+     * window by window. A window closes after its last sync point when
+     * that carries at most one batch over, so at most 2x streaming_window
+     * operations are held at once. Each window is drained completely
+     * before the next starts: dependencies on earlier windows are already
+     * satisfied, and completed operations are retired with their window.
+     * Memory stays proportional to the window, not the trace.
+     * 
+     * Validation runs per window. Parallel replay and simulation need the
+     * whole graph and are not supported; overlap is not measured.
+     */
+    ReplayResult replayStreaming(const std::string& filename, const ReplayConfig& config);
+    
     /**
      * Get determinism checker for validation
      */
     const DeterminismChecker& getChecker() const { return *checker_; }
+    
+    /**
+     * Get the last simulation (ReplayMode::Simulate)
+     */
+    const SimulationResult& getSimulation() const { return simulation_; }
+    
+    /**
+     * Get the predicted timeline of the last simulation as trace events,
+     * ready for PerfettoExporter
+     */
+    std::vector<TraceEvent> getSimulatedTimeline() const;
 
 private:
     std::unique_ptr<StreamScheduler> scheduler_;
@@ -49,6 +80,7 @@ private:
     std::vector<TraceEvent> events_;
     std::vector<StreamOperation> operations_;
     TraceMetadata metadata_;
+    SimulationResult simulation_;
     
     // Prepare operations from events
     void prepareOperations(const ReplayConfig& config);
@@ -56,8 +88,20 @@ private:
     // Build dependency graph
     void buildDependencies();
     
-    // Execute replay loop
-    ReplayResult executeReplay(const ReplayConfig& config);
+    // Add stream-order and sync dependencies for the next operation
+    static void addDependencies(StreamOperation& op, std::map<uint32_t, size_t>& last_op_per_stream);
+    
+    // Execute replay loop (timer: shared OriginalTiming clock, nullptr = own clock)
+    ReplayResult executeReplay(const ReplayConfig& config, PacingTimer* timer = nullptr);
+    
+    // Replay one streaming window held in operations_
+    void executeWindow(const ReplayConfig& config, PacingTimer& timer, ReplayResult& total);
+    
+    // Execute replay with one worker per (device, stream)
+    ReplayResult executeParallelReplay(const ReplayConfig& config);
+    
+    // Discrete-event simulation instead of execution
+    ReplayResult executeSimulation(const ReplayConfig& config);
     
     // Filter operations based on config
     bool shouldIncludeOperation(const StreamOperation& op, const ReplayConfig& config);
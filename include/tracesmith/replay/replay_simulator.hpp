@@ -0,0 +1,136 @@
+#pragma once
+
+#include "tracesmith/replay/replay_config.hpp"
+#include "tracesmith/common/types.hpp"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tracesmith {
+
+/// Hardware engine an operation occupies during simulation
+enum class SimEngine {
+    None,       // No engine (syncs, markers)
+    Compute,    // Kernel execution
+    Copy        // Copy / memset engine
+};
+
+/// Default engine for an event type
+inline SimEngine defaultSimEngine(EventType type) {
+    switch (type) {
+        case EventType::KernelLaunch:
+            return SimEngine::Compute;
+        case EventType::MemcpyH2D:
+        case EventType::MemcpyD2H:
+        case EventType::MemcpyD2D:
+        case EventType::MemsetDevice:
+            return SimEngine::Copy;
+        default:
+            return SimEngine::None;
+    }
+}
+
+/// Check if an event type only waits on other work
+inline bool isSyncEvent(EventType type) {
+    return type == EventType::StreamSync ||
+           type == EventType::DeviceSync ||
+           type == EventType::EventSync;
+}
+
+/**
+ * Cost Model
+ * 
+ * Predicts how long an operation runs in the simulation and which engine
+ * it occupies. Implementations must be thread-safe for concurrent reads.
+ */
+class CostModel {
+public:
+    virtual ~CostModel() = default;
+    
+    /// Simulated execution time (ns)
+    virtual Timestamp cost(const StreamOperation& op) const = 0;
+    
+    /// Engine occupied while executing
+    virtual SimEngine engine(const StreamOperation& op) const {
+        return defaultSimEngine(op.event.type);
+    }
+};
+
+/**
+ * Scaled Cost Model
+ * 
+ * Captured duration times a scale factor. A per-name scale takes
+ * precedence over a per-type scale, which takes precedence over the
+ * default scale. Syncs cost nothing: their waiting is reproduced by the
+ * dependency graph.
+ * 
+ * Example: setTypeScale(EventType::MemcpyH2D, 0.5) models 2x faster
+ * host-to-device copies.
+ */
+class ScaledCostModel : public CostModel {
+public:
+    explicit ScaledCostModel(double default_scale = 1.0) : default_scale_(default_scale) {}
+    
+    void setDefaultScale(double scale) { default_scale_ = scale; }
+    void setTypeScale(EventType type, double scale) { type_scales_[static_cast<uint8_t>(type)] = scale; }
+    void setNameScale(const std::string& name, double scale) { name_scales_[name] = scale; }
+    
+    Timestamp cost(const StreamOperation& op) const override;
+
+private:
+    double default_scale_;
+    std::unordered_map<uint8_t, double> type_scales_;
+    std::unordered_map<std::string, double> name_scales_;
+};
+
+/// Predicted timeline from a simulation run
+struct SimulationResult {
+    static constexpr Timestamp kNotSimulated = UINT64_MAX;
+    
+    Timestamp origin = 0;                 // Captured timestamp mapped to simulated time 0
+    Timestamp makespan = 0;               // Predicted end-to-end time (ns)
+    Timestamp captured_makespan = 0;      // Captured end-to-end time (ns)
+    
+    /// Simulated start/end per operation index, relative to origin
+    /// (kNotSimulated for blocked operations)
+    std::vector<Timestamp> start;
+    std::vector<Timestamp> end;
+    
+    Timestamp compute_busy_time = 0;      // Sum of compute op costs
+    Timestamp copy_busy_time = 0;         // Sum of copy op costs
+    Timestamp contention_wait_time = 0;   // Time ops waited for a busy engine
+    size_t simulated_operations = 0;
+    size_t blocked_operations = 0;        // Never ran (dependency cycle)
+    size_t unresolved_dependencies = 0;   // Dependencies on unknown operation IDs (ignored)
+    
+    /**
+     * Build the predicted timeline as trace events (captured events with
+     * simulated timestamps and durations), e.g. for PerfettoExporter
+     */
+    std::vector<TraceEvent> toTraceEvents(const std::vector<StreamOperation>& operations) const;
+};
+
+/**
+ * Replay Simulator
+ * 
+ * Discrete-event simulation of a replay on a virtual clock. Operations
+ * become eligible when all dependencies have finished (plus the captured
+ * launch gap, if preserved), then run on their device's engine for the
+ * cost-model duration. Engines with a contention limit queue eligible
+ * operations FIFO. Nothing sleeps or executes, so runs take O(n log n)
+ * time in the number of operations.
+ */
+class ReplaySimulator {
+public:
+    explicit ReplaySimulator(SimulationConfig config = SimulationConfig());
+    
+    /**
+     * Simulate operations whose depends_on lists are filled in
+     */
+    SimulationResult run(const std::vector<StreamOperation>& operations) const;
+
+private:
+    SimulationConfig config_;
+};
+
+} // namespace tracesmith
@@ -2,8 +2,12 @@
 
 #include "tracesmith/replay/replay_config.hpp"
 #include "tracesmith/common/types.hpp"
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <map>
 #include <queue>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
@@ -14,24 +18,65 @@ namespace tracesmith {
  * 
  * Manages execution order of operations across multiple GPU streams,
  * respecting dependencies and synchronization points.
+ * 
+ * Operations live in a dense array. Each one carries a count of
+ * unfinished dependencies; completing an operation decrements the counts
+ * of its dependents and queues those reaching zero for dispatch.
+ * Selection and completion are O(log n), and completion/ready counts are
+ * maintained incrementally, so a full replay is O(n log n) in the number
+ * of operations.
+ * 
+ * Policies:
+ * - RoundRobin: per-stream FIFO ready queues; dispatch cycles over the
+ *   streams that have ready work, one operation per turn
+ * - Priority: highest stream priority first (setStreamPriority), then
+ *   earliest captured timestamp
+ * - OriginalTiming: earliest captured timestamp first; pacing against
+ *   the captured timeline is done by ReplayEngine
+ * 
+ * Operation IDs are expected to be mostly dense (as assigned by
+ * ReplayEngine); sparse IDs fall back to a hash lookup.
  */
 class StreamScheduler {
 public:
     explicit StreamScheduler(SchedulingPolicy policy = SchedulingPolicy::RoundRobin);
     
+    /**
+     * Change scheduling policy; already-ready operations are re-queued
+     */
+    void setPolicy(SchedulingPolicy policy);
+    SchedulingPolicy policy() const { return policy_; }
+    
+    /**
+     * Set dispatch priority of a stream (higher runs first, default 0).
+     * Used by SchedulingPolicy::Priority.
+     */
+    void setStreamPriority(uint32_t stream_id, int priority);
+    void setStreamPriorities(const std::map<uint32_t, int>& priorities);
+    int streamPriority(uint32_t stream_id) const;
+    
     /**
      * Add operation to schedule
+     * Dependencies may refer to operations added later. Operations whose
+     * ID is already scheduled are ignored.
      */
     void addOperation(const StreamOperation& op);
+    void addOperation(StreamOperation&& op);
     
     /**
      * Add multiple operations
      */
     void addOperations(const std::vector<StreamOperation>& ops);
     
+    /**
+     * Reserve storage for an expected number of operations
+     */
+    void reserve(size_t count);
+    
     /**
      * Get next operation ready for execution
-     * Returns nullptr if no operations are ready
+     * Returns nullptr if no operations are ready. The pointer stays valid
+     * until the next addOperation() or reset().
      */
     StreamOperation* getNextOperation();
     
@@ -41,6 +86,17 @@ public:
      */
     void markCompleted(size_t operation_id);
     
+    /**
+     * Mark operation as failed
+     * Retires it without releasing operations that depend on it
+     */
+    void markFailed(size_t operation_id);
+    
+    /**
+     * Find an operation by ID (nullptr if unknown)
+     */
+    StreamOperation* getOperation(size_t operation_id);
+    
     /**
      * Check if all operations are complete
      */
@@ -57,7 +113,7 @@ public:
     size_t readyCount() const;
     
     /**
-     * Reset scheduler state
+     * Reset scheduler state (policy and stream priorities are kept)
      */
     void reset();
     
@@ -75,27 +131,75 @@ public:
     Statistics getStatistics() const;
 
 private:
+    static constexpr uint32_t kInvalidSlot = UINT32_MAX;
+    
+    /// Ready heap entry; ordered by priority, timestamp, then operation ID
+    struct ReadyEntry {
+        int priority;
+        Timestamp timestamp;
+        size_t operation_id;
+        uint32_t slot;
+        
+        bool operator>(const ReadyEntry& other) const {
+            if (priority != other.priority) return priority < other.priority;
+            if (timestamp != other.timestamp) return timestamp > other.timestamp;
+            return operation_id > other.operation_id;
+        }
+    };
+    
+    /// Singly linked dependent list stored in one array
+    struct DependentLink {
+        uint32_t slot;  // Dependent operation
+        uint32_t next;  // Next link, or kInvalidSlot
+    };
+    
     SchedulingPolicy policy_;
     
-    // All operations
-    std::map<size_t, StreamOperation> operations_;
+    // All operations, indexed by slot (insertion order)
+    std::vector<StreamOperation> operations_;
+    std::vector<uint32_t> unmet_deps_;       // Unfinished dependency count per slot
+    std::vector<uint32_t> first_dependent_;  // Head of dependent list per slot
+    std::vector<DependentLink> dependent_links_;
     
-    // Operations ready for execution (dependencies satisfied)
-    std::vector<size_t> ready_queue_;
+    // Operation ID -> slot (dense_slots_ is indexed by ID - id_base_)
+    size_t id_base_ = 0;
+    std::vector<uint32_t> dense_slots_;
+    std::unordered_map<size_t, uint32_t> sparse_slots_;
     
-    // Stream round-robin state
-    std::map<uint32_t, std::queue<size_t>> stream_queues_;
-    size_t round_robin_index_ = 0;
+    // Dependencies on IDs not added yet: op_id -> waiting slots
+    std::unordered_map<size_t, std::vector<uint32_t>> waiting_on_;
     
-    // Dependency tracking
-    std::map<size_t, std::vector<size_t>> dependents_;  // op_id -> [dependent_op_ids]
+    // Operations ready for execution (dependencies satisfied), used by the
+    // Priority and OriginalTiming policies. Entries of operations completed
+    // out of order are discarded lazily.
+    std::priority_queue<ReadyEntry, std::vector<ReadyEntry>, std::greater<ReadyEntry>> ready_queue_;
+    size_t ready_count_ = 0;
+    size_t completed_count_ = 0;
+    
+    // Stream round-robin state: ready FIFO per stream and the rotation of
+    // streams that currently have ready operations
+    std::unordered_map<uint32_t, uint32_t> stream_index_;  // stream_id -> queue
+    std::vector<std::deque<uint32_t>> stream_queues_;
+    std::vector<uint8_t> stream_in_rotation_;
+    std::deque<uint32_t> stream_rotation_;
+    
+    std::unordered_map<uint32_t, int> stream_priorities_;
     
     // Helper methods
-    void updateDependencies(size_t completed_id);
-    void addToReadyQueue(size_t op_id);
-    size_t selectNextRoundRobin();
-    size_t selectNextPriority();
-    size_t selectNextOriginalTiming();
+    uint32_t findSlot(size_t operation_id) const;
+    void registerSlot(size_t operation_id, uint32_t slot);
+    void addDependent(uint32_t dependency_slot, uint32_t dependent_slot);
+    void updateDependencies(uint32_t completed_slot);
+    
+    /// Count a finished slot and drop it from the ready queues
+    void retire(uint32_t slot);
+    void addToReadyQueue(uint32_t slot);
+    void enqueueReady(uint32_t slot);
+    void rebuildReadyQueues();
+    static bool isDone(const StreamOperation& op) { return op.executed || op.skipped; }
+    uint32_t selectNextRoundRobin();
+    uint32_t selectNextPriority();
+    uint32_t selectNextOriginalTiming();
 };
 
 } // namespace tracesmith
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "tracesmith/common/types.hpp"
+#include "tracesmith/state/instruction_stream.hpp"
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tracesmith {
+
+/// One operation on the critical path
+struct CriticalPathEntry {
+    uint64_t correlation_id = 0;
+    std::string name;
+    EventType type = EventType::Unknown;
+    uint32_t stream_id = 0;
+    Timestamp start = 0;      // Start relative to trace start (ns)
+    Timestamp duration = 0;   // Execution time (ns)
+    Timestamp gap = 0;        // Idle time before start once dependencies were met (ns)
+};
+
+/// Predicted effect of speeding up one operation name
+struct WhatIfResult {
+    std::string name;
+    double speedup = 1.0;
+    size_t affected_operations = 0;
+    Timestamp original_makespan = 0;
+    Timestamp predicted_makespan = 0;
+    
+    /// End-to-end time saved (ns)
+    Timestamp reduction() const {
+        return original_makespan > predicted_makespan ? original_makespan - predicted_makespan : 0;
+    }
+    
+    /// End-to-end time saved as a percentage of the original
+    double reductionPercent() const {
+        return original_makespan > 0 ?
+            100.0 * static_cast<double>(reduction()) / original_makespan : 0.0;
+    }
+};
+
+/// Result of a critical-path pass
+struct CriticalPathResult {
+    Timestamp makespan = 0;                 // End-to-end time (ns)
+    std::vector<CriticalPathEntry> path;    // Critical path, earliest first
+    Timestamp path_busy_time = 0;           // Sum of durations on the path
+    Timestamp path_gap_time = 0;            // Sum of gaps on the path
+    
+    /// Per-node slack (ns), indexed like InstructionStreamBuilder nodes.
+    /// Zero slack means delaying the op delays the whole trace.
+    std::vector<Timestamp> slack;
+    
+    /// Time each operation name contributes to the critical path
+    std::map<std::string, Timestamp> path_time_by_name;
+    
+    /// Nodes not reached by the topological pass (dependency cycle)
+    size_t unreachable_nodes = 0;
+};
+
+/**
+ * Critical Path Analyzer
+ * 
+ * Longest-path analysis over the dependency DAG produced by
+ * InstructionStreamBuilder::analyze().
+ * 
+ * Each operation is modelled as gap + duration: the gap is the idle time
+ * observed between its last dependency finishing and the operation
+ * starting (launch latency, host-side stalls), the duration is its
+ * execution time. Operations without dependencies start at their
+ * captured offset from the trace start. With unchanged durations the
+ * forward pass reproduces the captured timeline; scaling durations
+ * predicts the timeline after an optimization.
+ * 
+ * Every pass is O(nodes + edges) over the builder's CSR arrays.
+ */
+class CriticalPathAnalyzer {
+public:
+    /// The builder must outlive the analyzer and must already be analyzed
+    explicit CriticalPathAnalyzer(const InstructionStreamBuilder& graph);
+    
+    /**
+     * Compute makespan, critical path and per-node slack
+     */
+    CriticalPathResult analyze() const;
+    
+    /**
+     * Predict end-to-end time if every operation named `name` ran
+     * `speedup` times faster
+     */
+    WhatIfResult whatIf(const std::string& name, double speedup = 2.0) const;
+    
+    /**
+     * Evaluate whatIf() for the operation names with the most time on the
+     * critical path, sorted by predicted reduction
+     */
+    std::vector<WhatIfResult> rankSpeedups(double speedup = 2.0, size_t top_n = 10) const;
+    
+    /// Number of nodes in topological order (excludes cycle members)
+    size_t orderedNodes() const { return topo_order_.size(); }
+
+private:
+    const InstructionStreamBuilder& graph_;
+    
+    std::vector<uint32_t> topo_order_;
+    std::vector<Timestamp> gap_;        // Per-node gap (or start offset for sources)
+    std::vector<Timestamp> duration_;   // Per-node captured duration
+    std::vector<uint32_t> name_id_;     // Per-node interned name
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, uint32_t> name_index_;
+    Timestamp base_makespan_ = 0;
+    
+    // Forward pass; returns makespan. finish and critical_pred may be null.
+    Timestamp forwardPass(const std::vector<Timestamp>& duration,
+                          std::vector<Timestamp>* finish,
+                          std::vector<uint32_t>* critical_pred) const;
+};
+
+} // namespace tracesmith
@@ -104,6 +104,18 @@ public:
     /// Process multiple events
     void processEvents(const std::vector<TraceEvent>& events);
     
+    /**
+     * Set worker threads used by processEvents()
+     * 
+     * Streams are independent, so with more than one thread events are
+     * partitioned by (device, stream) and each stream is replayed on a
+     * worker. Results are identical to the serial path.
+     * 
+     * @param num_threads 1 = serial (default), 0 = hardware concurrency
+     */
+    void setParallelism(size_t num_threads) { num_threads_ = num_threads; }
+    size_t parallelism() const { return num_threads_; }
+    
     /// Get state for a specific stream
     GPUStreamState* getStreamState(uint32_t device_id, uint32_t stream_id);
     const GPUStreamState* getStreamState(uint32_t device_id, uint32_t stream_id) const;
@@ -139,9 +151,13 @@ private:
     std::map<std::pair<uint32_t, uint32_t>, GPUStreamState> stream_states_;
     
     size_t event_count_ = 0;
+    size_t num_threads_ = 1;
     
     // Helper to get or create stream state
     GPUStreamState& getOrCreateStreamState(uint32_t device_id, uint32_t stream_id);
+    
+    // Per-stream parallel path for processEvents()
+    void processEventsParallel(const std::vector<TraceEvent>& events, size_t num_threads);
 };
 
 } // namespace tracesmith
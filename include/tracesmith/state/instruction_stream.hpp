@@ -3,8 +3,9 @@
 #include "tracesmith/common/types.hpp"
 #include <vector>
 #include <map>
-#include <set>
-#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
 
 namespace tracesmith {
 
@@ -17,6 +18,18 @@ enum class DependencyType {
     Memory           // Memory dependency (WAR, WAW, RAW)
 };
 
+/// Convert DependencyType to string
+inline const char* dependencyTypeToString(DependencyType type) {
+    switch (type) {
+        case DependencyType::None:            return "None";
+        case DependencyType::Sequential:      return "Sequential";
+        case DependencyType::Synchronization: return "Synchronization";
+        case DependencyType::HostBarrier:     return "HostBarrier";
+        case DependencyType::Memory:          return "Memory";
+        default:                              return "Unknown";
+    }
+}
+
 /// Represents a dependency between two operations
 struct OperationDependency {
     uint64_t from_correlation_id;
@@ -31,6 +44,25 @@ struct OperationDependency {
         , description(desc) {}
 };
 
+/**
+ * Compact dependency edge
+ * 
+ * Internal edge representation: endpoints are dense node indices and the
+ * description is implied by the type plus stream id, so an edge is 16 bytes
+ * and building it never allocates. OperationDependency (with its text
+ * description) is materialized only when requested via getDependencies().
+ */
+struct DependencyEdge {
+    uint32_t from;        // Node index of the operation depended upon
+    uint32_t to;          // Node index of the dependent operation
+    DependencyType type;
+    uint32_t stream_id;   // Stream the edge was derived from
+    
+    DependencyEdge() : from(0), to(0), type(DependencyType::None), stream_id(0) {}
+    DependencyEdge(uint32_t f, uint32_t t, DependencyType ty, uint32_t stream)
+        : from(f), to(t), type(ty), stream_id(stream) {}
+};
+
 /// Instruction stream node
 struct InstructionNode {
     TraceEvent event;
@@ -46,13 +78,23 @@ struct InstructionNode {
  * 
  * Builds an ordered sequence of GPU operations with dependency tracking.
  * Analyzes event streams to construct execution order and detect synchronization.
+ * 
+ * Nodes and edges live in dense arrays indexed by insertion order; after
+ * analyze() the adjacency is also available in CSR form, so graph passes
+ * (e.g. critical-path analysis) run in O(nodes + edges).
  */
 class InstructionStreamBuilder {
 public:
+    /// Sentinel returned by findNode() for unknown correlation IDs
+    static constexpr uint32_t kInvalidNode = UINT32_MAX;
+    
     InstructionStreamBuilder() = default;
     
     /**
      * Add an event to the instruction stream
+     * 
+     * A repeated correlation ID replaces the earlier event; if its device
+     * or stream changed, the node moves to the new stream's sequence.
      */
     void addEvent(const TraceEvent& event);
     
@@ -63,9 +105,29 @@ public:
     
     /**
      * Analyze and build the dependency graph
+     * 
+     * Streams are identified by (device_id, stream_id). Sequential edges
+     * link consecutive operations on each stream. Each StreamSync/DeviceSync
+     * is linked only to the latest earlier operation on every other stream
+     * of the same device (the sync frontier); older operations are already
+     * ordered before it through the sequential chain, so the graph is the
+     * transitive reduction of the all-prior-ops barrier.
      */
     void analyze();
     
+    /**
+     * Set worker threads used by analyze()
+     * 
+     * Sequential dependencies are detected per stream and synchronization
+     * dependencies per device on a worker pool, then merged in stream and
+     * device order. The resulting graph is identical to the serial path,
+     * including dependency order.
+     * 
+     * @param num_threads 1 = serial (default), 0 = hardware concurrency
+     */
+    void setParallelism(size_t num_threads) { num_threads_ = num_threads; }
+    size_t parallelism() const { return num_threads_; }
+    
     /**
      * Get the instruction stream in execution order
      */
@@ -77,7 +139,7 @@ public:
     std::vector<OperationDependency> getDependencies() const;
     
     /**
-     * Get all operations on a specific stream
+     * Get all operations on a specific stream (on any device)
      */
     std::vector<InstructionNode> getStreamOperations(uint32_t stream_id) const;
     
@@ -86,6 +148,31 @@ public:
      */
     bool hasDependency(uint64_t from, uint64_t to) const;
     
+    // ---- Dense graph access (valid after analyze()) ----
+    
+    /// Number of nodes
+    size_t nodeCount() const { return events_.size(); }
+    
+    /// Event for a node index
+    const TraceEvent& nodeEvent(uint32_t index) const { return events_[index]; }
+    
+    /// Node index for a correlation ID, or kInvalidNode
+    uint32_t findNode(uint64_t correlation_id) const;
+    
+    /// All edges in detection order
+    const std::vector<DependencyEdge>& edges() const { return edges_; }
+    
+    /// CSR successors: node i's dependents are out_targets[out_offsets[i] .. out_offsets[i+1])
+    const std::vector<uint32_t>& outOffsets() const { return out_offsets_; }
+    const std::vector<uint32_t>& outTargets() const { return out_targets_; }
+    
+    /// CSR predecessors: node i's dependencies are in_sources[in_offsets[i] .. in_offsets[i+1])
+    const std::vector<uint32_t>& inOffsets() const { return in_offsets_; }
+    const std::vector<uint32_t>& inSources() const { return in_sources_; }
+    
+    /// Human-readable description of an edge
+    static std::string describe(const DependencyEdge& edge);
+    
     /**
      * Get statistics about the instruction stream
      */
@@ -111,24 +198,27 @@ public:
     void clear();
 
 private:
-    std::map<uint64_t, InstructionNode> nodes_;           // Correlation ID -> Node
-    std::map<uint32_t, std::vector<uint64_t>> streams_;   // Stream ID -> Operations
-    std::vector<OperationDependency> dependencies_;
+    using StreamKey = std::pair<uint32_t, uint32_t>;        // (device ID, stream ID)
     
-    // Last operation on each stream (for sequential dependencies)
-    std::map<uint32_t, uint64_t> stream_last_op_;
+    std::vector<TraceEvent> events_;                        // Node index -> event
+    std::unordered_map<uint64_t, uint32_t> node_index_;     // Correlation ID -> node index
+    std::map<StreamKey, std::vector<uint32_t>> streams_;    // (device, stream) -> node indices
+    std::vector<DependencyEdge> edges_;
     
-    // Pending synchronizations
-    struct SyncPoint {
-        uint64_t event_correlation_id;
-        uint32_t stream_id;
-    };
-    std::vector<SyncPoint> pending_syncs_;
+    // CSR adjacency built from edges_ by analyze()
+    std::vector<uint32_t> out_offsets_;
+    std::vector<uint32_t> out_targets_;
+    std::vector<uint32_t> in_offsets_;
+    std::vector<uint32_t> in_sources_;
+    
+    size_t num_threads_ = 1;
     
     void detectSequentialDependencies();
     void detectSynchronizationDependencies();
-    void createSyncDependencies(uint64_t sync_corr_id, uint32_t sync_stream);
-    void addDependency(uint64_t from, uint64_t to, DependencyType type, const std::string& desc = "");
+    void buildAdjacency();
+    void appendEdges(const std::vector<std::vector<DependencyEdge>>& parts);
+    void moveToStream(uint32_t index, const StreamKey& from, const StreamKey& to);
+    InstructionNode makeNode(uint32_t index) const;
 };
 
 } // namespace tracesmith
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace tracesmith {
+
+/**
+ * Streaming JSON writer over a preallocated character buffer.
+ *
+ * Numbers are formatted with std::to_chars and strings are escaped per
+ * RFC 8259. Separators follow from the previous byte written, so callers
+ * only emit keys and values. In pretty mode every member goes on
+ * its own line with two-space indentation; compact mode emits no
+ * whitespace at all.
+ *
+ * Keys given as string literals are copied verbatim (they must not need
+ * escaping); keys from runtime strings are escaped like values.
+ *
+ * Without a sink the output accumulates in the buffer (see takeString()).
+ * With a sink, the buffer is handed over whenever it passes the flush
+ * threshold at the end of an object, and once more on flush().
+ *
+ * Usage:
+ *   JsonWriter json(false);
+ *   json.beginObject();
+ *   json.key("name"); json.value(event.name);
+ *   json.key("ts");   json.value(uint64_t(42));
+ *   json.endObject();
+ *   std::string text = json.takeString();
+ */
+class JsonWriter {
+public:
+    /// Receives buffered output; returns false on write failure
+    using Sink = std::function<bool(const char* data, size_t size)>;
+
+    explicit JsonWriter(bool pretty = false, size_t buffer_size = 1 << 20);
+
+    void setSink(Sink sink) { sink_ = std::move(sink); }
+
+    void beginObject() { open('{'); }
+    void endObject() {
+        close('}');
+        if (sink_ && size_ >= flush_threshold_) {
+            flush();
+        }
+    }
+    void beginArray() { open('['); }
+    void endArray() { close(']'); }
+
+    /// Literal member name, copied without escaping
+    template <size_t N>
+    void key(const char (&name)[N]) {
+        separator();
+        reserve(N + 3);
+        put('"');
+        putRaw(name, N - 1);
+        put('"');
+        keySuffix();
+    }
+
+    /// Runtime member name, escaped
+    void key(const std::string& name) { key(std::string_view(name)); }
+    void key(std::string_view name) {
+        separator();
+        putQuoted(name);
+        keySuffix();
+    }
+
+    void value(std::string_view text) {
+        separator();
+        putQuoted(text);
+    }
+    void value(const std::string& text) { value(std::string_view(text)); }
+    void value(const char* text) { value(std::string_view(text)); }
+
+    /// String known not to need escaping (constants, digits), copied verbatim
+    void literalValue(std::string_view text) {
+        separator();
+        reserve(text.size() + 2);
+        put('"');
+        putRaw(text.data(), text.size());
+        put('"');
+    }
+
+    void value(uint64_t number) {
+        separator();
+        putUint(number);
+    }
+    void value(int64_t number) {
+        separator();
+        reserve(24);
+        auto result = std::to_chars(data() + size_, data() + size_ + 24, number);
+        size_ = static_cast<size_t>(result.ptr - data());
+    }
+    void value(uint32_t number) { value(static_cast<uint64_t>(number)); }
+    void value(int32_t number) { value(static_cast<int64_t>(number)); }
+    void value(bool flag);
+
+    /// Fixed-point with the given number of decimals (null if not finite)
+    void value(double number, int precision);
+
+    /// "0x..." hexadecimal string
+    void hexValue(uint64_t number);
+
+    /// Short numeric array kept on one line in pretty mode
+    void value(const uint32_t* numbers, size_t count);
+
+    /**
+     * Restart as a fragment that continues another writer's document
+     * right after an element at the given nesting depth. Used to render
+     * chunks of an array on worker threads; see appendFragment().
+     */
+    void resumeAfterElement(size_t depth) {
+        size_ = 0;
+        depth_ = depth;
+        flushed_last_ = '}';
+    }
+
+    /// Rendered fragment (the buffer contents)
+    std::string_view fragment() const { return std::string_view(buffer_.data(), size_); }
+
+    /**
+     * Append a fragment rendered by a resumed writer at this writer's
+     * current position. Its leading comma is dropped when this writer is
+     * at the start of a container, so output matches writing serially.
+     */
+    void appendFragment(std::string_view text);
+
+    /// Current nesting depth
+    size_t depth() const { return depth_; }
+
+    /// Hand buffered output to the sink (no-op without one)
+    bool flush();
+
+    /// Output accumulated so far (empties the writer)
+    std::string takeString();
+
+    size_t size() const { return size_; }
+    bool good() const { return good_; }
+    bool pretty() const { return pretty_; }
+
+private:
+    bool pretty_;
+    bool good_ = true;
+    size_t flush_threshold_;
+    std::string buffer_;   // Sized to capacity; size_ is the write cursor
+    size_t size_ = 0;
+    Sink sink_;
+
+    // Indentation depth (pretty mode) and the last byte handed to the sink
+    size_t depth_ = 0;
+    char flushed_last_ = '\0';
+
+    char* data() { return &buffer_[0]; }
+    void reserve(size_t bytes) {
+        if (size_ + bytes > buffer_.size()) {
+            grow(bytes);
+        }
+    }
+    void grow(size_t bytes);
+    void put(char c) { buffer_[size_++] = c; }
+    void putRaw(const char* text, size_t length) {
+        std::memcpy(data() + size_, text, length);
+        size_ += length;
+    }
+    void putUint(uint64_t number) {
+        reserve(24);
+        auto result = std::to_chars(data() + size_, data() + size_ + 24, number);
+        size_ = static_cast<size_t>(result.ptr - data());
+    }
+    void putQuoted(std::string_view text);
+    void newline();
+
+    /// Comma (and newline in pretty mode) unless at the start of a
+    /// container or right after a key; decided from the previous byte
+    void separator() {
+        char last = size_ ? buffer_[size_ - 1] : flushed_last_;
+        if (last == ':' || last == ' ' || last == '\0') {
+            return;
+        }
+        reserve(1);
+        if (last != '{' && last != '[') {
+            put(',');
+        }
+        if (pretty_) {
+            newline();
+        }
+    }
+    void keySuffix() {
+        reserve(2);
+        put(':');
+        if (pretty_) put(' ');
+    }
+    void open(char bracket);
+    void close(char bracket);
+};
+
+} // namespace tracesmith
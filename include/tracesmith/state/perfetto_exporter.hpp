@@ -1,9 +1,11 @@
 #pragma once
 
 #include "tracesmith/common/types.hpp"
+#include "tracesmith/state/json_writer.hpp"
 #include <string>
 #include <vector>
 #include <fstream>
+#include <functional>
 #include <map>
 #include <set>
 
@@ -23,6 +25,10 @@ struct PerfettoMetadata {
  * - Process/thread metadata for better visualization
  * - Performance counters and GPU state information
  * - Flow events for dependency tracking
+ * - Pretty or compact output, optionally gzip-compressed
+ * 
+ * Output is streamed through JsonWriter in buffered chunks, so file
+ * export never holds the whole document in memory.
  * 
  * Compatible with:
  * - chrome://tracing
@@ -93,21 +99,59 @@ public:
      * Set custom metadata for process/thread naming
      */
     void setMetadata(const PerfettoMetadata& metadata) { metadata_ = metadata; }
+    
+    /**
+     * Compact output: no indentation or newlines (about half the size)
+     */
+    void setCompact(bool compact) { compact_ = compact; }
+    
+    /**
+     * Gzip-compress file output; also enabled by a ".gz" file suffix.
+     * Level 1 favours speed, 9 favours size.
+     */
+    void setGzip(bool enable, int level = 1) {
+        gzip_ = enable;
+        gzip_level_ = level;
+    }
+    
+    /**
+     * Check whether gzip output was compiled in (requires zlib)
+     */
+    static bool isGzipAvailable();
+    
+    /**
+     * Set worker threads used for serialisation
+     * 
+     * Events, counters and flows are cut into fixed-size chunks that are
+     * rendered on workers into separate buffers and appended in order,
+     * a bounded wave at a time. Output is byte-identical to the serial
+     * path.
+     * 
+     * @param num_threads 1 = serial (default), 0 = hardware concurrency
+     */
+    void setParallelism(size_t num_threads) { num_threads_ = num_threads; }
+    size_t parallelism() const { return num_threads_; }
 
 private:
-    void writeHeader(std::ostream& out);
-    void writeMetadataEvents(std::ostream& out, const std::vector<TraceEvent>& events, bool& first);
-    void writeEvent(std::ostream& out, const TraceEvent& event, bool& first);
-    void writeFlowEvents(std::ostream& out, const std::vector<TraceEvent>& events, bool& first);
-    void writeCounterEvents(std::ostream& out, const std::vector<CounterEvent>& counters, bool& first);
-    void writeCounterTrackMetadata(std::ostream& out, const std::vector<CounterEvent>& counters, bool& first);
-    void writeFooter(std::ostream& out);
-    
-    std::string getEventPhase(EventType type);
-    std::string getEventCategory(EventType type);
-    std::string getGPUTrackName(EventType type);
-    uint64_t eventToMicroseconds(Timestamp ns);
-    void writeEventArgs(std::ostream& out, const TraceEvent& event);
+    void writeDocument(JsonWriter& json, const std::vector<TraceEvent>& events,
+                       const std::vector<CounterEvent>& counters);
+    void writeMetadataEvents(JsonWriter& json);
+    void writeEvent(JsonWriter& json, const TraceEvent& event);
+    void writeFlowEvents(JsonWriter& json, const std::vector<TraceEvent>& events);
+    void writeCounterEvents(JsonWriter& json, const std::vector<CounterEvent>& counters);
+    void writeCounter(JsonWriter& json, const CounterEvent& counter, uint32_t tid);
+    void writeCounterTrackMetadata(JsonWriter& json, const std::vector<CounterEvent>& counters);
+    void writeFooter(JsonWriter& json);
+    
+    // Render items [0, count) as array elements, in parallel chunks when enabled
+    void writeChunked(JsonWriter& json, size_t count,
+                      const std::function<void(JsonWriter&, size_t, size_t)>& write_range);
+    
+    static const char* getEventPhase(EventType type);
+    static const char* getEventCategory(EventType type);
+    static const char* getGPUTrackName(EventType type);
+    static uint64_t eventToMicroseconds(Timestamp ns);
+    void writeEventArgs(JsonWriter& json, const TraceEvent& event);
     
     // Extract unique process/thread IDs for metadata
     void extractMetadata(const std::vector<TraceEvent>& events);
@@ -115,9 +159,13 @@ private:
     bool enable_gpu_tracks_ = true;
     bool enable_flow_events_ = true;
     bool enable_counter_tracks_ = true;
+    bool compact_ = false;
+    bool gzip_ = false;
+    int gzip_level_ = 1;
+    size_t num_threads_ = 1;
     PerfettoMetadata metadata_;
     std::set<uint32_t> device_ids_;
-    std::set<uint32_t> stream_ids_;
+    std::map<uint32_t, uint32_t> stream_devices_;  // stream -> first device seen
     std::set<std::string> counter_names_;  // Track unique counter names
 };
 
@@ -2,9 +2,18 @@
 
 #include "tracesmith/common/types.hpp"
 #include "tracesmith/common/ring_buffer.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 #include <memory>
+#include <ostream>
 
 #ifdef TRACESMITH_PERFETTO_SDK_ENABLED
 #include "perfetto.h"
@@ -13,6 +22,7 @@
 // Forward declaration
 namespace tracesmith {
 class PerfettoExporter;
+class PerfettoProtoWriter;
 }
 
 namespace tracesmith {
@@ -34,20 +44,29 @@ struct TracingConfig {
     bool enable_counter_tracks = true;
     bool enable_flow_events = true;
     
+    // Live streaming (TracingSession): packets go to socket_path if set,
+    // else output_file, every flush_interval_ms while the session runs
+    bool live_streaming = false;
+    std::string socket_path;        // Unix-domain socket to connect to
+    uint32_t flush_interval_ms = 100;
+    
     TracingConfig() = default;
 };
 
-/// Perfetto protobuf exporter with fallback to JSON
+/// Perfetto protobuf exporter with JSON output for .json files
+/// 
+/// Protobuf is encoded by PerfettoProtoWriter and needs no SDK; the SDK
+/// is only used for the real-time session hooks below.
 class PerfettoProtoExporter {
 public:
     /// Output format selection
     enum class Format {
-        JSON,       // Fallback to JSON if SDK not available
-        PROTOBUF    // Native Perfetto protobuf (requires SDK)
+        JSON,       // Perfetto JSON via PerfettoExporter
+        PROTOBUF    // Native Perfetto protobuf
     };
     
     /// Constructor with format selection
-    /// @param format Output format (PROTOBUF requires TRACESMITH_PERFETTO_SDK_ENABLED)
+    /// @param format Output format
     explicit PerfettoProtoExporter(Format format = Format::PROTOBUF);
     
     /// Destructor
@@ -60,12 +79,21 @@ public:
     bool exportToFile(const std::vector<TraceEvent>& events, 
                      const std::string& output_file);
     
-#ifdef TRACESMITH_PERFETTO_SDK_ENABLED
-    /// Export to protobuf buffer (SDK only)
+    /// Export events and counter samples to file
+    bool exportToFile(const std::vector<TraceEvent>& events,
+                     const std::vector<CounterEvent>& counters,
+                     const std::string& output_file);
+    
+    /// Export to protobuf buffer
     /// @param events Vector of trace events to export
-    /// @return Protobuf binary data
+    /// @return Protobuf binary data (a serialized perfetto.protos.Trace)
     std::vector<uint8_t> exportToProto(const std::vector<TraceEvent>& events);
     
+    /// Export events and counter samples to protobuf buffer
+    std::vector<uint8_t> exportToProto(const std::vector<TraceEvent>& events,
+                                       const std::vector<CounterEvent>& counters);
+    
+#ifdef TRACESMITH_PERFETTO_SDK_ENABLED
     /// Initialize real-time tracing session (SDK only)
     /// @param config Tracing configuration
     /// @return true if initialization succeeded
@@ -107,8 +135,21 @@ public:
 #endif
     }
     
+    /**
+     * Set worker threads used for encoding
+     * 
+     * Events are encoded in fixed-size chunks on workers and the framed
+     * packets are concatenated in order; output is byte-identical to the
+     * serial path. Also applies to JSON output via PerfettoExporter.
+     * 
+     * @param num_threads 1 = serial (default), 0 = hardware concurrency
+     */
+    void setParallelism(size_t num_threads) { num_threads_ = num_threads; }
+    size_t parallelism() const { return num_threads_; }
+    
 private:
     Format format_;
+    size_t num_threads_ = 1;
     
 #ifdef TRACESMITH_PERFETTO_SDK_ENABLED
     // Perfetto SDK implementation details
@@ -131,9 +172,6 @@ private:
     std::vector<GPUTrack> gpu_tracks_;
     std::vector<CounterTrack> counter_tracks_;
     
-    // Event conversion helpers
-    std::string getEventCategory(EventType type);
-    
     // Track event type conversion
     enum class PerfettoEventType {
         SliceBegin,
@@ -145,9 +183,131 @@ private:
     PerfettoEventType mapEventTypeToPerfetto(EventType type);
 #endif
     
+    // Event conversion helpers
+    static const std::string& getEventCategory(EventType type);
+    
+    static bool isProtoFile(const std::string& output_file);
+    
+    /// Encode events and counters; flushes to out in chunks when non-null
+    bool writeProto(const std::vector<TraceEvent>& events,
+                    const std::vector<CounterEvent>& counters,
+                    PerfettoProtoWriter& writer, std::ostream* out) const;
+    
     // JSON fallback
     bool exportToJSON(const std::vector<TraceEvent>& events, 
                      const std::string& output_file);
+    
+    friend class PerfettoLiveStreamer;
+};
+
+/// Streams a running session's events as Perfetto TracePackets
+/// 
+/// A drain thread wakes every interval, pops what the ring buffers hold
+/// and encodes it into the front buffer, then swaps it with the back
+/// buffer that an I/O thread writes to a file or Unix-domain socket while
+/// the next batch is encoded. The drain only waits for I/O when the last
+/// batch is still being written, so memory stays at two buffers and an
+/// event reaches the output within about one interval plus one write.
+/// 
+/// Output is length-delimited packets (perfetto.protos.Trace field 1), so
+/// every flushed prefix is a valid trace. Tracks are described the first
+/// time a device, stream or counter appears. An event with a correlation
+/// ID is held until the next event with that ID arrives, and the two are
+/// written as a flow. An event left unmatched for eight intervals, or while
+/// too many are held, is written without a flow, so the held set stays
+/// bounded and the output has no dangling flow starts.
+/// 
+/// The drain thread is the ring buffers' only consumer until stop().
+class PerfettoLiveStreamer {
+public:
+    struct Statistics {
+        uint64_t events_written = 0;
+        uint64_t counters_written = 0;
+        uint64_t packets_written = 0;
+        uint64_t bytes_written = 0;
+        uint64_t flushes = 0;
+    };
+    
+    PerfettoLiveStreamer(RingBuffer<TraceEvent>& events, RingBuffer<CounterEvent>& counters);
+    ~PerfettoLiveStreamer();
+    
+    PerfettoLiveStreamer(const PerfettoLiveStreamer&) = delete;
+    PerfettoLiveStreamer& operator=(const PerfettoLiveStreamer&) = delete;
+    
+    /// Write to a file (truncated)
+    bool openFile(const std::string& path);
+    
+    /// Write to a listening Unix-domain socket (not available on Windows)
+    bool connectSocket(const std::string& path);
+    
+    /// Start the drain and I/O threads; requires an open output
+    bool start(uint32_t flush_interval_ms);
+    
+    /// Drain what is left, write it out and close the output
+    void stop();
+    
+    bool isRunning() const { return drain_thread_.joinable(); }
+    
+    /// False once a write to the output has failed
+    bool good() const { return good_.load(std::memory_order_relaxed); }
+    
+    Statistics getStatistics() const;
+
+private:
+    RingBuffer<TraceEvent>& events_;
+    RingBuffer<CounterEvent>& counters_;
+    uint32_t flush_interval_ms_ = 100;
+    
+    // Output: a FILE* or a socket descriptor
+    std::FILE* file_ = nullptr;
+    int socket_fd_ = -1;
+    std::atomic<bool> good_{true};
+    
+    // Drain thread state (encoder side)
+    std::unique_ptr<PerfettoProtoWriter> writer_;
+    std::vector<TraceEvent> event_batch_;
+    std::vector<CounterEvent> counter_batch_;
+    std::unordered_set<uint32_t> devices_;
+    std::unordered_set<uint64_t> streams_;
+    std::unordered_map<std::string, uint64_t> counter_tracks_;
+    
+    // Events waiting for their correlation partner, oldest first in
+    // held_order_ (entries whose event was matched are skipped lazily)
+    struct HeldEvent {
+        TraceEvent event;
+        uint64_t sequence = 0;
+        uint64_t drain = 0;
+    };
+    std::unordered_map<uint64_t, HeldEvent> held_flows_;
+    std::deque<std::pair<uint64_t, uint64_t>> held_order_;  // (correlation ID, sequence)
+    uint64_t held_sequence_ = 0;
+    uint64_t drain_count_ = 0;
+    
+    std::thread drain_thread_;
+    std::mutex drain_mutex_;
+    std::condition_variable drain_cv_;
+    bool drain_stop_ = false;
+    
+    // Double buffer: the drain fills writer_, the I/O thread writes back_
+    std::vector<uint8_t> back_;
+    bool back_busy_ = false;
+    bool io_stop_ = false;
+    std::thread io_thread_;
+    std::mutex io_mutex_;
+    std::condition_variable io_cv_;
+    
+    std::atomic<uint64_t> events_written_{0};
+    std::atomic<uint64_t> counters_written_{0};
+    std::atomic<uint64_t> packets_written_{0};
+    std::atomic<uint64_t> bytes_written_{0};
+    std::atomic<uint64_t> flushes_{0};
+    
+    void drainLoop();
+    void drainOnce(bool final);
+    void submit();
+    void ioLoop();
+    bool writeOutput(const uint8_t* data, size_t size);
+    void closeOutput();
 };
 
 /// Real-time tracing session (v0.3.0 full implementation)
@@ -173,7 +333,8 @@ public:
     /// Tracing mode
     enum class Mode {
         InProcess,      // In-process circular buffer
-        File            // Direct file output
+        File,           // Direct file output
+        Live            // Packets streamed to a file or socket while running
     };
     
     /// Session statistics
@@ -181,6 +342,7 @@ public:
         uint64_t events_emitted = 0;
         uint64_t events_dropped = 0;
         uint64_t counters_emitted = 0;
+        uint64_t bytes_streamed = 0;    // Live mode
         Timestamp start_time = 0;
         Timestamp stop_time = 0;
         
@@ -220,6 +382,12 @@ public:
         stats_ = Statistics{};
         stats_.start_time = getCurrentTimestamp();
         
+        mode_ = Mode::InProcess;
+        if (config.live_streaming && !startStreaming(config)) {
+            state_ = State::Stopped;
+            return false;
+        }
+        
         state_ = State::Running;
         return true;
     }
@@ -231,6 +399,13 @@ public:
         state_ = State::Stopping;
         stats_.stop_time = getCurrentTimestamp();
         
+        // The streamer drains the buffers itself until it stops
+        if (streamer_) {
+            streamer_->stop();
+            stats_.bytes_streamed = streamer_->getStatistics().bytes_written;
+            streamer_.reset();
+        }
+        
         // Flush remaining events from buffer
         flushEvents();
         flushCounters();
@@ -291,7 +466,8 @@ public:
         return success;
     }
     
-    /// Get all captured events (call after stop)
+    /// Get all captured events (call after stop; empty in live mode,
+    /// where events go to the stream instead)
     const std::vector<TraceEvent>& getEvents() const { return flushed_events_; }
     
     /// Get all captured counters (call after stop)
@@ -316,8 +492,26 @@ public:
     size_t eventBufferSize() const { return event_buffer_.size(); }
     size_t eventBufferCapacity() const { return event_buffer_.capacity(); }
     uint64_t eventsDropped() const { return event_buffer_.droppedCount(); }
+    
+    /// Bytes written to the live stream so far (whole batches only)
+    uint64_t bytesStreamed() const {
+        return streamer_ ? streamer_->getStatistics().bytes_written : stats_.bytes_streamed;
+    }
 
 private:
+    bool startStreaming(const TracingConfig& config) {
+        streamer_ = std::make_unique<PerfettoLiveStreamer>(event_buffer_, counter_buffer_);
+        bool opened = config.socket_path.empty()
+            ? streamer_->openFile(config.output_file)
+            : streamer_->connectSocket(config.socket_path);
+        if (!opened || !streamer_->start(config.flush_interval_ms)) {
+            streamer_.reset();
+            return false;
+        }
+        mode_ = Mode::Live;
+        return true;
+    }
+    
     void flushEvents() {
         event_buffer_.popBatch(flushed_events_, event_buffer_.capacity());
     }
@@ -338,6 +532,9 @@ private:
     // Flushed data storage
     std::vector<TraceEvent> flushed_events_;
     std::vector<CounterEvent> flushed_counters_;
+    
+    // Live mode only
+    std::unique_ptr<PerfettoLiveStreamer> streamer_;
 };
 
 } // namespace tracesmith
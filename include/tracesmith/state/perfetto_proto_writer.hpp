@@ -0,0 +1,257 @@
+#pragma once
+
+#include "tracesmith/common/types.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tracesmith {
+
+/// Perfetto trace protobuf constants (subset of perfetto/trace/*.proto)
+namespace pftrace {
+    // Trace
+    constexpr uint32_t TRACE_PACKET = 1;
+
+    // TracePacket
+    constexpr uint32_t PACKET_TIMESTAMP = 8;
+    constexpr uint32_t PACKET_SEQUENCE_ID = 10;     // trusted_packet_sequence_id
+    constexpr uint32_t PACKET_TRACK_EVENT = 11;
+    constexpr uint32_t PACKET_INTERNED_DATA = 12;
+    constexpr uint32_t PACKET_SEQUENCE_FLAGS = 13;
+    constexpr uint32_t PACKET_TRACK_DESCRIPTOR = 60;
+
+    constexpr uint32_t SEQ_INCREMENTAL_STATE_CLEARED = 1;
+    constexpr uint32_t SEQ_NEEDS_INCREMENTAL_STATE = 2;
+
+    // InternedData
+    constexpr uint32_t INTERNED_EVENT_CATEGORIES = 1;
+    constexpr uint32_t INTERNED_EVENT_NAMES = 2;
+    constexpr uint32_t INTERNED_IID = 1;             // EventCategory / EventName
+    constexpr uint32_t INTERNED_NAME = 2;
+
+    // TrackDescriptor
+    constexpr uint32_t TRACK_UUID = 1;
+    constexpr uint32_t TRACK_NAME = 2;
+    constexpr uint32_t TRACK_PROCESS = 3;
+    constexpr uint32_t TRACK_THREAD = 4;
+    constexpr uint32_t TRACK_PARENT_UUID = 5;
+    constexpr uint32_t TRACK_COUNTER = 8;
+    constexpr uint32_t PROCESS_PID = 1;
+    constexpr uint32_t PROCESS_NAME = 6;
+    constexpr uint32_t THREAD_PID = 1;
+    constexpr uint32_t THREAD_TID = 2;
+    constexpr uint32_t THREAD_NAME = 5;
+    constexpr uint32_t COUNTER_UNIT_NAME = 6;
+
+    // TrackEvent
+    constexpr uint32_t EVENT_CATEGORY_IIDS = 3;
+    constexpr uint32_t EVENT_DEBUG_ANNOTATIONS = 4;
+    constexpr uint32_t EVENT_TYPE = 9;
+    constexpr uint32_t EVENT_NAME_IID = 10;
+    constexpr uint32_t EVENT_TRACK_UUID = 11;
+    constexpr uint32_t EVENT_DOUBLE_COUNTER_VALUE = 44;
+    constexpr uint32_t EVENT_FLOW_IDS = 47;
+    constexpr uint32_t EVENT_TERMINATING_FLOW_IDS = 48;
+
+    constexpr uint32_t TYPE_SLICE_BEGIN = 1;
+    constexpr uint32_t TYPE_SLICE_END = 2;
+    constexpr uint32_t TYPE_INSTANT = 3;
+    constexpr uint32_t TYPE_COUNTER = 4;
+
+    // DebugAnnotation
+    constexpr uint32_t ANNOTATION_UINT_VALUE = 3;
+    constexpr uint32_t ANNOTATION_INT_VALUE = 4;
+    constexpr uint32_t ANNOTATION_DOUBLE_VALUE = 5;
+    constexpr uint32_t ANNOTATION_STRING_VALUE = 6;
+    constexpr uint32_t ANNOTATION_NAME = 10;
+
+    // Wire types
+    constexpr uint32_t WIRE_VARINT = 0;
+    constexpr uint32_t WIRE_FIXED64 = 1;
+    constexpr uint32_t WIRE_BYTES = 2;
+}
+
+/**
+ * Minimal protobuf encoder appending to a byte buffer.
+ *
+ * Nested messages reserve a 4-byte redundant varint for their length and
+ * patch it on close (the ProtoZero technique), so no message is ever
+ * built twice. Nested messages are limited to 256 MB.
+ */
+class ProtoEncoder {
+public:
+    explicit ProtoEncoder(std::vector<uint8_t>& buffer) : buffer_(buffer) {}
+
+    void writeVarint(uint64_t value);
+    void writeTag(uint32_t field, uint32_t wire_type);
+
+    void addVarint(uint32_t field, uint64_t value);
+    void addSignedVarint(uint32_t field, int64_t value);
+    void addDouble(uint32_t field, double value);
+    void addString(uint32_t field, const std::string& value);
+
+    /// Open a nested message; returns a token for endNested()
+    size_t beginNested(uint32_t field);
+    void endNested(size_t token);
+
+private:
+    std::vector<uint8_t>& buffer_;
+};
+
+/// A debug annotation attached to a track event
+struct ProtoAnnotation {
+    enum class Kind { Uint, Int, Double, String };
+
+    std::string name;
+    Kind kind = Kind::Uint;
+    uint64_t uint_value = 0;
+    int64_t int_value = 0;
+    double double_value = 0.0;
+    std::string string_value;
+
+    static ProtoAnnotation ofUint(std::string name, uint64_t value);
+    static ProtoAnnotation ofInt(std::string name, int64_t value);
+    static ProtoAnnotation ofDouble(std::string name, double value);
+    static ProtoAnnotation ofString(std::string name, std::string value);
+};
+
+/**
+ * Streaming writer for Perfetto's binary trace format without the SDK.
+ *
+ * Encodes the TracePacket/TrackEvent subset TraceSmith needs: track
+ * descriptors (process, thread, counter), slices, instants, counters and
+ * flows. Event names and categories are interned per packet sequence;
+ * the first packet after a reset clears incremental state and carries
+ * the interned entries it introduces.
+ *
+ * Packets are appended to an in-memory buffer; call flushTo() as often
+ * as convenient to stream them out. Every packet is framed as a
+ * `Trace.packet` field, so buffers from several writers can be
+ * concatenated into one valid trace as long as their sequence IDs differ.
+ *
+ * Usage:
+ *   PerfettoProtoWriter writer;
+ *   uint64_t gpu = writer.addProcessTrack(1, 0, "GPU 0");
+ *   uint64_t stream = writer.addThreadTrack(2, gpu, 0, 7, "Stream 7");
+ *   writer.writeSlice(stream, ts, dur, "gemm", "kernel");
+ *   writer.flushTo(out);
+ */
+class PerfettoProtoWriter {
+public:
+    explicit PerfettoProtoWriter(uint32_t sequence_id = 1);
+
+    /// Track descriptors (uuid must be unique and non-zero)
+    void addProcessTrack(uint64_t uuid, uint32_t pid, const std::string& name);
+    void addThreadTrack(uint64_t uuid, uint64_t parent_uuid, uint32_t pid, uint32_t tid,
+                        const std::string& name);
+    void addCounterTrack(uint64_t uuid, uint64_t parent_uuid, const std::string& name,
+                         const std::string& unit = "");
+
+    /// Begin/end pair; flow_ids start flows here, terminating_flow_ids end them
+    void writeSlice(uint64_t track_uuid, Timestamp timestamp, Timestamp duration,
+                    const std::string& name, const std::string& category,
+                    const std::vector<ProtoAnnotation>& annotations = {},
+                    const std::vector<uint64_t>& flow_ids = {},
+                    const std::vector<uint64_t>& terminating_flow_ids = {});
+
+    void writeInstant(uint64_t track_uuid, Timestamp timestamp,
+                      const std::string& name, const std::string& category,
+                      const std::vector<ProtoAnnotation>& annotations = {},
+                      const std::vector<uint64_t>& flow_ids = {},
+                      const std::vector<uint64_t>& terminating_flow_ids = {});
+
+    void writeCounter(uint64_t track_uuid, Timestamp timestamp, double value);
+    
+    /// Interned IDs for one event; new entries are emitted with its packet
+    struct InternedIds {
+        uint64_t name_iid = 0;
+        uint64_t category_iid = 0;
+        bool new_name = false;
+        bool new_category = false;
+    };
+    
+    /**
+     * Intern a name and category exactly as writeSlice()/writeInstant()
+     * would, without writing anything. Resolving IDs up front lets other
+     * writers encode events of this sequence in parallel (see the
+     * overloads below) and still produce the bytes this writer would.
+     */
+    InternedIds intern(const std::string& name, const std::string& category);
+    
+    void writeSlice(uint64_t track_uuid, Timestamp timestamp, Timestamp duration,
+                    const std::string& name, const std::string& category,
+                    const InternedIds& ids,
+                    const std::vector<ProtoAnnotation>& annotations = {},
+                    const std::vector<uint64_t>& flow_ids = {},
+                    const std::vector<uint64_t>& terminating_flow_ids = {});
+    
+    void writeInstant(uint64_t track_uuid, Timestamp timestamp,
+                      const std::string& name, const std::string& category,
+                      const InternedIds& ids,
+                      const std::vector<ProtoAnnotation>& annotations = {},
+                      const std::vector<uint64_t>& flow_ids = {},
+                      const std::vector<uint64_t>& terminating_flow_ids = {});
+    
+    /// Continue a sequence another writer started, whose packets will
+    /// precede this writer's once appended
+    void continueSequence(uint32_t sequence_id, bool state_cleared) {
+        sequence_id_ = sequence_id;
+        state_cleared_ = state_cleared;
+    }
+    
+    /// Move another writer's buffered packets (same sequence) to the end of this one
+    void append(PerfettoProtoWriter& other);
+    
+    /// Whether a packet has already cleared incremental state
+    bool incrementalStateCleared() const { return state_cleared_; }
+
+    /**
+     * Drop interned state; the next event re-interns what it uses. Lets a
+     * reader that joins a live stream mid-way decode from this point on.
+     */
+    void resetIncrementalState();
+
+    /// Encoded packets not yet flushed
+    const std::vector<uint8_t>& data() const { return buffer_; }
+    size_t size() const { return buffer_.size(); }
+
+    /// Write buffered packets to out and clear the buffer
+    bool flushTo(std::ostream& out);
+
+    /// Move buffered packets out
+    std::vector<uint8_t> takeData();
+
+    /// Exchange buffered packets for spare, which must be empty; its
+    /// capacity is reused for the packets that follow
+    void swapData(std::vector<uint8_t>& spare) { buffer_.swap(spare); }
+
+    /// Packets written since construction
+    uint64_t packetCount() const { return packet_count_; }
+
+    uint32_t sequenceId() const { return sequence_id_; }
+
+private:
+    uint32_t sequence_id_;
+    std::vector<uint8_t> buffer_;
+    uint64_t packet_count_ = 0;
+    bool state_cleared_ = false;
+
+    // Interning tables (string -> iid), valid since the last reset
+    std::unordered_map<std::string, uint64_t> name_iids_;
+    std::unordered_map<std::string, uint64_t> category_iids_;
+
+    size_t beginPacket(ProtoEncoder& encoder, Timestamp timestamp, bool needs_state);
+    void endPacket(ProtoEncoder& encoder, size_t token);
+
+    void writeTrackEvent(uint64_t track_uuid, Timestamp timestamp, uint32_t type,
+                         const std::string* name, const std::string* category,
+                         const InternedIds& ids,
+                         const std::vector<ProtoAnnotation>* annotations,
+                         const std::vector<uint64_t>* flow_ids,
+                         const std::vector<uint64_t>* terminating_flow_ids,
+                         const double* counter_value);
+};
+
+} // namespace tracesmith
@@ -66,6 +66,7 @@
 // =============================================================================
 #include "tracesmith/state/gpu_state_machine.hpp"
 #include "tracesmith/state/instruction_stream.hpp"
+#include "tracesmith/state/critical_path.hpp"
 #include "tracesmith/state/timeline_builder.hpp"
 #include "tracesmith/state/timeline_viewer.hpp"
 #include "tracesmith/state/perfetto_exporter.hpp"
@@ -79,6 +80,9 @@
 #include "tracesmith/replay/determinism_checker.hpp"
 #include "tracesmith/replay/operation_executor.hpp"
 #include "tracesmith/replay/stream_scheduler.hpp"
+#include "tracesmith/replay/pacing_timer.hpp"
+#include "tracesmith/replay/parallel_executor.hpp"
+#include "tracesmith/replay/replay_simulator.hpp"
 #include "tracesmith/replay/frame_capture.hpp"
 
 // =============================================================================
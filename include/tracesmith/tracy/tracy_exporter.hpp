@@ -131,6 +131,11 @@ public:
     
     /**
      * Batch export multiple events
+     * 
+     * GPU work (kernels, copies, syncs) is grouped per device and emitted
+     * as zones on that device's GPU timeline, taking the context lock and
+     * the source location cache lock once per batch. Other events go
+     * through emitEvent(). With enable_gpu_zones off, every event does.
      */
     void exportEvents(const std::vector<TraceEvent>& events);
     
@@ -224,7 +229,9 @@ public:
     
 private:
     // Implementation helpers
+    bool shouldEmit(EventType type) const;
     void emitTraceEventInternal(const TraceEvent& event);
+    TracyGpuContext* zoneContextLocked(uint32_t device_id);
     void setupDefaultPlots();
     uint32_t allocateQueryId();
     
@@ -241,6 +248,17 @@ private:
     std::unordered_map<uint32_t, uint8_t> gpu_contexts_;
     std::mutex gpu_context_mutex_;
     
+    // Timeline contexts for batched zones (device_id -> context) and the
+    // per-device scratch lists reused across batches; guarded by
+    // gpu_context_mutex_
+    struct ZoneBatch {
+        uint32_t device_id = 0;
+        TracyGpuContext* context = nullptr;
+        std::vector<const TraceEvent*> events;
+    };
+    std::unordered_map<uint32_t, TracyGpuContext*> zone_contexts_;
+    std::vector<ZoneBatch> zone_batches_;
+    
     // Configured plots
     std::unordered_map<std::string, bool> configured_plots_;
     std::mutex plot_mutex_;
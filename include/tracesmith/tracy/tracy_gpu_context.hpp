@@ -27,11 +27,18 @@
 #endif
 
 #include <string>
+#include <string_view>
 #include <atomic>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 #include <cstdint>
 
+// Declared here so the header also compiles without the Tracy client
+namespace tracy {
+struct SourceLocationData;
+}
+
 namespace tracesmith {
 namespace tracy {
 
@@ -71,6 +78,25 @@ inline GpuContextType platformToGpuContextType(PlatformType platform) {
     }
 }
 
+/**
+ * Whether an event is GPU work that belongs on a GPU timeline
+ */
+inline bool isGpuTimelineEvent(EventType type) {
+    switch (type) {
+        case EventType::KernelLaunch:
+        case EventType::KernelComplete:
+        case EventType::MemcpyH2D:
+        case EventType::MemcpyD2H:
+        case EventType::MemcpyD2D:
+        case EventType::MemsetDevice:
+        case EventType::StreamSync:
+        case EventType::DeviceSync:
+            return true;
+        default:
+            return false;
+    }
+}
+
 /**
  * TracyGpuContext - Full GPU timeline support for any GPU platform
  * 
@@ -142,9 +168,20 @@ public:
     
     /**
      * Emit multiple GPU zones from TraceSmith events
+     * Non-GPU events are skipped
      */
     void emitGpuZones(const std::vector<TraceEvent>& events);
     
+    /**
+     * Emit a batch of GPU zones
+     * 
+     * Source locations are resolved under a single cache lock and the
+     * batch's query IDs are reserved with one atomic add, so the per-zone
+     * cost is just the queue items Tracy needs. Events are emitted as
+     * given; callers filter out non-GPU events.
+     */
+    void emitGpuZones(const TraceEvent* const* events, size_t count);
+    
     // =========================================================================
     // Timestamp Calibration
     // =========================================================================
@@ -180,6 +217,12 @@ private:
                           int64_t gpu_start, int64_t gpu_end,
                           uint32_t thread_id, uint32_t color);
     
+    // Queue one zone with a resolved source location and query ID pair
+    void writeZone(const ::tracy::SourceLocationData* src_loc, uint16_t query_id,
+                   int64_t cpu_start, int64_t cpu_end,
+                   int64_t gpu_start, int64_t gpu_end,
+                   uint32_t thread_id);
+    
     std::string name_;
     GpuContextType type_;
     uint32_t device_id_;
@@ -193,11 +236,15 @@ private:
     int64_t last_calibration_gpu_ = 0;
     
     // Source location for zones (persistent memory)
+    // Keys view the interned name owned by each location, so lookups
+    // do not allocate
     struct SourceLocationCache {
-        std::unordered_map<std::string, ::tracy::SourceLocationData*> locations;
+        std::unordered_map<std::string_view, ::tracy::SourceLocationData*> locations;
         std::mutex mutex;
         
-        ::tracy::SourceLocationData* getOrCreate(const std::string& name, uint32_t color);
+        ::tracy::SourceLocationData* getOrCreate(std::string_view name, uint32_t color);
+        // Caller holds mutex
+        ::tracy::SourceLocationData* getOrCreateLocked(std::string_view name, uint32_t color);
         ~SourceLocationCache();
     };
     static SourceLocationCache& getSourceLocationCache();
@@ -36,11 +36,13 @@
 // Replay
 #include "tracesmith/replay/replay_engine.hpp"
 #include "tracesmith/replay/frame_capture.hpp"
+#include "tracesmith/replay/capture_file.hpp"
 
 // Common (additional)
 #include "tracesmith/common/xray_importer.hpp"
 #include "tracesmith/state/gpu_state_machine.hpp"
 #include "tracesmith/state/instruction_stream.hpp"
+#include "tracesmith/state/critical_path.hpp"
 #include "tracesmith/common/stack_capture.hpp"
 #include "tracesmith/common/ring_buffer.hpp"
 
@@ -289,6 +291,41 @@ PYBIND11_MODULE(_tracesmith, m) {
         .value("Block", OverflowPolicy::Block)
         .export_values();
     
+    // Capture-time sampling
+    py::class_<SamplingRule>(m, "SamplingRule",
+        "Name-based filtering/sampling rule applied at capture time")
+        .def(py::init<>())
+        .def_readwrite("pattern", &SamplingRule::pattern,
+                       "Event name glob ('*' any run, '?' any character)")
+        .def_readwrite("type", &SamplingRule::type,
+                       "Only match this event type (Unknown = any)")
+        .def_readwrite("exclude", &SamplingRule::exclude,
+                       "Drop every matching event")
+        .def_readwrite("sample_every", &SamplingRule::sample_every,
+                       "Keep 1 in N events per name")
+        .def_readwrite("max_per_second", &SamplingRule::max_per_second,
+                       "Per-name rate limit (0 = unlimited)")
+        .def_readwrite("keep_slower_than_ns", &SamplingRule::keep_slower_than_ns,
+                       "Always keep events at least this long (0 = off)");
+    
+    py::class_<SamplingConfig>(m, "SamplingConfig",
+        "Capture-time sampling rules; the first match applies")
+        .def(py::init<>())
+        .def_readwrite("rules", &SamplingConfig::rules);
+    
+    py::class_<SamplingCounters>(m, "SamplingCounters",
+        "Exact counts of capture-time sampling decisions")
+        .def(py::init<>())
+        .def_readonly("seen", &SamplingCounters::seen)
+        .def_readonly("kept", &SamplingCounters::kept)
+        .def_readonly("kept_slow", &SamplingCounters::kept_slow)
+        .def_readonly("filtered", &SamplingCounters::filtered)
+        .def_readonly("sampled_out", &SamplingCounters::sampled_out)
+        .def_readonly("rate_limited", &SamplingCounters::rate_limited)
+        .def_readonly("dropped_duration_ns", &SamplingCounters::dropped_duration_ns)
+        .def("weight", &SamplingCounters::weight,
+             "Events each non-slow kept event stands for");
+    
     // ProfilerConfig class
     py::class_<ProfilerConfig>(m, "ProfilerConfig",
         "Configuration options for GPU profilers")
@@ -314,7 +351,9 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def_readwrite("capture_sync", &ProfilerConfig::capture_sync,
                        "Whether to capture synchronization events")
         .def_readwrite("capture_alloc", &ProfilerConfig::capture_alloc,
-                       "Whether to capture allocation events");
+                       "Whether to capture allocation events")
+        .def_readwrite("sampling", &ProfilerConfig::sampling,
+                       "Name-based filtering and sampling rules");
     
     // SBTResult struct
     py::class_<SBTResult>(m, "SBTResult",
@@ -417,7 +456,12 @@ PYBIND11_MODULE(_tracesmith, m) {
              py::arg("events"), py::arg("counters"))
         .def("set_enable_gpu_tracks", &PerfettoExporter::setEnableGPUTracks)
         .def("set_enable_flow_events", &PerfettoExporter::setEnableFlowEvents)
-        .def("set_enable_counter_tracks", &PerfettoExporter::setEnableCounterTracks);
+        .def("set_enable_counter_tracks", &PerfettoExporter::setEnableCounterTracks)
+        .def("set_compact", &PerfettoExporter::setCompact, py::arg("compact"))
+        .def("set_gzip", &PerfettoExporter::setGzip, py::arg("enable"), py::arg("level") = 1)
+        .def_static("is_gzip_available", &PerfettoExporter::isGzipAvailable)
+        .def("set_parallelism", &PerfettoExporter::setParallelism, py::arg("num_threads"))
+        .def("parallelism", &PerfettoExporter::parallelism);
     
     // PerfettoProtoExporter class (Protobuf format - v0.2.0)
     py::enum_<PerfettoProtoExporter::Format>(m, "PerfettoFormat")
@@ -428,10 +472,14 @@ PYBIND11_MODULE(_tracesmith, m) {
     py::class_<PerfettoProtoExporter>(m, "PerfettoProtoExporter")
         .def(py::init<PerfettoProtoExporter::Format>(),
              py::arg("format") = PerfettoProtoExporter::Format::PROTOBUF)
-        .def("export_to_file", &PerfettoProtoExporter::exportToFile,
+        .def("export_to_file",
+             py::overload_cast<const std::vector<TraceEvent>&, const std::string&>(
+                 &PerfettoProtoExporter::exportToFile),
              py::arg("events"), py::arg("output_file"),
              "Export events to file (auto-detects format from extension)")
         .def("get_format", &PerfettoProtoExporter::getFormat)
+        .def("set_parallelism", &PerfettoProtoExporter::setParallelism, py::arg("num_threads"))
+        .def("parallelism", &PerfettoProtoExporter::parallelism)
         .def_static("is_sdk_available", &PerfettoProtoExporter::isSDKAvailable,
                    "Check if Perfetto SDK is available for protobuf export");
     
@@ -446,13 +494,28 @@ PYBIND11_MODULE(_tracesmith, m) {
     py::enum_<TracingSession::Mode>(m, "TracingMode")
         .value("InProcess", TracingSession::Mode::InProcess)
         .value("File", TracingSession::Mode::File)
+        .value("Live", TracingSession::Mode::Live)
         .export_values();
     
+    py::class_<TracingConfig>(m, "TracingConfig")
+        .def(py::init<>())
+        .def_readwrite("buffer_size_kb", &TracingConfig::buffer_size_kb)
+        .def_readwrite("duration_ms", &TracingConfig::duration_ms)
+        .def_readwrite("write_to_file", &TracingConfig::write_to_file)
+        .def_readwrite("output_file", &TracingConfig::output_file)
+        .def_readwrite("enable_gpu_tracks", &TracingConfig::enable_gpu_tracks)
+        .def_readwrite("enable_counter_tracks", &TracingConfig::enable_counter_tracks)
+        .def_readwrite("enable_flow_events", &TracingConfig::enable_flow_events)
+        .def_readwrite("live_streaming", &TracingConfig::live_streaming)
+        .def_readwrite("socket_path", &TracingConfig::socket_path)
+        .def_readwrite("flush_interval_ms", &TracingConfig::flush_interval_ms);
+    
     py::class_<TracingSession::Statistics>(m, "TracingStatistics")
         .def(py::init<>())
         .def_readwrite("events_emitted", &TracingSession::Statistics::events_emitted)
         .def_readwrite("events_dropped", &TracingSession::Statistics::events_dropped)
         .def_readwrite("counters_emitted", &TracingSession::Statistics::counters_emitted)
+        .def_readwrite("bytes_streamed", &TracingSession::Statistics::bytes_streamed)
         .def_readwrite("start_time", &TracingSession::Statistics::start_time)
         .def_readwrite("stop_time", &TracingSession::Statistics::stop_time)
         .def("duration_ms", &TracingSession::Statistics::duration_ms);
@@ -483,7 +546,8 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def("clear", &TracingSession::clear)
         .def("event_buffer_size", &TracingSession::eventBufferSize)
         .def("event_buffer_capacity", &TracingSession::eventBufferCapacity)
-        .def("events_dropped", &TracingSession::eventsDropped);
+        .def("events_dropped", &TracingSession::eventsDropped)
+        .def("bytes_streamed", &TracingSession::bytesStreamed);
     
     // ReplayMode enum
     py::enum_<ReplayMode>(m, "ReplayMode")
@@ -491,6 +555,49 @@ PYBIND11_MODULE(_tracesmith, m) {
         .value("Partial", ReplayMode::Partial)
         .value("DryRun", ReplayMode::DryRun)
         .value("StreamSpecific", ReplayMode::StreamSpecific)
+        .value("Simulate", ReplayMode::Simulate)
+        .export_values();
+    
+    // Simulation (ReplayMode::Simulate)
+    py::enum_<SimEngine>(m, "SimEngine")
+        .value("None_", SimEngine::None)
+        .value("Compute", SimEngine::Compute)
+        .value("Copy", SimEngine::Copy);
+    
+    py::class_<CostModel, std::shared_ptr<CostModel>>(m, "CostModel");
+    
+    py::class_<ScaledCostModel, CostModel, std::shared_ptr<ScaledCostModel>>(m, "ScaledCostModel")
+        .def(py::init<double>(), py::arg("default_scale") = 1.0)
+        .def("set_default_scale", &ScaledCostModel::setDefaultScale)
+        .def("set_type_scale", &ScaledCostModel::setTypeScale,
+             py::arg("type"), py::arg("scale"))
+        .def("set_name_scale", &ScaledCostModel::setNameScale,
+             py::arg("name"), py::arg("scale"));
+    
+    py::class_<SimulationConfig>(m, "SimulationConfig")
+        .def(py::init<>())
+        .def_readwrite("cost_model", &SimulationConfig::cost_model)
+        .def_readwrite("compute_slots", &SimulationConfig::compute_slots)
+        .def_readwrite("copy_engines", &SimulationConfig::copy_engines)
+        .def_readwrite("preserve_gaps", &SimulationConfig::preserve_gaps);
+    
+    py::class_<SimulationResult>(m, "SimulationResult")
+        .def_readonly("origin", &SimulationResult::origin)
+        .def_readonly("makespan", &SimulationResult::makespan)
+        .def_readonly("captured_makespan", &SimulationResult::captured_makespan)
+        .def_readonly("start", &SimulationResult::start)
+        .def_readonly("end", &SimulationResult::end)
+        .def_readonly("compute_busy_time", &SimulationResult::compute_busy_time)
+        .def_readonly("copy_busy_time", &SimulationResult::copy_busy_time)
+        .def_readonly("contention_wait_time", &SimulationResult::contention_wait_time)
+        .def_readonly("simulated_operations", &SimulationResult::simulated_operations)
+        .def_readonly("blocked_operations", &SimulationResult::blocked_operations);
+    
+    // SchedulingPolicy enum
+    py::enum_<SchedulingPolicy>(m, "SchedulingPolicy")
+        .value("RoundRobin", SchedulingPolicy::RoundRobin)
+        .value("Priority", SchedulingPolicy::Priority)
+        .value("OriginalTiming", SchedulingPolicy::OriginalTiming)
         .export_values();
     
     // ReplayConfig class
@@ -504,8 +611,23 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def_readwrite("verbose", &ReplayConfig::verbose)
         .def_readwrite("pause_on_error", &ReplayConfig::pause_on_error)
         .def_readwrite("time_scale", &ReplayConfig::time_scale)
+        .def_readwrite("scheduling", &ReplayConfig::scheduling)
+        .def_readwrite("stream_priorities", &ReplayConfig::stream_priorities)
+        .def_readwrite("timer_spin_ns", &ReplayConfig::timer_spin_ns)
+        .def_readwrite("parallel_streams", &ReplayConfig::parallel_streams)
+        .def_readwrite("streaming_window", &ReplayConfig::streaming_window)
+        .def_readwrite("simulation", &ReplayConfig::simulation)
         .def_readwrite("stream_id", &ReplayConfig::stream_id);
     
+    // DispatchJitterStats
+    py::class_<DispatchJitterStats>(m, "DispatchJitterStats")
+        .def(py::init<>())
+        .def_readonly("samples", &DispatchJitterStats::samples)
+        .def_readonly("mean", &DispatchJitterStats::mean)
+        .def_readonly("p50", &DispatchJitterStats::p50)
+        .def_readonly("p99", &DispatchJitterStats::p99)
+        .def_readonly("max", &DispatchJitterStats::max);
+    
     // ReplayResult class
     py::class_<ReplayResult>(m, "ReplayResult")
         .def(py::init<>())
@@ -520,6 +642,13 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def_readwrite("order_violations", &ReplayResult::order_violations)
         .def_readwrite("dependency_violations", &ReplayResult::dependency_violations)
         .def_readwrite("timing_violations", &ReplayResult::timing_violations)
+        .def_readwrite("dispatch_jitter", &ReplayResult::dispatch_jitter)
+        .def_readwrite("original_overlap", &ReplayResult::original_overlap)
+        .def_readwrite("achieved_overlap", &ReplayResult::achieved_overlap)
+        .def_readwrite("worker_threads", &ReplayResult::worker_threads)
+        .def_readwrite("windows", &ReplayResult::windows)
+        .def_readwrite("captured_makespan", &ReplayResult::captured_makespan)
+        .def_readwrite("simulated_makespan", &ReplayResult::simulated_makespan)
         .def_readwrite("errors", &ReplayResult::errors)
         .def_readwrite("warnings", &ReplayResult::warnings)
         .def("summary", &ReplayResult::summary);
@@ -529,7 +658,39 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def(py::init<>())
         .def("load_trace", &ReplayEngine::loadTrace)
         .def("load_events", &ReplayEngine::loadEvents)
-        .def("replay", &ReplayEngine::replay);
+        .def("replay", &ReplayEngine::replay)
+        .def("replay_streaming", &ReplayEngine::replayStreaming,
+             py::arg("filename"), py::arg("config"))
+        .def("get_simulation", &ReplayEngine::getSimulation,
+             py::return_value_policy::reference_internal)
+        .def("get_simulated_timeline", &ReplayEngine::getSimulatedTimeline);
+    
+    // DeterminismDiff class
+    py::class_<DeterminismDiff>(m, "DeterminismDiff")
+        .def(py::init<>())
+        .def_readonly("original_count", &DeterminismDiff::original_count)
+        .def_readonly("replayed_count", &DeterminismDiff::replayed_count)
+        .def_readonly("first_divergence", &DeterminismDiff::first_divergence)
+        .def_readonly("expected", &DeterminismDiff::expected)
+        .def_readonly("actual", &DeterminismDiff::actual)
+        .def_readonly("matched_operations", &DeterminismDiff::matched_operations)
+        .def_readonly("missing_operations", &DeterminismDiff::missing_operations)
+        .def_readonly("extra_operations", &DeterminismDiff::extra_operations)
+        .def_readonly("common_subsequence", &DeterminismDiff::common_subsequence)
+        .def_readonly("stream_reorders", &DeterminismDiff::stream_reorders)
+        .def("identical", &DeterminismDiff::identical)
+        .def("reordered_operations", &DeterminismDiff::reorderedOperations)
+        .def("summary", &DeterminismDiff::summary);
+    
+    m.def("compare_trace_files", [](const std::string& original, const std::string& replayed) {
+        DeterminismDiff diff;
+        std::string error;
+        if (!DeterminismChecker::compareFiles(original, replayed, diff, &error)) {
+            throw std::runtime_error(error);
+        }
+        return diff;
+    }, py::arg("original"), py::arg("replayed"),
+       "Compare the operation order of two SBT files");
     
     // ========================================================================
     // Frame Capture (RenderDoc-inspired) - v0.5.0
@@ -613,10 +774,24 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def_readonly("total_dispatches", &CapturedFrame::total_dispatches)
         .def_readonly("total_memory_ops", &CapturedFrame::total_memory_ops)
         .def_readonly("total_sync_ops", &CapturedFrame::total_sync_ops)
+        .def_readonly("resource_versions", &CapturedFrame::resource_versions)
         .def("duration", &CapturedFrame::duration)
         .def("get_resource_state_at", &CapturedFrame::getResourceStateAt,
              py::arg("resource_id"), py::arg("draw_call_id"));
     
+    // ChunkStore statistics (deduplicated capture contents)
+    py::class_<ChunkStore::Statistics>(m, "ChunkStoreStatistics")
+        .def(py::init<>())
+        .def_readonly("logical_bytes", &ChunkStore::Statistics::logical_bytes)
+        .def_readonly("stored_bytes", &ChunkStore::Statistics::stored_bytes)
+        .def_readonly("unique_chunks", &ChunkStore::Statistics::unique_chunks)
+        .def_readonly("duplicate_chunks", &ChunkStore::Statistics::duplicate_chunks)
+        .def_readonly("resident_bytes", &ChunkStore::Statistics::resident_bytes)
+        .def_readonly("spilled_bytes", &ChunkStore::Statistics::spilled_bytes)
+        .def_readonly("ingest_time_ns", &ChunkStore::Statistics::ingest_time_ns)
+        .def("dedup_ratio", &ChunkStore::Statistics::dedupRatio)
+        .def("overhead_ns_per_mb", &ChunkStore::Statistics::overheadNsPerMB);
+    
     // FrameCaptureConfig class
     py::class_<FrameCaptureConfig>(m, "FrameCaptureConfig")
         .def(py::init<>())
@@ -628,7 +803,16 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def_readwrite("capture_buffer_contents", &FrameCaptureConfig::capture_buffer_contents)
         .def_readwrite("capture_texture_contents", &FrameCaptureConfig::capture_texture_contents)
         .def_readwrite("max_buffer_capture_size", &FrameCaptureConfig::max_buffer_capture_size)
-        .def_readwrite("max_texture_capture_size", &FrameCaptureConfig::max_texture_capture_size);
+        .def_readwrite("max_texture_capture_size", &FrameCaptureConfig::max_texture_capture_size)
+        .def_property("chunk_size",
+            [](const FrameCaptureConfig& c) { return c.chunk_store.chunk_size; },
+            [](FrameCaptureConfig& c, size_t v) { c.chunk_store.chunk_size = v; })
+        .def_property("max_resident_bytes",
+            [](const FrameCaptureConfig& c) { return c.chunk_store.max_resident_bytes; },
+            [](FrameCaptureConfig& c, size_t v) { c.chunk_store.max_resident_bytes = v; })
+        .def_property("spill_path",
+            [](const FrameCaptureConfig& c) { return c.chunk_store.spill_path; },
+            [](FrameCaptureConfig& c, const std::string& v) { c.chunk_store.spill_path = v; });
     
     // FrameCapture class
     py::class_<FrameCapture>(m, "FrameCapture")
@@ -656,14 +840,70 @@ PYBIND11_MODULE(_tracesmith, m) {
              py::return_value_policy::reference_internal)
         .def("get_resource", &FrameCapture::getResource, py::arg("resource_id"),
              py::return_value_policy::reference_internal)
-        .def("get_resources", &FrameCapture::getResources,
-             py::return_value_policy::reference_internal)
+        .def("get_resources", [](const FrameCapture& self) {
+            std::map<uint64_t, ResourceState> resources;
+            for (const auto& [id, version] : self.getResources()) {
+                resources.emplace(id, *version);
+            }
+            return resources;
+        })
+        .def("read_resource_data", [](const FrameCapture& self, const ResourceState& state) {
+            std::vector<uint8_t> out;
+            if (!self.readResourceData(state, out)) {
+                throw std::runtime_error("Resource contents not available");
+            }
+            return py::bytes(reinterpret_cast<const char*>(out.data()), out.size());
+        }, py::arg("state"))
+        .def("get_chunk_store_stats", [](const FrameCapture& self) {
+            return self.getChunkStore().getStatistics();
+        })
         .def("replay_to_draw_call", &FrameCapture::replayToDrawCall,
              py::arg("frame_number"), py::arg("draw_call_id"))
         .def("export_to_perfetto", &FrameCapture::exportToPerfetto,
              py::arg("filename"), py::arg("frame_number"))
+        .def("save_capture", &FrameCapture::saveCapture, py::arg("filename"),
+             "Save captured frames to a frame capture file")
         .def("clear", &FrameCapture::clear);
     
+    // Frame capture file reader (lazy loading)
+    py::class_<CaptureFileReader::FrameSummary>(m, "CaptureFrameSummary")
+        .def_readonly("frame_number", &CaptureFileReader::FrameSummary::frame_number)
+        .def_readonly("start_time", &CaptureFileReader::FrameSummary::start_time)
+        .def_readonly("end_time", &CaptureFileReader::FrameSummary::end_time)
+        .def_readonly("resource_versions", &CaptureFileReader::FrameSummary::resource_versions)
+        .def_readonly("event_count", &CaptureFileReader::FrameSummary::event_count)
+        .def_readonly("draw_count", &CaptureFileReader::FrameSummary::draw_count);
+    
+    py::class_<CaptureFileReader>(m, "CaptureFileReader")
+        .def(py::init<const std::string&>(), py::arg("filename"))
+        .def("is_valid", &CaptureFileReader::isValid)
+        .def("last_error", &CaptureFileReader::lastError)
+        .def("frames", &CaptureFileReader::frames)
+        .def("draw_call_ids", &CaptureFileReader::drawCallIds, py::arg("frame_number"))
+        .def("read_draw_call", [](CaptureFileReader& self, uint64_t frame_number, uint64_t draw_call_id) {
+            DrawCallInfo draw;
+            if (!self.readDrawCall(frame_number, draw_call_id, draw)) {
+                throw std::runtime_error(self.lastError());
+            }
+            return draw;
+        }, py::arg("frame_number"), py::arg("draw_call_id"))
+        .def("read_resource_state_at", &CaptureFileReader::readResourceStateAt,
+             py::arg("frame_number"), py::arg("draw_call_id"), py::arg("resource_id"))
+        .def("read_resource_data", [](CaptureFileReader& self, const ResourceState& state) {
+            std::vector<uint8_t> out;
+            if (!self.readResourceData(state, out)) {
+                throw std::runtime_error(self.lastError());
+            }
+            return py::bytes(reinterpret_cast<const char*>(out.data()), out.size());
+        }, py::arg("state"))
+        .def("load_frame", [](CaptureFileReader& self, uint64_t frame_number) {
+            CapturedFrame frame;
+            if (!self.loadFrame(frame_number, frame)) {
+                throw std::runtime_error(self.lastError());
+            }
+            return frame;
+        }, py::arg("frame_number"));
+    
     // ResourceTracker class
     py::class_<ResourceTracker>(m, "ResourceTracker")
         .def(py::init<>())
@@ -747,7 +987,11 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def_readwrite("leak_threshold_ns", &MemoryProfiler::Config::leak_threshold_ns)
         .def_readwrite("track_call_stacks", &MemoryProfiler::Config::track_call_stacks)
         .def_readwrite("detect_double_free", &MemoryProfiler::Config::detect_double_free)
-        .def_readwrite("max_timeline_samples", &MemoryProfiler::Config::max_timeline_samples);
+        .def_readwrite("track_fragmentation", &MemoryProfiler::Config::track_fragmentation)
+        .def_readwrite("max_timeline_samples", &MemoryProfiler::Config::max_timeline_samples)
+        .def_readwrite("streaming_stats", &MemoryProfiler::Config::streaming_stats)
+        .def_readwrite("freed_sample_size", &MemoryProfiler::Config::freed_sample_size)
+        .def_readwrite("freed_spill_path", &MemoryProfiler::Config::freed_spill_path);
     
     // MemoryProfiler class
     py::class_<MemoryProfiler>(m, "MemoryProfiler")
@@ -756,9 +1000,13 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def("start", &MemoryProfiler::start)
         .def("stop", &MemoryProfiler::stop)
         .def("is_active", &MemoryProfiler::isActive)
-        .def("record_alloc", &MemoryProfiler::recordAlloc,
+        .def("record_alloc",
+             py::overload_cast<uint64_t, uint64_t, uint32_t, const std::string&, const std::string&>(
+                 &MemoryProfiler::recordAlloc),
              py::arg("ptr"), py::arg("size"), py::arg("device_id") = 0,
              py::arg("allocator") = "default", py::arg("tag") = "")
+        .def("intern_name", &MemoryProfiler::internName, py::arg("name"))
+        .def("name_of", &MemoryProfiler::nameOf, py::arg("id"))
         .def("record_free", &MemoryProfiler::recordFree,
              py::arg("ptr"), py::arg("device_id") = 0)
         .def("record_event", &MemoryProfiler::recordEvent, py::arg("event"))
@@ -767,6 +1015,7 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def("get_live_allocation_count", &MemoryProfiler::getLiveAllocationCount)
         .def("get_live_allocations", &MemoryProfiler::getLiveAllocations)
         .def("take_snapshot", &MemoryProfiler::takeSnapshot)
+        .def("get_timeline", &MemoryProfiler::getTimeline)
         .def("generate_report", &MemoryProfiler::generateReport)
         .def("detect_leaks", &MemoryProfiler::detectLeaks)
         .def("clear", &MemoryProfiler::clear)
@@ -805,7 +1054,9 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def_readwrite("include_custom_events", &XRayImporter::Config::include_custom_events)
         .def_readwrite("filter_short_calls", &XRayImporter::Config::filter_short_calls)
         .def_readwrite("min_duration_ns", &XRayImporter::Config::min_duration_ns)
-        .def_readwrite("symbol_file", &XRayImporter::Config::symbol_file);
+        .def_readwrite("symbol_file", &XRayImporter::Config::symbol_file)
+        .def_readwrite("use_symbol_cache", &XRayImporter::Config::use_symbol_cache)
+        .def_readwrite("keep_raw_records", &XRayImporter::Config::keep_raw_records);
     
     // XRayImporter::Statistics
     py::class_<XRayImporter::Statistics>(m, "XRayStatistics")
@@ -845,6 +1096,7 @@ PYBIND11_MODULE(_tracesmith, m) {
              py::return_value_policy::reference_internal)
         .def("set_symbol_file", &XRayImporter::setSymbolFile, py::arg("path"))
         .def("set_config", &XRayImporter::setConfig, py::arg("config"))
+        .def("set_parallelism", &XRayImporter::setParallelism, py::arg("num_threads"))
         .def_static("is_available", &XRayImporter::isAvailable);
     
     // ========================================================================
@@ -932,7 +1184,11 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def("events_captured", &IPlatformProfiler::eventsCaptured,
              "Get number of events captured")
         .def("events_dropped", &IPlatformProfiler::eventsDropped,
-             "Get number of events dropped");
+             "Get number of events dropped")
+        .def("sampling_totals", &IPlatformProfiler::samplingTotals,
+             "Counts of events removed by capture-time sampling")
+        .def("sampling_by_name", &IPlatformProfiler::samplingByName,
+             "Capture-time sampling counts per event name");
     
     m.def("create_profiler", [](PlatformType type) -> std::shared_ptr<IPlatformProfiler> {
         return createProfiler(type);
@@ -1045,6 +1301,7 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def("get_all_streams", &GPUStateMachine::getAllStreams)
         .def("get_statistics", &GPUStateMachine::getStatistics)
         .def("export_history", &GPUStateMachine::exportHistory)
+        .def("set_parallelism", &GPUStateMachine::setParallelism, py::arg("num_threads"))
         .def("reset", &GPUStateMachine::reset);
     
     // DependencyType enum
@@ -1095,8 +1352,56 @@ PYBIND11_MODULE(_tracesmith, m) {
         .def("has_dependency", &InstructionStreamBuilder::hasDependency)
         .def("get_statistics", &InstructionStreamBuilder::getStatistics)
         .def("export_to_dot", &InstructionStreamBuilder::exportToDot)
+        .def("set_parallelism", &InstructionStreamBuilder::setParallelism,
+             py::arg("num_threads"))
+        .def("node_count", &InstructionStreamBuilder::nodeCount)
+        .def("find_node", &InstructionStreamBuilder::findNode, py::arg("correlation_id"))
         .def("clear", &InstructionStreamBuilder::clear);
     
+    // CriticalPathEntry struct
+    py::class_<CriticalPathEntry>(m, "CriticalPathEntry")
+        .def(py::init<>())
+        .def_readwrite("correlation_id", &CriticalPathEntry::correlation_id)
+        .def_readwrite("name", &CriticalPathEntry::name)
+        .def_readwrite("type", &CriticalPathEntry::type)
+        .def_readwrite("stream_id", &CriticalPathEntry::stream_id)
+        .def_readwrite("start", &CriticalPathEntry::start)
+        .def_readwrite("duration", &CriticalPathEntry::duration)
+        .def_readwrite("gap", &CriticalPathEntry::gap);
+    
+    // WhatIfResult struct
+    py::class_<WhatIfResult>(m, "WhatIfResult")
+        .def(py::init<>())
+        .def_readwrite("name", &WhatIfResult::name)
+        .def_readwrite("speedup", &WhatIfResult::speedup)
+        .def_readwrite("affected_operations", &WhatIfResult::affected_operations)
+        .def_readwrite("original_makespan", &WhatIfResult::original_makespan)
+        .def_readwrite("predicted_makespan", &WhatIfResult::predicted_makespan)
+        .def("reduction", &WhatIfResult::reduction)
+        .def("reduction_percent", &WhatIfResult::reductionPercent);
+    
+    // CriticalPathResult struct
+    py::class_<CriticalPathResult>(m, "CriticalPathResult")
+        .def(py::init<>())
+        .def_readwrite("makespan", &CriticalPathResult::makespan)
+        .def_readwrite("path", &CriticalPathResult::path)
+        .def_readwrite("path_busy_time", &CriticalPathResult::path_busy_time)
+        .def_readwrite("path_gap_time", &CriticalPathResult::path_gap_time)
+        .def_readwrite("slack", &CriticalPathResult::slack)
+        .def_readwrite("path_time_by_name", &CriticalPathResult::path_time_by_name)
+        .def_readwrite("unreachable_nodes", &CriticalPathResult::unreachable_nodes);
+    
+    // CriticalPathAnalyzer class (keeps the analyzed builder alive)
+    py::class_<CriticalPathAnalyzer>(m, "CriticalPathAnalyzer")
+        .def(py::init<const InstructionStreamBuilder&>(), py::keep_alive<1, 2>(),
+             py::arg("graph"))
+        .def("analyze", &CriticalPathAnalyzer::analyze)
+        .def("what_if", &CriticalPathAnalyzer::whatIf,
+             py::arg("name"), py::arg("speedup") = 2.0)
+        .def("rank_speedups", &CriticalPathAnalyzer::rankSpeedups,
+             py::arg("speedup") = 2.0, py::arg("top_n") = 10)
+        .def("ordered_nodes", &CriticalPathAnalyzer::orderedNodes);
+    
     // TimelineViewer::ViewConfig
     py::class_<TimelineViewer::ViewConfig>(m, "TimelineViewConfig")
         .def(py::init<>())
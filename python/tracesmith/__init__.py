@@ -94,6 +94,9 @@ from ._tracesmith import (  # noqa: I001 - imports organized by category
     # ========================================================================
     FrameCapture,
     FrameCaptureConfig,
+    ChunkStoreStatistics,
+    CaptureFileReader,
+    CaptureFrameSummary,
     CapturedFrame,
     DrawCallInfo,
     ResourceState,
@@ -122,7 +125,16 @@ from ._tracesmith import (  # noqa: I001 - imports organized by category
     # ========================================================================
     ReplayConfig,
     ReplayResult,
+    SchedulingPolicy,
+    DispatchJitterStats,
+    SimEngine,
+    CostModel,
+    ScaledCostModel,
+    SimulationConfig,
+    SimulationResult,
     ReplayEngine,
+    DeterminismDiff,
+    compare_trace_files,
     # ========================================================================
     # State Module (GPU State Machine, Instruction Stream, Timeline Viewer)
     # ========================================================================
@@ -135,6 +147,10 @@ from ._tracesmith import (  # noqa: I001 - imports organized by category
     InstructionNode,
     InstructionStreamBuilder,
     InstructionStreamStatistics,
+    CriticalPathEntry,
+    CriticalPathResult,
+    CriticalPathAnalyzer,
+    WhatIfResult,
     TimelineViewConfig,
     TimelineViewer,
     # ========================================================================
@@ -380,6 +396,9 @@ __all__ = [
     # Frame Capture
     "FrameCapture",
     "FrameCaptureConfig",
+    "ChunkStoreStatistics",
+    "CaptureFileReader",
+    "CaptureFrameSummary",
     "CapturedFrame",
     "DrawCallInfo",
     "ResourceState",
@@ -400,6 +419,15 @@ __all__ = [
     # Replay
     "ReplayConfig",
     "ReplayResult",
+    "SchedulingPolicy",
+    "DispatchJitterStats",
+    "SimEngine",
+    "CostModel",
+    "ScaledCostModel",
+    "SimulationConfig",
+    "SimulationResult",
+    "DeterminismDiff",
+    "compare_trace_files",
     "ReplayEngine",
     # State Module
     "StateTransition",
@@ -411,6 +439,10 @@ __all__ = [
     "InstructionNode",
     "InstructionStreamBuilder",
     "InstructionStreamStatistics",
+    "CriticalPathEntry",
+    "CriticalPathResult",
+    "CriticalPathAnalyzer",
+    "WhatIfResult",
     "TimelineViewConfig",
     "TimelineViewer",
     # Functions
@@ -2155,6 +2155,39 @@ def cmd_analyze(args):
                 f"  {short_name:<35} {count:>8} {format_duration(total):>12} {format_duration(avg):>12}"
             )
 
+    # Critical path analysis over the dependency DAG
+    if getattr(args, "critical_path", False):
+        from . import CriticalPathAnalyzer, InstructionStreamBuilder
+
+        graph = InstructionStreamBuilder()
+        graph.add_events(events)
+        graph.analyze()
+
+        analyzer = CriticalPathAnalyzer(graph)
+        cp = analyzer.analyze()
+
+        print(f"\n{colorize(Color.BOLD)}Critical Path:{colorize(Color.RESET)}")
+        print(f"  End-to-end:     {format_duration(cp.makespan)}")
+        print(f"  Operations:     {len(cp.path)} of {graph.node_count()}")
+        print(f"  Busy time:      {format_duration(cp.path_busy_time)}")
+        print(f"  Gap time:       {format_duration(cp.path_gap_time)}")
+        print(f"  Zero-slack ops: {sum(1 for s in cp.slack if s == 0)}")
+
+        ranked = analyzer.rank_speedups(args.speedup, 10)
+        if ranked:
+            print(
+                f"\n{colorize(Color.BOLD)}What-if ({args.speedup:.1f}x faster):{colorize(Color.RESET)}"
+            )
+            print(f"  {'Operation':<35} {'Count':>8} {'Saves':>12} {'End-to-end':>12}")
+            print(f"  {'-' * 67}")
+            for what_if in ranked:
+                short_name = what_if.name[:32] + "..." if len(what_if.name) > 32 else what_if.name
+                print(
+                    f"  {short_name:<35} {what_if.affected_operations:>8} "
+                    f"{format_duration(what_if.reduction()):>12} "
+                    f"{-what_if.reduction_percent():>11.1f}%"
+                )
+
     print()
     print_success("Analysis complete")
 
@@ -2166,7 +2199,15 @@ def cmd_analyze(args):
 # =============================================================================
 def cmd_replay(args):
     """Replay a captured trace."""
-    from . import ReplayConfig, ReplayEngine, ReplayMode, SBTReader
+    from . import (
+        ReplayConfig,
+        ReplayEngine,
+        ReplayMode,
+        SBTReader,
+        ScaledCostModel,
+        SchedulingPolicy,
+        export_perfetto,
+    )
 
     input_path = Path(args.input)
 
@@ -2178,6 +2219,7 @@ def cmd_replay(args):
 
     print(f"File: {colorize(Color.CYAN)}{input_path}{colorize(Color.RESET)}")
     print(f"Mode: {args.mode}")
+    print(f"Policy: {args.policy}")
     print()
 
     # Read trace
@@ -2186,8 +2228,7 @@ def cmd_replay(args):
         print_error(f"Invalid SBT file '{input_path}'")
         return 1
 
-    events = reader.read_all()
-    print_info(f"Loaded {len(events)} events")
+    print_info(f"Trace has {reader.event_count()} events")
 
     # Create replay engine
     engine = ReplayEngine()
@@ -2199,15 +2240,55 @@ def cmd_replay(args):
         config.mode = ReplayMode.Full
     elif args.mode == "partial":
         config.mode = ReplayMode.Partial
+    elif args.mode == "simulate":
+        config.mode = ReplayMode.Simulate
+
+    simulation = config.simulation
+    simulation.compute_slots = args.compute_slots
+    simulation.copy_engines = args.copy_engines
+    if args.scale:
+        model = ScaledCostModel()
+        for spec in args.scale:
+            name, _, value = spec.rpartition("=")
+            if not name:
+                print_error(f"Invalid --scale value (expected NAME=F): {spec}")
+                return 1
+            model.set_name_scale(name, float(value))
+        simulation.cost_model = model
+    config.simulation = simulation
+
+    policies = {
+        "round-robin": SchedulingPolicy.RoundRobin,
+        "priority": SchedulingPolicy.Priority,
+        "timing": SchedulingPolicy.OriginalTiming,
+    }
+    config.scheduling = policies[args.policy]
+    config.time_scale = args.speed
+    config.parallel_streams = args.parallel
+    config.streaming_window = args.window
+
+    priorities = {}
+    for spec in args.priority or []:
+        stream_id, _, value = spec.partition("=")
+        if not value:
+            print_error(f"Invalid --priority value (expected ID=N): {spec}")
+            return 1
+        priorities[int(stream_id)] = int(value)
+    config.stream_priorities = priorities
 
     config.validate_dependencies = args.validate
 
-    if not engine.load_trace(str(input_path)):
+    if not args.streaming and not engine.load_trace(str(input_path)):
         print_error("Failed to load trace for replay")
         return 1
 
     print("Replaying...")
-    result = engine.replay(config)
+    if args.streaming:
+        result = engine.replay_streaming(str(input_path), config)
+    else:
+        result = engine.replay(config)
+    for warning in result.warnings:
+        print_warning(warning)
 
     print(f"\n{colorize(Color.BOLD)}Replay Results:{colorize(Color.RESET)}")
     success_color = Color.GREEN if result.success else Color.RED
@@ -2215,6 +2296,24 @@ def cmd_replay(args):
     print(f"  Operations:    {result.operations_executed}/{result.operations_total}")
     print(f"  Deterministic: {result.deterministic}")
     print(f"  Duration:      {format_duration(result.replay_duration)}")
+    if result.worker_threads > 0:
+        print(f"  Workers:       {result.worker_threads}")
+    if result.windows > 0:
+        print(f"  Windows:       {result.windows}")
+    print(f"  Overlap:       {result.achieved_overlap * 100:.1f}% achieved / "
+          f"{result.original_overlap * 100:.1f}% original")
+    if args.mode == "simulate":
+        print(f"  Captured:      {format_duration(result.captured_makespan)}")
+        print(f"  Predicted:     {format_duration(result.simulated_makespan)}")
+        if args.timeline:
+            if export_perfetto(engine.get_simulated_timeline(), args.timeline):
+                print_success(f"Predicted timeline exported to {args.timeline}")
+            else:
+                print_error("Failed to export predicted timeline")
+    jitter = result.dispatch_jitter
+    if jitter.samples > 0:
+        print(f"  Jitter:        mean {format_duration(jitter.mean)}, "
+              f"p99 {format_duration(jitter.p99)}, max {format_duration(jitter.max)}")
 
     if result.success:
         print_success("Replay completed")
@@ -2906,12 +3005,40 @@ cannot be captured due to CUPTI/MCPTI API limitations.
     # analyze command
     analyze_parser = subparsers.add_parser("analyze", help="Analyze trace file")
     analyze_parser.add_argument("input", help="Input trace file")
+    analyze_parser.add_argument(
+        "--critical-path",
+        action="store_true",
+        help="Critical path, slack and what-if speedups",
+    )
+    analyze_parser.add_argument(
+        "--speedup", type=float, default=2.0, help="Speedup used for what-if analysis"
+    )
     analyze_parser.set_defaults(func=cmd_analyze)
 
     # replay command
     replay_parser = subparsers.add_parser("replay", help="Replay a captured trace")
     replay_parser.add_argument("input", help="Input trace file")
-    replay_parser.add_argument("--mode", choices=["dry-run", "full", "partial"], default="dry-run")
+    replay_parser.add_argument("--mode", choices=["dry-run", "full", "partial", "simulate"],
+                               default="dry-run")
+    replay_parser.add_argument("--policy", choices=["round-robin", "priority", "timing"],
+                               default="round-robin", help="Scheduling policy")
+    replay_parser.add_argument("--speed", type=float, default=1.0,
+                               help="Replay speed factor for timing policy (default: 1.0)")
+    replay_parser.add_argument("--priority", action="append", metavar="ID=N",
+                               help="Stream priority for priority policy (repeatable)")
+    replay_parser.add_argument("--parallel", action="store_true",
+                               help="One worker thread per (device, stream)")
+    replay_parser.add_argument("--streaming", action="store_true",
+                               help="Replay from the file in windows without loading it")
+    replay_parser.add_argument("--window", type=int, default=65536,
+                               help="Streaming: events per window (default: 65536)")
+    replay_parser.add_argument("--scale", action="append", metavar="NAME=F",
+                               help="Simulate: scale durations of ops named NAME (repeatable)")
+    replay_parser.add_argument("--compute-slots", type=int, default=0,
+                               help="Simulate: concurrent kernels per device (0 = unlimited)")
+    replay_parser.add_argument("--copy-engines", type=int, default=0,
+                               help="Simulate: concurrent copies per device (0 = unlimited)")
+    replay_parser.add_argument("--timeline", help="Simulate: export predicted timeline to FILE")
     replay_parser.add_argument("--validate", action="store_true", help="Validate determinism")
     replay_parser.set_defaults(func=cmd_replay)
 
@@ -50,6 +50,7 @@ bool AscendProfiler::isAvailable() const {
 
 bool AscendProfiler::initialize(const ProfilerConfig& config) {
     impl_->profiler_config = config;
+    sampler_.configure(config);
     
 #ifdef TRACESMITH_ENABLE_ASCEND
     // ACL should already be initialized in constructor
@@ -113,6 +114,7 @@ bool AscendProfiler::startCapture() {
     if (is_running_) {
         return false;
     }
+    sampler_.reset();
     
     // Create output directory
     std::filesystem::create_directories(config_.output_dir);
@@ -285,7 +287,7 @@ void AscendProfiler::parse_summary_file(const std::string& filepath) {
                 }
             }
             
-            if (!event.name.empty()) {
+            if (!event.name.empty() && sampler_.admit(event)) {
                 events_.push_back(event);
                 stats_.kernel_count++;
                 stats_.total_events++;
@@ -340,8 +342,8 @@ void AscendProfiler::parse_timeline_file(const std::string& filepath) {
                 } catch (...) {}
             }
             
-            if (!event.name.empty()) {
-                event.type = EventType::KernelLaunch;
+            event.type = EventType::KernelLaunch;
+            if (!event.name.empty() && sampler_.admit(event)) {
                 events_.push_back(event);
                 stats_.total_events++;
             }
@@ -152,6 +152,7 @@ bool CUPTIProfiler::initialize(const ProfilerConfig& config) {
     }
     
     config_ = config;
+    sampler_.configure(config);
     
     // Initialize CUDA driver API
     CUDA_CALL(cuInit(0));
@@ -221,6 +222,7 @@ bool CUPTIProfiler::startCapture() {
     }
     events_captured_ = 0;
     events_dropped_ = 0;
+    sampler_.reset();
     
     // Enable activity kinds
     for (auto kind : enabled_activities_) {
@@ -687,6 +689,9 @@ void CUPTIProfiler::processSyncActivity(const CUpti_ActivitySynchronization* syn
 //==============================================================================
 
 void CUPTIProfiler::addEvent(TraceEvent&& event) {
+    if (!sampler_.admit(event)) {
+        return;
+    }
     ++events_captured_;
     
     // Fire callback if registered
@@ -0,0 +1,267 @@
+/**
+ * Capture-time event filtering and sampling
+ */
+
+#include "tracesmith/capture/event_sampler.hpp"
+#include "tracesmith/capture/profiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tracesmith {
+
+namespace {
+
+/// Compare a glob segment at pos; '?' matches any character
+bool segmentAt(const std::string& name, size_t pos, const std::string& segment) {
+    if (pos + segment.size() > name.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < segment.size(); ++i) {
+        if (segment[i] != '?' && segment[i] != name[pos + i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void countDropped(SamplingCounters& counters, uint64_t SamplingCounters::*reason,
+                  uint64_t duration) {
+    ++(counters.*reason);
+    if (reason != &SamplingCounters::filtered) {
+        counters.dropped_duration_ns += duration;
+    }
+}
+
+void addCounters(SamplingCounters& into, const SamplingCounters& from) {
+    into.seen += from.seen;
+    into.kept += from.kept;
+    into.kept_slow += from.kept_slow;
+    into.filtered += from.filtered;
+    into.sampled_out += from.sampled_out;
+    into.rate_limited += from.rate_limited;
+    into.dropped_duration_ns += from.dropped_duration_ns;
+}
+
+} // anonymous namespace
+
+bool EventSampler::CompiledRule::matches(const std::string& name) const {
+    const std::string& first = segments.front();
+    if (segments.size() == 1 && !trailing_star) {
+        return name.size() == first.size() && segmentAt(name, 0, first);
+    }
+    if (!segmentAt(name, 0, first)) {
+        return false;
+    }
+
+    // The last segment is anchored at the end unless the glob ends in '*'
+    size_t end = name.size();
+    size_t last = segments.size();
+    if (!trailing_star) {
+        const std::string& suffix = segments.back();
+        if (suffix.size() > end - first.size()) {
+            return false;
+        }
+        end -= suffix.size();
+        if (!segmentAt(name, end, suffix)) {
+            return false;
+        }
+        --last;
+    }
+
+    // Middle segments: the leftmost placement of each leaves the most room
+    size_t pos = first.size();
+    for (size_t i = 1; i < last; ++i) {
+        const std::string& segment = segments[i];
+        while (pos + segment.size() <= end && !segmentAt(name, pos, segment)) {
+            ++pos;
+        }
+        if (pos + segment.size() > end) {
+            return false;
+        }
+        pos += segment.size();
+    }
+    return true;
+}
+
+void EventSampler::configure(const ProfilerConfig& config) {
+    type_filter_.clear();
+    auto drop = [this](bool capture, std::initializer_list<EventType> types) {
+        if (!capture) {
+            type_filter_.insert(type_filter_.end(), types);
+        }
+    };
+    drop(config.capture_kernels, {EventType::KernelLaunch, EventType::KernelComplete});
+    drop(config.capture_memcpy, {EventType::MemcpyH2D, EventType::MemcpyD2H, EventType::MemcpyD2D});
+    drop(config.capture_memset, {EventType::MemsetDevice});
+    drop(config.capture_sync, {EventType::StreamSync, EventType::DeviceSync, EventType::EventSync});
+    drop(config.capture_alloc, {EventType::MemAlloc, EventType::MemFree});
+
+    rules_.clear();
+    rules_.reserve(config.sampling.rules.size());
+    for (const auto& rule : config.sampling.rules) {
+        CompiledRule compiled;
+        compiled.rule = rule;
+        const std::string& pattern = rule.pattern;
+        size_t start = 0;
+        size_t star;
+        while ((star = pattern.find('*', start)) != std::string::npos) {
+            compiled.segments.push_back(pattern.substr(start, star - start));
+            start = star + 1;
+        }
+        compiled.trailing_star = start == pattern.size() && !compiled.segments.empty();
+        if (!compiled.trailing_star) {
+            compiled.segments.push_back(pattern.substr(start));
+        }
+        rules_.push_back(std::move(compiled));
+    }
+
+    // Cached rule pointers refer to the old rules
+    clearState();
+}
+
+void EventSampler::reset() {
+    clearState();
+}
+
+void EventSampler::clearState() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.names.clear();
+        shard.totals = SamplingCounters();
+    }
+    unruled_seen_.store(0, std::memory_order_relaxed);
+    unruled_filtered_.store(0, std::memory_order_relaxed);
+}
+
+size_t EventSampler::shardOf(const std::string& name) {
+    // Constant-time mix of the length and the first and last 8 bytes; names
+    // that collide only share a lock
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    if (name.size() >= sizeof(head)) {
+        std::memcpy(&head, name.data(), sizeof(head));
+        std::memcpy(&tail, name.data() + name.size() - sizeof(tail), sizeof(tail));
+    } else {
+        for (char c : name) {
+            head = (head << 8) | static_cast<uint8_t>(c);
+        }
+    }
+    uint64_t mixed = (head ^ (tail * 0x9E3779B97F4A7C15ull) ^ name.size()) * 0xFF51AFD7ED558CCDull;
+    return static_cast<size_t>(mixed >> (64 - kShardBits));
+}
+
+EventSampler::NameState& EventSampler::stateFor(Shard& shard, const TraceEvent& event) const {
+    auto& by_name = shard.names[event.type];
+    auto it = by_name.find(event.name);
+    if (it != by_name.end()) {
+        return it->second;
+    }
+
+    NameState state;
+    for (const auto& rule : rules_) {
+        if ((rule.rule.type == EventType::Unknown || rule.rule.type == event.type) &&
+            rule.matches(event.name)) {
+            state.rule = &rule;
+            break;
+        }
+    }
+    if (state.rule) {
+        state.tokens = std::max(1.0, state.rule->rule.max_per_second);
+        state.last_refill = event.timestamp;
+    }
+    return by_name.emplace(event.name, state).first->second;
+}
+
+bool EventSampler::admit(const TraceEvent& event) {
+    // Type switches and the rule-free case need no per-name state
+    if (!type_filter_.empty() &&
+        std::find(type_filter_.begin(), type_filter_.end(), event.type) != type_filter_.end()) {
+        unruled_seen_.fetch_add(1, std::memory_order_relaxed);
+        unruled_filtered_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (rules_.empty()) {
+        unruled_seen_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    Shard& shard = shards_[shardOf(event.name)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    SamplingCounters& totals = shard.totals;
+    ++totals.seen;
+
+    NameState& state = stateFor(shard, event);
+    SamplingCounters& counters = state.counters;
+    ++counters.seen;
+    auto dropped = [&](uint64_t SamplingCounters::*reason) {
+        countDropped(counters, reason, event.duration);
+        countDropped(totals, reason, event.duration);
+        return false;
+    };
+    auto kept = [&](bool slow) {
+        ++counters.kept;
+        ++totals.kept;
+        if (slow) {
+            ++counters.kept_slow;
+            ++totals.kept_slow;
+        }
+        return true;
+    };
+
+    if (!state.rule) {
+        return kept(false);
+    }
+    const SamplingRule& rule = state.rule->rule;
+    if (rule.exclude) {
+        return dropped(&SamplingCounters::filtered);
+    }
+    if (rule.keep_slower_than_ns > 0 && event.duration >= rule.keep_slower_than_ns) {
+        return kept(true);
+    }
+    if (rule.sample_every > 1 && state.sample_counter++ % rule.sample_every != 0) {
+        return dropped(&SamplingCounters::sampled_out);
+    }
+    if (rule.max_per_second > 0.0) {
+        // Token bucket holding up to one second of events
+        if (event.timestamp > state.last_refill) {
+            double elapsed = static_cast<double>(event.timestamp - state.last_refill) * 1e-9;
+            state.tokens = std::min(std::max(1.0, rule.max_per_second),
+                                    state.tokens + elapsed * rule.max_per_second);
+            state.last_refill = event.timestamp;
+        }
+        if (state.tokens < 1.0) {
+            return dropped(&SamplingCounters::rate_limited);
+        }
+        state.tokens -= 1.0;
+    }
+    return kept(false);
+}
+
+SamplingCounters EventSampler::totals() const {
+    SamplingCounters result;
+    // Filtered first: each thread counts an event as seen before filtered
+    result.filtered = unruled_filtered_.load(std::memory_order_relaxed);
+    result.seen = unruled_seen_.load(std::memory_order_relaxed);
+    result.kept = result.seen - result.filtered;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        addCounters(result, shard.totals);
+    }
+    return result;
+}
+
+std::unordered_map<std::string, SamplingCounters> EventSampler::countersByName() const {
+    std::unordered_map<std::string, SamplingCounters> result;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& by_type : shard.names) {
+            for (const auto& entry : by_type.second) {
+                addCounters(result[entry.first], entry.second.counters);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace tracesmith
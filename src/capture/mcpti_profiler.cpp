@@ -151,6 +151,7 @@ bool MCPTIProfiler::initialize(const ProfilerConfig& config) {
     }
     
     config_ = config;
+    sampler_.configure(config);
     
     // Initialize MACA driver API
     MCC_CALL(mcInit(0));
@@ -220,6 +221,7 @@ bool MCPTIProfiler::startCapture() {
     }
     events_captured_ = 0;
     events_dropped_ = 0;
+    sampler_.reset();
     
     // Enable activity kinds
     for (auto kind : enabled_activities_) {
@@ -672,6 +674,9 @@ void MCPTIProfiler::processSyncActivity(const MCpti_ActivitySynchronization* syn
 //==============================================================================
 
 void MCPTIProfiler::addEvent(TraceEvent&& event) {
+    if (!sampler_.admit(event)) {
+        return;
+    }
     ++events_captured_;
     
     // Fire callback if registered
@@ -3,20 +3,212 @@
  */
 
 #include "tracesmith/capture/memory_profiler.hpp"
+#include "tracesmith/format/sbt_format.hpp"
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <numeric>
+#include <iterator>
+#include <chrono>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace tracesmith {
 
+namespace {
+
+std::atomic<uint64_t> next_instance_id{1};
+
+/// Last allocator (slot 0) and tag (slot 1) name looked up on this thread
+struct NameCacheEntry {
+    uint64_t instance = 0;
+    std::string name;
+    uint32_t id = 0;
+};
+thread_local NameCacheEntry name_cache[2];
+
+/// Freed records buffered per shard before a spill write
+constexpr size_t kSpillBatch = 256;
+
+/// Index of the highest set bit (value must be non-zero)
+int highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    int bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+#endif
+}
+
+/// Exponent of the power of two a size rounds up to (capped at 2^63)
+int ceilLog2(uint64_t size) {
+    if (size <= 1) return 0;
+    return std::min(highestBit(size - 1) + 1, 63);
+}
+
+/// xorshift64 step for reservoir sampling
+uint64_t nextRandom(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+} // anonymous namespace
+
+// ============================================================================
+// LogHistogram Implementation
+// ============================================================================
+
+size_t LogHistogram::bucketIndex(uint64_t value) {
+    if (value < kSubBuckets) {
+        return static_cast<size_t>(value);
+    }
+    int exponent = highestBit(value);
+    size_t sub = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + sub;
+}
+
+uint64_t LogHistogram::bucketLowerBound(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    int shift = static_cast<int>(index / kSubBuckets) - 1;
+    return (kSubBuckets + index % kSubBuckets) << shift;
+}
+
+uint64_t LogHistogram::bucketUpperBound(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    int shift = static_cast<int>(index / kSubBuckets) - 1;
+    return bucketLowerBound(index) + ((uint64_t(1) << shift) - 1);
+}
+
+void LogHistogram::record(uint64_t value, uint64_t count) {
+    counts[bucketIndex(value)] += count;
+    total_count += count;
+    min_value = std::min(min_value, value);
+    max_value = std::max(max_value, value);
+}
+
+void LogHistogram::merge(const LogHistogram& other) {
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        counts[i] += other.counts[i];
+    }
+    total_count += other.total_count;
+    min_value = std::min(min_value, other.min_value);
+    max_value = std::max(max_value, other.max_value);
+}
+
+uint64_t LogHistogram::valueAtPercentile(double percentile) const {
+    if (total_count == 0) return 0;
+    
+    percentile = std::min(std::max(percentile, 0.0), 100.0);
+    uint64_t target = static_cast<uint64_t>(percentile / 100.0 * total_count + 0.5);
+    target = std::max<uint64_t>(target, 1);
+    
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return std::min(std::max(bucketUpperBound(i), min_value), max_value);
+        }
+    }
+    return max_value;
+}
+
+// ============================================================================
+// AddressSpaceMap Implementation
+// ============================================================================
+
+void AddressSpaceMap::addHole(uint64_t begin, uint64_t end) {
+    if (end > begin) {
+        holes_.insert(end - begin);
+        hole_bytes_ += end - begin;
+    }
+}
+
+void AddressSpaceMap::removeHole(uint64_t begin, uint64_t end) {
+    if (end > begin) {
+        holes_.erase(holes_.find(end - begin));
+        hole_bytes_ -= end - begin;
+    }
+}
+
+void AddressSpaceMap::insert(uint64_t ptr, uint64_t size) {
+    if (blocks_.count(ptr)) {
+        erase(ptr);
+    }
+    
+    // The new block splits the hole between its neighbours
+    uint64_t end = ptr + size;
+    auto next = blocks_.lower_bound(ptr);
+    bool has_prev = next != blocks_.begin();
+    bool has_next = next != blocks_.end();
+    uint64_t prev_end = has_prev ? std::prev(next)->second : 0;
+    
+    if (has_prev && has_next) removeHole(prev_end, next->first);
+    if (has_prev) addHole(prev_end, ptr);
+    if (has_next) addHole(end, next->first);
+    
+    blocks_.emplace_hint(next, ptr, end);
+}
+
+void AddressSpaceMap::erase(uint64_t ptr) {
+    auto it = blocks_.find(ptr);
+    if (it == blocks_.end()) return;
+    
+    // The holes on both sides merge into one
+    auto next = std::next(it);
+    bool has_prev = it != blocks_.begin();
+    bool has_next = next != blocks_.end();
+    uint64_t prev_end = has_prev ? std::prev(it)->second : 0;
+    
+    if (has_prev) removeHole(prev_end, it->first);
+    if (has_next) removeHole(it->second, next->first);
+    if (has_prev && has_next) addHole(prev_end, next->first);
+    
+    blocks_.erase(it);
+}
+
+FragmentationInfo AddressSpaceMap::info() const {
+    FragmentationInfo info;
+    info.total_free_bytes = hole_bytes_;
+    info.largest_free_block = holes_.empty() ? 0 : *holes_.rbegin();
+    info.free_block_count = holes_.size();
+    if (info.total_free_bytes > 0) {
+        info.fragmentation_ratio = 1.0 -
+            static_cast<double>(info.largest_free_block) / info.total_free_bytes;
+    }
+    return info;
+}
+
+void AddressSpaceMap::clear() {
+    blocks_.clear();
+    holes_.clear();
+    hole_bytes_ = 0;
+}
+
 // ============================================================================
 // MemoryProfiler Implementation
 // ============================================================================
 
-MemoryProfiler::MemoryProfiler() : config_() {}
+MemoryProfiler::MemoryProfiler() : MemoryProfiler(Config()) {}
 
-MemoryProfiler::MemoryProfiler(const Config& config) : config_(config) {}
+MemoryProfiler::MemoryProfiler(const Config& config)
+    : config_(config)
+    , instance_id_(next_instance_id.fetch_add(1, std::memory_order_relaxed)) {
+    default_allocator_id_ = internName("default");
+    empty_tag_id_ = internName("");
+}
 
 MemoryProfiler::~MemoryProfiler() {
     if (active_.load()) {
@@ -32,8 +224,23 @@ void MemoryProfiler::start() {
     start_time_ = getCurrentTimestamp();
     stop_time_ = 0;
     
+    if (config_.streaming_stats && !config_.freed_spill_path.empty()) {
+        std::lock_guard<std::mutex> lock(spill_mutex_);
+        if (!spill_writer_) {
+            spill_writer_ = std::make_unique<SBTWriter>(config_.freed_spill_path);
+        }
+    }
+    
     // Take initial snapshot
     takeTimelineSnapshot();
+    
+    if (config_.snapshot_interval_ms > 0) {
+        {
+            std::lock_guard<std::mutex> lock(sampler_mutex_);
+            sampler_stop_ = false;
+        }
+        sampler_thread_ = std::thread(&MemoryProfiler::samplerLoop, this);
+    }
 }
 
 void MemoryProfiler::stop() {
@@ -41,37 +248,130 @@ void MemoryProfiler::stop() {
         return; // Already stopped
     }
     
+    if (sampler_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(sampler_mutex_);
+            sampler_stop_ = true;
+        }
+        sampler_cv_.notify_all();
+        sampler_thread_.join();
+    }
+    
     stop_time_ = getCurrentTimestamp();
     
     // Take final snapshot
     takeTimelineSnapshot();
+    
+    flushSpill();
+}
+
+MemoryProfiler::Shard& MemoryProfiler::shardFor(uint64_t ptr) {
+    // Fibonacci hashing: allocations are aligned, so the low bits carry
+    // little information; the product's top bits mix all of them
+    return shards_[(ptr * 0x9E3779B97F4A7C15ULL) >> (64 - kShardBits)];
+}
+
+MemoryProfiler::Pool& MemoryProfiler::poolFor(uint32_t device_id, uint32_t allocator_id) {
+    uint64_t key = (static_cast<uint64_t>(device_id) << 32) | allocator_id;
+    {
+        std::shared_lock<std::shared_mutex> lock(pools_mutex_);
+        auto it = pools_.find(key);
+        if (it != pools_.end()) {
+            return *it->second;
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(pools_mutex_);
+    auto& pool = pools_[key];
+    if (!pool) {
+        pool = std::make_unique<Pool>();
+    }
+    return *pool;
+}
+
+uint32_t MemoryProfiler::internName(const std::string& name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(names_mutex_);
+        auto it = name_ids_.find(name);
+        if (it != name_ids_.end()) {
+            return it->second;
+        }
+    }
+    
+    std::unique_lock<std::shared_mutex> lock(names_mutex_);
+    auto [it, inserted] = name_ids_.emplace(name, static_cast<uint32_t>(names_.size()));
+    if (inserted) {
+        names_.push_back(name);
+    }
+    return it->second;
+}
+
+std::string MemoryProfiler::nameOf(uint32_t id) const {
+    std::shared_lock<std::shared_mutex> lock(names_mutex_);
+    return id < names_.size() ? names_[id] : std::string();
+}
+
+std::vector<std::string> MemoryProfiler::nameTable() const {
+    std::shared_lock<std::shared_mutex> lock(names_mutex_);
+    return names_;
+}
+
+uint32_t MemoryProfiler::cachedNameId(const std::string& name, int slot) {
+    // Hooks pass the same allocator/tag on nearly every call, so a
+    // per-thread cache avoids touching the shared name table
+    NameCacheEntry& entry = name_cache[slot];
+    if (entry.instance == instance_id_ && entry.name == name) {
+        return entry.id;
+    }
+    
+    uint32_t id = internName(name);
+    entry.instance = instance_id_;
+    entry.name = name;
+    entry.id = id;
+    return id;
 }
 
 void MemoryProfiler::recordAlloc(uint64_t ptr, uint64_t size, uint32_t device_id,
                                   const std::string& allocator,
                                   const std::string& tag) {
-    if (!active_.load()) return;
+    if (!active_.load(std::memory_order_relaxed)) return;
     
-    MemoryAllocation alloc;
-    alloc.ptr = ptr;
+    uint32_t allocator_id = allocator == "default" ? default_allocator_id_ : cachedNameId(allocator, 0);
+    uint32_t tag_id = tag.empty() ? empty_tag_id_ : cachedNameId(tag, 1);
+    recordAlloc(ptr, size, device_id, allocator_id, tag_id);
+}
+
+void MemoryProfiler::recordAlloc(uint64_t ptr, uint64_t size, uint32_t device_id,
+                                  uint32_t allocator_id, uint32_t tag_id) {
+    if (!active_.load(std::memory_order_relaxed)) return;
+    
+    LiveAllocation alloc;
     alloc.size = size;
-    alloc.device_id = device_id;
     alloc.alloc_time = getCurrentTimestamp();
-    alloc.free_time = 0;
-    alloc.allocator = allocator;
-    alloc.tag = tag;
+    alloc.device_id = device_id;
+    alloc.allocator_id = allocator_id;
+    alloc.tag_id = tag_id;
     alloc.call_stack_hash = 0;
     
+    Shard& shard = shardFor(ptr);
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        live_allocations_[ptr] = alloc;
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.live[ptr] = alloc;
+        shard.allocations.fetch_add(1, std::memory_order_relaxed);
+        shard.bytes_allocated.fetch_add(size, std::memory_order_relaxed);
+        
+        // Updated under the shard lock so a reused pointer's free and
+        // alloc reach the pool in order
+        if (config_.track_fragmentation) {
+            Pool& pool = poolFor(device_id, allocator_id);
+            std::lock_guard<std::mutex> pool_lock(pool.mutex);
+            pool.map.insert(ptr, size);
+        }
     }
     
     // Update statistics
-    current_usage_.fetch_add(size);
-    total_allocations_.fetch_add(1);
-    total_bytes_allocated_.fetch_add(size);
-    updatePeakUsage();
+    uint64_t current = current_usage_.fetch_add(size, std::memory_order_relaxed) + size;
+    updatePeakUsage(current);
     
     // Callback
     if (callback_) {
@@ -81,23 +381,25 @@ void MemoryProfiler::recordAlloc(uint64_t ptr, uint64_t size, uint32_t device_id
         event.bytes = size;
         event.ptr = ptr;
         event.is_allocation = true;
-        event.allocator_name = allocator;
+        event.allocator_name = nameOf(allocator_id);
         callback_(event);
     }
 }
 
 void MemoryProfiler::recordFree(uint64_t ptr, uint32_t device_id) {
-    if (!active_.load()) return;
+    if (!active_.load(std::memory_order_relaxed)) return;
     
     Timestamp free_time = getCurrentTimestamp();
     uint64_t size = 0;
-    std::string allocator;
+    uint32_t allocator_id = 0;
+    std::vector<FreedAllocation> spill_batch;
     
+    Shard& shard = shardFor(ptr);
     {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<std::mutex> lock(shard.mutex);
         
-        auto it = live_allocations_.find(ptr);
-        if (it == live_allocations_.end()) {
+        auto it = shard.live.find(ptr);
+        if (it == shard.live.end()) {
             // Double free or unknown allocation
             if (config_.detect_double_free) {
                 // Could log warning here
@@ -105,19 +407,40 @@ void MemoryProfiler::recordFree(uint64_t ptr, uint32_t device_id) {
             return;
         }
         
-        it->second.free_time = free_time;
-        size = it->second.size;
-        allocator = it->second.allocator;
+        const LiveAllocation& alloc = it->second;
+        size = alloc.size;
+        allocator_id = alloc.allocator_id;
         
-        // Move to freed list
-        freed_allocations_.push_back(std::move(it->second));
-        live_allocations_.erase(it);
+        if (config_.track_fragmentation) {
+            Pool& pool = poolFor(alloc.device_id, alloc.allocator_id);
+            std::lock_guard<std::mutex> pool_lock(pool.mutex);
+            pool.map.erase(ptr);
+        }
+        
+        FreedAllocation record{ptr, alloc.size, alloc.alloc_time, free_time,
+                               alloc.device_id, alloc.allocator_id, alloc.tag_id};
+        shard.live.erase(it);
+        shard.frees.fetch_add(1, std::memory_order_relaxed);
+        shard.bytes_freed.fetch_add(size, std::memory_order_relaxed);
+        foldFreed(shard, static_cast<size_t>(&shard - shards_.data()), record);
+        
+        // Streaming mode keeps only a spill batch, written outside the lock
+        if (!config_.streaming_stats) {
+            shard.freed.push_back(record);
+        } else if (!config_.freed_spill_path.empty()) {
+            shard.freed.push_back(record);
+            if (shard.freed.size() >= kSpillBatch) {
+                spill_batch.swap(shard.freed);
+            }
+        }
+    }
+    
+    if (!spill_batch.empty()) {
+        spillFreed(spill_batch);
     }
     
     // Update statistics
-    current_usage_.fetch_sub(size);
-    total_frees_.fetch_add(1);
-    total_bytes_freed_.fetch_add(size);
+    current_usage_.fetch_sub(size, std::memory_order_relaxed);
     
     // Callback
     if (callback_) {
@@ -127,7 +450,7 @@ void MemoryProfiler::recordFree(uint64_t ptr, uint32_t device_id) {
         event.bytes = size;
         event.ptr = ptr;
         event.is_allocation = false;
-        event.allocator_name = allocator;
+        event.allocator_name = nameOf(allocator_id);
         callback_(event);
     }
 }
@@ -141,19 +464,121 @@ void MemoryProfiler::recordEvent(const MemoryEvent& event) {
     }
 }
 
+size_t MemoryProfiler::samplesPerShard() const {
+    return (config_.freed_sample_size + kShardCount - 1) / kShardCount;
+}
+
+void MemoryProfiler::foldFreed(Shard& shard, size_t shard_index,
+                               const FreedAllocation& record) {
+    if (!shard.freed_stats) {
+        shard.freed_stats = std::make_unique<FreedStats>();
+        shard.freed_stats->rng_state = 0x9E3779B97F4A7C15ULL * (shard_index + 1);
+    }
+    FreedStats& stats = *shard.freed_stats;
+    
+    uint64_t lifetime = record.free_time > record.alloc_time
+                        ? record.free_time - record.alloc_time : 0;
+    stats.size.record(record.size);
+    stats.lifetime.record(lifetime);
+    stats.size_pow2[ceilLog2(record.size)]++;
+    stats.total_size += record.size;
+    stats.total_lifetime += lifetime;
+    
+    FreedCounters& by_allocator = stats.by_allocator[record.allocator_id];
+    by_allocator.frees++;
+    by_allocator.bytes_freed += record.size;
+    FreedCounters& by_tag = stats.by_tag[record.tag_id];
+    by_tag.frees++;
+    by_tag.bytes_freed += record.size;
+    
+    if (!config_.streaming_stats) return;
+    
+    // Algorithm R over this shard's frees; shard.frees already counts this one
+    size_t capacity = samplesPerShard();
+    if (stats.samples.size() < capacity) {
+        stats.samples.push_back(record);
+    } else if (capacity > 0) {
+        uint64_t slot = nextRandom(stats.rng_state) % shard.frees.load(std::memory_order_relaxed);
+        if (slot < capacity) {
+            stats.samples[slot] = record;
+        }
+    }
+}
+
+void MemoryProfiler::spillFreed(std::vector<FreedAllocation>& batch) {
+    std::lock_guard<std::mutex> lock(spill_mutex_);
+    if (!spill_writer_) return;
+    
+    // One MemFree event per allocation: alloc time, lifetime as duration,
+    // "allocator" or "allocator/tag" as the name
+    std::shared_lock<std::shared_mutex> names_lock(names_mutex_);
+    for (const auto& record : batch) {
+        TraceEvent event(EventType::MemFree, record.alloc_time);
+        event.duration = record.free_time > record.alloc_time
+                         ? record.free_time - record.alloc_time : 0;
+        event.device_id = record.device_id;
+        event.name = names_[record.allocator_id];
+        if (!names_[record.tag_id].empty()) {
+            event.name += "/" + names_[record.tag_id];
+        }
+        
+        MemoryParams params;
+        params.dst_address = record.ptr;
+        params.size_bytes = record.size;
+        event.memory_params = params;
+        spill_writer_->writeEvent(event);
+    }
+    batch.clear();
+}
+
+void MemoryProfiler::flushSpill() {
+    if (!config_.streaming_stats || config_.freed_spill_path.empty()) return;
+    
+    for (auto& shard : shards_) {
+        std::vector<FreedAllocation> batch;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            batch.swap(shard.freed);
+        }
+        if (!batch.empty()) {
+            spillFreed(batch);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(spill_mutex_);
+    if (spill_writer_) {
+        spill_writer_->finalize();
+        spill_writer_.reset();
+    }
+}
+
 uint64_t MemoryProfiler::getLiveAllocationCount() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return live_allocations_.size();
+    uint64_t count = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.live.size();
+    }
+    return count;
 }
 
 std::vector<MemoryAllocation> MemoryProfiler::getLiveAllocations() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
+    std::vector<std::string> names = nameTable();
     std::vector<MemoryAllocation> result;
-    result.reserve(live_allocations_.size());
     
-    for (const auto& [ptr, alloc] : live_allocations_) {
-        result.push_back(alloc);
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [ptr, alloc] : shard.live) {
+            MemoryAllocation record;
+            record.ptr = ptr;
+            record.size = alloc.size;
+            record.device_id = alloc.device_id;
+            record.alloc_time = alloc.alloc_time;
+            record.free_time = 0;
+            record.allocator = names[alloc.allocator_id];
+            record.tag = names[alloc.tag_id];
+            record.call_stack_hash = alloc.call_stack_hash;
+            result.push_back(std::move(record));
+        }
     }
     
     return result;
@@ -162,40 +587,117 @@ std::vector<MemoryAllocation> MemoryProfiler::getLiveAllocations() const {
 MemorySnapshot MemoryProfiler::takeSnapshot() const {
     MemorySnapshot snapshot;
     snapshot.timestamp = getCurrentTimestamp();
-    snapshot.total_allocated = total_bytes_allocated_.load();
-    snapshot.total_freed = total_bytes_freed_.load();
+    snapshot.total_allocated = 0;
+    snapshot.total_freed = 0;
+    snapshot.live_allocations = 0;
     snapshot.live_bytes = current_usage_.load();
     snapshot.peak_bytes = peak_usage_.load();
     
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        snapshot.live_allocations = live_allocations_.size();
+    std::unordered_map<uint32_t, uint64_t> allocator_usage;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        snapshot.total_allocated += shard.bytes_allocated.load(std::memory_order_relaxed);
+        snapshot.total_freed += shard.bytes_freed.load(std::memory_order_relaxed);
+        snapshot.live_allocations += shard.live.size();
         
         // Per-device usage
-        for (const auto& [ptr, alloc] : live_allocations_) {
+        for (const auto& [ptr, alloc] : shard.live) {
             snapshot.device_usage[alloc.device_id] += alloc.size;
-            snapshot.allocator_usage[alloc.allocator] += alloc.size;
+            allocator_usage[alloc.allocator_id] += alloc.size;
         }
     }
     
+    std::vector<std::string> names = nameTable();
+    for (const auto& [id, bytes] : allocator_usage) {
+        snapshot.allocator_usage[names[id]] += bytes;
+    }
+    
+    snapshot.fragmentation = calculateFragmentation();
+    
+    return snapshot;
+}
+
+MemorySnapshot MemoryProfiler::sampleCounters() const {
+    MemorySnapshot snapshot;
+    snapshot.timestamp = getCurrentTimestamp();
+    snapshot.total_allocated = 0;
+    snapshot.total_freed = 0;
+    snapshot.live_allocations = 0;
+    snapshot.live_bytes = current_usage_.load(std::memory_order_relaxed);
+    snapshot.peak_bytes = peak_usage_.load(std::memory_order_relaxed);
+    
+    // Relaxed reads: shards may be a few operations apart from each other
+    for (const auto& shard : shards_) {
+        uint64_t frees = shard.frees.load(std::memory_order_relaxed);
+        uint64_t allocations = shard.allocations.load(std::memory_order_relaxed);
+        snapshot.total_allocated += shard.bytes_allocated.load(std::memory_order_relaxed);
+        snapshot.total_freed += shard.bytes_freed.load(std::memory_order_relaxed);
+        snapshot.live_allocations += allocations > frees ? allocations - frees : 0;
+    }
+    
+    if (config_.track_fragmentation) {
+        snapshot.fragmentation = calculateFragmentation();
+    }
+    
     return snapshot;
 }
 
 void MemoryProfiler::takeTimelineSnapshot() {
-    if (timeline_.size() >= config_.max_timeline_samples) {
-        // Remove oldest samples if we hit the limit
-        timeline_.erase(timeline_.begin());
+    MemorySnapshot snapshot = sampleCounters();
+    {
+        std::lock_guard<std::mutex> lock(timeline_mutex_);
+        size_t capacity = std::max<size_t>(config_.max_timeline_samples, 1);
+        if (timeline_.size() < capacity) {
+            timeline_.resize(capacity);
+        }
+        
+        // Overwrite the oldest slot once full
+        timeline_[timeline_head_] = snapshot;
+        timeline_head_ = (timeline_head_ + 1) % capacity;
+        timeline_count_ = std::min(timeline_count_ + 1, capacity);
+    }
+    
+    if (snapshot_callback_) {
+        snapshot_callback_(snapshot);
+    }
+}
+
+void MemoryProfiler::samplerLoop() {
+    auto interval = std::chrono::milliseconds(config_.snapshot_interval_ms);
+    auto next = std::chrono::steady_clock::now() + interval;
+    
+    std::unique_lock<std::mutex> lock(sampler_mutex_);
+    while (!sampler_cv_.wait_until(lock, next, [this] { return sampler_stop_; })) {
+        lock.unlock();
+        takeTimelineSnapshot();
+        lock.lock();
+        
+        // Fixed cadence; skip missed ticks rather than bursting
+        next += interval;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now + interval;
+        }
     }
+}
+
+std::vector<MemorySnapshot> MemoryProfiler::getTimeline() const {
+    std::lock_guard<std::mutex> lock(timeline_mutex_);
+    std::vector<MemorySnapshot> result;
+    result.reserve(timeline_count_);
     
-    timeline_.push_back(takeSnapshot());
+    size_t capacity = timeline_.size();
+    for (size_t i = 0; i < timeline_count_; ++i) {
+        result.push_back(timeline_[(timeline_head_ + capacity - timeline_count_ + i) % capacity]);
+    }
+    return result;
 }
 
-void MemoryProfiler::updatePeakUsage() {
-    uint64_t current = current_usage_.load();
-    uint64_t peak = peak_usage_.load();
+void MemoryProfiler::updatePeakUsage(uint64_t current) {
+    uint64_t peak = peak_usage_.load(std::memory_order_relaxed);
     
     while (current > peak) {
-        if (peak_usage_.compare_exchange_weak(peak, current)) {
+        if (peak_usage_.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
             break;
         }
     }
@@ -203,35 +705,67 @@ void MemoryProfiler::updatePeakUsage() {
 
 FragmentationInfo MemoryProfiler::calculateFragmentation() const {
     FragmentationInfo info;
-    info.total_free_bytes = 0;
-    info.largest_free_block = 0;
-    info.free_block_count = 0;
-    info.fragmentation_ratio = 0.0;
     
-    // In a real implementation, this would query the GPU allocator
-    // For now, we estimate based on allocation patterns
+    // Pools are separate address ranges: holes add up, the largest wins
+    std::shared_lock<std::shared_mutex> lock(pools_mutex_);
+    for (const auto& [key, pool] : pools_) {
+        std::lock_guard<std::mutex> pool_lock(pool->mutex);
+        FragmentationInfo pool_info = pool->map.info();
+        info.total_free_bytes += pool_info.total_free_bytes;
+        info.largest_free_block = std::max(info.largest_free_block, pool_info.largest_free_block);
+        info.free_block_count += pool_info.free_block_count;
+    }
+    
+    if (info.total_free_bytes > 0) {
+        info.fragmentation_ratio = 1.0 -
+            static_cast<double>(info.largest_free_block) / info.total_free_bytes;
+    }
     
     return info;
 }
 
+FragmentationInfo MemoryProfiler::getFragmentation(uint32_t device_id,
+                                                   const std::string& allocator) const {
+    uint32_t allocator_id;
+    {
+        std::shared_lock<std::shared_mutex> lock(names_mutex_);
+        auto it = name_ids_.find(allocator);
+        if (it == name_ids_.end()) {
+            return FragmentationInfo();
+        }
+        allocator_id = it->second;
+    }
+    
+    uint64_t key = (static_cast<uint64_t>(device_id) << 32) | allocator_id;
+    std::shared_lock<std::shared_mutex> lock(pools_mutex_);
+    auto it = pools_.find(key);
+    if (it == pools_.end()) {
+        return FragmentationInfo();
+    }
+    std::lock_guard<std::mutex> pool_lock(it->second->mutex);
+    return it->second->map.info();
+}
+
 std::vector<MemoryLeak> MemoryProfiler::detectLeaks() const {
     std::vector<MemoryLeak> leaks;
     Timestamp now = getCurrentTimestamp();
+    std::vector<std::string> names = nameTable();
     
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    for (const auto& [ptr, alloc] : live_allocations_) {
-        uint64_t lifetime = now - alloc.alloc_time;
-        
-        if (lifetime > config_.leak_threshold_ns) {
-            MemoryLeak leak;
-            leak.ptr = alloc.ptr;
-            leak.size = alloc.size;
-            leak.alloc_time = alloc.alloc_time;
-            leak.allocator = alloc.allocator;
-            leak.tag = alloc.tag;
-            leak.lifetime_ns = lifetime;
-            leaks.push_back(leak);
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto& [ptr, alloc] : shard.live) {
+            uint64_t lifetime = now - alloc.alloc_time;
+            
+            if (lifetime > config_.leak_threshold_ns) {
+                MemoryLeak leak;
+                leak.ptr = ptr;
+                leak.size = alloc.size;
+                leak.alloc_time = alloc.alloc_time;
+                leak.allocator = names[alloc.allocator_id];
+                leak.tag = names[alloc.tag_id];
+                leak.lifetime_ns = lifetime;
+                leaks.push_back(leak);
+            }
         }
     }
     
@@ -248,10 +782,10 @@ MemoryReport MemoryProfiler::generateReport() const {
     MemoryReport report;
     
     // Summary
-    report.total_allocations = total_allocations_.load();
-    report.total_frees = total_frees_.load();
-    report.total_bytes_allocated = total_bytes_allocated_.load();
-    report.total_bytes_freed = total_bytes_freed_.load();
+    report.total_allocations = 0;
+    report.total_frees = 0;
+    report.total_bytes_allocated = 0;
+    report.total_bytes_freed = 0;
     report.peak_memory_usage = peak_usage_.load();
     report.current_memory_usage = current_usage_.load();
     
@@ -261,64 +795,108 @@ MemoryReport MemoryProfiler::generateReport() const {
     // Allocation statistics
     report.min_allocation_size = UINT64_MAX;
     report.max_allocation_size = 0;
+    report.avg_allocation_size = 0.0;
+    report.avg_allocation_lifetime_ns = 0.0;
     uint64_t total_size = 0;
     uint64_t total_lifetime = 0;
     size_t count = 0;
     
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
+    std::array<uint64_t, 64> size_pow2{};
+    std::unordered_map<uint32_t, MemoryReport::AllocatorStats> allocator_stats;
+    std::unordered_map<uint32_t, MemoryReport::AllocatorStats> tag_stats;
+    std::vector<FreedAllocation> samples;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        report.total_allocations += shard.allocations.load(std::memory_order_relaxed);
+        report.total_frees += shard.frees.load(std::memory_order_relaxed);
+        report.total_bytes_allocated += shard.bytes_allocated.load(std::memory_order_relaxed);
+        report.total_bytes_freed += shard.bytes_freed.load(std::memory_order_relaxed);
         
         // Process live allocations
-        for (const auto& [ptr, alloc] : live_allocations_) {
+        for (const auto& [ptr, alloc] : shard.live) {
             report.min_allocation_size = std::min(report.min_allocation_size, alloc.size);
             report.max_allocation_size = std::max(report.max_allocation_size, alloc.size);
             total_size += alloc.size;
+            size_pow2[ceilLog2(alloc.size)]++;
+            report.size_histogram.record(alloc.size);
             
-            // Histogram
-            uint64_t bucket = alloc.size;
-            // Round to nearest power of 2 for histogram
-            uint64_t power = 1;
-            while (power < bucket) power *= 2;
-            report.allocation_size_histogram[power]++;
-            
-            // Per-allocator stats
-            auto& stats = report.allocator_stats[alloc.allocator];
-            stats.allocations++;
-            stats.bytes_allocated += alloc.size;
-            stats.current_usage += alloc.size;
+            // Per-allocator and per-tag stats
+            for (auto* stats : {&allocator_stats[alloc.allocator_id], &tag_stats[alloc.tag_id]}) {
+                stats->allocations++;
+                stats->bytes_allocated += alloc.size;
+                stats->current_usage += alloc.size;
+            }
             
             count++;
         }
         
-        // Process freed allocations
-        for (const auto& alloc : freed_allocations_) {
-            report.min_allocation_size = std::min(report.min_allocation_size, alloc.size);
-            report.max_allocation_size = std::max(report.max_allocation_size, alloc.size);
-            total_size += alloc.size;
-            total_lifetime += alloc.lifetime_ns();
-            
-            // Histogram
-            uint64_t bucket = alloc.size;
-            uint64_t power = 1;
-            while (power < bucket) power *= 2;
-            report.allocation_size_histogram[power]++;
-            
-            // Per-allocator stats
-            auto& stats = report.allocator_stats[alloc.allocator];
-            stats.frees++;
-            stats.bytes_freed += alloc.size;
-            
-            count++;
+        // Fold in freed aggregates
+        if (!shard.freed_stats) continue;
+        const FreedStats& freed = *shard.freed_stats;
+        report.min_allocation_size = std::min(report.min_allocation_size, freed.size.min_value);
+        report.max_allocation_size = std::max(report.max_allocation_size, freed.size.max_value);
+        total_size += freed.total_size;
+        total_lifetime += freed.total_lifetime;
+        for (size_t i = 0; i < size_pow2.size(); ++i) {
+            size_pow2[i] += freed.size_pow2[i];
+        }
+        report.size_histogram.merge(freed.size);
+        report.lifetime_histogram.merge(freed.lifetime);
+        
+        for (const auto& [id, counters] : freed.by_allocator) {
+            allocator_stats[id].frees += counters.frees;
+            allocator_stats[id].bytes_freed += counters.bytes_freed;
+        }
+        for (const auto& [id, counters] : freed.by_tag) {
+            tag_stats[id].frees += counters.frees;
+            tag_stats[id].bytes_freed += counters.bytes_freed;
+        }
+        samples.insert(samples.end(), freed.samples.begin(), freed.samples.end());
+        
+        count += freed.size.total_count;
+    }
+    
+    for (size_t i = 0; i < size_pow2.size(); ++i) {
+        if (size_pow2[i] > 0) {
+            report.allocation_size_histogram[uint64_t(1) << i] = size_pow2[i];
         }
     }
     
+    std::vector<std::string> names = nameTable();
+    auto mergeByName = [&names](const std::unordered_map<uint32_t, MemoryReport::AllocatorStats>& by_id,
+                                std::map<std::string, MemoryReport::AllocatorStats>& by_name) {
+        for (const auto& [id, stats] : by_id) {
+            auto& merged = by_name[names[id]];
+            merged.allocations += stats.allocations;
+            merged.frees += stats.frees;
+            merged.bytes_allocated += stats.bytes_allocated;
+            merged.bytes_freed += stats.bytes_freed;
+            merged.current_usage += stats.current_usage;
+        }
+    };
+    mergeByName(allocator_stats, report.allocator_stats);
+    mergeByName(tag_stats, report.tag_stats);
+    
+    for (const auto& sample : samples) {
+        MemoryAllocation record;
+        record.ptr = sample.ptr;
+        record.size = sample.size;
+        record.device_id = sample.device_id;
+        record.alloc_time = sample.alloc_time;
+        record.free_time = sample.free_time;
+        record.allocator = names[sample.allocator_id];
+        record.tag = names[sample.tag_id];
+        record.call_stack_hash = 0;
+        report.freed_samples.push_back(std::move(record));
+    }
+    
     if (count > 0) {
         report.avg_allocation_size = static_cast<double>(total_size) / count;
     }
     
-    if (total_frees_.load() > 0) {
+    if (report.total_frees > 0) {
         report.avg_allocation_lifetime_ns = 
-            static_cast<double>(total_lifetime) / total_frees_.load();
+            static_cast<double>(total_lifetime) / report.total_frees;
     }
     
     if (report.min_allocation_size == UINT64_MAX) {
@@ -328,49 +906,86 @@ MemoryReport MemoryProfiler::generateReport() const {
     // Potential issues
     report.potential_leaks = detectLeaks();
     report.fragmentation = calculateFragmentation();
+    {
+        std::shared_lock<std::shared_mutex> lock(pools_mutex_);
+        for (const auto& [key, pool] : pools_) {
+            std::lock_guard<std::mutex> pool_lock(pool->mutex);
+            std::string name = std::to_string(key >> 32) + ":" + names[key & 0xFFFFFFFFu];
+            report.pool_fragmentation[name] = pool->map.info();
+        }
+    }
     
     // Timeline
-    report.timeline = timeline_;
+    report.timeline = getTimeline();
     
     return report;
 }
 
 void MemoryProfiler::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    live_allocations_.clear();
-    freed_allocations_.clear();
-    timeline_.clear();
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.live.clear();
+        shard.freed.clear();
+        shard.freed_stats.reset();
+        shard.allocations.store(0, std::memory_order_relaxed);
+        shard.frees.store(0, std::memory_order_relaxed);
+        shard.bytes_allocated.store(0, std::memory_order_relaxed);
+        shard.bytes_freed.store(0, std::memory_order_relaxed);
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(pools_mutex_);
+        pools_.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(timeline_mutex_);
+        timeline_.clear();
+        timeline_head_ = 0;
+        timeline_count_ = 0;
+    }
     
     current_usage_.store(0);
     peak_usage_.store(0);
-    total_allocations_.store(0);
-    total_frees_.store(0);
-    total_bytes_allocated_.store(0);
-    total_bytes_freed_.store(0);
     
     start_time_ = 0;
     stop_time_ = 0;
 }
 
+std::vector<CounterEvent> MemoryProfiler::snapshotCounters(const MemorySnapshot& snapshot) {
+    std::vector<CounterEvent> events;
+    events.reserve(5);
+    
+    // Memory usage counter
+    events.emplace_back("GPU Memory Usage", 
+                       static_cast<double>(snapshot.live_bytes) / (1024*1024*1024),
+                       snapshot.timestamp, "GB");
+    
+    // Live allocations counter
+    events.emplace_back("Live Allocations",
+                       static_cast<double>(snapshot.live_allocations),
+                       snapshot.timestamp, "count");
+    
+    // Peak memory counter
+    events.emplace_back("Peak Memory",
+                       static_cast<double>(snapshot.peak_bytes) / (1024*1024*1024),
+                       snapshot.timestamp, "GB");
+    
+    // Fragmentation counters
+    events.emplace_back("Memory Fragmentation",
+                       snapshot.fragmentation.fragmentation_ratio * 100.0,
+                       snapshot.timestamp, "%");
+    events.emplace_back("Free Blocks",
+                       static_cast<double>(snapshot.fragmentation.free_block_count),
+                       snapshot.timestamp, "count");
+    
+    return events;
+}
+
 std::vector<CounterEvent> MemoryProfiler::toCounterEvents() const {
     std::vector<CounterEvent> events;
     
-    for (const auto& snapshot : timeline_) {
-        // Memory usage counter
-        events.emplace_back("GPU Memory Usage", 
-                           static_cast<double>(snapshot.live_bytes) / (1024*1024*1024),
-                           snapshot.timestamp, "GB");
-        
-        // Live allocations counter
-        events.emplace_back("Live Allocations",
-                           static_cast<double>(snapshot.live_allocations),
-                           snapshot.timestamp, "count");
-        
-        // Peak memory counter
-        events.emplace_back("Peak Memory",
-                           static_cast<double>(snapshot.peak_bytes) / (1024*1024*1024),
-                           snapshot.timestamp, "GB");
+    for (const auto& snapshot : getTimeline()) {
+        std::vector<CounterEvent> counters = snapshotCounters(snapshot);
+        events.insert(events.end(), counters.begin(), counters.end());
     }
     
     return events;
@@ -378,42 +993,49 @@ std::vector<CounterEvent> MemoryProfiler::toCounterEvents() const {
 
 std::vector<MemoryEvent> MemoryProfiler::toMemoryEvents() const {
     std::vector<MemoryEvent> events;
+    std::vector<std::string> names = nameTable();
     
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // Live allocations
-    for (const auto& [ptr, alloc] : live_allocations_) {
-        MemoryEvent event;
-        event.timestamp = alloc.alloc_time;
-        event.device_id = alloc.device_id;
-        event.bytes = alloc.size;
-        event.ptr = alloc.ptr;
-        event.is_allocation = true;
-        event.allocator_name = alloc.allocator;
-        events.push_back(event);
-    }
-    
-    // Freed allocations (both alloc and free events)
-    for (const auto& alloc : freed_allocations_) {
-        // Allocation event
-        MemoryEvent alloc_event;
-        alloc_event.timestamp = alloc.alloc_time;
-        alloc_event.device_id = alloc.device_id;
-        alloc_event.bytes = alloc.size;
-        alloc_event.ptr = alloc.ptr;
-        alloc_event.is_allocation = true;
-        alloc_event.allocator_name = alloc.allocator;
-        events.push_back(alloc_event);
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
         
-        // Free event
-        MemoryEvent free_event;
-        free_event.timestamp = alloc.free_time;
-        free_event.device_id = alloc.device_id;
-        free_event.bytes = alloc.size;
-        free_event.ptr = alloc.ptr;
-        free_event.is_allocation = false;
-        free_event.allocator_name = alloc.allocator;
-        events.push_back(free_event);
+        // Live allocations
+        for (const auto& [ptr, alloc] : shard.live) {
+            MemoryEvent event;
+            event.timestamp = alloc.alloc_time;
+            event.device_id = alloc.device_id;
+            event.bytes = alloc.size;
+            event.ptr = ptr;
+            event.is_allocation = true;
+            event.allocator_name = names[alloc.allocator_id];
+            events.push_back(event);
+        }
+        
+        // Freed allocations (both alloc and free events)
+        const std::vector<FreedAllocation>& freed =
+            config_.streaming_stats
+                ? (shard.freed_stats ? shard.freed_stats->samples : shard.freed)
+                : shard.freed;
+        for (const auto& alloc : freed) {
+            // Allocation event
+            MemoryEvent alloc_event;
+            alloc_event.timestamp = alloc.alloc_time;
+            alloc_event.device_id = alloc.device_id;
+            alloc_event.bytes = alloc.size;
+            alloc_event.ptr = alloc.ptr;
+            alloc_event.is_allocation = true;
+            alloc_event.allocator_name = names[alloc.allocator_id];
+            events.push_back(alloc_event);
+            
+            // Free event
+            MemoryEvent free_event;
+            free_event.timestamp = alloc.free_time;
+            free_event.device_id = alloc.device_id;
+            free_event.bytes = alloc.size;
+            free_event.ptr = alloc.ptr;
+            free_event.is_allocation = false;
+            free_event.allocator_name = names[alloc.allocator_id];
+            events.push_back(free_event);
+        }
     }
     
     // Sort by timestamp
@@ -452,6 +1074,10 @@ std::string MemoryReport::summary() const {
     oss << "  Max Size:           " << formatBytes(max_allocation_size) << "\n";
     oss << "  Avg Size:           " << formatBytes(static_cast<uint64_t>(avg_allocation_size)) << "\n";
     oss << "  Avg Lifetime:       " << formatDuration(static_cast<uint64_t>(avg_allocation_lifetime_ns)) << "\n";
+    if (lifetime_histogram.total_count > 0) {
+        oss << "  Lifetime p50/p99:   " << formatDuration(lifetime_histogram.valueAtPercentile(50))
+            << " / " << formatDuration(lifetime_histogram.valueAtPercentile(99)) << "\n";
+    }
     
     if (!potential_leaks.empty()) {
         oss << "\n⚠️  Potential Memory Leaks (" << potential_leaks.size() << ")\n";
@@ -469,6 +1095,17 @@ std::string MemoryReport::summary() const {
         }
     }
     
+    if (fragmentation.total_free_bytes > 0) {
+        oss << "\nFragmentation\n";
+        oss << "───────────────────────────────────────────────────\n";
+        oss << "  Free (in span):     " << formatBytes(fragmentation.total_free_bytes)
+            << " in " << fragmentation.free_block_count << " blocks\n";
+        oss << "  Largest Free Block: " << formatBytes(fragmentation.largest_free_block) << "\n";
+        char ratio[32];
+        snprintf(ratio, sizeof(ratio), "%.1f%%", fragmentation.fragmentation_ratio * 100.0);
+        oss << "  Fragmentation:      " << ratio << "\n";
+    }
+    
     if (!allocator_stats.empty()) {
         oss << "\nPer-Allocator Statistics\n";
         oss << "───────────────────────────────────────────────────\n";
@@ -504,10 +1141,22 @@ std::string MemoryReport::toJSON() const {
     oss << "    \"min_size\": " << min_allocation_size << ",\n";
     oss << "    \"max_size\": " << max_allocation_size << ",\n";
     oss << "    \"avg_size\": " << avg_allocation_size << ",\n";
-    oss << "    \"avg_lifetime_ns\": " << avg_allocation_lifetime_ns << "\n";
+    oss << "    \"avg_lifetime_ns\": " << avg_allocation_lifetime_ns << ",\n";
+    oss << "    \"size_p50\": " << size_histogram.valueAtPercentile(50) << ",\n";
+    oss << "    \"size_p99\": " << size_histogram.valueAtPercentile(99) << ",\n";
+    oss << "    \"lifetime_p50_ns\": " << lifetime_histogram.valueAtPercentile(50) << ",\n";
+    oss << "    \"lifetime_p99_ns\": " << lifetime_histogram.valueAtPercentile(99) << "\n";
+    oss << "  },\n";
+    
+    oss << "  \"fragmentation\": {\n";
+    oss << "    \"total_free_bytes\": " << fragmentation.total_free_bytes << ",\n";
+    oss << "    \"largest_free_block\": " << fragmentation.largest_free_block << ",\n";
+    oss << "    \"free_block_count\": " << fragmentation.free_block_count << ",\n";
+    oss << "    \"fragmentation_ratio\": " << fragmentation.fragmentation_ratio << "\n";
     oss << "  },\n";
     
     oss << "  \"potential_leaks\": " << potential_leaks.size() << ",\n";
+    oss << "  \"freed_samples\": " << freed_samples.size() << ",\n";
     
     oss << "  \"timeline_samples\": " << timeline.size() << "\n";
     oss << "}\n";
@@ -84,6 +84,7 @@ bool MetalProfiler::initialize(const ProfilerConfig& config) {
         }
         
         config_ = config;
+        sampler_.configure(config);
         
         // Get default Metal device
         id<MTLDevice> device = MTLCreateSystemDefaultDevice();
@@ -163,6 +164,7 @@ bool MetalProfiler::startCapture() {
         }
         events_captured_ = 0;
         events_dropped_ = 0;
+        sampler_.reset();
         
         // Start Metal capture
         if (@available(macOS 10.15, iOS 13.0, *)) {
@@ -337,6 +339,9 @@ void MetalProfiler::processCommandBuffer(void* buffer) {
                 event.duration = gpu_end_ns - gpu_start_ns;
                 
                 // Add event
+                if (!sampler_.admit(event)) {
+                    return;
+                }
                 events_captured_++;
                 if (callback_) {
                     callback_(event);
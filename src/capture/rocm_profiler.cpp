@@ -161,6 +161,7 @@ bool ROCmProfiler::initialize(const ProfilerConfig& config) {
     }
     
     config_ = config;
+    sampler_.configure(config);
     
     // Initialize HIP runtime
     HIP_CALL(hipInit(0));
@@ -223,6 +224,7 @@ bool ROCmProfiler::startCapture() {
     }
     events_captured_ = 0;
     events_dropped_ = 0;
+    sampler_.reset();
     
     // Enable HIP API tracing (callback-based)
     if (hip_api_tracing_enabled_) {
@@ -667,6 +669,9 @@ void ROCmProfiler::processSyncActivity(const roctracer_record_t* record) {
 //==============================================================================
 
 void ROCmProfiler::addEvent(TraceEvent&& event) {
+    if (!sampler_.admit(event)) {
+        return;
+    }
     ++events_captured_;
     
     // Fire callback if registered
@@ -1,10 +1,22 @@
 #include "tracesmith/common/xray_importer.hpp"
+#include "tracesmith/common/parallel.hpp"
+#include "tracesmith/common/xray_symbol_resolver.hpp"
 #include <fstream>
 #include <algorithm>
 #include <cstring>
-#include <stack>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <queue>
 #include <unordered_set>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace tracesmith {
 
 // XRay basic mode record structure (32 bytes)
@@ -18,24 +30,263 @@ struct XRayBasicRecord {
 };
 static_assert(sizeof(XRayBasicRecord) == 32, "XRay record must be 32 bytes");
 
+// XRay basic mode record as written by the LLVM runtime (32 bytes)
+struct XRayLLVMBasicRecord {
+    uint16_t record_type;       // 0 = function, 1 = argument payload
+    uint8_t cpu_id;
+    uint8_t type;               // 0 = enter, 1 = exit, 2 = tail exit, 3 = enter with args
+    int32_t function_id;
+    uint64_t tsc;
+    uint32_t thread_id;
+    uint32_t pid;
+    uint8_t padding[8];
+};
+static_assert(sizeof(XRayLLVMBasicRecord) == 32, "XRay record must be 32 bytes");
+
 // XRay file magic
 constexpr uint32_t XRAY_MAGIC = 0x4152584C;  // "LXRA"
 
-std::vector<TraceEvent> XRayImporter::importFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary | std::ios::ate);
-    if (!file) {
-        return {};
+namespace {
+
+constexpr size_t kLegacyHeaderSize = 16;
+constexpr size_t kLLVMHeaderSize = 32;
+
+// FDR records: 16-byte metadata records (low bit set, kind in bits 1-7)
+// and 8-byte function records (kind in bits 1-3, function ID in 4-31,
+// then a 32-bit TSC delta)
+constexpr size_t kMetadataSize = 16;
+constexpr size_t kFunctionRecordSize = 8;
+
+enum class FDRMetadata : uint8_t {
+    NewBuffer = 0,
+    EndOfBuffer = 1,
+    NewCPUId = 2,
+    TSCWrap = 3,
+    WalltimeMarker = 4,
+    CustomEventMarker = 5,
+    CallArgument = 6,
+    BufferExtents = 7,
+    TypedEventMarker = 8,
+    Pid = 9
+};
+
+constexpr uint8_t metadataByte(FDRMetadata kind) {
+    return static_cast<uint8_t>((static_cast<uint8_t>(kind) << 1) | 1);
+}
+
+template<typename T>
+T load(const uint8_t* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+/// Read-only view of a file: mapped where supported, read otherwise
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* mapping = ::mmap(nullptr, static_cast<size_t>(st.st_size),
+                                   PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                data_ = static_cast<const uint8_t*>(mapping);
+                size_ = static_cast<size_t>(st.st_size);
+                mapped_ = true;
+            }
+        }
+        ::close(fd);
+        if (mapped_) {
+            return;
+        }
+#endif
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return;
+        }
+        buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data_ = reinterpret_cast<const uint8_t*>(buffer_.data());
+        size_ = buffer_.size();
     }
     
-    size_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapped_) {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+        }
+#endif
+    }
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> buffer_;
+};
+
+/// One per-thread FDR buffer: its records span [begin, end)
+struct FDRBuffer {
+    size_t begin;
+    size_t end;
+    uint64_t first_tsc;
+};
+
+/**
+ * Decode the records of one FDR buffer, calling
+ * sink(function_id, tsc, type, cpu_id) for each function record.
+ * TSCs are rebuilt from the NewCPUId/TSCWrap bases and the per-record
+ * deltas. Decoding stops at a record that cannot be framed.
+ */
+template<typename Sink>
+void decodeFDRBuffer(const uint8_t* data, const FDRBuffer& buffer, uint16_t version,
+                     uint64_t& custom_events, Sink&& sink) {
+    uint64_t tsc = 0;
+    uint8_t cpu_id = 0;
+    size_t offset = buffer.begin;
     
-    std::vector<uint8_t> buffer(size);
-    if (!file.read(reinterpret_cast<char*>(buffer.data()), size)) {
+    while (offset < buffer.end) {
+        const uint8_t* record = data + offset;
+        
+        if ((record[0] & 1) == 0) {
+            if (offset + kFunctionRecordSize > buffer.end) {
+                return;
+            }
+            uint32_t word = load<uint32_t>(record);
+            tsc += load<uint32_t>(record + 4);
+            offset += kFunctionRecordSize;
+            
+            switch ((word >> 1) & 7) {
+                case 0:  // Enter
+                case 3:  // Enter with arguments
+                    sink(word >> 4, tsc, XRayEntryType::FunctionEnter, cpu_id);
+                    break;
+                case 1:
+                    sink(word >> 4, tsc, XRayEntryType::FunctionExit, cpu_id);
+                    break;
+                case 2:
+                    sink(word >> 4, tsc, XRayEntryType::TailExit, cpu_id);
+                    break;
+                default:
+                    break;
+            }
+            continue;
+        }
+        
+        if (offset + kMetadataSize > buffer.end) {
+            return;
+        }
+        const uint8_t* payload = record + 1;
+        offset += kMetadataSize;
+        
+        switch (static_cast<FDRMetadata>(record[0] >> 1)) {
+            case FDRMetadata::NewCPUId:
+                cpu_id = static_cast<uint8_t>(load<uint16_t>(payload));
+                tsc = load<uint64_t>(payload + 2);
+                break;
+            case FDRMetadata::TSCWrap:
+                tsc = load<uint64_t>(payload);
+                break;
+            case FDRMetadata::EndOfBuffer:
+                return;
+            case FDRMetadata::CustomEventMarker: {
+                // Version 5 carries a TSC delta; earlier versions a full TSC
+                // that does not rebase later function records
+                int32_t event_size = load<int32_t>(payload);
+                if (version >= 5) {
+                    tsc += static_cast<uint64_t>(static_cast<int64_t>(load<int32_t>(payload + 4)));
+                }
+                offset += static_cast<size_t>(std::max(event_size, 0));
+                custom_events++;
+                break;
+            }
+            case FDRMetadata::TypedEventMarker: {
+                int32_t event_size = load<int32_t>(payload);
+                tsc += static_cast<uint64_t>(static_cast<int64_t>(load<int32_t>(payload + 4)));
+                offset += static_cast<size_t>(std::max(event_size, 0));
+                custom_events++;
+                break;
+            }
+            case FDRMetadata::NewBuffer:
+            case FDRMetadata::WalltimeMarker:
+            case FDRMetadata::CallArgument:
+            case FDRMetadata::BufferExtents:
+            case FDRMetadata::Pid:
+                break;
+            default:
+                return;
+        }
+    }
+}
+
+} // anonymous namespace
+
+/// Calls of one thread, matched in record order
+struct XRayImporter::ThreadCalls {
+    struct Call {
+        uint64_t start_tsc = 0;
+        uint64_t end_tsc = 0;
+        uint32_t function_id = 0;
+        uint8_t cpu_id = 0;
+        bool complete = false;
+    };
+    
+    uint32_t thread_id = 0;
+    std::vector<Call> calls;            // In entry order
+    std::vector<size_t> open_calls;     // Entered but not yet exited
+    std::vector<XRayFunctionRecord> raw;
+    std::vector<TraceEvent> events;     // Converted calls, by timestamp
+    uint64_t records = 0;
+    uint64_t custom_events = 0;
+    uint64_t filtered = 0;
+    
+    void record(uint32_t function_id, uint64_t tsc, XRayEntryType type,
+                uint8_t cpu_id, bool keep_raw) {
+        records++;
+        if (keep_raw) {
+            XRayFunctionRecord func_record;
+            func_record.function_id = function_id;
+            func_record.timestamp = tsc;
+            func_record.type = type;
+            func_record.thread_id = thread_id;
+            func_record.cpu_id = cpu_id;
+            raw.push_back(func_record);
+        }
+        
+        if (type == XRayEntryType::FunctionEnter) {
+            open_calls.push_back(calls.size());
+            Call call;
+            call.start_tsc = tsc;
+            call.function_id = function_id;
+            call.cpu_id = cpu_id;
+            calls.push_back(call);
+        } else if ((type == XRayEntryType::FunctionExit ||
+                    type == XRayEntryType::TailExit) && !open_calls.empty()) {
+            Call& call = calls[open_calls.back()];
+            open_calls.pop_back();
+            call.end_tsc = tsc;
+            call.complete = true;
+        }
+    }
+};
+
+std::vector<TraceEvent> XRayImporter::importFile(const std::string& filename) {
+    MappedFile file(filename);
+    if (!file.data()) {
         return {};
     }
     
-    return importBuffer(buffer.data(), buffer.size());
+    return importBuffer(file.data(), file.size());
 }
 
 std::vector<TraceEvent> XRayImporter::importBuffer(const uint8_t* data, size_t size) {
@@ -51,15 +302,17 @@ std::vector<TraceEvent> XRayImporter::importBuffer(const uint8_t* data, size_t s
         return {};
     }
     
+    std::vector<ThreadCalls> threads;
+    
     // Parse based on file type
     if (header_.type == 0) {
         // Basic mode
-        if (!parseBasicMode(data, size)) {
+        if (!parseBasicMode(data, size, threads)) {
             return {};
         }
     } else if (header_.type == 1) {
         // FDR mode
-        if (!parseFDRMode(data, size)) {
+        if (!parseFDRMode(data, size, threads)) {
             return {};
         }
     } else {
@@ -67,22 +320,43 @@ std::vector<TraceEvent> XRayImporter::importBuffer(const uint8_t* data, size_t s
         return {};
     }
     
+    for (auto& thread : threads) {
+        stats_.records_read += thread.records;
+        stats_.custom_events += thread.custom_events;
+        if (config_.keep_raw_records) {
+            raw_records_.insert(raw_records_.end(), thread.raw.begin(), thread.raw.end());
+            std::vector<XRayFunctionRecord>().swap(thread.raw);
+        }
+    }
+    header_.num_records = stats_.records_read;
+    
     // Resolve symbols if configured
     if (config_.resolve_symbols) {
-        resolveSymbols();
+        resolveSymbols(threads);
     }
     
     // Convert to TraceSmith events
-    return convertToEvents();
+    return convertToEvents(threads);
 }
 
 bool XRayImporter::parseHeader(const uint8_t* data, size_t size) {
     if (size < 16) return false;
     
+    header_ = XRayFileHeader{};
+    llvm_header_ = false;
+    fdr_buffer_size_ = 0;
+    
     // Check magic number
     uint32_t magic;
     std::memcpy(&magic, data, sizeof(magic));
     
+    // LLVM header: version, type, TSC flags (2 bits), cycle frequency,
+    // then 16 bytes holding the thread buffer size in FDR version 1
+    uint16_t version = load<uint16_t>(data);
+    uint16_t type = load<uint16_t>(data + 2);
+    uint32_t flags = load<uint32_t>(data + 4);
+    uint64_t frequency = size >= kLLVMHeaderSize ? load<uint64_t>(data + 8) : 0;
+    
     // XRay files can have different formats
     // Try to detect the format
     if (magic == XRAY_MAGIC) {
@@ -90,198 +364,252 @@ bool XRayImporter::parseHeader(const uint8_t* data, size_t size) {
         std::memcpy(&header_.version, data + 4, sizeof(uint16_t));
         std::memcpy(&header_.type, data + 6, sizeof(uint16_t));
         std::memcpy(&header_.cycle_frequency, data + 8, sizeof(uint32_t));
+        data_offset_ = kLegacyHeaderSize;
+    } else if (version >= 1 && version <= 5 && type <= 1 && flags <= 3 && frequency != 0) {
+        // Log written by the LLVM XRay runtime
+        header_.version = version;
+        header_.type = type;
+        header_.cycle_frequency = static_cast<uint32_t>(
+            std::min<uint64_t>(frequency, std::numeric_limits<uint32_t>::max()));
+        fdr_buffer_size_ = load<uint64_t>(data + 16);
+        data_offset_ = kLLVMHeaderSize;
+        llvm_header_ = true;
     } else {
         // Try basic mode without header (raw records)
         header_.version = 1;
         header_.type = 0;
         header_.cycle_frequency = 2400000000;  // Default 2.4 GHz
+        data_offset_ = 0;
     }
     
     return true;
 }
 
-bool XRayImporter::parseBasicMode(const uint8_t* data, size_t size) {
-    // Skip header if present
-    size_t offset = 0;
-    uint32_t magic;
-    std::memcpy(&magic, data, sizeof(magic));
-    if (magic == XRAY_MAGIC) {
-        offset = 16;  // Skip header
-    }
+bool XRayImporter::parseBasicMode(const uint8_t* data, size_t size,
+                                  std::vector<ThreadCalls>& threads) {
+    // Records of all threads are interleaved; match them in one pass
+    std::unordered_map<uint32_t, size_t> thread_index;
+    auto threadCalls = [&](uint32_t thread_id) -> ThreadCalls& {
+        auto [it, inserted] = thread_index.emplace(thread_id, threads.size());
+        if (inserted) {
+            threads.emplace_back();
+            threads.back().thread_id = thread_id;
+        }
+        return threads[it->second];
+    };
+    const bool keep_raw = config_.keep_raw_records;
     
-    // Parse records
-    while (offset + sizeof(XRayBasicRecord) <= size) {
-        XRayBasicRecord record;
-        std::memcpy(&record, data + offset, sizeof(XRayBasicRecord));
-        offset += sizeof(XRayBasicRecord);
+    size_t offset = data_offset_;
+    while (offset + 32 <= size) {
+        const uint8_t* record = data + offset;
+        offset += 32;
         
-        // Validate record type
-        if (record.record_type > 4) {
-            continue;  // Invalid record type
+        if (llvm_header_) {
+            XRayLLVMBasicRecord llvm_record;
+            std::memcpy(&llvm_record, record, sizeof(llvm_record));
+            
+            // Skip argument payloads and unknown entry types
+            if (llvm_record.record_type != 0 || llvm_record.type > 3) {
+                continue;
+            }
+            XRayEntryType type = llvm_record.type == 3
+                ? XRayEntryType::FunctionEnter
+                : static_cast<XRayEntryType>(llvm_record.type);
+            threadCalls(llvm_record.thread_id).record(
+                static_cast<uint32_t>(llvm_record.function_id), llvm_record.tsc,
+                type, llvm_record.cpu_id, keep_raw);
+        } else {
+            XRayBasicRecord basic_record;
+            std::memcpy(&basic_record, record, sizeof(XRayBasicRecord));
+            
+            // Validate record type
+            if (basic_record.record_type > 4) {
+                continue;  // Invalid record type
+            }
+            threadCalls(basic_record.thread_id).record(
+                basic_record.function_id, basic_record.timestamp,
+                static_cast<XRayEntryType>(basic_record.record_type),
+                basic_record.cpu_id, keep_raw);
         }
-        
-        XRayFunctionRecord func_record;
-        func_record.function_id = record.function_id;
-        func_record.timestamp = record.timestamp;
-        func_record.type = static_cast<XRayEntryType>(record.record_type);
-        func_record.thread_id = record.thread_id;
-        func_record.cpu_id = record.cpu_id;
-        
-        raw_records_.push_back(func_record);
-        stats_.records_read++;
     }
     
     return true;
 }
 
-bool XRayImporter::parseFDRMode(const uint8_t* data, size_t size) {
-    // FDR (Flight Data Recorder) mode has a more complex format
-    // with buffer extents and metadata records
+bool XRayImporter::parseFDRMode(const uint8_t* data, size_t size,
+                                std::vector<ThreadCalls>& threads) {
+    // Version 1 writes fixed-size buffers ending in EndOfBuffer; later
+    // versions prefix each buffer with a BufferExtents record
+    uint16_t version = llvm_header_ ? header_.version : 3;
+    if (version < 2 && fdr_buffer_size_ == 0) {
+        return false;
+    }
     
-    size_t offset = 16;  // Skip header
+    // Index pass: locate every buffer and the thread that wrote it
+    std::unordered_map<uint32_t, size_t> thread_index;
+    std::vector<std::vector<FDRBuffer>> buffers;
     
-    while (offset + 8 <= size) {
-        // Read record type
-        uint8_t record_type = data[offset];
-        
-        switch (record_type) {
-            case 0: {
-                // Buffer extent - metadata about buffer
-                offset += 16;
-                break;
-            }
-            case 1: {
-                // New buffer record
-                offset += 16;
-                break;
-            }
-            case 2: {
-                // End of buffer
-                offset += 8;
-                break;
-            }
-            case 3: {
-                // New CPU record
-                offset += 16;
-                break;
+    size_t offset = data_offset_;
+    while (offset + kMetadataSize <= size) {
+        FDRBuffer buffer;
+        if (version >= 2) {
+            if (data[offset] != metadataByte(FDRMetadata::BufferExtents)) {
+                break;  // Trailing padding or corruption
             }
-            case 4: {
-                // Function entry/exit record (8 bytes)
-                if (offset + 8 > size) break;
-                
-                uint64_t entry;
-                std::memcpy(&entry, data + offset, sizeof(entry));
-                
-                XRayFunctionRecord func_record;
-                func_record.type = (entry & 1) ? XRayEntryType::FunctionExit 
-                                               : XRayEntryType::FunctionEnter;
-                func_record.function_id = (entry >> 1) & 0xFFFFFFF;
-                func_record.timestamp = entry >> 32;
-                
-                raw_records_.push_back(func_record);
-                stats_.records_read++;
-                
-                offset += 8;
-                break;
-            }
-            case 5: {
-                // Custom event record
-                if (offset + 16 > size) break;
-                
-                uint64_t size_field;
-                std::memcpy(&size_field, data + offset + 8, sizeof(size_field));
-                size_t event_size = size_field & 0xFFFFFFFF;
-                
-                stats_.custom_events++;
-                offset += 16 + event_size;
+            uint64_t extent = load<uint64_t>(data + offset + 1);
+            buffer.begin = offset + kMetadataSize;
+            buffer.end = buffer.begin + static_cast<size_t>(
+                std::min<uint64_t>(extent, size - buffer.begin));
+        } else {
+            buffer.begin = offset;
+            buffer.end = buffer.begin + static_cast<size_t>(
+                std::min<uint64_t>(fdr_buffer_size_, size - buffer.begin));
+        }
+        offset = buffer.end;
+        
+        // Preamble: NewBuffer (thread), walltime and pid, then NewCPUId
+        // with the base TSC that orders a thread's buffers
+        bool has_thread = false;
+        uint32_t thread_id = 0;
+        buffer.first_tsc = 0;
+        for (size_t pos = buffer.begin;
+             pos + kMetadataSize <= buffer.end && (data[pos] & 1);
+             pos += kMetadataSize) {
+            auto kind = static_cast<FDRMetadata>(data[pos] >> 1);
+            if (kind == FDRMetadata::NewBuffer) {
+                thread_id = static_cast<uint32_t>(load<int32_t>(data + pos + 1));
+                has_thread = true;
+            } else if (kind == FDRMetadata::NewCPUId) {
+                buffer.first_tsc = load<uint64_t>(data + pos + 3);
                 break;
-            }
-            case 6: {
-                // Typed event record
-                offset += 24;  // Fixed size typed event
+            } else if (kind != FDRMetadata::WalltimeMarker && kind != FDRMetadata::Pid) {
                 break;
             }
-            default:
-                // Unknown record type, try to skip
-                offset += 8;
-                break;
         }
+        if (!has_thread) {
+            continue;
+        }
+        
+        auto [it, inserted] = thread_index.emplace(thread_id, buffers.size());
+        if (inserted) {
+            buffers.emplace_back();
+        }
+        buffers[it->second].push_back(buffer);
+    }
+    
+    threads.resize(buffers.size());
+    for (const auto& [thread_id, index] : thread_index) {
+        threads[index].thread_id = thread_id;
     }
     
+    // Threads are independent: decode each one's buffers in time order,
+    // matching calls that span buffers on the thread's own stack
+    const bool keep_raw = config_.keep_raw_records;
+    parallelFor(threads.size(), num_threads_, [&](size_t t) {
+        auto& thread_buffers = buffers[t];
+        std::stable_sort(thread_buffers.begin(), thread_buffers.end(),
+                         [](const FDRBuffer& a, const FDRBuffer& b) {
+                             return a.first_tsc < b.first_tsc;
+                         });
+        
+        ThreadCalls& thread = threads[t];
+        for (const auto& buffer : thread_buffers) {
+            decodeFDRBuffer(data, buffer, version, thread.custom_events,
+                            [&](uint32_t function_id, uint64_t tsc,
+                                XRayEntryType type, uint8_t cpu_id) {
+                                thread.record(function_id, tsc, type, cpu_id, keep_raw);
+                            });
+        }
+    });
+    
     return true;
 }
 
-std::vector<TraceEvent> XRayImporter::convertToEvents() {
-    std::vector<TraceEvent> events;
-    
-    // Sort records by timestamp
-    std::vector<XRayFunctionRecord> sorted_records = raw_records_;
-    std::sort(sorted_records.begin(), sorted_records.end(),
-              [](const XRayFunctionRecord& a, const XRayFunctionRecord& b) {
-                  return a.timestamp < b.timestamp;
-              });
-    
-    // Use stack to match enter/exit pairs per thread
-    std::unordered_map<uint32_t, std::stack<size_t>> thread_stacks;
-    
-    // First pass: create events for entries
-    for (size_t i = 0; i < sorted_records.size(); ++i) {
-        const auto& record = sorted_records[i];
+std::vector<TraceEvent> XRayImporter::convertToEvents(std::vector<ThreadCalls>& threads) {
+    // Per thread: calls become events, already in entry order
+    parallelFor(threads.size(), num_threads_, [&](size_t t) {
+        ThreadCalls& thread = threads[t];
+        thread.events.reserve(thread.calls.size());
         
-        if (record.type == XRayEntryType::FunctionEnter) {
+        for (const auto& call : thread.calls) {
             TraceEvent event(EventType::RangeStart);
-            event.timestamp = tscToNanoseconds(record.timestamp);
-            event.thread_id = record.thread_id;
-            event.correlation_id = i;  // Use index as correlation ID
+            event.timestamp = tscToNanoseconds(call.start_tsc);
+            event.thread_id = thread.thread_id;
+            
+            if (call.complete) {
+                uint64_t end_time = tscToNanoseconds(call.end_tsc);
+                event.duration = end_time > event.timestamp ? end_time - event.timestamp : 0;
+                
+                // Apply duration filter
+                if (config_.filter_short_calls &&
+                    event.duration < config_.min_duration_ns) {
+                    thread.filtered++;
+                    continue;
+                }
+            }
             
             // Set function name
-            auto it = function_map_.find(record.function_id);
+            auto it = function_map_.find(call.function_id);
             if (it != function_map_.end()) {
                 event.name = it->second;
             } else {
-                event.name = "func_" + std::to_string(record.function_id);
+                event.name = "func_" + std::to_string(call.function_id);
             }
             
             // Add XRay metadata
-            event.metadata["xray_func_id"] = std::to_string(record.function_id);
-            event.metadata["cpu_id"] = std::to_string(record.cpu_id);
-            
-            events.push_back(event);
-            thread_stacks[record.thread_id].push(events.size() - 1);
+            event.metadata["xray_func_id"] = std::to_string(call.function_id);
+            event.metadata["cpu_id"] = std::to_string(call.cpu_id);
             
-            stats_.records_converted++;
-        } else if (record.type == XRayEntryType::FunctionExit || 
-                   record.type == XRayEntryType::TailExit) {
-            auto& stack = thread_stacks[record.thread_id];
-            
-            if (!stack.empty()) {
-                size_t start_idx = stack.top();
-                stack.pop();
-                
-                // Update the start event with duration
-                auto& start_event = events[start_idx];
-                uint64_t end_time = tscToNanoseconds(record.timestamp);
-                start_event.duration = end_time - start_event.timestamp;
-                
-                // Apply duration filter
-                if (config_.filter_short_calls && 
-                    start_event.duration < config_.min_duration_ns) {
-                    // Mark for removal (we'll filter later)
-                    start_event.type = EventType::Unknown;
-                    stats_.records_filtered++;
-                }
-            }
+            thread.events.push_back(std::move(event));
         }
+        
+        // TSCs can step backwards when a thread migrates between cores
+        // without an invariant TSC
+        auto by_time = [](const TraceEvent& a, const TraceEvent& b) {
+            return a.timestamp < b.timestamp;
+        };
+        if (!std::is_sorted(thread.events.begin(), thread.events.end(), by_time)) {
+            std::stable_sort(thread.events.begin(), thread.events.end(), by_time);
+        }
+        
+        std::vector<ThreadCalls::Call>().swap(thread.calls);
+        std::vector<size_t>().swap(thread.open_calls);
+    });
+    
+    size_t total = 0;
+    for (const auto& thread : threads) {
+        total += thread.events.size();
+        stats_.records_converted += thread.events.size() + thread.filtered;
+        stats_.records_filtered += thread.filtered;
     }
     
-    // Remove filtered events
-    if (config_.filter_short_calls) {
-        events.erase(
-            std::remove_if(events.begin(), events.end(),
-                          [](const TraceEvent& e) { 
-                              return e.type == EventType::Unknown; 
-                          }),
-            events.end());
+    // K-way merge by timestamp; ties go to the thread seen first in the
+    // file, so output does not depend on the worker count
+    std::vector<TraceEvent> events;
+    events.reserve(total);
+    
+    using Cursor = std::pair<uint64_t, size_t>;  // (timestamp, thread)
+    std::priority_queue<Cursor, std::vector<Cursor>, std::greater<Cursor>> heap;
+    std::vector<size_t> next(threads.size(), 0);
+    for (size_t t = 0; t < threads.size(); ++t) {
+        if (!threads[t].events.empty()) {
+            heap.emplace(threads[t].events.front().timestamp, t);
+        }
+    }
+    while (!heap.empty()) {
+        size_t t = heap.top().second;
+        heap.pop();
+        
+        auto& thread_events = threads[t].events;
+        TraceEvent& event = thread_events[next[t]++];
+        event.correlation_id = events.size();
+        events.push_back(std::move(event));
+        
+        if (next[t] < thread_events.size()) {
+            heap.emplace(thread_events[next[t]].timestamp, t);
+        } else {
+            std::vector<TraceEvent>().swap(thread_events);
+        }
     }
     
     // Calculate statistics
@@ -296,25 +624,27 @@ std::vector<TraceEvent> XRayImporter::convertToEvents() {
     return events;
 }
 
-void XRayImporter::resolveSymbols() {
-    // Symbol resolution would typically use:
-    // 1. DWARF debug info from the binary
-    // 2. XRay instrumentation map
-    // 3. External symbol file
-    
-    // For now, we generate synthetic names
-    // Real implementation would use libdwarf or llvm-symbolizer
+void XRayImporter::resolveSymbols(const std::vector<ThreadCalls>& threads) {
+    // Function IDs index the binary's XRay instrumentation map; the
+    // resolver is shared by every import of the same binary
+    std::shared_ptr<const XRaySymbolResolver> resolver;
+    if (!config_.symbol_file.empty()) {
+        resolver = XRaySymbolResolver::forBinary(config_.symbol_file, config_.use_symbol_cache);
+    }
     
     std::unordered_set<uint32_t> func_ids;
-    for (const auto& record : raw_records_) {
-        func_ids.insert(record.function_id);
+    for (const auto& thread : threads) {
+        for (const auto& call : thread.calls) {
+            func_ids.insert(call.function_id);
+        }
     }
     
     for (uint32_t id : func_ids) {
-        // Check if we have a symbol file
-        if (!config_.symbol_file.empty()) {
-            // TODO: Parse symbol file to get real function names
-            // For now, use placeholder
+        const std::string* name = resolver ? resolver->functionName(id) : nullptr;
+        if (name) {
+            function_map_[id] = *name;
+        } else if (!config_.symbol_file.empty()) {
+            // Not in the instrumentation map (or the binary is unreadable)
             function_map_[id] = "xray_func_" + std::to_string(id);
         } else {
             function_map_[id] = "func_" + std::to_string(id);
@@ -350,4 +680,3 @@ uint64_t XRayImporter::tscToNanoseconds(uint64_t tsc) const {
 }
 
 } // namespace tracesmith
-
@@ -0,0 +1,518 @@
+/**
+ * XRay symbol resolver
+ *
+ * Only the section headers, the instrumentation map, the symbol and
+ * string tables and (for old sled layouts) the relocation sections are
+ * read from the binary; debug info is never touched.
+ */
+
+#include "tracesmith/common/xray_symbol_resolver.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
+
+namespace tracesmith {
+
+namespace {
+
+// ELF64 on-disk structures (little-endian)
+struct Elf64Header {
+    uint8_t ident[16];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint64_t entry;
+    uint64_t phoff;
+    uint64_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint16_t phnum;
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+};
+
+struct Elf64Section {
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t addralign;
+    uint64_t entsize;
+};
+
+struct Elf64Symbol {
+    uint32_t name;
+    uint8_t info;
+    uint8_t other;
+    uint16_t shndx;
+    uint64_t value;
+    uint64_t size;
+};
+
+struct Elf64Rela {
+    uint64_t offset;
+    uint64_t info;
+    int64_t addend;
+};
+
+static_assert(sizeof(Elf64Header) == 64, "ELF64 header is 64 bytes");
+static_assert(sizeof(Elf64Section) == 64, "ELF64 section header is 64 bytes");
+static_assert(sizeof(Elf64Symbol) == 24, "ELF64 symbol is 24 bytes");
+static_assert(sizeof(Elf64Rela) == 24, "ELF64 rela entry is 24 bytes");
+
+constexpr uint16_t kTypeRelocatable = 1;
+constexpr uint32_t kSectionSymtab = 2;
+constexpr uint32_t kSectionRela = 4;
+constexpr uint32_t kSectionNobits = 8;
+constexpr uint32_t kSectionDynsym = 11;
+constexpr uint8_t kSymbolFunc = 2;
+
+constexpr uint16_t kMachineX86_64 = 62;
+constexpr uint16_t kMachineAArch64 = 183;
+
+// XRay sled entry (xray_instr_map), 32 bytes per sled
+struct XRaySledEntry {
+    uint64_t address;
+    uint64_t function;
+    uint8_t kind;
+    uint8_t always_instrument;
+    uint8_t version;
+    uint8_t padding[13];
+};
+static_assert(sizeof(XRaySledEntry) == 32, "XRay sled entry is 32 bytes");
+
+// Cache file: magic, format version, binary size, mtime seconds and
+// nanoseconds, function count, then [address, name length, name] per
+// function ID
+constexpr char kCacheMagic[4] = {'T', 'S', 'X', 'S'};
+constexpr uint32_t kCacheVersion = 2;
+constexpr uint64_t kCacheHeaderSize = 36;
+constexpr uint64_t kCacheEntryMinSize = 12;
+
+struct BinarySignature {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    int64_t mtime_ns = 0;   // Sub-second part, where the platform has it
+
+    bool operator==(const BinarySignature& other) const {
+        return size == other.size && mtime == other.mtime && mtime_ns == other.mtime_ns;
+    }
+    bool operator!=(const BinarySignature& other) const { return !(*this == other); }
+};
+
+bool binarySignature(const std::string& path, BinarySignature& signature) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    signature.size = static_cast<uint64_t>(st.st_size);
+    signature.mtime = static_cast<int64_t>(st.st_mtime);
+#if defined(__APPLE__)
+    signature.mtime_ns = static_cast<int64_t>(st.st_mtimespec.tv_nsec);
+#elif defined(__linux__)
+    signature.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_nsec);
+#else
+    signature.mtime_ns = 0;
+#endif
+    return true;
+}
+
+/// Size of an open file, leaving the read position at the start
+uint64_t fileSize(std::ifstream& file) {
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0);
+    return size > 0 ? static_cast<uint64_t>(size) : 0;
+}
+
+/// Whether [offset, offset + size) lies within a file of file_size bytes
+bool inFile(uint64_t offset, uint64_t size, uint64_t file_size) {
+    return offset <= file_size && size <= file_size - offset;
+}
+
+bool readAt(std::ifstream& file, uint64_t offset, void* dst, size_t size) {
+    file.seekg(static_cast<std::streamoff>(offset));
+    return static_cast<bool>(file.read(static_cast<char*>(dst), static_cast<std::streamsize>(size)));
+}
+
+/// Read a section as an array; sizes are checked against the file first,
+/// so a corrupt header fails here instead of in the allocation
+template<typename T>
+bool readTable(std::ifstream& file, uint64_t file_size, const Elf64Section& section,
+               std::vector<T>& out) {
+    if (!inFile(section.offset, section.size, file_size)) {
+        return false;
+    }
+    out.resize(section.size / sizeof(T));
+    return out.empty() || readAt(file, section.offset, out.data(), out.size() * sizeof(T));
+}
+
+std::string demangle(const char* mangled) {
+#if defined(__GNUC__) || defined(__clang__)
+    if (std::strncmp(mangled, "_Z", 2) == 0) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+        if (status == 0 && demangled) {
+            std::string result(demangled);
+            std::free(demangled);
+            return result;
+        }
+    }
+#endif
+    return mangled;
+}
+
+/// Function symbol, sorted by address for lookup
+struct SymbolEntry {
+    uint64_t address;
+    uint64_t size;
+    uint32_t name;      // Offset into its string table
+    uint32_t strtab;    // Index into the loaded string tables
+};
+
+} // anonymous namespace
+
+bool XRaySymbolResolver::fail(const std::string& message) {
+    error_ = message;
+    functions_.clear();
+    return false;
+}
+
+bool XRaySymbolResolver::loadBinary(const std::string& binary_path) {
+    functions_.clear();
+    error_.clear();
+
+    std::ifstream file(binary_path, std::ios::binary);
+    if (!file) {
+        return fail("Cannot open " + binary_path);
+    }
+    uint64_t file_size = fileSize(file);
+
+    Elf64Header header;
+    if (!readAt(file, 0, &header, sizeof(header)) ||
+        std::memcmp(header.ident, "\x7f" "ELF", 4) != 0) {
+        return fail(binary_path + " is not an ELF file");
+    }
+    if (header.ident[4] != 2 || header.ident[5] != 1) {
+        return fail(binary_path + ": only 64-bit little-endian ELF is supported");
+    }
+    if (header.type == kTypeRelocatable) {
+        return fail(binary_path + " is an object file; pass the linked binary");
+    }
+    if (header.shentsize != sizeof(Elf64Section)) {
+        return fail(binary_path + ": unexpected section header size");
+    }
+
+    // Section headers; counts that overflow 16 bits live in section 0
+    Elf64Section first;
+    if (!readAt(file, header.shoff, &first, sizeof(first))) {
+        return fail(binary_path + ": truncated section headers");
+    }
+    uint64_t section_count = header.shnum != 0 ? header.shnum : first.size;
+    uint32_t names_index = header.shstrndx != 0xFFFF ? header.shstrndx : first.link;
+    if (section_count > file_size / sizeof(Elf64Section) ||
+        !inFile(header.shoff, section_count * sizeof(Elf64Section), file_size)) {
+        return fail(binary_path + ": truncated section headers");
+    }
+    std::vector<Elf64Section> sections(section_count);
+    if (!readAt(file, header.shoff, sections.data(), sections.size() * sizeof(Elf64Section)) ||
+        names_index >= sections.size()) {
+        return fail(binary_path + ": truncated section headers");
+    }
+
+    std::vector<char> section_names;
+    if (!readTable(file, file_size, sections[names_index], section_names)) {
+        return fail(binary_path + ": cannot read section names");
+    }
+    section_names.push_back('\0');
+
+    size_t map_index = sections.size();
+    for (size_t i = 0; i < sections.size(); ++i) {
+        if (sections[i].name < section_names.size() &&
+            std::strcmp(section_names.data() + sections[i].name, "xray_instr_map") == 0) {
+            map_index = i;
+            break;
+        }
+    }
+    if (map_index == sections.size() || sections[map_index].type == kSectionNobits) {
+        return fail(binary_path + " has no XRay instrumentation map");
+    }
+    const Elf64Section& map_section = sections[map_index];
+
+    std::vector<XRaySledEntry> sleds;
+    if (!readTable(file, file_size, map_section, sleds)) {
+        return fail(binary_path + ": cannot read xray_instr_map");
+    }
+
+    // Function symbols from every symbol table (.symtab and .dynsym)
+    std::vector<std::vector<char>> string_tables;
+    std::vector<SymbolEntry> symbols;
+    std::unordered_map<uint32_t, std::vector<Elf64Symbol>> symbol_tables;
+    for (size_t i = 0; i < sections.size(); ++i) {
+        const Elf64Section& section = sections[i];
+        if ((section.type != kSectionSymtab && section.type != kSectionDynsym) ||
+            section.link >= sections.size()) {
+            continue;
+        }
+        std::vector<Elf64Symbol>& table = symbol_tables[static_cast<uint32_t>(i)];
+        std::vector<char> strings;
+        if (!readTable(file, file_size, section, table) ||
+            !readTable(file, file_size, sections[section.link], strings)) {
+            return fail(binary_path + ": cannot read symbol table");
+        }
+        strings.push_back('\0');
+
+        uint32_t strtab = static_cast<uint32_t>(string_tables.size());
+        for (const auto& symbol : table) {
+            if ((symbol.info & 0xF) == kSymbolFunc && symbol.value != 0 &&
+                symbol.name != 0 && symbol.name < strings.size()) {
+                symbols.push_back({symbol.value, symbol.size, symbol.name, strtab});
+            }
+        }
+        string_tables.push_back(std::move(strings));
+    }
+    // Sized symbols first among aliases, so lookups prefer a real extent
+    std::sort(symbols.begin(), symbols.end(), [](const SymbolEntry& a, const SymbolEntry& b) {
+        return a.address != b.address ? a.address < b.address : a.size > b.size;
+    });
+
+    // Older sled layouts hold absolute addresses, which in PIE binaries
+    // are only filled in by dynamic relocations
+    bool relocations_needed = std::any_of(sleds.begin(), sleds.end(),
+                                          [](const XRaySledEntry& sled) { return sled.version < 2; });
+    if (relocations_needed) {
+        uint32_t relative = header.machine == kMachineAArch64 ? 1027 : 8;
+        uint32_t absolute = header.machine == kMachineAArch64 ? 257 : 1;
+        if (header.machine != kMachineX86_64 && header.machine != kMachineAArch64) {
+            relative = absolute = 0;
+        }
+        for (const auto& section : sections) {
+            if (section.type != kSectionRela) {
+                continue;
+            }
+            // Dynamic relocations (.rela.dyn) apply to virtual addresses;
+            // other sections' relocations were resolved at link time
+            if (section.info != 0) {
+                continue;
+            }
+            uint64_t base = map_section.addr;
+            std::vector<Elf64Rela> relas;
+            if (!readTable(file, file_size, section, relas)) {
+                continue;
+            }
+            auto table = symbol_tables.find(section.link);
+            for (const auto& rela : relas) {
+                if (rela.offset < base || rela.offset - base + 8 > map_section.size) {
+                    continue;
+                }
+                uint64_t offset = rela.offset - base;
+                uint32_t type = static_cast<uint32_t>(rela.info);
+                uint64_t symbol = rela.info >> 32;
+                uint64_t value;
+                if (type != 0 && type == relative) {
+                    value = static_cast<uint64_t>(rela.addend);
+                } else if (type != 0 && type == absolute && table != symbol_tables.end() &&
+                           symbol < table->second.size()) {
+                    value = table->second[symbol].value + static_cast<uint64_t>(rela.addend);
+                } else {
+                    continue;
+                }
+                std::memcpy(reinterpret_cast<uint8_t*>(sleds.data()) + offset, &value, sizeof(value));
+            }
+        }
+    }
+
+    // Function IDs: consecutive sleds of one function share an ID
+    uint64_t current = 0;
+    for (size_t i = 0; i < sleds.size(); ++i) {
+        const XRaySledEntry& sled = sleds[i];
+        uint64_t function = sled.function;
+        if (sled.version >= 2) {
+            // PC-relative to the field itself
+            function += map_section.addr + i * sizeof(XRaySledEntry) + 8;
+        }
+        if (function == 0 || function == current) {
+            continue;
+        }
+        current = function;
+
+        Function entry;
+        entry.address = function;
+        auto it = std::upper_bound(symbols.begin(), symbols.end(), function,
+                                   [](uint64_t address, const SymbolEntry& symbol) {
+                                       return address < symbol.address;
+                                   });
+        if (it != symbols.begin()) {
+            // Aliases at the closest address are sorted largest first
+            auto first_alias = std::lower_bound(symbols.begin(), it, std::prev(it)->address,
+                                                [](const SymbolEntry& s, uint64_t address) {
+                                                    return s.address < address;
+                                                });
+            if (first_alias->address == function ||
+                function < first_alias->address + first_alias->size) {
+                entry.name = demangle(string_tables[first_alias->strtab].data() + first_alias->name);
+            }
+        }
+        functions_.push_back(std::move(entry));
+    }
+
+    if (functions_.empty()) {
+        return fail(binary_path + ": xray_instr_map has no functions");
+    }
+    return true;
+}
+
+bool XRaySymbolResolver::loadCache(const std::string& cache_path, const std::string& binary_path) {
+    functions_.clear();
+    error_.clear();
+
+    BinarySignature signature;
+    if (!binarySignature(binary_path, signature)) {
+        return fail("Cannot stat " + binary_path);
+    }
+
+    std::ifstream file(cache_path, std::ios::binary);
+    if (!file) {
+        return fail("No symbol cache at " + cache_path);
+    }
+    uint64_t file_size = fileSize(file);
+
+    char magic[4];
+    uint32_t version = 0;
+    BinarySignature cached;
+    uint32_t count = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&cached.size), sizeof(cached.size));
+    file.read(reinterpret_cast<char*>(&cached.mtime), sizeof(cached.mtime));
+    file.read(reinterpret_cast<char*>(&cached.mtime_ns), sizeof(cached.mtime_ns));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || std::memcmp(magic, kCacheMagic, 4) != 0 || version != kCacheVersion) {
+        return fail(cache_path + " is not a symbol cache");
+    }
+    if (cached != signature) {
+        return fail(cache_path + " is stale");
+    }
+    if (count > (file_size - kCacheHeaderSize) / kCacheEntryMinSize) {
+        return fail(cache_path + " is truncated");
+    }
+
+    functions_.resize(count);
+    for (auto& function : functions_) {
+        uint32_t length = 0;
+        file.read(reinterpret_cast<char*>(&function.address), sizeof(function.address));
+        file.read(reinterpret_cast<char*>(&length), sizeof(length));
+        if (!file || length > (1u << 20) || !inFile(static_cast<uint64_t>(file.tellg()), length, file_size)) {
+            return fail(cache_path + " is truncated");
+        }
+        function.name.resize(length);
+        file.read(&function.name[0], length);
+    }
+    if (!file) {
+        return fail(cache_path + " is truncated");
+    }
+    return true;
+}
+
+bool XRaySymbolResolver::saveCache(const std::string& cache_path, const std::string& binary_path) const {
+    BinarySignature signature;
+    if (!binarySignature(binary_path, signature)) {
+        return false;
+    }
+
+    // Concurrent importers may race to write; each writes its own
+    // temporary and the rename makes the last one win atomically
+    std::random_device random;
+    std::string temp_path = cache_path + ".tmp" + std::to_string(random());
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        uint32_t count = static_cast<uint32_t>(functions_.size());
+        file.write(kCacheMagic, sizeof(kCacheMagic));
+        file.write(reinterpret_cast<const char*>(&kCacheVersion), sizeof(kCacheVersion));
+        file.write(reinterpret_cast<const char*>(&signature.size), sizeof(signature.size));
+        file.write(reinterpret_cast<const char*>(&signature.mtime), sizeof(signature.mtime));
+        file.write(reinterpret_cast<const char*>(&signature.mtime_ns), sizeof(signature.mtime_ns));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (const auto& function : functions_) {
+            uint32_t length = static_cast<uint32_t>(function.name.size());
+            file.write(reinterpret_cast<const char*>(&function.address), sizeof(function.address));
+            file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            file.write(function.name.data(), length);
+        }
+        if (!file.flush()) {
+            file.close();
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool XRaySymbolResolver::load(const std::string& binary_path, bool use_cache) {
+    std::string cache_path = cachePath(binary_path);
+    if (use_cache && loadCache(cache_path, binary_path)) {
+        return true;
+    }
+    if (!loadBinary(binary_path)) {
+        return false;
+    }
+    if (use_cache) {
+        saveCache(cache_path, binary_path);  // Best effort: may be read-only
+    }
+    return true;
+}
+
+std::shared_ptr<const XRaySymbolResolver> XRaySymbolResolver::forBinary(const std::string& binary_path,
+                                                                        bool use_cache) {
+    struct Entry {
+        BinarySignature signature;
+        std::shared_ptr<const XRaySymbolResolver> resolver;
+    };
+    static std::mutex mutex;
+    static std::unordered_map<std::string, Entry> resolvers;
+
+    BinarySignature signature;
+    if (!binarySignature(binary_path, signature)) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = resolvers.find(binary_path);
+    if (it != resolvers.end() && it->second.signature == signature) {
+        return it->second.resolver;
+    }
+
+    auto resolver = std::make_shared<XRaySymbolResolver>();
+    if (!resolver->load(binary_path, use_cache)) {
+        return nullptr;
+    }
+    resolvers[binary_path] = Entry{signature, resolver};
+    return resolver;
+}
+
+} // namespace tracesmith
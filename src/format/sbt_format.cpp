@@ -495,18 +495,49 @@ SBTResult SBTReader::readEvents(std::vector<TraceEvent>& events,
         }
     }
     
-    // For now, just read all and slice (TODO: optimize for large files)
-    TraceRecord record;
-    auto result = readAll(record);
-    if (!result) {
-        return result;
+    if (header_.events_offset == 0 || offset >= header_.event_count) {
+        return SBTResult(true);  // Nothing to read
     }
     
-    size_t end = std::min(offset + count, record.size());
-    for (size_t i = offset; i < end; ++i) {
-        events.push_back(record.events()[i]);
+    if (cursor_valid_ && cursor_index_ <= offset) {
+        file_.clear();
+        file_.seekg(cursor_pos_);
+    } else {
+        // (Re)start at the beginning of the events section
+        file_.clear();
+        file_.seekg(header_.events_offset);
+        
+        uint8_t section_type;
+        file_.read(reinterpret_cast<char*>(&section_type), 1);
+        if (section_type != static_cast<uint8_t>(sbt::SectionType::Events)) {
+            return SBTResult("Invalid events section");
+        }
+        
+        cursor_timestamp_ = readVarInt();
+        cursor_index_ = 0;
+    }
+    
+    // Timestamps are delta-encoded, so skipped events still have to be decoded
+    for (; cursor_index_ < offset; ++cursor_index_) {
+        cursor_timestamp_ += readEventCompact().timestamp;
+    }
+    
+    uint64_t end = std::min<uint64_t>(offset + count, header_.event_count);
+    events.reserve(events.size() + static_cast<size_t>(end - offset));
+    for (; cursor_index_ < end; ++cursor_index_) {
+        TraceEvent event = readEventCompact();
+        cursor_timestamp_ += event.timestamp;
+        event.timestamp = cursor_timestamp_;
+        events.push_back(std::move(event));
+    }
+    
+    if (!file_) {
+        cursor_valid_ = false;
+        return SBTResult("Truncated events section");
     }
     
+    cursor_pos_ = file_.tellg();
+    cursor_valid_ = true;
     return SBTResult(true);
 }
 
@@ -0,0 +1,950 @@
+/**
+ * Frame Capture File Implementation
+ */
+
+#include "tracesmith/replay/capture_file.hpp"
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+
+namespace tracesmith {
+
+// ============================================================================
+// Record Encoding
+// ============================================================================
+
+namespace {
+
+class ByteWriter {
+public:
+    void u8(uint8_t value) { buffer_.push_back(static_cast<char>(value)); }
+    
+    void u32(uint32_t value) { raw(&value, sizeof(value)); }
+    
+    void u64(uint64_t value) { raw(&value, sizeof(value)); }
+    
+    void varint(uint64_t value) {
+        // 7 bits per byte, MSB indicates continuation
+        while (value >= 0x80) {
+            u8(static_cast<uint8_t>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        u8(static_cast<uint8_t>(value));
+    }
+    
+    void string(const std::string& str) {
+        varint(str.size());
+        buffer_.append(str);
+    }
+    
+    void raw(const void* data, size_t size) {
+        buffer_.append(static_cast<const char*>(data), size);
+    }
+    
+    const std::string& buffer() const { return buffer_; }
+    void clear() { buffer_.clear(); }
+
+private:
+    std::string buffer_;
+};
+
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+    
+    bool ok() const { return ok_; }
+    bool atEnd() const { return p_ == end_; }
+    
+    uint8_t u8() {
+        if (!need(1)) return 0;
+        return *p_++;
+    }
+    
+    uint32_t u32() {
+        uint32_t value = 0;
+        raw(&value, sizeof(value));
+        return value;
+    }
+    
+    uint64_t u64() {
+        uint64_t value = 0;
+        raw(&value, sizeof(value));
+        return value;
+    }
+    
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = u8();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        ok_ = false;
+        return 0;
+    }
+    
+    std::string string() {
+        uint64_t size = varint();
+        if (!need(size)) return {};
+        std::string str(reinterpret_cast<const char*>(p_), static_cast<size_t>(size));
+        p_ += size;
+        return str;
+    }
+    
+    void raw(void* out, size_t size) {
+        if (!need(size)) return;
+        std::memcpy(out, p_, size);
+        p_ += size;
+    }
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+    bool ok_ = true;
+    
+    bool need(uint64_t size) {
+        if (!ok_ || size > static_cast<uint64_t>(end_ - p_)) {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+};
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void encodeResource(ByteWriter& out, const ResourceState& state) {
+    out.varint(state.resource_id);
+    out.varint(static_cast<uint32_t>(state.type));
+    out.string(state.name);
+    out.varint(state.address);
+    out.varint(state.size);
+    out.varint(state.width);
+    out.varint(state.height);
+    out.varint(state.depth);
+    out.varint(state.mip_levels);
+    out.varint(state.array_layers);
+    out.string(state.format);
+    
+    uint8_t flags = 0;
+    if (state.readable) flags |= 0x01;
+    if (state.writable) flags |= 0x02;
+    if (state.bound_as_input) flags |= 0x04;
+    if (state.bound_as_output) flags |= 0x08;
+    out.u8(flags);
+    out.varint(state.last_modified);
+    
+    out.varint(state.contents.size);
+    out.varint(state.contents.chunks.size());
+    for (uint64_t id : state.contents.chunks) {
+        out.u64(id);
+    }
+}
+
+bool decodeResource(ByteReader& in, ResourceState& state) {
+    state.resource_id = in.varint();
+    state.type = static_cast<ResourceType>(in.varint());
+    state.name = in.string();
+    state.address = in.varint();
+    state.size = in.varint();
+    state.width = static_cast<uint32_t>(in.varint());
+    state.height = static_cast<uint32_t>(in.varint());
+    state.depth = static_cast<uint32_t>(in.varint());
+    state.mip_levels = static_cast<uint32_t>(in.varint());
+    state.array_layers = static_cast<uint32_t>(in.varint());
+    state.format = in.string();
+    
+    uint8_t flags = in.u8();
+    state.readable = flags & 0x01;
+    state.writable = flags & 0x02;
+    state.bound_as_input = flags & 0x04;
+    state.bound_as_output = flags & 0x08;
+    state.last_modified = in.varint();
+    
+    state.contents.size = in.varint();
+    uint64_t chunk_count = in.varint();
+    state.contents.chunks.clear();
+    for (uint64_t i = 0; i < chunk_count && in.ok(); ++i) {
+        state.contents.chunks.push_back(in.u64());
+    }
+    return in.ok();
+}
+
+void encodeIds(ByteWriter& out, const std::vector<uint64_t>& ids) {
+    out.varint(ids.size());
+    for (uint64_t id : ids) out.varint(id);
+}
+
+void decodeIds(ByteReader& in, std::vector<uint64_t>& ids) {
+    uint64_t count = in.varint();
+    ids.clear();
+    for (uint64_t i = 0; i < count && in.ok(); ++i) {
+        ids.push_back(in.varint());
+    }
+}
+
+void encodeDraw(ByteWriter& out, const DrawCallInfo& draw) {
+    out.varint(draw.call_id);
+    out.string(draw.name);
+    out.varint(draw.timestamp);
+    out.varint(draw.vertex_count);
+    out.varint(draw.instance_count);
+    out.varint(draw.first_vertex);
+    out.varint(draw.first_instance);
+    out.varint(draw.index_count);
+    out.varint(draw.first_index);
+    out.varint(zigzag(draw.vertex_offset));
+    out.varint(draw.group_count_x);
+    out.varint(draw.group_count_y);
+    out.varint(draw.group_count_z);
+    encodeIds(out, draw.input_resources);
+    encodeIds(out, draw.output_resources);
+    out.varint(draw.pipeline_id);
+    out.string(draw.vertex_shader);
+    out.string(draw.fragment_shader);
+    out.string(draw.compute_shader);
+}
+
+bool decodeDraw(ByteReader& in, DrawCallInfo& draw) {
+    draw.call_id = in.varint();
+    draw.name = in.string();
+    draw.timestamp = in.varint();
+    draw.vertex_count = static_cast<uint32_t>(in.varint());
+    draw.instance_count = static_cast<uint32_t>(in.varint());
+    draw.first_vertex = static_cast<uint32_t>(in.varint());
+    draw.first_instance = static_cast<uint32_t>(in.varint());
+    draw.index_count = static_cast<uint32_t>(in.varint());
+    draw.first_index = static_cast<uint32_t>(in.varint());
+    draw.vertex_offset = static_cast<int32_t>(unzigzag(in.varint()));
+    draw.group_count_x = static_cast<uint32_t>(in.varint());
+    draw.group_count_y = static_cast<uint32_t>(in.varint());
+    draw.group_count_z = static_cast<uint32_t>(in.varint());
+    decodeIds(in, draw.input_resources);
+    decodeIds(in, draw.output_resources);
+    draw.pipeline_id = in.varint();
+    draw.vertex_shader = in.string();
+    draw.fragment_shader = in.string();
+    draw.compute_shader = in.string();
+    return in.ok();
+}
+
+void encodeEvent(ByteWriter& out, const TraceEvent& event) {
+    out.u8(static_cast<uint8_t>(event.type));
+    
+    uint8_t flags = 0;
+    if (event.kernel_params.has_value()) flags |= 0x01;
+    if (event.memory_params.has_value()) flags |= 0x02;
+    if (event.call_stack.has_value()) flags |= 0x04;
+    out.u8(flags);
+    
+    out.varint(event.timestamp);
+    out.varint(event.duration);
+    out.varint(event.device_id);
+    out.varint(event.stream_id);
+    out.varint(event.correlation_id);
+    out.varint(event.thread_id);
+    out.string(event.name);
+    
+    out.varint(event.metadata.size());
+    for (const auto& [key, value] : event.metadata) {
+        out.string(key);
+        out.string(value);
+    }
+    
+    out.varint(event.flow_info.id);
+    out.u8(static_cast<uint8_t>(event.flow_info.type));
+    out.u8(event.flow_info.is_start ? 1 : 0);
+    
+    if (flags & 0x01) {
+        const auto& kp = event.kernel_params.value();
+        out.varint(kp.grid_x);
+        out.varint(kp.grid_y);
+        out.varint(kp.grid_z);
+        out.varint(kp.block_x);
+        out.varint(kp.block_y);
+        out.varint(kp.block_z);
+        out.varint(kp.shared_mem_bytes);
+        out.varint(kp.registers_per_thread);
+    }
+    if (flags & 0x02) {
+        const auto& mp = event.memory_params.value();
+        out.varint(mp.src_address);
+        out.varint(mp.dst_address);
+        out.varint(mp.size_bytes);
+    }
+    if (flags & 0x04) {
+        const auto& cs = event.call_stack.value();
+        out.varint(cs.thread_id);
+        out.varint(cs.frames.size());
+        for (const auto& frame : cs.frames) {
+            out.varint(frame.address);
+            out.string(frame.function_name);
+            out.string(frame.file_name);
+            out.varint(frame.line_number);
+        }
+    }
+    
+    out.varint(event.custom_data.size());
+    out.raw(event.custom_data.data(), event.custom_data.size());
+}
+
+bool decodeEvent(ByteReader& in, TraceEvent& event) {
+    event.type = static_cast<EventType>(in.u8());
+    uint8_t flags = in.u8();
+    
+    event.timestamp = in.varint();
+    event.duration = in.varint();
+    event.device_id = static_cast<uint32_t>(in.varint());
+    event.stream_id = static_cast<uint32_t>(in.varint());
+    event.correlation_id = in.varint();
+    event.thread_id = static_cast<uint32_t>(in.varint());
+    event.name = in.string();
+    
+    uint64_t metadata_count = in.varint();
+    for (uint64_t i = 0; i < metadata_count && in.ok(); ++i) {
+        std::string key = in.string();
+        event.metadata[key] = in.string();
+    }
+    
+    event.flow_info.id = in.varint();
+    event.flow_info.type = static_cast<FlowType>(in.u8());
+    event.flow_info.is_start = in.u8() != 0;
+    
+    if (flags & 0x01) {
+        KernelParams kp;
+        kp.grid_x = static_cast<uint32_t>(in.varint());
+        kp.grid_y = static_cast<uint32_t>(in.varint());
+        kp.grid_z = static_cast<uint32_t>(in.varint());
+        kp.block_x = static_cast<uint32_t>(in.varint());
+        kp.block_y = static_cast<uint32_t>(in.varint());
+        kp.block_z = static_cast<uint32_t>(in.varint());
+        kp.shared_mem_bytes = static_cast<uint32_t>(in.varint());
+        kp.registers_per_thread = static_cast<uint32_t>(in.varint());
+        event.kernel_params = kp;
+    }
+    if (flags & 0x02) {
+        MemoryParams mp;
+        mp.src_address = in.varint();
+        mp.dst_address = in.varint();
+        mp.size_bytes = in.varint();
+        event.memory_params = mp;
+    }
+    if (flags & 0x04) {
+        CallStack cs;
+        cs.thread_id = in.varint();
+        uint64_t depth = in.varint();
+        for (uint64_t i = 0; i < depth && in.ok(); ++i) {
+            StackFrame frame;
+            frame.address = in.varint();
+            frame.function_name = in.string();
+            frame.file_name = in.string();
+            frame.line_number = static_cast<uint32_t>(in.varint());
+            cs.frames.push_back(std::move(frame));
+        }
+        event.call_stack = std::move(cs);
+    }
+    
+    uint64_t custom_size = in.varint();
+    if (in.ok() && custom_size > 0) {
+        event.custom_data.resize(static_cast<size_t>(std::min<uint64_t>(custom_size, 1ULL << 32)));
+        in.raw(event.custom_data.data(), event.custom_data.size());
+    }
+    return in.ok();
+}
+
+// Index sizes (bytes per entry)
+constexpr uint64_t kChunkEntrySize = 8 + 8 + 4;
+constexpr uint64_t kFrameEntrySize = 15 * 8;
+constexpr uint64_t kDrawEntrySize = 8 + 8 + 4;
+constexpr uint64_t kStateEntrySize = 8 + 8;
+constexpr uint64_t kChainEntrySize = 8 + 4 + 8;
+
+} // anonymous namespace
+
+// ============================================================================
+// CaptureFileWriter Implementation
+// ============================================================================
+
+CaptureFileWriter::CaptureFileWriter(const std::string& filename)
+    : filename_(filename) {
+    file_.open(filename, std::ios::binary | std::ios::out | std::ios::trunc);
+}
+
+void CaptureFileWriter::writeBytes(const void* data, size_t size) {
+    file_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    position_ += size;
+}
+
+SBTResult CaptureFileWriter::writeCapture(const FrameCapture& capture) {
+    if (!file_.is_open()) {
+        return SBTResult("File not open");
+    }
+    
+    CaptureFileHeader header;
+    const ChunkStore& store = capture.getChunkStore();
+    header.chunk_size = static_cast<uint32_t>(store.getConfig().chunk_size);
+    writeBytes(&header, sizeof(header));
+    
+    const auto& frames = capture.getCapturedFrames();
+    
+    // Number the distinct resource versions
+    std::vector<const ResourceState*> versions;
+    std::unordered_map<const ResourceState*, uint64_t> version_index;
+    auto intern = [&](const ResourceVersion& version) -> uint64_t {
+        auto [it, inserted] = version_index.emplace(version.get(), versions.size());
+        if (inserted) versions.push_back(version.get());
+        return it->second;
+    };
+    for (const auto& frame : frames) {
+        for (const auto& [id, version] : frame.initial_state) intern(version);
+        for (const auto& delta : frame.state_deltas) {
+            for (const auto& version : delta.changed) intern(version);
+        }
+        for (const auto& [id, version] : frame.final_state) intern(version);
+    }
+    
+    // Chunk data: each distinct chunk once
+    struct ChunkLocation {
+        uint64_t id;
+        uint64_t offset;
+        uint32_t size;
+    };
+    std::vector<ChunkLocation> chunk_table;
+    std::unordered_set<uint64_t> written_chunks;
+    std::vector<uint8_t> chunk;
+    for (const ResourceState* version : versions) {
+        for (uint64_t id : version->contents.chunks) {
+            if (!written_chunks.insert(id).second) continue;
+            if (!store.readChunk(id, chunk)) {
+                return SBTResult("Chunk " + std::to_string(id) + " not in chunk store");
+            }
+            chunk_table.push_back({id, position_, static_cast<uint32_t>(chunk.size())});
+            writeBytes(chunk.data(), chunk.size());
+        }
+    }
+    std::sort(chunk_table.begin(), chunk_table.end(),
+              [](const ChunkLocation& a, const ChunkLocation& b) { return a.id < b.id; });
+    
+    // Resource version records
+    ByteWriter record;
+    std::vector<uint64_t> version_offsets;
+    version_offsets.reserve(versions.size() + 1);
+    for (const ResourceState* version : versions) {
+        version_offsets.push_back(position_);
+        record.clear();
+        encodeResource(record, *version);
+        writeBytes(record.buffer().data(), record.buffer().size());
+    }
+    version_offsets.push_back(position_);
+    
+    // Per-frame events and draw call records; frame index entries are
+    // built alongside
+    ByteWriter index;
+    for (const auto& entry : chunk_table) {
+        index.u64(entry.id);
+        index.u64(entry.offset);
+        index.u32(entry.size);
+    }
+    for (uint64_t offset : version_offsets) {
+        index.u64(offset);
+    }
+    
+    struct ChainLocation {
+        uint64_t resource_id;
+        uint32_t draw_index;
+        uint64_t version;
+    };
+    std::vector<ChainLocation> chains;
+    ByteWriter draw_table;
+    for (const auto& frame : frames) {
+        uint64_t events_offset = position_;
+        record.clear();
+        for (const auto& event : frame.events) {
+            encodeEvent(record, event);
+        }
+        writeBytes(record.buffer().data(), record.buffer().size());
+        uint64_t events_size = position_ - events_offset;
+        
+        draw_table.clear();
+        for (size_t i = 0; i < frame.draw_calls.size(); ++i) {
+            const DrawCallInfo& draw = frame.draw_calls[i];
+            record.clear();
+            encodeDraw(record, draw);
+            
+            // Deltas are appended per draw call, so they line up with draw_calls
+            bool has_delta = i < frame.state_deltas.size() &&
+                             frame.state_deltas[i].call_id == draw.call_id;
+            record.u8(has_delta ? 1 : 0);
+            if (has_delta) {
+                const auto& changed = frame.state_deltas[i].changed;
+                record.varint(changed.size());
+                for (const auto& version : changed) {
+                    record.varint(version_index.at(version.get()));
+                }
+            }
+            
+            draw_table.u64(draw.call_id);
+            draw_table.u64(position_);
+            draw_table.u32(static_cast<uint32_t>(record.buffer().size()));
+            writeBytes(record.buffer().data(), record.buffer().size());
+        }
+        
+        chains.clear();
+        for (const auto& [resource_id, chain] : frame.version_chains) {
+            for (const auto& [draw_index, version] : chain) {
+                chains.push_back({resource_id, draw_index, version_index.at(version.get())});
+            }
+        }
+        std::sort(chains.begin(), chains.end(),
+                  [](const ChainLocation& a, const ChainLocation& b) {
+                      return a.resource_id != b.resource_id ? a.resource_id < b.resource_id
+                                                            : a.draw_index < b.draw_index;
+                  });
+        
+        index.u64(frame.frame_number);
+        index.u64(frame.start_time);
+        index.u64(frame.end_time);
+        index.u64(frame.total_draw_calls);
+        index.u64(frame.total_dispatches);
+        index.u64(frame.total_memory_ops);
+        index.u64(frame.total_sync_ops);
+        index.u64(frame.resource_versions);
+        index.u64(frame.events.size());
+        index.u64(events_offset);
+        index.u64(events_size);
+        index.u64(frame.draw_calls.size());
+        index.u64(frame.initial_state.size());
+        index.u64(frame.final_state.size());
+        index.u64(chains.size());
+        
+        index.raw(draw_table.buffer().data(), draw_table.buffer().size());
+        for (const auto& [id, version] : frame.initial_state) {
+            index.u64(id);
+            index.u64(version_index.at(version.get()));
+        }
+        for (const auto& [id, version] : frame.final_state) {
+            index.u64(id);
+            index.u64(version_index.at(version.get()));
+        }
+        for (const auto& chain : chains) {
+            index.u64(chain.resource_id);
+            index.u32(chain.draw_index);
+            index.u64(chain.version);
+        }
+    }
+    
+    header.index_offset = position_;
+    header.index_size = index.buffer().size();
+    header.frame_count = frames.size();
+    header.chunk_count = chunk_table.size();
+    header.version_count = versions.size();
+    writeBytes(index.buffer().data(), index.buffer().size());
+    
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file_.flush();
+    if (!file_) {
+        return SBTResult("Write failed: " + filename_);
+    }
+    return SBTResult(true);
+}
+
+// ============================================================================
+// CaptureFileReader Implementation
+// ============================================================================
+
+CaptureFileReader::CaptureFileReader(const std::string& filename) {
+    file_.open(filename, std::ios::binary | std::ios::in);
+    if (!file_.is_open()) {
+        fail("Cannot open " + filename);
+        return;
+    }
+    valid_ = readIndex();
+}
+
+bool CaptureFileReader::fail(const std::string& error) {
+    last_error_ = error;
+    return false;
+}
+
+bool CaptureFileReader::readBlock(uint64_t offset, uint64_t size, std::vector<uint8_t>& out) {
+    // Offsets and sizes come from the file; never allocate past its end
+    if (offset > file_size_ || size > file_size_ - offset) {
+        return fail("Block at offset " + std::to_string(offset) + " exceeds file size");
+    }
+    out.resize(static_cast<size_t>(size));
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(offset));
+    file_.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(size));
+    if (!file_) {
+        return fail("Read past end of file at offset " + std::to_string(offset));
+    }
+    return true;
+}
+
+bool CaptureFileReader::readIndex() {
+    file_.read(reinterpret_cast<char*>(&header_), sizeof(header_));
+    if (!file_ || !header_.isValid()) {
+        return fail("Not a frame capture file");
+    }
+    if (header_.version_major != fcap::FORMAT_VERSION_MAJOR) {
+        return fail("Unsupported frame capture file version");
+    }
+    
+    file_.seekg(0, std::ios::end);
+    file_size_ = static_cast<uint64_t>(file_.tellg());
+    if (header_.index_offset > file_size_ || header_.index_size > file_size_ - header_.index_offset) {
+        return fail("Truncated frame capture file");
+    }
+    
+    std::vector<uint8_t> buffer;
+    if (!readBlock(header_.index_offset, header_.index_size, buffer)) {
+        return false;
+    }
+    ByteReader in(buffer.data(), buffer.size());
+    
+    // Reject counts the index cannot hold before allocating for them
+    auto fits = [&](uint64_t count, uint64_t entry_size) {
+        return entry_size == 0 || count <= header_.index_size / entry_size;
+    };
+    
+    if (!fits(header_.chunk_count, kChunkEntrySize) || !fits(header_.version_count + 1, 8)) {
+        return fail("Corrupt frame capture index");
+    }
+    chunks_.resize(static_cast<size_t>(header_.chunk_count));
+    for (auto& chunk : chunks_) {
+        chunk.id = in.u64();
+        chunk.offset = in.u64();
+        chunk.size = in.u32();
+    }
+    version_offsets_.resize(static_cast<size_t>(header_.version_count + 1));
+    for (auto& offset : version_offsets_) {
+        offset = in.u64();
+    }
+    
+    // Version records are contiguous, so their offsets must not decrease
+    // and the last one ends inside the file; readVersion() relies on this
+    for (size_t v = 1; v < version_offsets_.size(); ++v) {
+        if (version_offsets_[v] < version_offsets_[v - 1]) {
+            return fail("Corrupt frame capture index");
+        }
+    }
+    if (!in.ok() || version_offsets_.back() > file_size_) {
+        return fail("Corrupt frame capture index");
+    }
+    
+    if (!fits(header_.frame_count, kFrameEntrySize)) {
+        return fail("Corrupt frame capture index");
+    }
+    frames_.resize(static_cast<size_t>(header_.frame_count));
+    for (auto& frame : frames_) {
+        FrameSummary& s = frame.summary;
+        s.frame_number = in.u64();
+        s.start_time = in.u64();
+        s.end_time = in.u64();
+        s.total_draw_calls = in.u64();
+        s.total_dispatches = in.u64();
+        s.total_memory_ops = in.u64();
+        s.total_sync_ops = in.u64();
+        s.resource_versions = in.u64();
+        s.event_count = in.u64();
+        frame.events_offset = in.u64();
+        frame.events_size = in.u64();
+        s.draw_count = in.u64();
+        uint64_t initial_count = in.u64();
+        uint64_t final_count = in.u64();
+        uint64_t chain_count = in.u64();
+        
+        if (!in.ok() || !fits(s.draw_count, kDrawEntrySize) ||
+            !fits(initial_count, kStateEntrySize) || !fits(final_count, kStateEntrySize) ||
+            !fits(chain_count, kChainEntrySize)) {
+            return fail("Corrupt frame capture index");
+        }
+        
+        frame.draws.resize(static_cast<size_t>(s.draw_count));
+        frame.draw_lookup.reserve(frame.draws.size());
+        for (size_t i = 0; i < frame.draws.size(); ++i) {
+            DrawEntry& draw = frame.draws[i];
+            draw.call_id = in.u64();
+            draw.offset = in.u64();
+            draw.size = in.u32();
+            frame.draw_lookup[draw.call_id] = static_cast<uint32_t>(i);
+        }
+        frame.initial_state.resize(static_cast<size_t>(initial_count));
+        for (auto& [id, version] : frame.initial_state) {
+            id = in.u64();
+            version = in.u64();
+        }
+        frame.final_state.resize(static_cast<size_t>(final_count));
+        for (auto& [id, version] : frame.final_state) {
+            id = in.u64();
+            version = in.u64();
+        }
+        frame.chains.resize(static_cast<size_t>(chain_count));
+        for (auto& chain : frame.chains) {
+            chain.resource_id = in.u64();
+            chain.draw_index = in.u32();
+            chain.version = in.u64();
+        }
+    }
+    
+    if (!in.ok()) {
+        return fail("Corrupt frame capture index");
+    }
+    return true;
+}
+
+std::vector<CaptureFileReader::FrameSummary> CaptureFileReader::frames() const {
+    std::vector<FrameSummary> result;
+    result.reserve(frames_.size());
+    for (const auto& frame : frames_) {
+        result.push_back(frame.summary);
+    }
+    return result;
+}
+
+const CaptureFileReader::FrameIndex* CaptureFileReader::findFrame(uint64_t frame_number) const {
+    for (const auto& frame : frames_) {
+        if (frame.summary.frame_number == frame_number) {
+            return &frame;
+        }
+    }
+    return nullptr;
+}
+
+CaptureFileReader::FrameIndex* CaptureFileReader::findFrame(uint64_t frame_number) {
+    return const_cast<FrameIndex*>(std::as_const(*this).findFrame(frame_number));
+}
+
+const CaptureFileReader::FrameSummary* CaptureFileReader::frame(uint64_t frame_number) const {
+    const FrameIndex* frame = findFrame(frame_number);
+    return frame ? &frame->summary : nullptr;
+}
+
+std::vector<uint64_t> CaptureFileReader::drawCallIds(uint64_t frame_number) const {
+    std::vector<uint64_t> ids;
+    if (const FrameIndex* frame = findFrame(frame_number)) {
+        ids.reserve(frame->draws.size());
+        for (const auto& draw : frame->draws) {
+            ids.push_back(draw.call_id);
+        }
+    }
+    return ids;
+}
+
+bool CaptureFileReader::readVersion(uint64_t version, ResourceState& state) {
+    if (version + 1 >= version_offsets_.size()) {
+        return fail("Unknown resource version " + std::to_string(version));
+    }
+    uint64_t offset = version_offsets_[version];
+    uint64_t size = version_offsets_[version + 1] - offset;  // Monotonic, checked by readIndex()
+    
+    std::vector<uint8_t> buffer;
+    if (!readBlock(offset, size, buffer)) {
+        return false;
+    }
+    ByteReader in(buffer.data(), buffer.size());
+    if (!decodeResource(in, state)) {
+        return fail("Corrupt resource version " + std::to_string(version));
+    }
+    return true;
+}
+
+bool CaptureFileReader::readDrawRecord(const DrawEntry& entry, DrawCallInfo& draw,
+                                       std::vector<uint64_t>* changed, bool& has_delta) {
+    std::vector<uint8_t> buffer;
+    if (!readBlock(entry.offset, entry.size, buffer)) {
+        return false;
+    }
+    ByteReader in(buffer.data(), buffer.size());
+    decodeDraw(in, draw);
+    
+    has_delta = in.u8() != 0;
+    if (has_delta && changed) {
+        decodeIds(in, *changed);
+    }
+    if (!in.ok()) {
+        return fail("Corrupt draw call record " + std::to_string(entry.call_id));
+    }
+    return true;
+}
+
+bool CaptureFileReader::readDrawCall(uint64_t frame_number, uint64_t draw_call_id,
+                                     DrawCallInfo& draw,
+                                     std::vector<ResourceState>* changed) {
+    const FrameIndex* frame = findFrame(frame_number);
+    if (!frame) {
+        return fail("Frame " + std::to_string(frame_number) + " not in file");
+    }
+    auto it = frame->draw_lookup.find(draw_call_id);
+    if (it == frame->draw_lookup.end()) {
+        return fail("Draw call " + std::to_string(draw_call_id) + " not in frame");
+    }
+    
+    std::vector<uint64_t> versions;
+    bool has_delta = false;
+    if (!readDrawRecord(frame->draws[it->second], draw, &versions, has_delta)) {
+        return false;
+    }
+    if (changed) {
+        changed->clear();
+        changed->resize(versions.size());
+        for (size_t i = 0; i < versions.size(); ++i) {
+            if (!readVersion(versions[i], (*changed)[i])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::optional<ResourceState> CaptureFileReader::readResourceStateAt(
+    uint64_t frame_number, uint64_t draw_call_id, uint64_t resource_id) {
+    
+    const FrameIndex* frame = findFrame(frame_number);
+    if (!frame) return std::nullopt;
+    auto draw_it = frame->draw_lookup.find(draw_call_id);
+    if (draw_it == frame->draw_lookup.end()) return std::nullopt;
+    
+    // Latest change at or before this draw call
+    uint64_t version = UINT64_MAX;
+    auto next = std::upper_bound(
+        frame->chains.begin(), frame->chains.end(),
+        std::make_pair(resource_id, static_cast<uint64_t>(draw_it->second)),
+        [](const std::pair<uint64_t, uint64_t>& key, const ChainEntry& entry) {
+            return key.first != entry.resource_id ? key.first < entry.resource_id
+                                                  : key.second < entry.draw_index;
+        });
+    if (next != frame->chains.begin() && std::prev(next)->resource_id == resource_id) {
+        version = std::prev(next)->version;
+    }
+    
+    if (version == UINT64_MAX) {
+        // Unchanged since frame start
+        auto init_it = std::lower_bound(
+            frame->initial_state.begin(), frame->initial_state.end(), resource_id,
+            [](const std::pair<uint64_t, uint64_t>& entry, uint64_t id) { return entry.first < id; });
+        if (init_it == frame->initial_state.end() || init_it->first != resource_id) {
+            return std::nullopt;
+        }
+        version = init_it->second;
+    }
+    
+    ResourceState state;
+    if (!readVersion(version, state)) {
+        return std::nullopt;
+    }
+    return state;
+}
+
+bool CaptureFileReader::readResourceData(const ResourceState& state, std::vector<uint8_t>& out) {
+    out.clear();
+    out.reserve(static_cast<size_t>(state.contents.size));
+    
+    std::vector<uint8_t> chunk;
+    for (uint64_t id : state.contents.chunks) {
+        auto it = std::lower_bound(
+            chunks_.begin(), chunks_.end(), id,
+            [](const ChunkEntry& entry, uint64_t key) { return entry.id < key; });
+        if (it == chunks_.end() || it->id != id) {
+            return fail("Chunk " + std::to_string(id) + " not in file");
+        }
+        if (!readBlock(it->offset, it->size, chunk)) {
+            return false;
+        }
+        out.insert(out.end(), chunk.begin(), chunk.end());
+    }
+    return out.size() == state.contents.size;
+}
+
+bool CaptureFileReader::readEvents(uint64_t frame_number, std::vector<TraceEvent>& events) {
+    const FrameIndex* frame = findFrame(frame_number);
+    if (!frame) {
+        return fail("Frame " + std::to_string(frame_number) + " not in file");
+    }
+    
+    std::vector<uint8_t> buffer;
+    if (!readBlock(frame->events_offset, frame->events_size, buffer)) {
+        return false;
+    }
+    ByteReader in(buffer.data(), buffer.size());
+    events.clear();
+    events.reserve(static_cast<size_t>(frame->summary.event_count));
+    for (uint64_t i = 0; i < frame->summary.event_count; ++i) {
+        TraceEvent event;
+        if (!decodeEvent(in, event)) {
+            return fail("Corrupt event block in frame " + std::to_string(frame_number));
+        }
+        events.push_back(std::move(event));
+    }
+    return true;
+}
+
+bool CaptureFileReader::loadFrame(uint64_t frame_number, CapturedFrame& frame) {
+    const FrameIndex* index = findFrame(frame_number);
+    if (!index) {
+        return fail("Frame " + std::to_string(frame_number) + " not in file");
+    }
+    
+    frame = CapturedFrame{};
+    const FrameSummary& s = index->summary;
+    frame.frame_number = s.frame_number;
+    frame.start_time = s.start_time;
+    frame.end_time = s.end_time;
+    frame.total_draw_calls = s.total_draw_calls;
+    frame.total_dispatches = s.total_dispatches;
+    frame.total_memory_ops = s.total_memory_ops;
+    frame.total_sync_ops = s.total_sync_ops;
+    
+    if (!readEvents(frame_number, frame.events)) {
+        return false;
+    }
+    
+    // Versions shared within the frame are loaded once
+    std::unordered_map<uint64_t, ResourceVersion> loaded;
+    auto load = [&](uint64_t version) -> ResourceVersion {
+        auto it = loaded.find(version);
+        if (it != loaded.end()) return it->second;
+        auto state = std::make_shared<ResourceState>();
+        if (!readVersion(version, *state)) return nullptr;
+        return loaded[version] = std::move(state);
+    };
+    
+    for (const auto& [id, version] : index->initial_state) {
+        if (!(frame.initial_state[id] = load(version))) return false;
+    }
+    for (const auto& [id, version] : index->final_state) {
+        if (!(frame.final_state[id] = load(version))) return false;
+    }
+    
+    std::vector<uint64_t> changed;
+    frame.draw_calls.reserve(index->draws.size());
+    for (const auto& entry : index->draws) {
+        DrawCallInfo draw;
+        bool has_delta = false;
+        changed.clear();
+        if (!readDrawRecord(entry, draw, &changed, has_delta)) {
+            return false;
+        }
+        if (has_delta) {
+            DrawStateDelta delta;
+            delta.call_id = draw.call_id;
+            for (uint64_t version : changed) {
+                ResourceVersion state = load(version);
+                if (!state) return false;
+                delta.changed.push_back(std::move(state));
+            }
+            frame.addDelta(std::move(delta));
+        }
+        frame.draw_calls.push_back(std::move(draw));
+    }
+    return true;
+}
+
+} // namespace tracesmith
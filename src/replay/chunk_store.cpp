@@ -0,0 +1,333 @@
+/**
+ * Content-Addressed Chunk Store Implementation
+ */
+
+#include "tracesmith/replay/chunk_store.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace tracesmith {
+
+// ============================================================================
+// XXH64
+// ============================================================================
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t xxhRound(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = rotl64(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t xxhMergeRound(uint64_t acc, uint64_t val) {
+    acc ^= xxhRound(0, val);
+    return acc * kPrime1 + kPrime4;
+}
+
+} // anonymous namespace
+
+uint64_t hashBytes(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t h;
+    
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = xxhRound(v1, read64(p));
+            v2 = xxhRound(v2, read64(p + 8));
+            v3 = xxhRound(v3, read64(p + 16));
+            v4 = xxhRound(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxhMergeRound(h, v1);
+        h = xxhMergeRound(h, v2);
+        h = xxhMergeRound(h, v3);
+        h = xxhMergeRound(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+    
+    h += static_cast<uint64_t>(size);
+    
+    while (p + 8 <= end) {
+        h ^= xxhRound(0, read64(p));
+        h = rotl64(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+        h = rotl64(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= static_cast<uint64_t>(*p) * kPrime5;
+        h = rotl64(h, 11) * kPrime1;
+        ++p;
+    }
+    
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+// ============================================================================
+// ChunkStore Implementation
+// ============================================================================
+
+ChunkStore::ChunkStore() : ChunkStore(Config()) {}
+
+ChunkStore::ChunkStore(Config config) : config_(std::move(config)) {
+    if (config_.chunk_size == 0) {
+        config_.chunk_size = Config().chunk_size;
+    }
+}
+
+ChunkStore::~ChunkStore() {
+    if (spill_.is_open()) {
+        spill_.close();
+        std::remove(config_.spill_path.c_str());
+    }
+}
+
+ChunkList ChunkStore::put(const void* data, size_t size) {
+    Timestamp start = getCurrentTimestamp();
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    
+    ChunkList list;
+    list.size = size;
+    list.chunks.reserve((size + config_.chunk_size - 1) / config_.chunk_size);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t offset = 0; offset < size; offset += config_.chunk_size) {
+        size_t len = std::min(config_.chunk_size, size - offset);
+        list.chunks.push_back(storeChunk(bytes + offset, len));
+    }
+    stats_.logical_bytes += size;
+    spillIfNeeded();
+    stats_.ingest_time_ns += getCurrentTimestamp() - start;
+    return list;
+}
+
+ChunkList ChunkStore::patch(const ChunkList& base, uint64_t offset,
+                            const void* data, size_t size) {
+    Timestamp start = getCurrentTimestamp();
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const uint64_t chunk_size = config_.chunk_size;
+    const uint64_t new_size = std::max<uint64_t>(base.size, offset + size);
+    const size_t count = static_cast<size_t>((new_size + chunk_size - 1) / chunk_size);
+    
+    // Chunks to rebuild: those overlapping the written range, plus the
+    // old partial tail chunk and anything past it when the buffer grows
+    size_t first_dirty = size > 0 ? static_cast<size_t>(offset / chunk_size) : count;
+    size_t last_dirty = size > 0 ? static_cast<size_t>((offset + size - 1) / chunk_size) : 0;
+    if (new_size > base.size && base.size > 0) {
+        first_dirty = std::min(first_dirty, static_cast<size_t>((base.size - 1) / chunk_size));
+    } else if (new_size > base.size) {
+        first_dirty = 0;
+    }
+    
+    ChunkList list;
+    list.size = new_size;
+    list.chunks.reserve(count);
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint8_t> buffer;
+    for (size_t i = 0; i < count; ++i) {
+        bool dirty = i >= first_dirty && (i <= last_dirty || i >= base.chunks.size() ||
+                                          new_size > base.size);
+        if (!dirty) {
+            list.chunks.push_back(base.chunks[i]);
+            continue;
+        }
+        
+        uint64_t chunk_begin = i * chunk_size;
+        size_t chunk_len = static_cast<size_t>(std::min(chunk_size, new_size - chunk_begin));
+        buffer.clear();
+        if (i < base.chunks.size()) {
+            auto it = chunks_.find(base.chunks[i]);
+            if (it != chunks_.end()) {
+                loadChunk(it->second, buffer);
+            }
+        }
+        buffer.resize(chunk_len, 0);
+        
+        uint64_t copy_begin = std::max(chunk_begin, offset);
+        uint64_t copy_end = std::min<uint64_t>(chunk_begin + chunk_len, offset + size);
+        if (copy_begin < copy_end) {
+            std::memcpy(buffer.data() + (copy_begin - chunk_begin),
+                        bytes + (copy_begin - offset),
+                        static_cast<size_t>(copy_end - copy_begin));
+        }
+        list.chunks.push_back(storeChunk(buffer.data(), buffer.size()));
+    }
+    stats_.logical_bytes += size;
+    spillIfNeeded();
+    stats_.ingest_time_ns += getCurrentTimestamp() - start;
+    return list;
+}
+
+bool ChunkStore::read(const ChunkList& list, std::vector<uint8_t>& out) const {
+    out.clear();
+    out.reserve(static_cast<size_t>(list.size));
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint8_t> chunk;
+    for (uint64_t id : list.chunks) {
+        auto it = chunks_.find(id);
+        if (it == chunks_.end() || !loadChunk(it->second, chunk)) {
+            return false;
+        }
+        out.insert(out.end(), chunk.begin(), chunk.end());
+    }
+    return out.size() == list.size;
+}
+
+bool ChunkStore::readChunk(uint64_t id, std::vector<uint8_t>& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = chunks_.find(id);
+    return it != chunks_.end() && loadChunk(it->second, out);
+}
+
+bool ChunkStore::contains(uint64_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return chunks_.count(id) > 0;
+}
+
+ChunkStore::Statistics ChunkStore::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void ChunkStore::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    chunks_.clear();
+    resident_order_.clear();
+    stats_ = Statistics();
+    if (spill_.is_open()) {
+        spill_.close();
+        std::remove(config_.spill_path.c_str());
+    }
+}
+
+uint64_t ChunkStore::storeChunk(const uint8_t* data, size_t size) {
+    uint64_t id = hashBytes(data, size);
+    std::vector<uint8_t> existing;
+    
+    // Probe past colliding IDs until we find this content or a free slot
+    for (;;) {
+        auto it = chunks_.find(id);
+        if (it == chunks_.end()) {
+            break;
+        }
+        const Chunk& chunk = it->second;
+        if (chunk.size == size) {
+            if (!chunk.spilled) {
+                if (std::memcmp(chunk.data.data(), data, size) == 0) {
+                    stats_.duplicate_chunks++;
+                    return id;
+                }
+            } else if (loadChunk(chunk, existing) &&
+                       std::memcmp(existing.data(), data, size) == 0) {
+                stats_.duplicate_chunks++;
+                return id;
+            }
+        }
+        ++id;
+    }
+    
+    Chunk& chunk = chunks_[id];
+    chunk.data.assign(data, data + size);
+    chunk.size = static_cast<uint32_t>(size);
+    resident_order_.push_back(id);
+    stats_.unique_chunks++;
+    stats_.stored_bytes += size;
+    stats_.resident_bytes += size;
+    return id;
+}
+
+bool ChunkStore::loadChunk(const Chunk& chunk, std::vector<uint8_t>& out) const {
+    if (!chunk.spilled) {
+        out = chunk.data;
+        return true;
+    }
+    
+    out.resize(chunk.size);
+    spill_.clear();
+    spill_.seekg(static_cast<std::streamoff>(chunk.spill_offset));
+    spill_.read(reinterpret_cast<char*>(out.data()), chunk.size);
+    return static_cast<bool>(spill_);
+}
+
+void ChunkStore::spillIfNeeded() {
+    if (config_.max_resident_bytes == 0 || config_.spill_path.empty() ||
+        stats_.resident_bytes <= config_.max_resident_bytes) {
+        return;
+    }
+    
+    if (!spill_.is_open()) {
+        spill_.open(config_.spill_path,
+                    std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!spill_) {
+            return;
+        }
+    }
+    
+    spill_.clear();
+    spill_.seekp(0, std::ios::end);
+    while (stats_.resident_bytes > config_.max_resident_bytes && !resident_order_.empty()) {
+        uint64_t id = resident_order_.front();
+        resident_order_.pop_front();
+        
+        auto it = chunks_.find(id);
+        if (it == chunks_.end() || it->second.spilled) {
+            continue;
+        }
+        Chunk& chunk = it->second;
+        chunk.spill_offset = static_cast<uint64_t>(spill_.tellp());
+        spill_.write(reinterpret_cast<const char*>(chunk.data.data()), chunk.size);
+        if (!spill_) {
+            return;
+        }
+        chunk.spilled = true;
+        std::vector<uint8_t>().swap(chunk.data);
+        stats_.resident_bytes -= chunk.size;
+        stats_.spilled_bytes += chunk.size;
+    }
+    spill_.flush();
+}
+
+} // namespace tracesmith
@@ -1,14 +1,225 @@
 #include "tracesmith/replay/determinism_checker.hpp"
+#include "tracesmith/format/sbt_format.hpp"
+#include <algorithm>
 #include <sstream>
 
 namespace tracesmith {
 
+namespace {
+
+constexpr size_t kNoParent = SIZE_MAX;
+
+/// Dense operation-ID arrays grow up to this far past the op count
+constexpr size_t kDenseIdSlack = 1024;
+
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/// Hash of the fields that identify an operation across runs
+uint64_t eventSignature(const TraceEvent& event) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint8_t type = static_cast<uint8_t>(event.type);
+    hash = fnv1a(&type, sizeof(type), hash);
+    hash = fnv1a(&event.device_id, sizeof(event.device_id), hash);
+    hash = fnv1a(&event.stream_id, sizeof(event.stream_id), hash);
+    return fnv1a(event.name.data(), event.name.size(), hash);
+}
+
+/// Combine a signature with its occurrence number into a unique key
+uint64_t occurrenceKey(uint64_t signature, uint64_t occurrence) {
+    uint64_t x = signature ^ (occurrence * 0x9e3779b97f4a7c15ULL);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+std::string describe(const std::string& name, uint32_t stream_id) {
+    return name + " (stream " + std::to_string(stream_id) + ")";
+}
+
+/**
+ * Match replayed keys against original keys and fill in the matched /
+ * missing / extra counts, the longest common subsequence and the
+ * per-stream reorder counts.
+ * 
+ * Keys are unique within a sequence, so the LCS is the longest increasing
+ * subsequence of original positions in replay order (O(n log n)).
+ */
+void matchSequences(const std::vector<uint64_t>& original_keys,
+                    const std::vector<uint64_t>& replayed_keys,
+                    const std::vector<uint32_t>& replayed_streams,
+                    DeterminismDiff& diff) {
+    std::unordered_map<uint64_t, size_t> position;
+    position.reserve(original_keys.size());
+    for (size_t i = 0; i < original_keys.size(); ++i) {
+        position.emplace(original_keys[i], i);
+    }
+    
+    std::vector<bool> seen(original_keys.size(), false);
+    std::vector<size_t> matched;        // Original position per matched op, replay order
+    std::vector<size_t> parent;         // LIS predecessor (index into matched)
+    std::vector<size_t> tails;          // tails[k]: matched index ending the best run of length k + 1
+    std::unordered_map<uint32_t, std::vector<size_t>> stream_tails;
+    std::unordered_map<uint32_t, size_t> stream_matched;
+    matched.reserve(replayed_keys.size());
+    parent.reserve(replayed_keys.size());
+    
+    for (size_t j = 0; j < replayed_keys.size(); ++j) {
+        auto it = position.find(replayed_keys[j]);
+        if (it == position.end() || seen[it->second]) {
+            diff.extra_operations++;
+            continue;
+        }
+        size_t pos = it->second;
+        seen[pos] = true;
+        
+        size_t m = matched.size();
+        matched.push_back(pos);
+        
+        auto slot = std::lower_bound(tails.begin(), tails.end(), pos,
+                                     [&](size_t t, size_t p) { return matched[t] < p; });
+        parent.push_back(slot == tails.begin() ? kNoParent : *(slot - 1));
+        if (slot == tails.end()) {
+            tails.push_back(m);
+        } else {
+            *slot = m;
+        }
+        
+        // Per-stream LIS length only, so positions are stored directly
+        uint32_t stream = replayed_streams[j];
+        auto& st = stream_tails[stream];
+        auto stream_slot = std::lower_bound(st.begin(), st.end(), pos);
+        if (stream_slot == st.end()) {
+            st.push_back(pos);
+        } else {
+            *stream_slot = pos;
+        }
+        stream_matched[stream]++;
+    }
+    
+    diff.matched_operations = matched.size();
+    diff.missing_operations = original_keys.size() - matched.size();
+    
+    diff.common_subsequence.clear();
+    diff.common_subsequence.reserve(tails.size());
+    for (size_t k = tails.empty() ? kNoParent : tails.back(); k != kNoParent; k = parent[k]) {
+        diff.common_subsequence.push_back(matched[k]);
+    }
+    std::reverse(diff.common_subsequence.begin(), diff.common_subsequence.end());
+    
+    diff.stream_reorders.clear();
+    for (const auto& [stream, count] : stream_matched) {
+        diff.stream_reorders[stream] = count - stream_tails[stream].size();
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// DeterminismDiff
+// ============================================================================
+
+std::string DeterminismDiff::summary() const {
+    std::ostringstream ss;
+    
+    ss << "Determinism Diff\n";
+    ss << "================\n";
+    ss << "Original operations: " << original_count << "\n";
+    ss << "Replayed operations: " << replayed_count << "\n";
+    
+    if (identical()) {
+        ss << "✓ Sequences are identical\n";
+        return ss.str();
+    }
+    
+    ss << "First divergence at index " << first_divergence << ": expected "
+       << (expected.empty() ? "<end>" : expected) << ", got "
+       << (actual.empty() ? "<end>" : actual) << "\n";
+    ss << "Matched: " << matched_operations
+       << ", missing: " << missing_operations
+       << ", extra: " << extra_operations << "\n";
+    ss << "Longest common subsequence: " << common_subsequence.size()
+       << " (" << reorderedOperations() << " reordered)\n";
+    
+    bool header = false;
+    for (const auto& [stream, count] : stream_reorders) {
+        if (count == 0) {
+            continue;
+        }
+        if (!header) {
+            ss << "Reordered within stream:\n";
+            header = true;
+        }
+        ss << "  stream " << stream << ": " << count << "\n";
+    }
+    
+    return ss.str();
+}
+
+// ============================================================================
+// DeterminismChecker
+// ============================================================================
+
+uint32_t DeterminismChecker::internName(const std::string& name) {
+    auto [it, inserted] = name_index_.emplace(name, static_cast<uint32_t>(names_.size()));
+    if (inserted) {
+        names_.push_back(name);
+    }
+    return it->second;
+}
+
+DeterminismChecker::OpRecord DeterminismChecker::makeRecord(const StreamOperation& op) {
+    OpRecord record;
+    record.operation_id = op.operation_id;
+    record.name_id = internName(op.event.name);
+    record.device_id = op.event.device_id;
+    record.stream_id = op.event.stream_id;
+    record.type = op.event.type;
+    record.executed = op.executed;
+    record.execution_time = op.execution_time;
+    return record;
+}
+
 void DeterminismChecker::recordOriginal(const StreamOperation& op) {
-    original_ops_.push_back(op);
+    original_ops_.push_back(makeRecord(op));
 }
 
 void DeterminismChecker::recordReplayed(const StreamOperation& op) {
-    replayed_ops_.push_back(op);
+    size_t sequence = replayed_ops_.size();
+    replayed_ops_.push_back(makeRecord(op));
+    
+    dep_ids_.insert(dep_ids_.end(), op.depends_on.begin(), op.depends_on.end());
+    dep_offsets_.push_back(dep_ids_.size());
+    
+    // IDs are indexed relative to the first replayed one (streaming windows)
+    if (sequence == 0) {
+        id_base_ = op.operation_id;
+    }
+    size_t index = op.operation_id - id_base_;
+    size_t dense_limit = 2 * std::max(original_ops_.size(), replayed_ops_.size()) + kDenseIdSlack;
+    if (op.operation_id >= id_base_ && index < dense_limit) {
+        if (index >= replay_seq_.size()) {
+            replay_seq_.resize(index + 1, kNotReplayed);
+        }
+        replay_seq_[index] = sequence;
+    } else {
+        sparse_replay_seq_[op.operation_id] = sequence;
+    }
+}
+
+size_t DeterminismChecker::replaySequence(size_t operation_id) const {
+    size_t index = operation_id - id_base_;
+    if (operation_id >= id_base_ && index < replay_seq_.size() && replay_seq_[index] != kNotReplayed) {
+        return replay_seq_[index];
+    }
+    auto it = sparse_replay_seq_.find(operation_id);
+    return it != sparse_replay_seq_.end() ? it->second : kNotReplayed;
 }
 
 bool DeterminismChecker::validateOrder() {
@@ -20,13 +231,38 @@ bool DeterminismChecker::validateOrder() {
         return false;
     }
     
-    bool valid = true;
+    // Streams run concurrently, so only the order within each
+    // (device, stream) queue is checked: the i-th replayed op of a stream
+    // must be the i-th original op of that stream
+    auto streamKey = [](const OpRecord& op) {
+        return (static_cast<uint64_t>(op.device_id) << 32) | op.stream_id;
+    };
+    std::unordered_map<uint64_t, std::vector<size_t>> original_streams;
     for (size_t i = 0; i < original_ops_.size(); ++i) {
-        if (!checkOperationMatch(original_ops_[i], replayed_ops_[i])) {
+        original_streams[streamKey(original_ops_[i])].push_back(i);
+    }
+    std::unordered_map<uint64_t, size_t> stream_position;
+    
+    bool valid = true;
+    for (size_t i = 0; i < replayed_ops_.size(); ++i) {
+        const OpRecord& replay = replayed_ops_[i];
+        uint64_t key = streamKey(replay);
+        size_t position = stream_position[key]++;
+        auto it = original_streams.find(key);
+        if (it == original_streams.end() || position >= it->second.size()) {
+            violations_.order_violations.push_back(
+                "Unexpected operation at index " + std::to_string(i) + ": " +
+                describe(names_[replay.name_id], replay.stream_id)
+            );
+            valid = false;
+            continue;
+        }
+        const OpRecord& orig = original_ops_[it->second[position]];
+        if (!checkOperationMatch(orig, replay)) {
             violations_.order_violations.push_back(
                 "Operation mismatch at index " + std::to_string(i) +
-                ": expected " + original_ops_[i].event.name +
-                ", got " + replayed_ops_[i].event.name
+                ": expected " + describe(names_[orig.name_id], orig.stream_id) +
+                ", got " + describe(names_[replay.name_id], replay.stream_id)
             );
             valid = false;
         }
@@ -38,20 +274,24 @@ bool DeterminismChecker::validateOrder() {
 bool DeterminismChecker::validateDependencies() {
     bool valid = true;
     
-    for (const auto& op : replayed_ops_) {
-        // Check if all dependencies were executed before this operation
-        for (size_t dep_id : op.depends_on) {
-            bool dep_found = false;
-            for (const auto& completed_op : replayed_ops_) {
-                if (completed_op.operation_id == dep_id && 
-                    completed_op.executed &&
-                    completed_op.execution_time < op.execution_time) {
-                    dep_found = true;
-                    break;
-                }
+    for (size_t seq = 0; seq < replayed_ops_.size(); ++seq) {
+        const OpRecord& op = replayed_ops_[seq];
+        
+        // A dependency must have executed first: earlier execution time,
+        // or the same time and an earlier sequence number
+        for (size_t d = dep_offsets_[seq]; d < dep_offsets_[seq + 1]; ++d) {
+            size_t dep_id = dep_ids_[d];
+            size_t dep_seq = replaySequence(dep_id);
+            
+            bool satisfied = false;
+            if (dep_seq != kNotReplayed) {
+                const OpRecord& dep = replayed_ops_[dep_seq];
+                satisfied = dep.executed &&
+                            (dep.execution_time < op.execution_time ||
+                             (dep.execution_time == op.execution_time && dep_seq < seq));
             }
             
-            if (!dep_found) {
+            if (!satisfied) {
                 violations_.dependency_violations.push_back(
                     "Dependency violation: operation " + std::to_string(op.operation_id) +
                     " executed before dependency " + std::to_string(dep_id)
@@ -64,6 +304,128 @@ bool DeterminismChecker::validateDependencies() {
     return valid;
 }
 
+DeterminismDiff DeterminismChecker::diff() const {
+    DeterminismDiff result;
+    result.original_count = original_ops_.size();
+    result.replayed_count = replayed_ops_.size();
+    
+    size_t common = std::min(original_ops_.size(), replayed_ops_.size());
+    for (size_t i = 0; i < common; ++i) {
+        if (!checkOperationMatch(original_ops_[i], replayed_ops_[i])) {
+            result.first_divergence = i;
+            break;
+        }
+    }
+    if (result.first_divergence == DeterminismDiff::kNoDivergence &&
+        original_ops_.size() != replayed_ops_.size()) {
+        result.first_divergence = common;
+    }
+    
+    size_t at = result.first_divergence;
+    if (at < original_ops_.size()) {
+        result.expected = describe(names_[original_ops_[at].name_id], original_ops_[at].stream_id);
+    }
+    if (at < replayed_ops_.size()) {
+        result.actual = describe(names_[replayed_ops_[at].name_id], replayed_ops_[at].stream_id);
+    }
+    
+    std::vector<uint64_t> original_keys(original_ops_.size());
+    for (size_t i = 0; i < original_ops_.size(); ++i) {
+        original_keys[i] = original_ops_[i].operation_id;
+    }
+    std::vector<uint64_t> replayed_keys(replayed_ops_.size());
+    std::vector<uint32_t> replayed_streams(replayed_ops_.size());
+    for (size_t i = 0; i < replayed_ops_.size(); ++i) {
+        replayed_keys[i] = replayed_ops_[i].operation_id;
+        replayed_streams[i] = replayed_ops_[i].stream_id;
+    }
+    
+    matchSequences(original_keys, replayed_keys, replayed_streams, result);
+    return result;
+}
+
+bool DeterminismChecker::compareFiles(const std::string& original_file,
+                                      const std::string& replayed_file,
+                                      DeterminismDiff& diff,
+                                      std::string* error,
+                                      size_t batch_size) {
+    diff = DeterminismDiff{};
+    
+    SBTReader original(original_file);
+    SBTReader replayed(replayed_file);
+    for (const auto* reader : {&original, &replayed}) {
+        if (!reader->isOpen() || !reader->isValid()) {
+            if (error) {
+                *error = "Cannot read SBT file: " +
+                         (reader == &original ? original_file : replayed_file);
+            }
+            return false;
+        }
+    }
+    
+    diff.original_count = static_cast<size_t>(original.eventCount());
+    diff.replayed_count = static_cast<size_t>(replayed.eventCount());
+    batch_size = std::max<size_t>(batch_size, 1);
+    
+    std::vector<uint64_t> original_keys;
+    std::vector<uint64_t> replayed_keys;
+    std::vector<uint32_t> replayed_streams;
+    original_keys.reserve(diff.original_count);
+    replayed_keys.reserve(diff.replayed_count);
+    replayed_streams.reserve(diff.replayed_count);
+    
+    // Occurrence counters per signature, so repeated launches of the same
+    // kernel on the same stream are matched in order
+    std::unordered_map<uint64_t, uint64_t> original_seen;
+    std::unordered_map<uint64_t, uint64_t> replayed_seen;
+    
+    std::vector<TraceEvent> original_batch;
+    std::vector<TraceEvent> replayed_batch;
+    size_t total = std::max(diff.original_count, diff.replayed_count);
+    
+    for (size_t offset = 0; offset < total; offset += batch_size) {
+        original_batch.clear();
+        replayed_batch.clear();
+        
+        for (auto [reader, batch] : {std::make_pair(&original, &original_batch),
+                                     std::make_pair(&replayed, &replayed_batch)}) {
+            auto result = reader->readEvents(*batch, offset, batch_size);
+            if (!result) {
+                if (error) {
+                    *error = result.error_message;
+                }
+                return false;
+            }
+        }
+        
+        size_t count = std::max(original_batch.size(), replayed_batch.size());
+        for (size_t i = 0; i < count; ++i) {
+            const TraceEvent* a = i < original_batch.size() ? &original_batch[i] : nullptr;
+            const TraceEvent* b = i < replayed_batch.size() ? &replayed_batch[i] : nullptr;
+            uint64_t sig_a = a ? eventSignature(*a) : 0;
+            uint64_t sig_b = b ? eventSignature(*b) : 0;
+            
+            if (a) {
+                original_keys.push_back(occurrenceKey(sig_a, original_seen[sig_a]++));
+            }
+            if (b) {
+                replayed_keys.push_back(occurrenceKey(sig_b, replayed_seen[sig_b]++));
+                replayed_streams.push_back(b->stream_id);
+            }
+            
+            if (diff.first_divergence == DeterminismDiff::kNoDivergence &&
+                (!a || !b || sig_a != sig_b)) {
+                diff.first_divergence = offset + i;
+                diff.expected = a ? describe(a->name, a->stream_id) : "";
+                diff.actual = b ? describe(b->name, b->stream_id) : "";
+            }
+        }
+    }
+    
+    matchSequences(original_keys, replayed_keys, replayed_streams, diff);
+    return true;
+}
+
 std::string DeterminismChecker::getReport() const {
     std::ostringstream ss;
     
@@ -107,15 +469,22 @@ std::string DeterminismChecker::getReport() const {
 void DeterminismChecker::reset() {
     original_ops_.clear();
     replayed_ops_.clear();
+    dep_offsets_.assign(1, 0);
+    dep_ids_.clear();
+    replay_seq_.clear();
+    sparse_replay_seq_.clear();
+    id_base_ = 0;
+    names_.clear();
+    name_index_.clear();
     violations_ = Violations{};
 }
 
-bool DeterminismChecker::checkOperationMatch(const StreamOperation& orig, const StreamOperation& replay) {
-    // Check if operations are the same
-    return orig.event.type == replay.event.type &&
-           orig.event.device_id == replay.event.device_id &&
-           orig.event.stream_id == replay.event.stream_id &&
-           orig.event.name == replay.event.name;
+bool DeterminismChecker::checkOperationMatch(const OpRecord& orig, const OpRecord& replay) const {
+    // Names are interned, so equal IDs mean equal names
+    return orig.type == replay.type &&
+           orig.device_id == replay.device_id &&
+           orig.stream_id == replay.stream_id &&
+           orig.name_id == replay.name_id;
 }
 
 } // namespace tracesmith
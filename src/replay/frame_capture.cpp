@@ -5,6 +5,7 @@
  */
 
 #include "tracesmith/replay/frame_capture.hpp"
+#include "tracesmith/replay/capture_file.hpp"
 #include "tracesmith/state/perfetto_exporter.hpp"
 #include <algorithm>
 #include <fstream>
@@ -16,12 +17,26 @@ namespace tracesmith {
 // FrameCapture Implementation
 // ============================================================================
 
-FrameCapture::FrameCapture() : config_() {}
+FrameCapture::FrameCapture() : FrameCapture(FrameCaptureConfig()) {}
 
-FrameCapture::FrameCapture(const FrameCaptureConfig& config) : config_(config) {}
+FrameCapture::FrameCapture(const FrameCaptureConfig& config)
+    : config_(config)
+    , chunk_store_(std::make_unique<ChunkStore>(config.chunk_store)) {}
 
 FrameCapture::~FrameCapture() = default;
 
+void FrameCapture::setConfig(const FrameCaptureConfig& config) {
+    // Stored chunks depend on the store's settings, so a non-empty store
+    // keeps them and getConfig() keeps reporting what is in effect
+    ChunkStore::Config store_config = config_.chunk_store;
+    config_ = config;
+    if (chunk_store_->getStatistics().unique_chunks == 0) {
+        chunk_store_ = std::make_unique<ChunkStore>(config.chunk_store);
+    } else {
+        config_.chunk_store = store_config;
+    }
+}
+
 void FrameCapture::triggerCapture() {
     if (state_ == CaptureState::Idle) {
         state_ = CaptureState::Armed;
@@ -121,11 +136,9 @@ void FrameCapture::recordDrawCall(const DrawCallInfo& draw) {
     
     current_frame_.draw_calls.push_back(draw);
     
-    // Snapshot resource state at this draw call
+    // Record the resources changed since the previous draw call
     if (config_.capture_resource_state) {
-        std::map<uint64_t, ResourceState> state;
-        snapshotResources(state);
-        current_frame_.state_history[draw.call_id] = std::move(state);
+        current_frame_.addDelta(takeDelta(draw.call_id));
     }
     
     if (on_draw_call_) {
@@ -139,32 +152,47 @@ void FrameCapture::recordDispatch(const DrawCallInfo& dispatch) {
 }
 
 void FrameCapture::recordResourceCreate(const ResourceState& resource) {
-    resources_[resource.resource_id] = resource;
+    auto version = std::make_shared<ResourceState>(resource);
+    resources_[resource.resource_id] = version;
+    unpublished_[resource.resource_id] = std::move(version);
 }
 
 void FrameCapture::recordResourceUpdate(uint64_t resource_id, 
                                         const void* data, size_t size) {
-    auto it = resources_.find(resource_id);
-    if (it == resources_.end()) return;
+    ResourceState* state = mutableResource(resource_id);
+    if (!state) return;
     
-    it->second.last_modified = getCurrentTimestamp();
+    state->last_modified = getCurrentTimestamp();
     
     // Optionally capture data
     if (config_.capture_buffer_contents && 
-        it->second.type == ResourceType::Buffer &&
+        state->type == ResourceType::Buffer &&
         size <= config_.max_buffer_capture_size) {
-        it->second.data.resize(size);
-        std::memcpy(it->second.data.data(), data, size);
+        state->contents = chunk_store_->put(data, size);
+    }
+}
+
+void FrameCapture::recordResourceUpdate(uint64_t resource_id, uint64_t offset,
+                                        const void* data, size_t size) {
+    ResourceState* state = mutableResource(resource_id);
+    if (!state) return;
+    
+    state->last_modified = getCurrentTimestamp();
+    
+    if (config_.capture_buffer_contents && 
+        state->type == ResourceType::Buffer &&
+        offset + size <= config_.max_buffer_capture_size) {
+        state->contents = chunk_store_->patch(state->contents, offset, data, size);
     }
 }
 
 void FrameCapture::recordResourceBind(uint64_t resource_id,
                                       bool as_input, bool as_output) {
-    auto it = resources_.find(resource_id);
-    if (it == resources_.end()) return;
+    ResourceState* state = mutableResource(resource_id);
+    if (!state) return;
     
-    it->second.bound_as_input = as_input;
-    it->second.bound_as_output = as_output;
+    state->bound_as_input = as_input;
+    state->bound_as_output = as_output;
 }
 
 void FrameCapture::recordEvent(const TraceEvent& event) {
@@ -184,7 +212,7 @@ const CapturedFrame* FrameCapture::getFrame(uint64_t frame_number) const {
 
 const ResourceState* FrameCapture::getResource(uint64_t resource_id) const {
     auto it = resources_.find(resource_id);
-    return it != resources_.end() ? &it->second : nullptr;
+    return it != resources_.end() ? it->second.get() : nullptr;
 }
 
 bool FrameCapture::replayToDrawCall(uint64_t frame_number, 
@@ -210,32 +238,53 @@ std::optional<ResourceState> FrameCapture::getResourceStateAt(
     uint64_t frame_number, uint64_t draw_call_id, uint64_t resource_id) {
     
     const auto* frame = getFrame(frame_number);
-    if (!frame) return std::nullopt;
-    
-    auto history_it = frame->state_history.find(draw_call_id);
-    if (history_it == frame->state_history.end()) {
-        return std::nullopt;
-    }
+    if (!frame || !frame->hasDrawCall(draw_call_id)) return std::nullopt;
     
-    auto resource_it = history_it->second.find(resource_id);
-    if (resource_it == history_it->second.end()) {
-        return std::nullopt;
-    }
-    
-    return resource_it->second;
+    return frame->getResourceStateAt(resource_id, draw_call_id);
 }
 
 void FrameCapture::clear() {
     captured_frames_.clear();
     resources_.clear();
+    unpublished_.clear();
+    chunk_store_->clear();
     current_frame_ = CapturedFrame{};
     current_frame_number_ = 0;
     frames_remaining_ = 0;
     state_ = CaptureState::Idle;
 }
 
-void FrameCapture::snapshotResources(std::map<uint64_t, ResourceState>& out) {
-    out = resources_;  // Copy current state
+void FrameCapture::snapshotResources(std::map<uint64_t, ResourceVersion>& out) {
+    // Shares the current versions; later modifications copy on write
+    out = resources_;
+    unpublished_.clear();
+}
+
+ResourceState* FrameCapture::mutableResource(uint64_t resource_id) {
+    auto it = resources_.find(resource_id);
+    if (it == resources_.end()) return nullptr;
+    
+    auto unpublished = unpublished_.find(resource_id);
+    if (unpublished != unpublished_.end()) {
+        return unpublished->second.get();
+    }
+    
+    // Published versions are immutable: copy (contents stay shared)
+    auto version = std::make_shared<ResourceState>(*it->second);
+    it->second = version;
+    unpublished_[resource_id] = version;
+    return version.get();
+}
+
+DrawStateDelta FrameCapture::takeDelta(uint64_t call_id) {
+    DrawStateDelta delta;
+    delta.call_id = call_id;
+    delta.changed.reserve(unpublished_.size());
+    for (auto& [id, version] : unpublished_) {
+        delta.changed.push_back(std::move(version));
+    }
+    unpublished_.clear();
+    return delta;
 }
 
 bool FrameCapture::exportToRDC(const std::string& filename, 
@@ -254,34 +303,83 @@ bool FrameCapture::exportToPerfetto(const std::string& filename,
     
     PerfettoExporter exporter;
     
+    // Draw calls become markers carrying their parameters
+    std::vector<TraceEvent> events = frame->events;
+    events.reserve(events.size() + frame->draw_calls.size());
+    for (const auto& draw : frame->draw_calls) {
+        TraceEvent marker(EventType::Marker, draw.timestamp ? draw.timestamp : frame->start_time);
+        marker.name = draw.name;
+        marker.correlation_id = draw.call_id;
+        marker.metadata["call_id"] = std::to_string(draw.call_id);
+        if (draw.vertex_count) marker.metadata["vertex_count"] = std::to_string(draw.vertex_count);
+        if (draw.index_count) marker.metadata["index_count"] = std::to_string(draw.index_count);
+        if (draw.instance_count != 1) marker.metadata["instance_count"] = std::to_string(draw.instance_count);
+        if (draw.group_count_x) {
+            marker.metadata["groups"] = std::to_string(draw.group_count_x) + "x" +
+                                        std::to_string(draw.group_count_y) + "x" +
+                                        std::to_string(draw.group_count_z);
+        }
+        if (draw.pipeline_id) marker.metadata["pipeline_id"] = std::to_string(draw.pipeline_id);
+        events.push_back(std::move(marker));
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TraceEvent& a, const TraceEvent& b) { return a.timestamp < b.timestamp; });
+    
     // Export events (empty counters vector)
     std::vector<CounterEvent> empty_counters;
-    return exporter.exportToFile(frame->events, empty_counters, filename);
+    return exporter.exportToFile(events, empty_counters, filename);
+}
+
+bool FrameCapture::saveCapture(const std::string& filename) const {
+    CaptureFileWriter writer(filename);
+    return writer.isOpen() && writer.writeCapture(*this);
 }
 
 // ============================================================================
 // CapturedFrame Implementation
 // ============================================================================
 
-std::optional<ResourceState> CapturedFrame::getResourceStateAt(
+ResourceVersion CapturedFrame::getResourceVersionAt(
     uint64_t resource_id, uint64_t draw_call_id) const {
     
-    auto history_it = state_history.find(draw_call_id);
-    if (history_it == state_history.end()) {
-        // Fall back to initial state
-        auto init_it = initial_state.find(resource_id);
-        if (init_it != initial_state.end()) {
-            return init_it->second;
+    auto draw_it = draw_index.find(draw_call_id);
+    if (draw_it != draw_index.end()) {
+        // Latest change at or before this draw call
+        auto chain_it = version_chains.find(resource_id);
+        if (chain_it != version_chains.end()) {
+            const auto& chain = chain_it->second;
+            auto next = std::upper_bound(
+                chain.begin(), chain.end(), draw_it->second,
+                [](uint32_t index, const auto& entry) { return index < entry.first; });
+            if (next != chain.begin()) {
+                return std::prev(next)->second;
+            }
         }
-        return std::nullopt;
     }
     
-    auto resource_it = history_it->second.find(resource_id);
-    if (resource_it == history_it->second.end()) {
+    // Unchanged since frame start (or unknown draw call)
+    auto init_it = initial_state.find(resource_id);
+    return init_it != initial_state.end() ? init_it->second : nullptr;
+}
+
+std::optional<ResourceState> CapturedFrame::getResourceStateAt(
+    uint64_t resource_id, uint64_t draw_call_id) const {
+    
+    ResourceVersion version = getResourceVersionAt(resource_id, draw_call_id);
+    if (!version) {
         return std::nullopt;
     }
-    
-    return resource_it->second;
+    return *version;
+}
+
+void CapturedFrame::addDelta(DrawStateDelta delta) {
+    uint32_t index = static_cast<uint32_t>(state_deltas.size());
+    draw_index[delta.call_id] = index;
+    for (const auto& version : delta.changed) {
+        version_chains[version->resource_id].emplace_back(index, version);
+    }
+    resource_versions += delta.changed.size();
+    state_deltas.push_back(std::move(delta));
 }
 
 // ============================================================================
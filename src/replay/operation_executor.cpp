@@ -39,6 +39,10 @@ bool OperationExecutor::execute(const StreamOperation& op) {
             break;
     }
     
+    if (success && hook_) {
+        success = hook_(op);
+    }
+    
     if (success) {
         metrics_.operations_executed++;
         Timestamp end_time = getCurrentTimestamp();
@@ -0,0 +1,131 @@
+#include "tracesmith/replay/pacing_timer.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace tracesmith {
+
+PacingTimer::PacingTimer(double time_scale, Timestamp spin_threshold_ns)
+    : time_scale_(time_scale)
+    , spin_threshold_ns_(spin_threshold_ns)
+    , start_(Clock::now()) {
+}
+
+void PacingTimer::start(Timestamp origin) {
+    origin_ = origin;
+    start_ = Clock::now();
+    samples_ = 0;
+    total_ = 0;
+    max_ = 0;
+    histogram_.fill(0);
+}
+
+Timestamp PacingTimer::targetOffset(Timestamp captured) const {
+    if (time_scale_ <= 0.0 || captured <= origin_) {
+        return 0;
+    }
+    return static_cast<Timestamp>(static_cast<double>(captured - origin_) / time_scale_);
+}
+
+Timestamp PacingTimer::waitUntil(Timestamp captured) {
+    Timestamp target = targetOffset(captured);
+    if (time_scale_ > 0.0) {
+        sleepUntil(start_ + std::chrono::nanoseconds(target), spin_threshold_ns_);
+    }
+    
+    Timestamp now = elapsed();
+    Timestamp late = now > target ? now - target : 0;
+    record(late);
+    return late;
+}
+
+Timestamp PacingTimer::elapsed() const {
+    return static_cast<Timestamp>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count());
+}
+
+void PacingTimer::merge(const PacingTimer& other) {
+    samples_ += other.samples_;
+    total_ += other.total_;
+    max_ = std::max(max_, other.max_);
+    for (size_t i = 0; i < kBuckets; ++i) {
+        histogram_[i] += other.histogram_[i];
+    }
+}
+
+void PacingTimer::record(Timestamp late) {
+    ++samples_;
+    total_ += late;
+    max_ = std::max(max_, late);
+    ++histogram_[bucketOf(late)];
+}
+
+size_t PacingTimer::bucketOf(Timestamp value) {
+    if (value < kSubBuckets) {
+        return static_cast<size_t>(value);
+    }
+    // Top bit selects the power of two, the next four bits the sub-bucket
+    size_t msb = 63;
+    while (!(value >> msb)) {
+        --msb;
+    }
+    size_t shift = msb - 4;
+    return kSubBuckets + shift * kSubBuckets + static_cast<size_t>((value >> shift) - kSubBuckets);
+}
+
+Timestamp PacingTimer::bucketUpperBound(size_t bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket;
+    }
+    size_t shift = (bucket - kSubBuckets) / kSubBuckets;
+    Timestamp lower = static_cast<Timestamp>(kSubBuckets + (bucket - kSubBuckets) % kSubBuckets) << shift;
+    return lower + ((Timestamp(1) << shift) - 1);
+}
+
+Timestamp PacingTimer::percentile(double fraction) const {
+    // Same rank as indexing a sorted sample array at (n - 1) * fraction
+    uint64_t rank = static_cast<uint64_t>(static_cast<double>(samples_ - 1) * fraction);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += histogram_[i];
+        if (seen > rank) {
+            return std::min(bucketUpperBound(i), max_);
+        }
+    }
+    return max_;
+}
+
+DispatchJitterStats PacingTimer::jitterStats() const {
+    DispatchJitterStats stats;
+    stats.samples = samples_;
+    if (samples_ == 0) {
+        return stats;
+    }
+    
+    stats.mean = static_cast<Timestamp>(total_ / samples_);
+    stats.p50 = percentile(0.5);
+    stats.p99 = percentile(0.99);
+    stats.max = max_;
+    return stats;
+}
+
+void PacingTimer::sleepUntil(Clock::time_point deadline, Timestamp spin_threshold_ns) {
+    const auto spin = std::chrono::nanoseconds(spin_threshold_ns);
+    
+    // Coarse phase: sleep while the deadline is further away than the spin window
+    for (;;) {
+        auto now = Clock::now();
+        if (now >= deadline) {
+            return;
+        }
+        if (deadline - now <= spin) {
+            break;
+        }
+        std::this_thread::sleep_for(deadline - now - spin);
+    }
+    
+    // Fine phase: spin on the monotonic clock
+    while (Clock::now() < deadline) {
+    }
+}
+
+} // namespace tracesmith
@@ -0,0 +1,365 @@
+#include "tracesmith/replay/parallel_executor.hpp"
+#include "tracesmith/replay/pacing_timer.hpp"
+#include "tracesmith/common/ring_buffer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace tracesmith {
+
+namespace {
+
+constexpr size_t kCompletionRingCapacity = 1024;
+constexpr int kSpinIterations = 2000;
+
+/// Outcome of one operation, as seen by its dependents and the drainer
+enum class Outcome : uint8_t {
+    Pending = 0,
+    Succeeded,
+    Failed,      // Executed and failed
+    Blocked,     // Not executed: a dependency failed or was blocked
+    Cancelled    // Not executed: dispatch stopped by pause_on_error
+};
+
+/// Completion record sent from a worker to the calling thread
+struct Completion {
+    uint32_t index = 0;
+    Outcome outcome = Outcome::Pending;
+};
+
+/**
+ * Per-operation completion flags. Waiters spin on the flag for a short
+ * while and then park on a shared condition variable; signal() only
+ * touches the mutex when someone is parked.
+ */
+class CompletionEvents {
+public:
+    explicit CompletionEvents(size_t count)
+        : flags_(std::make_unique<std::atomic<uint8_t>[]>(count)) {
+        for (size_t i = 0; i < count; ++i) {
+            flags_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+    
+    void signal(size_t index, Outcome outcome) {
+        flags_[index].store(static_cast<uint8_t>(outcome), std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+    }
+    
+    /// Block until the operation has an outcome; true if it succeeded
+    bool wait(size_t index) {
+        for (int i = 0; i < kSpinIterations; ++i) {
+            uint8_t flag = flags_[index].load(std::memory_order_acquire);
+            if (flag != 0) {
+                return flag == static_cast<uint8_t>(Outcome::Succeeded);
+            }
+        }
+        
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        cv_.wait(lock, [&] { return flags_[index].load(std::memory_order_seq_cst) != 0; });
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return flags_[index].load(std::memory_order_relaxed) ==
+               static_cast<uint8_t>(Outcome::Succeeded);
+    }
+
+private:
+    std::unique_ptr<std::atomic<uint8_t>[]> flags_;
+    std::atomic<size_t> waiters_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+/**
+ * Wakes the draining thread when a worker has pushed a completion. The
+ * drainer spins briefly on the sequence number, then parks; notify() only
+ * touches the mutex while it is parked.
+ */
+class DrainSignal {
+public:
+    uint64_t sequence() const {
+        return sequence_.load(std::memory_order_seq_cst);
+    }
+    
+    void notify() {
+        sequence_.fetch_add(1, std::memory_order_seq_cst);
+        if (waiting_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_one();
+        }
+    }
+    
+    /// Block until notify() has been called since `seen` was read
+    void waitPast(uint64_t seen) {
+        for (int i = 0; i < kSpinIterations; ++i) {
+            if (sequence() != seen) {
+                return;
+            }
+        }
+        
+        std::unique_lock<std::mutex> lock(mutex_);
+        waiting_.store(true, std::memory_order_seq_cst);
+        cv_.wait(lock, [&] { return sequence() != seen; });
+        waiting_.store(false, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> sequence_{0};
+    std::atomic<bool> waiting_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+} // namespace
+
+ParallelReplayExecutor::ParallelReplayExecutor(bool dry_run) : dry_run_(dry_run) {}
+
+bool ParallelReplayExecutor::run(std::vector<StreamOperation>& operations,
+                                 const ReplayConfig& config,
+                                 const CompletionCallback& on_complete) {
+    const size_t n = operations.size();
+    last_error_.clear();
+    metrics_ = OperationExecutor::Metrics{};
+    jitter_ = DispatchJitterStats{};
+    worker_count_ = 0;
+    blocked_count_ = 0;
+    cancelled_count_ = 0;
+    start_times_.assign(n, 0);
+    end_times_.assign(n, 0);
+    
+    if (n == 0) {
+        return true;
+    }
+    
+    // Operation ID -> index
+    std::unordered_map<size_t, uint32_t> index_of;
+    index_of.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        index_of.emplace(operations[i].operation_id, i);
+    }
+    
+    // One worker per (device, stream), in order of first appearance
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> worker_index;
+    std::vector<std::vector<uint32_t>> worker_ops;
+    std::vector<uint32_t> worker_of(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        auto key = std::make_pair(operations[i].device_id, operations[i].stream_id);
+        auto [it, inserted] = worker_index.emplace(key, static_cast<uint32_t>(worker_ops.size()));
+        if (inserted) {
+            worker_ops.emplace_back();
+        }
+        worker_ops[it->second].push_back(i);
+        worker_of[i] = it->second;
+    }
+    
+    // Dependencies to wait on (CSR). A dependency on an earlier operation
+    // of the same worker is already complete by stream order, but is still
+    // checked so a failure blocks its dependents like in serial replay.
+    std::vector<uint32_t> wait_offsets(n + 1, 0);
+    std::vector<uint32_t> wait_sources;
+    for (uint32_t i = 0; i < n; ++i) {
+        for (size_t dep_id : operations[i].depends_on) {
+            auto it = index_of.find(dep_id);
+            if (it == index_of.end()) {
+                last_error_ = "Operation " + std::to_string(operations[i].operation_id) +
+                              " depends on unknown operation " + std::to_string(dep_id);
+                return false;
+            }
+            wait_sources.push_back(it->second);
+        }
+        wait_offsets[i + 1] = static_cast<uint32_t>(wait_sources.size());
+    }
+    
+    // Reject graphs that would deadlock: Kahn's algorithm over explicit
+    // waits plus per-worker order
+    {
+        std::vector<uint32_t> in_degree(n, 0);
+        std::vector<uint32_t> next_in_worker(n, UINT32_MAX);
+        std::vector<uint32_t> succ_offsets(n + 1, 0);
+        for (const auto& ops : worker_ops) {
+            for (size_t k = 1; k < ops.size(); ++k) {
+                next_in_worker[ops[k - 1]] = ops[k];
+                in_degree[ops[k]]++;
+            }
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            for (uint32_t e = wait_offsets[i]; e < wait_offsets[i + 1]; ++e) {
+                succ_offsets[wait_sources[e] + 1]++;
+                in_degree[i]++;
+            }
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            succ_offsets[i + 1] += succ_offsets[i];
+        }
+        std::vector<uint32_t> succ(wait_sources.size());
+        std::vector<uint32_t> fill(succ_offsets.begin(), succ_offsets.end() - 1);
+        for (uint32_t i = 0; i < n; ++i) {
+            for (uint32_t e = wait_offsets[i]; e < wait_offsets[i + 1]; ++e) {
+                succ[fill[wait_sources[e]]++] = i;
+            }
+        }
+        
+        std::vector<uint32_t> order;
+        order.reserve(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            if (in_degree[i] == 0) {
+                order.push_back(i);
+            }
+        }
+        for (size_t head = 0; head < order.size(); ++head) {
+            uint32_t v = order[head];
+            if (next_in_worker[v] != UINT32_MAX && --in_degree[next_in_worker[v]] == 0) {
+                order.push_back(next_in_worker[v]);
+            }
+            for (uint32_t e = succ_offsets[v]; e < succ_offsets[v + 1]; ++e) {
+                if (--in_degree[succ[e]] == 0) {
+                    order.push_back(succ[e]);
+                }
+            }
+        }
+        if (order.size() != n) {
+            last_error_ = "Dependency cycle across streams (" +
+                          std::to_string(n - order.size()) + " operations blocked)";
+            return false;
+        }
+    }
+    
+    const size_t workers = worker_ops.size();
+    worker_count_ = workers;
+    
+    // Pacing: every worker waits against the same replay clock
+    const bool paced = config.scheduling == SchedulingPolicy::OriginalTiming;
+    PacingTimer timer(config.time_scale, config.timer_spin_ns);
+    if (paced) {
+        Timestamp origin = operations.front().event.timestamp;
+        for (const auto& op : operations) {
+            origin = std::min(origin, op.event.timestamp);
+        }
+        timer.start(origin);
+    }
+    std::vector<PacingTimer> timers(workers, timer);
+    std::vector<OperationExecutor> executors(workers, OperationExecutor(dry_run_));
+    for (auto& executor : executors) {
+        executor.setHook(config.on_execute);
+    }
+    
+    CompletionEvents events(n);
+    DrainSignal drain_signal;
+    std::vector<std::unique_ptr<RingBuffer<Completion>>> rings;
+    rings.reserve(workers);
+    for (size_t w = 0; w < workers; ++w) {
+        rings.push_back(std::make_unique<RingBuffer<Completion>>(
+            kCompletionRingCapacity, OverflowPolicy::Block));
+    }
+    
+    // Set by the first failure when pause_on_error is on; workers stop
+    // dispatching and retire their remaining operations as cancelled
+    std::atomic<bool> stop{false};
+    
+    auto worker = [&](size_t w) {
+        for (uint32_t i : worker_ops[w]) {
+            bool dependencies_ok = true;
+            for (uint32_t e = wait_offsets[i]; e < wait_offsets[i + 1]; ++e) {
+                dependencies_ok = events.wait(wait_sources[e]) && dependencies_ok;
+            }
+            
+            Outcome outcome;
+            if (stop.load(std::memory_order_acquire)) {
+                outcome = Outcome::Cancelled;
+            } else if (!dependencies_ok) {
+                outcome = Outcome::Blocked;
+            } else {
+                if (paced) {
+                    timers[w].waitUntil(operations[i].event.timestamp);
+                }
+                
+                start_times_[i] = getCurrentTimestamp();
+                bool success = executors[w].execute(operations[i]);
+                end_times_[i] = getCurrentTimestamp();
+                
+                outcome = success ? Outcome::Succeeded : Outcome::Failed;
+                if (!success && config.pause_on_error) {
+                    stop.store(true, std::memory_order_release);
+                }
+            }
+            
+            // Publish to the drainer before releasing dependents, so
+            // completions are drained in dependency order
+            rings[w]->push(Completion{i, outcome});
+            events.signal(i, outcome);
+            drain_signal.notify();
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (size_t w = 0; w < workers; ++w) {
+        threads.emplace_back(worker, w);
+    }
+    
+    // Drain completions on the calling thread
+    std::vector<Completion> batch;
+    size_t completed = 0;
+    while (completed < n) {
+        // Read before popping, so a push after the pop still wakes us
+        uint64_t seen = drain_signal.sequence();
+        batch.clear();
+        for (auto& ring : rings) {
+            ring->popBatch(batch, kCompletionRingCapacity);
+        }
+        if (batch.empty()) {
+            drain_signal.waitPast(seen);
+            continue;
+        }
+        for (const auto& completion : batch) {
+            switch (completion.outcome) {
+                case Outcome::Succeeded:
+                    on_complete(completion.index, true);
+                    break;
+                case Outcome::Failed:
+                    on_complete(completion.index, false);
+                    break;
+                case Outcome::Blocked:
+                    blocked_count_++;
+                    break;
+                default:
+                    cancelled_count_++;
+                    break;
+            }
+        }
+        completed += batch.size();
+    }
+    
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    for (size_t w = 0; w < workers; ++w) {
+        auto m = executors[w].getMetrics();
+        metrics_.operations_executed += m.operations_executed;
+        metrics_.kernels_executed += m.kernels_executed;
+        metrics_.memory_ops_executed += m.memory_ops_executed;
+        metrics_.sync_ops_executed += m.sync_ops_executed;
+        metrics_.total_execution_time += m.total_execution_time;
+    }
+    
+    if (paced) {
+        PacingTimer merged(config.time_scale, config.timer_spin_ns);
+        for (const auto& t : timers) {
+            merged.merge(t);
+        }
+        jitter_ = merged.jitterStats();
+    }
+    
+    return true;
+}
+
+} // namespace tracesmith
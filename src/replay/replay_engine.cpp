@@ -1,10 +1,52 @@
 #include "tracesmith/replay/replay_engine.hpp"
+#include "tracesmith/replay/pacing_timer.hpp"
+#include "tracesmith/replay/parallel_executor.hpp"
 #include <iostream>
 #include <algorithm>
 #include <map>
+#include <utility>
 
 namespace tracesmith {
 
+namespace {
+
+/// Fraction of [first start, last end] covered by two or more intervals
+double overlapFraction(const std::vector<std::pair<Timestamp, Timestamp>>& intervals) {
+    std::vector<std::pair<Timestamp, int>> edges;
+    edges.reserve(intervals.size() * 2);
+    Timestamp first = 0;
+    Timestamp last = 0;
+    
+    for (const auto& [start, end] : intervals) {
+        if (end <= start) {
+            continue;
+        }
+        if (edges.empty() || start < first) first = start;
+        if (edges.empty() || end > last) last = end;
+        edges.emplace_back(start, 1);
+        edges.emplace_back(end, -1);
+    }
+    if (edges.empty() || last <= first) {
+        return 0.0;
+    }
+    
+    // Ends sort before starts at the same time, so touching intervals don't overlap
+    std::sort(edges.begin(), edges.end());
+    
+    Timestamp overlapped = 0;
+    int active = 0;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (active >= 2 && i > 0) {
+            overlapped += edges[i].first - edges[i - 1].first;
+        }
+        active += edges[i].second;
+    }
+    
+    return static_cast<double>(overlapped) / static_cast<double>(last - first);
+}
+
+} // namespace
+
 ReplayEngine::ReplayEngine()
     : scheduler_(std::make_unique<StreamScheduler>())
     , executor_(std::make_unique<OperationExecutor>())
@@ -41,12 +83,16 @@ ReplayResult ReplayEngine::replay(const ReplayConfig& config) {
     
     // Reset components
     scheduler_->reset();
+    scheduler_->setPolicy(config.scheduling);
+    scheduler_->setStreamPriorities(config.stream_priorities);
     executor_->resetMetrics();
     checker_->reset();
     operations_.clear();
+    simulation_ = SimulationResult();
     
     // Set executor mode
     executor_->setDryRun(config.mode == ReplayMode::DryRun);
+    executor_->setHook(config.on_execute);
     
     // Prepare operations
     prepareOperations(config);
@@ -57,14 +103,36 @@ ReplayResult ReplayEngine::replay(const ReplayConfig& config) {
         return result;
     }
     
+    // Simulated stream layouts are applied before dependencies are built
+    if (config.mode == ReplayMode::Simulate && config.simulation.stream_assignment) {
+        for (auto& op : operations_) {
+            op.stream_id = config.simulation.stream_assignment(op);
+            op.event.stream_id = op.stream_id;
+        }
+    }
+    
     // Build dependencies
     buildDependencies();
     
+    if (config.mode == ReplayMode::Simulate) {
+        result = executeSimulation(config);
+        result.replay_duration = getCurrentTimestamp() - start_time;
+        return result;
+    }
+    
     // Add operations to scheduler
     scheduler_->addOperations(operations_);
     
     // Execute replay
-    result = executeReplay(config);
+    result = config.parallel_streams ? executeParallelReplay(config) : executeReplay(config);
+    result.operations_total = operations_.size();
+    
+    std::vector<std::pair<Timestamp, Timestamp>> captured;
+    captured.reserve(operations_.size());
+    for (const auto& op : operations_) {
+        captured.emplace_back(op.event.timestamp, op.event.timestamp + op.event.duration);
+    }
+    result.original_overlap = overlapFraction(captured);
     
     // Record timing
     Timestamp end_time = getCurrentTimestamp();
@@ -89,6 +157,172 @@ ReplayResult ReplayEngine::replay(const ReplayConfig& config) {
     return result;
 }
 
+ReplayResult ReplayEngine::replayStreaming(const std::string& filename, const ReplayConfig& config) {
+    ReplayResult result;
+    Timestamp start_time = getCurrentTimestamp();
+    
+    scheduler_->reset();
+    scheduler_->setPolicy(config.scheduling);
+    scheduler_->setStreamPriorities(config.stream_priorities);
+    executor_->resetMetrics();
+    checker_->reset();
+    operations_.clear();
+    simulation_ = SimulationResult();
+    executor_->setDryRun(config.mode == ReplayMode::DryRun);
+    executor_->setHook(config.on_execute);
+    
+    if (config.mode == ReplayMode::Simulate) {
+        result.errors.push_back("Simulation needs the whole trace; use loadTrace() and replay()");
+        return result;
+    }
+    
+    SBTReader reader(filename);
+    if (!reader.isOpen() || !reader.isValid()) {
+        result.errors.push_back("Failed to open SBT file: " + filename);
+        return result;
+    }
+    
+    if (config.parallel_streams) {
+        result.warnings.push_back("Parallel replay is not supported when streaming, replayed serially");
+    }
+    
+    const size_t window = std::max<size_t>(config.streaming_window, 1);
+    const bool paced = config.scheduling == SchedulingPolicy::OriginalTiming;
+    PacingTimer timer(config.time_scale, config.timer_spin_ns);
+    bool timer_started = false;
+    
+    std::vector<TraceEvent> batch;
+    std::vector<StreamOperation> pending;
+    std::map<uint32_t, size_t> last_op_per_stream;
+    size_t last_sync = 0;   // One past the last sync in pending (0 = none)
+    size_t op_id = 0;
+    uint64_t total_events = reader.eventCount();
+    bool failed = false;
+    
+    for (uint64_t offset = 0; offset < total_events && !failed; offset += window) {
+        batch.clear();
+        auto read = reader.readEvents(batch, static_cast<size_t>(offset), window);
+        if (!read) {
+            result.errors.push_back("Failed to read events: " + read.error_message);
+            break;
+        }
+        
+        for (auto& event : batch) {
+            StreamOperation op;
+            op.operation_id = op_id++;
+            op.device_id = event.device_id;
+            op.stream_id = event.stream_id;
+            op.event = std::move(event);
+            
+            if (!shouldIncludeOperation(op, config)) {
+                continue;
+            }
+            
+            // The sync frontier lives in last_op_per_stream, so dependencies
+            // reach back into retired windows and are dropped on submission
+            addDependencies(op, last_op_per_stream);
+            
+            if (paced && !timer_started) {
+                timer.start(op.event.timestamp);
+                timer_started = true;
+            }
+            
+            bool sync = op.event.type == EventType::StreamSync ||
+                        op.event.type == EventType::DeviceSync;
+            pending.push_back(std::move(op));
+            if (sync) {
+                last_sync = pending.size();
+            }
+        }
+        
+        bool last_batch = offset + window >= total_events;
+        if (pending.size() < window && !last_batch) {
+            continue;
+        }
+        
+        // Close the window after the last sync unless that carries over too much
+        size_t cut = pending.size();
+        if (!last_batch && last_sync > 0 && pending.size() - last_sync <= window) {
+            cut = last_sync;
+        }
+        
+        operations_.assign(std::make_move_iterator(pending.begin()),
+                           std::make_move_iterator(pending.begin() + cut));
+        pending.erase(pending.begin(), pending.begin() + cut);
+        last_sync = 0;
+        for (size_t i = 0; i < pending.size(); ++i) {
+            if (pending[i].event.type == EventType::StreamSync ||
+                pending[i].event.type == EventType::DeviceSync) {
+                last_sync = i + 1;
+            }
+        }
+        
+        // Failed operations only stop the run with pause_on_error, as in
+        // replay(); their dependents stay blocked within their window
+        executeWindow(config, timer, result);
+        failed = config.pause_on_error && result.operations_failed > 0;
+    }
+    
+    if (result.operations_total == 0 && result.errors.empty()) {
+        result.errors.push_back("No operations to replay");
+    }
+    
+    if (paced) {
+        result.dispatch_jitter = timer.jitterStats();
+    }
+    result.original_duration = executor_->getMetrics().total_execution_time;
+    result.replay_duration = getCurrentTimestamp() - start_time;
+    result.success = result.operations_failed == 0 && result.errors.empty();
+    
+    return result;
+}
+
+void ReplayEngine::executeWindow(const ReplayConfig& config, PacingTimer& timer, ReplayResult& total) {
+    if (operations_.empty()) {
+        return;
+    }
+    
+    // Everything before this window has completed
+    size_t window_start = operations_.front().operation_id;
+    for (auto& op : operations_) {
+        op.depends_on.erase(
+            std::remove_if(op.depends_on.begin(), op.depends_on.end(),
+                           [window_start](size_t dep) { return dep < window_start; }),
+            op.depends_on.end());
+    }
+    
+    // The scheduler takes ownership, so each operation is held once
+    size_t count = operations_.size();
+    scheduler_->reset();
+    scheduler_->reserve(count);
+    checker_->reset();
+    for (auto& op : operations_) {
+        checker_->recordOriginal(op);
+        scheduler_->addOperation(std::move(op));
+    }
+    
+    ReplayResult result = executeReplay(config, &timer);
+    
+    total.windows++;
+    total.operations_total += count;
+    total.operations_executed += result.operations_executed;
+    total.operations_failed += result.operations_failed;
+    total.errors.insert(total.errors.end(), result.errors.begin(), result.errors.end());
+    
+    if (config.validate_order) {
+        total.deterministic = checker_->validateOrder() && total.deterministic;
+        total.order_violations += checker_->getViolations().order_violations.size();
+    }
+    if (config.validate_dependencies) {
+        total.deterministic = checker_->validateDependencies() && total.deterministic;
+        total.dependency_violations += checker_->getViolations().dependency_violations.size();
+    }
+    
+    // Retire the window
+    operations_.clear();
+    scheduler_->reset();
+}
+
 void ReplayEngine::prepareOperations(const ReplayConfig& config) {
     size_t op_id = 0;
     
@@ -106,36 +340,55 @@ void ReplayEngine::prepareOperations(const ReplayConfig& config) {
 }
 
 void ReplayEngine::buildDependencies() {
+    std::map<uint32_t, size_t> last_op_per_stream;
+    for (auto& op : operations_) {
+        addDependencies(op, last_op_per_stream);
+    }
+}
+
+void ReplayEngine::addDependencies(StreamOperation& op, std::map<uint32_t, size_t>& last_op_per_stream) {
     // Build simple stream-based dependencies
     // Operations on the same stream depend on previous operations
-    std::map<uint32_t, size_t> last_op_per_stream;
+    uint32_t stream_id = op.stream_id;
     
-    for (auto& op : operations_) {
-        uint32_t stream_id = op.stream_id;
-        
-        // Depend on previous operation in same stream
-        if (last_op_per_stream.find(stream_id) != last_op_per_stream.end()) {
-            op.depends_on.push_back(last_op_per_stream[stream_id]);
-        }
-        
-        // Sync operations create dependencies across streams
-        if (op.event.type == EventType::StreamSync || 
-            op.event.type == EventType::DeviceSync) {
-            // Depend on all previous operations in all streams
-            for (const auto& [other_stream, last_id] : last_op_per_stream) {
-                if (other_stream != stream_id) {
-                    op.depends_on.push_back(last_id);
-                }
+    // Depend on previous operation in same stream
+    auto last = last_op_per_stream.find(stream_id);
+    if (last != last_op_per_stream.end()) {
+        op.depends_on.push_back(last->second);
+    }
+    
+    // Sync operations create dependencies across streams
+    if (op.event.type == EventType::StreamSync || 
+        op.event.type == EventType::DeviceSync) {
+        // Depend on all previous operations in all streams
+        for (const auto& [other_stream, last_id] : last_op_per_stream) {
+            if (other_stream != stream_id) {
+                op.depends_on.push_back(last_id);
             }
         }
-        
-        last_op_per_stream[stream_id] = op.operation_id;
     }
+    
+    last_op_per_stream[stream_id] = op.operation_id;
 }
 
-ReplayResult ReplayEngine::executeReplay(const ReplayConfig& config) {
+ReplayResult ReplayEngine::executeReplay(const ReplayConfig& config, PacingTimer* shared_timer) {
     ReplayResult result;
     
+    // OriginalTiming paces dispatch against the captured timeline
+    const bool paced = config.scheduling == SchedulingPolicy::OriginalTiming;
+    PacingTimer own_timer(config.time_scale, config.timer_spin_ns);
+    PacingTimer& timer = shared_timer ? *shared_timer : own_timer;
+    if (paced && !shared_timer) {
+        Timestamp origin = operations_.front().event.timestamp;
+        for (const auto& op : operations_) {
+            origin = std::min(origin, op.event.timestamp);
+        }
+        timer.start(origin);
+    }
+    
+    std::vector<std::pair<Timestamp, Timestamp>> executed;
+    executed.reserve(operations_.size());
+    
     while (!scheduler_->allCompleted()) {
         StreamOperation* op = scheduler_->getNextOperation();
         
@@ -145,8 +398,13 @@ ReplayResult ReplayEngine::executeReplay(const ReplayConfig& config) {
             size_t ready = scheduler_->readyCount();
             
             if (pending > 0 && ready == 0) {
-                result.errors.push_back("Deadlock detected: " + 
-                    std::to_string(pending) + " operations pending but none ready");
+                if (result.operations_failed == 0) {
+                    result.errors.push_back("Deadlock detected: " + 
+                        std::to_string(pending) + " operations pending but none ready");
+                } else {
+                    result.errors.push_back(std::to_string(pending) +
+                        " operations blocked by failed operations");
+                }
                 break;
             }
             
@@ -158,8 +416,14 @@ ReplayResult ReplayEngine::executeReplay(const ReplayConfig& config) {
             continue;
         }
         
+        if (paced) {
+            timer.waitUntil(op->event.timestamp);
+        }
+        
         // Execute operation
+        Timestamp exec_start = getCurrentTimestamp();
         bool success = executor_->execute(*op);
+        executed.emplace_back(exec_start, getCurrentTimestamp());
         
         if (success) {
             result.operations_executed++;
@@ -171,6 +435,7 @@ ReplayResult ReplayEngine::executeReplay(const ReplayConfig& config) {
             }
         } else {
             result.operations_failed++;
+            scheduler_->markFailed(op->operation_id);
             result.errors.push_back("Failed to execute operation " + 
                 std::to_string(op->operation_id) + ": " + op->event.name);
             
@@ -180,6 +445,11 @@ ReplayResult ReplayEngine::executeReplay(const ReplayConfig& config) {
         }
     }
     
+    if (paced && !shared_timer) {
+        result.dispatch_jitter = timer.jitterStats();
+    }
+    result.achieved_overlap = overlapFraction(executed);
+    
     // Get executor metrics
     auto metrics = executor_->getMetrics();
     result.original_duration = metrics.total_execution_time;
@@ -187,6 +457,104 @@ ReplayResult ReplayEngine::executeReplay(const ReplayConfig& config) {
     return result;
 }
 
+ReplayResult ReplayEngine::executeSimulation(const ReplayConfig& config) {
+    ReplayResult result;
+    result.operations_total = operations_.size();
+    
+    ReplaySimulator simulator(config.simulation);
+    simulation_ = simulator.run(operations_);
+    
+    result.operations_executed = simulation_.simulated_operations;
+    result.captured_makespan = simulation_.captured_makespan;
+    result.simulated_makespan = simulation_.makespan;
+    
+    std::vector<std::pair<Timestamp, Timestamp>> captured;
+    std::vector<std::pair<Timestamp, Timestamp>> predicted;
+    captured.reserve(operations_.size());
+    predicted.reserve(operations_.size());
+    for (size_t i = 0; i < operations_.size(); ++i) {
+        const auto& event = operations_[i].event;
+        captured.emplace_back(event.timestamp, event.timestamp + event.duration);
+        if (simulation_.start[i] != SimulationResult::kNotSimulated) {
+            predicted.emplace_back(simulation_.start[i], simulation_.end[i]);
+        }
+    }
+    result.original_overlap = overlapFraction(captured);
+    result.achieved_overlap = overlapFraction(predicted);
+    
+    if (simulation_.unresolved_dependencies > 0) {
+        result.warnings.push_back(std::to_string(simulation_.unresolved_dependencies) +
+            " dependencies on unknown operations were ignored");
+    }
+    if (simulation_.blocked_operations > 0) {
+        result.errors.push_back("Dependency cycle: " +
+            std::to_string(simulation_.blocked_operations) + " operations never became ready");
+    }
+    
+    result.success = simulation_.blocked_operations == 0;
+    return result;
+}
+
+std::vector<TraceEvent> ReplayEngine::getSimulatedTimeline() const {
+    return simulation_.toTraceEvents(operations_);
+}
+
+ReplayResult ReplayEngine::executeParallelReplay(const ReplayConfig& config) {
+    ReplayResult result;
+    ParallelReplayExecutor parallel(executor_->isDryRun());
+    
+    bool ran = parallel.run(operations_, config, [&](size_t index, bool success) {
+        const StreamOperation& op = operations_[index];
+        
+        if (success) {
+            result.operations_executed++;
+            scheduler_->markCompleted(op.operation_id);
+            
+            // Completion time as measured by the worker, not the drain order
+            if (StreamOperation* scheduled = scheduler_->getOperation(op.operation_id)) {
+                scheduled->execution_time = parallel.endTimes()[index];
+                checker_->recordReplayed(*scheduled);
+            }
+            
+            if (config.verbose) {
+                std::cout << "Executed: " << op.event.name << " (stream " << op.stream_id << ")\n";
+            }
+        } else {
+            result.operations_failed++;
+            scheduler_->markFailed(op.operation_id);
+            result.errors.push_back("Failed to execute operation " +
+                std::to_string(op.operation_id) + ": " + op.event.name);
+        }
+    });
+    
+    if (!ran) {
+        ReplayResult serial = executeReplay(config);
+        serial.warnings.push_back("Parallel replay unavailable, replayed serially: " +
+                                  parallel.lastError());
+        return serial;
+    }
+    
+    // Same report as serial replay; cancelled operations stay pending silently
+    if (parallel.blockedCount() > 0) {
+        result.errors.push_back(std::to_string(parallel.blockedCount()) +
+            " operations blocked by failed operations");
+    }
+    
+    // Operations that never ran keep an empty interval and are ignored
+    std::vector<std::pair<Timestamp, Timestamp>> executed;
+    executed.reserve(operations_.size());
+    for (size_t i = 0; i < operations_.size(); ++i) {
+        executed.emplace_back(parallel.startTimes()[i], parallel.endTimes()[i]);
+    }
+    
+    result.worker_threads = parallel.workerCount();
+    result.achieved_overlap = overlapFraction(executed);
+    result.dispatch_jitter = parallel.jitterStats();
+    result.original_duration = parallel.getMetrics().total_execution_time;
+    
+    return result;
+}
+
 bool ReplayEngine::shouldIncludeOperation(const StreamOperation& op, const ReplayConfig& config) {
     // Filter by mode
     if (config.mode == ReplayMode::StreamSpecific && config.stream_id) {
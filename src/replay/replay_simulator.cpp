@@ -0,0 +1,269 @@
+#include "tracesmith/replay/replay_simulator.hpp"
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <queue>
+
+namespace tracesmith {
+
+namespace {
+
+enum class SimEventKind : uint8_t {
+    Finish = 0,     // Processed first at equal times so freed engines are reused
+    Eligible = 1
+};
+
+struct SimEvent {
+    Timestamp time;
+    SimEventKind kind;
+    uint32_t op;
+    
+    bool operator>(const SimEvent& other) const {
+        if (time != other.time) return time > other.time;
+        if (kind != other.kind) return kind > other.kind;
+        return op > other.op;
+    }
+};
+
+/// One contended engine class on one device
+struct EnginePool {
+    uint32_t capacity = 0;  // 0 = unlimited
+    uint32_t busy = 0;
+    std::deque<uint32_t> waiting;
+};
+
+} // namespace
+
+// ============================================================================
+// ScaledCostModel
+// ============================================================================
+
+Timestamp ScaledCostModel::cost(const StreamOperation& op) const {
+    if (isSyncEvent(op.event.type)) {
+        return 0;
+    }
+    
+    double scale = default_scale_;
+    auto name_it = name_scales_.empty() ? name_scales_.end() : name_scales_.find(op.event.name);
+    if (name_it != name_scales_.end()) {
+        scale = name_it->second;
+    } else if (!type_scales_.empty()) {
+        auto type_it = type_scales_.find(static_cast<uint8_t>(op.event.type));
+        if (type_it != type_scales_.end()) {
+            scale = type_it->second;
+        }
+    }
+    
+    if (scale <= 0.0) {
+        return 0;
+    }
+    return static_cast<Timestamp>(static_cast<double>(op.event.duration) * scale + 0.5);
+}
+
+// ============================================================================
+// SimulationResult
+// ============================================================================
+
+std::vector<TraceEvent> SimulationResult::toTraceEvents(
+    const std::vector<StreamOperation>& operations) const {
+    std::vector<TraceEvent> events;
+    events.reserve(operations.size());
+    
+    for (size_t i = 0; i < operations.size() && i < start.size(); ++i) {
+        if (start[i] == kNotSimulated) {
+            continue;
+        }
+        TraceEvent event = operations[i].event;
+        event.timestamp = origin + start[i];
+        event.duration = end[i] - start[i];
+        event.device_id = operations[i].device_id;
+        event.stream_id = operations[i].stream_id;
+        events.push_back(std::move(event));
+    }
+    
+    return events;
+}
+
+// ============================================================================
+// ReplaySimulator
+// ============================================================================
+
+ReplaySimulator::ReplaySimulator(SimulationConfig config) : config_(std::move(config)) {}
+
+SimulationResult ReplaySimulator::run(const std::vector<StreamOperation>& operations) const {
+    SimulationResult result;
+    const uint32_t n = static_cast<uint32_t>(operations.size());
+    result.start.assign(n, SimulationResult::kNotSimulated);
+    result.end.assign(n, SimulationResult::kNotSimulated);
+    
+    if (n == 0) {
+        return result;
+    }
+    
+    // Captured bounds
+    Timestamp origin = operations[0].event.timestamp;
+    Timestamp captured_end = 0;
+    for (const auto& op : operations) {
+        origin = std::min(origin, op.event.timestamp);
+        captured_end = std::max(captured_end, op.event.timestamp + op.event.duration);
+    }
+    result.origin = origin;
+    result.captured_makespan = captured_end - origin;
+    
+    // Operation ID -> index
+    std::unordered_map<size_t, uint32_t> index_of;
+    index_of.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        index_of.emplace(operations[i].operation_id, i);
+    }
+    
+    // Successor CSR, in-degrees and captured launch gaps
+    std::vector<uint32_t> in_degree(n, 0);
+    std::vector<uint32_t> succ_offsets(n + 1, 0);
+    std::vector<uint32_t> dep_index;
+    std::vector<uint32_t> dep_offsets(n + 1, 0);
+    std::vector<Timestamp> gap(n, 0);
+    
+    for (uint32_t i = 0; i < n; ++i) {
+        const auto& op = operations[i];
+        Timestamp deps_end = origin;
+        
+        for (size_t dep_id : op.depends_on) {
+            auto it = index_of.find(dep_id);
+            if (it == index_of.end()) {
+                result.unresolved_dependencies++;
+                continue;
+            }
+            const auto& dep = operations[it->second].event;
+            deps_end = std::max(deps_end, dep.timestamp + dep.duration);
+            dep_index.push_back(it->second);
+            succ_offsets[it->second + 1]++;
+            in_degree[i]++;
+        }
+        dep_offsets[i + 1] = static_cast<uint32_t>(dep_index.size());
+        
+        if (config_.preserve_gaps && op.event.timestamp > deps_end) {
+            gap[i] = op.event.timestamp - deps_end;
+        }
+    }
+    
+    for (uint32_t i = 0; i < n; ++i) {
+        succ_offsets[i + 1] += succ_offsets[i];
+    }
+    std::vector<uint32_t> successors(dep_index.size());
+    {
+        std::vector<uint32_t> fill(succ_offsets.begin(), succ_offsets.end() - 1);
+        for (uint32_t i = 0; i < n; ++i) {
+            for (uint32_t e = dep_offsets[i]; e < dep_offsets[i + 1]; ++e) {
+                successors[fill[dep_index[e]]++] = i;
+            }
+        }
+    }
+    
+    // Costs, engines and per-device engine pools
+    std::vector<Timestamp> cost(n);
+    std::vector<SimEngine> engine(n);
+    std::vector<uint32_t> pool_of(n, UINT32_MAX);
+    std::unordered_map<uint32_t, uint32_t> device_index;
+    std::vector<EnginePool> pools;
+    
+    for (uint32_t i = 0; i < n; ++i) {
+        const auto& op = operations[i];
+        if (config_.cost_model) {
+            cost[i] = config_.cost_model->cost(op);
+            engine[i] = config_.cost_model->engine(op);
+        } else {
+            cost[i] = isSyncEvent(op.event.type) ? 0 : op.event.duration;
+            engine[i] = defaultSimEngine(op.event.type);
+        }
+        
+        if (engine[i] == SimEngine::None) {
+            continue;
+        }
+        auto [it, inserted] = device_index.emplace(op.device_id, static_cast<uint32_t>(device_index.size()));
+        if (inserted) {
+            EnginePool compute;
+            compute.capacity = config_.compute_slots;
+            EnginePool copy;
+            copy.capacity = config_.copy_engines;
+            pools.push_back(std::move(compute));
+            pools.push_back(std::move(copy));
+        }
+        pool_of[i] = it->second * 2 + (engine[i] == SimEngine::Copy ? 1 : 0);
+    }
+    
+    // Event loop on the virtual clock
+    std::priority_queue<SimEvent, std::vector<SimEvent>, std::greater<SimEvent>> queue;
+    std::vector<Timestamp> ready(n, 0);
+    std::vector<Timestamp> eligible_at(n, 0);
+    
+    for (uint32_t i = 0; i < n; ++i) {
+        if (in_degree[i] == 0) {
+            Timestamp offset = config_.preserve_gaps ? operations[i].event.timestamp - origin : 0;
+            queue.push({offset, SimEventKind::Eligible, i});
+        }
+    }
+    
+    auto startOp = [&](uint32_t i, Timestamp now) {
+        result.start[i] = now;
+        if (engine[i] == SimEngine::Compute) {
+            result.compute_busy_time += cost[i];
+        } else if (engine[i] == SimEngine::Copy) {
+            result.copy_busy_time += cost[i];
+        }
+        queue.push({now + cost[i], SimEventKind::Finish, i});
+    };
+    
+    while (!queue.empty()) {
+        SimEvent ev = queue.top();
+        queue.pop();
+        const uint32_t i = ev.op;
+        const Timestamp now = ev.time;
+        
+        if (ev.kind == SimEventKind::Eligible) {
+            eligible_at[i] = now;
+            if (pool_of[i] == UINT32_MAX) {
+                startOp(i, now);
+                continue;
+            }
+            EnginePool& pool = pools[pool_of[i]];
+            if (pool.capacity == 0 || pool.busy < pool.capacity) {
+                pool.busy++;
+                startOp(i, now);
+            } else {
+                pool.waiting.push_back(i);
+            }
+            continue;
+        }
+        
+        // Finish: hand the engine to the next waiting op, then release dependents
+        result.end[i] = now;
+        result.simulated_operations++;
+        result.makespan = std::max(result.makespan, now);
+        
+        if (pool_of[i] != UINT32_MAX) {
+            EnginePool& pool = pools[pool_of[i]];
+            if (!pool.waiting.empty()) {
+                uint32_t next = pool.waiting.front();
+                pool.waiting.pop_front();
+                result.contention_wait_time += now - eligible_at[next];
+                startOp(next, now);
+            } else {
+                pool.busy--;
+            }
+        }
+        
+        for (uint32_t e = succ_offsets[i]; e < succ_offsets[i + 1]; ++e) {
+            uint32_t s = successors[e];
+            ready[s] = std::max(ready[s], now);
+            if (--in_degree[s] == 0) {
+                queue.push({ready[s] + gap[s], SimEventKind::Eligible, s});
+            }
+        }
+    }
+    
+    result.blocked_operations = n - result.simulated_operations;
+    return result;
+}
+
+} // namespace tracesmith
@@ -5,93 +5,233 @@ namespace tracesmith {
 
 StreamScheduler::StreamScheduler(SchedulingPolicy policy) : policy_(policy) {}
 
+void StreamScheduler::setPolicy(SchedulingPolicy policy) {
+    if (policy == policy_) {
+        return;
+    }
+    policy_ = policy;
+    rebuildReadyQueues();
+}
+
+void StreamScheduler::setStreamPriority(uint32_t stream_id, int priority) {
+    stream_priorities_[stream_id] = priority;
+    if (policy_ == SchedulingPolicy::Priority && ready_count_ > 0) {
+        rebuildReadyQueues();
+    }
+}
+
+void StreamScheduler::setStreamPriorities(const std::map<uint32_t, int>& priorities) {
+    stream_priorities_.clear();
+    stream_priorities_.insert(priorities.begin(), priorities.end());
+    if (policy_ == SchedulingPolicy::Priority && ready_count_ > 0) {
+        rebuildReadyQueues();
+    }
+}
+
+int StreamScheduler::streamPriority(uint32_t stream_id) const {
+    auto it = stream_priorities_.find(stream_id);
+    return it == stream_priorities_.end() ? 0 : it->second;
+}
+
 void StreamScheduler::addOperation(const StreamOperation& op) {
-    operations_[op.operation_id] = op;
+    addOperation(StreamOperation(op));
+}
+
+void StreamScheduler::addOperation(StreamOperation&& op) {
+    const size_t op_id = op.operation_id;
+    if (findSlot(op_id) != kInvalidSlot) {
+        return;
+    }
+    
+    const uint32_t slot = static_cast<uint32_t>(operations_.size());
+    operations_.push_back(std::move(op));
+    unmet_deps_.push_back(0);
+    first_dependent_.push_back(kInvalidSlot);
+    registerSlot(op_id, slot);
+    
+    StreamOperation& stored = operations_[slot];
+    stored.dependencies_satisfied = false;
+    if (isDone(stored)) {
+        completed_count_++;
+    }
     
     // Track dependencies
-    for (size_t dep_id : op.depends_on) {
-        dependents_[dep_id].push_back(op.operation_id);
+    for (size_t dep_id : stored.depends_on) {
+        uint32_t dep_slot = findSlot(dep_id);
+        if (dep_slot == kInvalidSlot) {
+            waiting_on_[dep_id].push_back(slot);
+            unmet_deps_[slot]++;
+        } else if (!isDone(operations_[dep_slot])) {
+            addDependent(dep_slot, slot);
+            unmet_deps_[slot]++;
+        }
+    }
+    
+    // Hook up operations added earlier that depend on this one
+    if (!waiting_on_.empty()) {
+        auto it = waiting_on_.find(op_id);
+        if (it != waiting_on_.end()) {
+            for (uint32_t waiting : it->second) {
+                if (!isDone(stored)) {
+                    addDependent(slot, waiting);
+                } else if (--unmet_deps_[waiting] == 0 && !isDone(operations_[waiting])) {
+                    addToReadyQueue(waiting);
+                }
+            }
+            waiting_on_.erase(it);
+        }
     }
     
     // If no dependencies, add to ready queue
-    if (op.depends_on.empty()) {
-        addToReadyQueue(op.operation_id);
+    if (unmet_deps_[slot] == 0 && !isDone(stored)) {
+        addToReadyQueue(slot);
     }
 }
 
 void StreamScheduler::addOperations(const std::vector<StreamOperation>& ops) {
+    reserve(operations_.size() + ops.size());
+    
     for (const auto& op : ops) {
         addOperation(op);
     }
 }
 
+void StreamScheduler::reserve(size_t count) {
+    operations_.reserve(count);
+    unmet_deps_.reserve(count);
+    first_dependent_.reserve(count);
+    dense_slots_.reserve(count);
+    dependent_links_.reserve(count);
+}
+
 StreamOperation* StreamScheduler::getNextOperation() {
-    if (ready_queue_.empty()) {
+    if (ready_count_ == 0) {
         return nullptr;
     }
     
-    // Use priority selection (timestamp order)
-    size_t next_id = selectNextPriority();
-    
-    // Check if operation exists (next_id can be 0 which is valid)
-    auto it = operations_.find(next_id);
-    if (it == operations_.end()) {
-        return nullptr;
+    uint32_t slot = kInvalidSlot;
+    switch (policy_) {
+        case SchedulingPolicy::RoundRobin:
+            slot = selectNextRoundRobin();
+            break;
+        case SchedulingPolicy::Priority:
+            slot = selectNextPriority();
+            break;
+        case SchedulingPolicy::OriginalTiming:
+            slot = selectNextOriginalTiming();
+            break;
     }
     
-    return &it->second;
+    return slot == kInvalidSlot ? nullptr : &operations_[slot];
+}
+
+StreamOperation* StreamScheduler::getOperation(size_t operation_id) {
+    uint32_t slot = findSlot(operation_id);
+    return slot == kInvalidSlot ? nullptr : &operations_[slot];
 }
 
 void StreamScheduler::markCompleted(size_t operation_id) {
-    auto it = operations_.find(operation_id);
-    if (it == operations_.end()) {
+    uint32_t slot = findSlot(operation_id);
+    if (slot == kInvalidSlot) {
         return;
     }
     
-    it->second.executed = true;
-    it->second.execution_time = getCurrentTimestamp();
+    StreamOperation& op = operations_[slot];
+    if (isDone(op)) {
+        return;
+    }
     
-    // Remove from ready queue
-    ready_queue_.erase(
-        std::remove(ready_queue_.begin(), ready_queue_.end(), operation_id),
-        ready_queue_.end()
-    );
+    op.executed = true;
+    op.execution_time = getCurrentTimestamp();
+    retire(slot);
     
     // Update dependent operations
-    updateDependencies(operation_id);
+    updateDependencies(slot);
+}
+
+void StreamScheduler::markFailed(size_t operation_id) {
+    uint32_t slot = findSlot(operation_id);
+    if (slot == kInvalidSlot) {
+        return;
+    }
+    
+    StreamOperation& op = operations_[slot];
+    if (isDone(op)) {
+        return;
+    }
+    
+    // Leaves dependents blocked: they never become ready
+    op.skipped = true;
+    retire(slot);
+}
+
+void StreamScheduler::retire(uint32_t slot) {
+    completed_count_++;
+    
+    // Remove from ready queue; entries not at the head are skipped lazily
+    if (unmet_deps_[slot] == 0) {
+        ready_count_--;
+        if (policy_ == SchedulingPolicy::RoundRobin) {
+            // Dispatched stream goes to the back of the rotation
+            if (!stream_rotation_.empty()) {
+                uint32_t queue = stream_rotation_.front();
+                auto& ready = stream_queues_[queue];
+                if (!ready.empty() && ready.front() == slot) {
+                    ready.pop_front();
+                    stream_rotation_.pop_front();
+                    if (ready.empty()) {
+                        stream_in_rotation_[queue] = 0;
+                    } else {
+                        stream_rotation_.push_back(queue);
+                    }
+                }
+            }
+        } else if (!ready_queue_.empty() && ready_queue_.top().slot == slot) {
+            ready_queue_.pop();
+        }
+    }
 }
 
 bool StreamScheduler::allCompleted() const {
-    return std::all_of(operations_.begin(), operations_.end(),
-        [](const auto& pair) { return pair.second.executed || pair.second.skipped; });
+    return completed_count_ == operations_.size();
 }
 
 size_t StreamScheduler::pendingCount() const {
-    return std::count_if(operations_.begin(), operations_.end(),
-        [](const auto& pair) { return !pair.second.executed && !pair.second.skipped; });
+    return operations_.size() - completed_count_;
 }
 
 size_t StreamScheduler::readyCount() const {
-    return ready_queue_.size();
+    return ready_count_;
 }
 
 void StreamScheduler::reset() {
     operations_.clear();
-    ready_queue_.clear();
+    unmet_deps_.clear();
+    first_dependent_.clear();
+    dependent_links_.clear();
+    dense_slots_.clear();
+    sparse_slots_.clear();
+    id_base_ = 0;
+    waiting_on_.clear();
+    ready_queue_ = decltype(ready_queue_)();
+    ready_count_ = 0;
+    completed_count_ = 0;
+    stream_index_.clear();
     stream_queues_.clear();
-    dependents_.clear();
-    round_robin_index_ = 0;
+    stream_in_rotation_.clear();
+    stream_rotation_.clear();
 }
 
 StreamScheduler::Statistics StreamScheduler::getStatistics() const {
     Statistics stats;
     stats.total_operations = operations_.size();
-    stats.ready_operations = ready_queue_.size();
+    stats.ready_operations = ready_count_;
     
-    for (const auto& [id, op] : operations_) {
+    for (size_t slot = 0; slot < operations_.size(); ++slot) {
+        const auto& op = operations_[slot];
         if (op.executed) {
             stats.completed_operations++;
-        } else if (!op.dependencies_satisfied) {
+        } else if (!op.skipped && unmet_deps_[slot] > 0) {
             stats.blocked_operations++;
         }
         
@@ -101,74 +241,129 @@ StreamScheduler::Statistics StreamScheduler::getStatistics() const {
     return stats;
 }
 
-void StreamScheduler::updateDependencies(size_t completed_id) {
-    auto it = dependents_.find(completed_id);
-    if (it == dependents_.end()) {
-        return;
+uint32_t StreamScheduler::findSlot(size_t operation_id) const {
+    size_t index = operation_id - id_base_;
+    if (operation_id >= id_base_ && index < dense_slots_.size() && dense_slots_[index] != kInvalidSlot) {
+        return dense_slots_[index];
+    }
+    if (sparse_slots_.empty()) {
+        return kInvalidSlot;
+    }
+    auto it = sparse_slots_.find(operation_id);
+    return it == sparse_slots_.end() ? kInvalidSlot : it->second;
+}
+
+void StreamScheduler::registerSlot(size_t operation_id, uint32_t slot) {
+    // IDs are indexed relative to the first one added, so a window of a
+    // long trace (IDs starting far from 0) still uses the direct table
+    if (operations_.size() == 1) {
+        id_base_ = operation_id;
     }
     
-    // Check all operations that depend on this one
-    for (size_t dependent_id : it->second) {
-        auto& dep_op = operations_[dependent_id];
-        
-        // Check if all dependencies are now satisfied
-        bool all_satisfied = true;
-        for (size_t dep_id : dep_op.depends_on) {
-            if (!operations_[dep_id].executed) {
-                all_satisfied = false;
-                break;
-            }
+    // Keep the direct-indexed table at most ~2x the operation count
+    size_t index = operation_id - id_base_;
+    if (operation_id >= id_base_ && index < 2 * operations_.size() + 1024) {
+        if (index >= dense_slots_.size()) {
+            dense_slots_.resize(std::max(index + 1, dense_slots_.size() * 3 / 2), kInvalidSlot);
         }
+        dense_slots_[index] = slot;
+    } else {
+        sparse_slots_[operation_id] = slot;
+    }
+}
+
+void StreamScheduler::addDependent(uint32_t dependency_slot, uint32_t dependent_slot) {
+    dependent_links_.push_back({dependent_slot, first_dependent_[dependency_slot]});
+    first_dependent_[dependency_slot] = static_cast<uint32_t>(dependent_links_.size() - 1);
+}
+
+void StreamScheduler::updateDependencies(uint32_t completed_slot) {
+    for (uint32_t link = first_dependent_[completed_slot]; link != kInvalidSlot;
+         link = dependent_links_[link].next) {
+        uint32_t dependent = dependent_links_[link].slot;
         
-        if (all_satisfied && !dep_op.dependencies_satisfied) {
-            dep_op.dependencies_satisfied = true;
-            addToReadyQueue(dependent_id);
+        if (unmet_deps_[dependent] > 0 && --unmet_deps_[dependent] == 0 &&
+            !isDone(operations_[dependent])) {
+            addToReadyQueue(dependent);
         }
     }
 }
 
-void StreamScheduler::addToReadyQueue(size_t op_id) {
-    auto& op = operations_[op_id];
-    op.dependencies_satisfied = true;
+void StreamScheduler::addToReadyQueue(uint32_t slot) {
+    operations_[slot].dependencies_satisfied = true;
+    ready_count_++;
+    enqueueReady(slot);
+}
+
+void StreamScheduler::enqueueReady(uint32_t slot) {
+    const auto& op = operations_[slot];
     
-    ready_queue_.push_back(op_id);
+    if (policy_ != SchedulingPolicy::RoundRobin) {
+        int priority = policy_ == SchedulingPolicy::Priority ? streamPriority(op.stream_id) : 0;
+        ready_queue_.push({priority, op.event.timestamp, op.operation_id, slot});
+        return;
+    }
     
     // Add to stream-specific queue for round-robin
-    stream_queues_[op.stream_id].push(op_id);
+    auto [it, inserted] = stream_index_.emplace(op.stream_id, static_cast<uint32_t>(stream_queues_.size()));
+    if (inserted) {
+        stream_queues_.emplace_back();
+        stream_in_rotation_.push_back(0);
+    }
+    uint32_t queue = it->second;
+    stream_queues_[queue].push_back(slot);
+    if (!stream_in_rotation_[queue]) {
+        stream_in_rotation_[queue] = 1;
+        stream_rotation_.push_back(queue);
+    }
 }
 
-size_t StreamScheduler::selectNextRoundRobin() {
-    // Fall back to priority selection if ready queue is available
-    if (ready_queue_.empty()) {
-        return 0;
+void StreamScheduler::rebuildReadyQueues() {
+    ready_queue_ = decltype(ready_queue_)();
+    for (auto& queue : stream_queues_) {
+        queue.clear();
     }
+    std::fill(stream_in_rotation_.begin(), stream_in_rotation_.end(), 0);
+    stream_rotation_.clear();
     
-    // Use priority selection (timestamp order) for simplicity and correctness
-    return selectNextPriority();
+    for (uint32_t slot = 0; slot < operations_.size(); ++slot) {
+        if (unmet_deps_[slot] == 0 && !isDone(operations_[slot])) {
+            enqueueReady(slot);
+        }
+    }
 }
 
-size_t StreamScheduler::selectNextPriority() {
-    // For now, prioritize by timestamp (earliest first)
-    if (ready_queue_.empty()) {
-        return 0;
+uint32_t StreamScheduler::selectNextRoundRobin() {
+    // Head of the first stream in the rotation; streams whose queue only
+    // held out-of-order completions drop out
+    while (!stream_rotation_.empty()) {
+        uint32_t queue = stream_rotation_.front();
+        auto& ready = stream_queues_[queue];
+        while (!ready.empty() && isDone(operations_[ready.front()])) {
+            ready.pop_front();
+        }
+        if (!ready.empty()) {
+            return ready.front();
+        }
+        stream_rotation_.pop_front();
+        stream_in_rotation_[queue] = 0;
     }
     
-    size_t earliest_id = ready_queue_[0];
-    Timestamp earliest_time = operations_[earliest_id].event.timestamp;
-    
-    for (size_t op_id : ready_queue_) {
-        Timestamp t = operations_[op_id].event.timestamp;
-        if (t < earliest_time) {
-            earliest_time = t;
-            earliest_id = op_id;
-        }
+    return kInvalidSlot;
+}
+
+uint32_t StreamScheduler::selectNextPriority() {
+    // Highest stream priority, then earliest timestamp, dropping entries of
+    // operations that were completed out of order
+    while (!ready_queue_.empty() && isDone(operations_[ready_queue_.top().slot])) {
+        ready_queue_.pop();
     }
     
-    return earliest_id;
+    return ready_queue_.empty() ? kInvalidSlot : ready_queue_.top().slot;
 }
 
-size_t StreamScheduler::selectNextOriginalTiming() {
-    // Same as priority for now - execute in original timestamp order
+uint32_t StreamScheduler::selectNextOriginalTiming() {
+    // Original timestamp order; all heap entries carry priority 0
     return selectNextPriority();
 }
 
@@ -0,0 +1,235 @@
+#include "tracesmith/state/critical_path.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace tracesmith {
+
+namespace {
+
+constexpr uint32_t kNoNode = InstructionStreamBuilder::kInvalidNode;
+
+} // namespace
+
+CriticalPathAnalyzer::CriticalPathAnalyzer(const InstructionStreamBuilder& graph)
+    : graph_(graph) {
+    const uint32_t n = static_cast<uint32_t>(graph_.nodeCount());
+    const auto& in_offsets = graph_.inOffsets();
+    const auto& in_sources = graph_.inSources();
+    const auto& out_offsets = graph_.outOffsets();
+    const auto& out_targets = graph_.outTargets();
+    const bool has_edges = in_offsets.size() == static_cast<size_t>(n) + 1;
+    
+    gap_.resize(n);
+    duration_.resize(n);
+    name_id_.resize(n);
+    
+    Timestamp trace_start = std::numeric_limits<Timestamp>::max();
+    for (uint32_t i = 0; i < n; ++i) {
+        trace_start = std::min(trace_start, graph_.nodeEvent(i).timestamp);
+    }
+    
+    for (uint32_t i = 0; i < n; ++i) {
+        const TraceEvent& event = graph_.nodeEvent(i);
+        duration_[i] = event.duration;
+        
+        // Gap: captured start minus the time the last dependency finished
+        Timestamp ready = trace_start;
+        if (has_edges) {
+            for (uint32_t e = in_offsets[i]; e < in_offsets[i + 1]; ++e) {
+                const TraceEvent& dep = graph_.nodeEvent(in_sources[e]);
+                ready = std::max(ready, dep.timestamp + dep.duration);
+            }
+        }
+        gap_[i] = event.timestamp > ready ? event.timestamp - ready : 0;
+        
+        auto [it, inserted] = name_index_.emplace(event.name, static_cast<uint32_t>(names_.size()));
+        if (inserted) {
+            names_.push_back(event.name);
+        }
+        name_id_[i] = it->second;
+    }
+    
+    // Kahn's algorithm over the CSR arrays
+    std::vector<uint32_t> in_degree(n, 0);
+    if (has_edges) {
+        for (uint32_t i = 0; i < n; ++i) {
+            in_degree[i] = in_offsets[i + 1] - in_offsets[i];
+        }
+    }
+    
+    topo_order_.reserve(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        if (in_degree[i] == 0) {
+            topo_order_.push_back(i);
+        }
+    }
+    for (size_t head = 0; head < topo_order_.size() && has_edges; ++head) {
+        uint32_t v = topo_order_[head];
+        for (uint32_t e = out_offsets[v]; e < out_offsets[v + 1]; ++e) {
+            if (--in_degree[out_targets[e]] == 0) {
+                topo_order_.push_back(out_targets[e]);
+            }
+        }
+    }
+    
+    base_makespan_ = forwardPass(duration_, nullptr, nullptr);
+}
+
+Timestamp CriticalPathAnalyzer::forwardPass(const std::vector<Timestamp>& duration,
+                                            std::vector<Timestamp>* finish,
+                                            std::vector<uint32_t>* critical_pred) const {
+    const auto& in_offsets = graph_.inOffsets();
+    const auto& in_sources = graph_.inSources();
+    const bool has_edges = in_offsets.size() == graph_.nodeCount() + 1;
+    
+    std::vector<Timestamp> local_finish;
+    std::vector<Timestamp>& eft = finish ? *finish : local_finish;
+    eft.assign(graph_.nodeCount(), 0);
+    if (critical_pred) {
+        critical_pred->assign(graph_.nodeCount(), kNoNode);
+    }
+    
+    Timestamp makespan = 0;
+    for (uint32_t v : topo_order_) {
+        Timestamp start = 0;
+        uint32_t pred = kNoNode;
+        
+        if (has_edges) {
+            for (uint32_t e = in_offsets[v]; e < in_offsets[v + 1]; ++e) {
+                uint32_t u = in_sources[e];
+                if (pred == kNoNode || eft[u] > start) {
+                    start = eft[u];
+                    pred = u;
+                }
+            }
+        }
+        
+        eft[v] = start + gap_[v] + duration[v];
+        if (critical_pred) {
+            (*critical_pred)[v] = pred;
+        }
+        makespan = std::max(makespan, eft[v]);
+    }
+    
+    return makespan;
+}
+
+CriticalPathResult CriticalPathAnalyzer::analyze() const {
+    CriticalPathResult result;
+    const uint32_t n = static_cast<uint32_t>(graph_.nodeCount());
+    result.unreachable_nodes = n - topo_order_.size();
+    result.slack.assign(n, 0);
+    
+    if (topo_order_.empty()) {
+        return result;
+    }
+    
+    std::vector<Timestamp> finish;
+    std::vector<uint32_t> pred;
+    result.makespan = forwardPass(duration_, &finish, &pred);
+    
+    // Walk back from the last node to finish (ties go to the later node so
+    // zero-length syncs closing the trace stay on the path)
+    uint32_t last = topo_order_.front();
+    for (uint32_t v : topo_order_) {
+        if (finish[v] >= finish[last]) {
+            last = v;
+        }
+    }
+    
+    std::vector<uint32_t> path;
+    for (uint32_t v = last; v != kNoNode; v = pred[v]) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+    
+    result.path.reserve(path.size());
+    for (uint32_t v : path) {
+        const TraceEvent& event = graph_.nodeEvent(v);
+        
+        CriticalPathEntry entry;
+        entry.correlation_id = event.correlation_id;
+        entry.name = event.name;
+        entry.type = event.type;
+        entry.stream_id = event.stream_id;
+        entry.duration = duration_[v];
+        entry.gap = gap_[v];
+        entry.start = finish[v] - duration_[v];
+        result.path.push_back(std::move(entry));
+        
+        result.path_busy_time += duration_[v];
+        result.path_gap_time += gap_[v];
+        result.path_time_by_name[event.name] += duration_[v];
+    }
+    
+    // Backward pass: latest finish time that does not delay the makespan
+    const auto& out_offsets = graph_.outOffsets();
+    const auto& out_targets = graph_.outTargets();
+    const bool has_edges = out_offsets.size() == static_cast<size_t>(n) + 1;
+    
+    std::vector<Timestamp> latest_finish(n, result.makespan);
+    for (auto it = topo_order_.rbegin(); it != topo_order_.rend(); ++it) {
+        uint32_t v = *it;
+        if (has_edges) {
+            for (uint32_t e = out_offsets[v]; e < out_offsets[v + 1]; ++e) {
+                uint32_t s = out_targets[e];
+                Timestamp latest_start = latest_finish[s] - duration_[s] - gap_[s];
+                latest_finish[v] = std::min(latest_finish[v], latest_start);
+            }
+        }
+        result.slack[v] = latest_finish[v] > finish[v] ? latest_finish[v] - finish[v] : 0;
+    }
+    
+    return result;
+}
+
+WhatIfResult CriticalPathAnalyzer::whatIf(const std::string& name, double speedup) const {
+    WhatIfResult result;
+    result.name = name;
+    result.speedup = speedup;
+    result.original_makespan = base_makespan_;
+    result.predicted_makespan = base_makespan_;
+    
+    auto it = name_index_.find(name);
+    if (it == name_index_.end() || speedup <= 0.0) {
+        return result;
+    }
+    
+    std::vector<Timestamp> scaled = duration_;
+    for (size_t i = 0; i < scaled.size(); ++i) {
+        if (name_id_[i] == it->second) {
+            scaled[i] = static_cast<Timestamp>(static_cast<double>(scaled[i]) / speedup + 0.5);
+            result.affected_operations++;
+        }
+    }
+    
+    result.predicted_makespan = forwardPass(scaled, nullptr, nullptr);
+    return result;
+}
+
+std::vector<WhatIfResult> CriticalPathAnalyzer::rankSpeedups(double speedup, size_t top_n) const {
+    auto critical = analyze();
+    
+    std::vector<std::pair<std::string, Timestamp>> candidates(
+        critical.path_time_by_name.begin(), critical.path_time_by_name.end());
+    std::sort(candidates.begin(), candidates.end(),
+              [](const auto& a, const auto& b) { return a.second > b.second; });
+    if (candidates.size() > top_n) {
+        candidates.resize(top_n);
+    }
+    
+    std::vector<WhatIfResult> results;
+    results.reserve(candidates.size());
+    for (const auto& candidate : candidates) {
+        results.push_back(whatIf(candidate.first, speedup));
+    }
+    
+    std::stable_sort(results.begin(), results.end(),
+                     [](const WhatIfResult& a, const WhatIfResult& b) {
+                         return a.reduction() > b.reduction();
+                     });
+    
+    return results;
+}
+
+} // namespace tracesmith
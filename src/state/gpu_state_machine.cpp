@@ -1,4 +1,5 @@
 #include "tracesmith/state/gpu_state_machine.hpp"
+#include "tracesmith/common/parallel.hpp"
 #include <algorithm>
 
 namespace tracesmith {
@@ -142,11 +143,47 @@ void GPUStateMachine::processEvent(const TraceEvent& event) {
 }
 
 void GPUStateMachine::processEvents(const std::vector<TraceEvent>& events) {
+    size_t num_threads = resolveThreadCount(num_threads_);
+    if (num_threads > 1) {
+        processEventsParallel(events, num_threads);
+        return;
+    }
+    
     for (const auto& event : events) {
         processEvent(event);
     }
 }
 
+void GPUStateMachine::processEventsParallel(const std::vector<TraceEvent>& events,
+                                            size_t num_threads) {
+    // Partition events by (device, stream), preserving per-stream order.
+    // Stream states are created up front on this thread so workers never
+    // touch stream_states_ itself, only their own GPUStreamState.
+    std::map<std::pair<uint32_t, uint32_t>, size_t> partition_index;
+    std::vector<GPUStreamState*> targets;
+    std::vector<std::vector<const TraceEvent*>> partitions;
+    
+    for (const auto& event : events) {
+        auto key = std::make_pair(event.device_id, event.stream_id);
+        auto it = partition_index.find(key);
+        if (it == partition_index.end()) {
+            it = partition_index.emplace(key, partitions.size()).first;
+            targets.push_back(&getOrCreateStreamState(event.device_id, event.stream_id));
+            partitions.emplace_back();
+        }
+        partitions[it->second].push_back(&event);
+    }
+    
+    parallelFor(partitions.size(), num_threads, [&](size_t i) {
+        GPUStreamState* state = targets[i];
+        for (const TraceEvent* event : partitions[i]) {
+            state->processEvent(*event);
+        }
+    });
+    
+    event_count_ += events.size();
+}
+
 GPUStreamState* GPUStateMachine::getStreamState(uint32_t device_id, uint32_t stream_id) {
     auto key = std::make_pair(device_id, stream_id);
     auto it = stream_states_.find(key);
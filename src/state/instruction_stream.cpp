@@ -1,5 +1,7 @@
 #include "tracesmith/state/instruction_stream.hpp"
+#include "tracesmith/common/parallel.hpp"
 #include <algorithm>
+#include <numeric>
 #include <sstream>
 
 namespace tracesmith {
@@ -9,15 +11,52 @@ void InstructionStreamBuilder::addEvent(const TraceEvent& event) {
         return;  // Invalid event
     }
     
+    // A repeated correlation ID replaces the earlier event in place
+    auto it = node_index_.find(event.correlation_id);
+    if (it != node_index_.end()) {
+        uint32_t index = it->second;
+        StreamKey old_key(events_[index].device_id, events_[index].stream_id);
+        events_[index] = event;
+        StreamKey new_key(event.device_id, event.stream_id);
+        if (old_key != new_key) {
+            moveToStream(index, old_key, new_key);
+        }
+        return;
+    }
+    
     // Create node
-    InstructionNode node(event);
-    nodes_[event.correlation_id] = node;
+    uint32_t index = static_cast<uint32_t>(events_.size());
+    events_.push_back(event);
+    node_index_.emplace(event.correlation_id, index);
     
-    // Track per-stream
-    streams_[event.stream_id].push_back(event.correlation_id);
+    // Track per (device, stream)
+    streams_[StreamKey(event.device_id, event.stream_id)].push_back(index);
+}
+
+void InstructionStreamBuilder::moveToStream(uint32_t index, const StreamKey& from,
+                                            const StreamKey& to) {
+    // Per-stream lists are in node index (insertion) order, which is the
+    // order sequential edges follow; keep both lists sorted.
+    auto from_it = streams_.find(from);
+    if (from_it != streams_.end()) {
+        auto& ops = from_it->second;
+        auto pos = std::lower_bound(ops.begin(), ops.end(), index);
+        if (pos != ops.end() && *pos == index) {
+            ops.erase(pos);
+        }
+        if (ops.empty()) {
+            streams_.erase(from_it);
+        }
+    }
+    
+    auto& ops = streams_[to];
+    ops.insert(std::lower_bound(ops.begin(), ops.end(), index), index);
 }
 
 void InstructionStreamBuilder::addEvents(const std::vector<TraceEvent>& events) {
+    events_.reserve(events_.size() + events.size());
+    node_index_.reserve(node_index_.size() + events.size());
+    
     for (const auto& event : events) {
         addEvent(event);
     }
@@ -25,11 +64,7 @@ void InstructionStreamBuilder::addEvents(const std::vector<TraceEvent>& events)
 
 void InstructionStreamBuilder::analyze() {
     // Clear previous analysis
-    dependencies_.clear();
-    for (auto& pair : nodes_) {
-        pair.second.dependencies.clear();
-        pair.second.dependents.clear();
-    }
+    edges_.clear();
     
     // Detect sequential dependencies within each stream
     detectSequentialDependencies();
@@ -37,137 +72,315 @@ void InstructionStreamBuilder::analyze() {
     // Detect synchronization dependencies across streams
     detectSynchronizationDependencies();
     
-    // Update node dependency lists
-    for (const auto& dep : dependencies_) {
-        auto from_it = nodes_.find(dep.from_correlation_id);
-        auto to_it = nodes_.find(dep.to_correlation_id);
-        
-        if (from_it != nodes_.end() && to_it != nodes_.end()) {
-            from_it->second.dependents.push_back(dep.to_correlation_id);
-            to_it->second.dependencies.push_back(dep.from_correlation_id);
-        }
-    }
+    // Build per-node dependency lists
+    buildAdjacency();
 }
 
 void InstructionStreamBuilder::detectSequentialDependencies() {
-    // Operations in the same stream have sequential dependencies
+    // Operations in the same (device, stream) have sequential dependencies.
+    // Each stream is independent, so edges are built per stream (possibly
+    // on worker threads) and then merged in stream order, which keeps the
+    // result identical regardless of thread count.
+    std::vector<const std::pair<const StreamKey, std::vector<uint32_t>>*> stream_list;
+    stream_list.reserve(streams_.size());
     for (const auto& stream_pair : streams_) {
-        const auto& ops = stream_pair.second;
+        stream_list.push_back(&stream_pair);
+    }
+    
+    std::vector<std::vector<DependencyEdge>> per_stream(stream_list.size());
+    
+    parallelFor(stream_list.size(), num_threads_, [&](size_t s) {
+        uint32_t stream_id = stream_list[s]->first.second;
+        const auto& ops = stream_list[s]->second;
+        auto& out = per_stream[s];
+        
+        if (ops.size() < 2) {
+            return;
+        }
         
+        out.reserve(ops.size() - 1);
         for (size_t i = 1; i < ops.size(); ++i) {
-            uint64_t prev = ops[i - 1];
-            uint64_t curr = ops[i];
-            
-            addDependency(prev, curr, DependencyType::Sequential, 
-                          "Sequential in stream " + std::to_string(stream_pair.first));
+            out.emplace_back(ops[i - 1], ops[i], DependencyType::Sequential, stream_id);
         }
-    }
+    });
+    
+    appendEdges(per_stream);
 }
 
 void InstructionStreamBuilder::detectSynchronizationDependencies() {
-    // Detect synchronization events and create cross-stream dependencies
-    for (const auto& node_pair : nodes_) {
-        const auto& event = node_pair.second.event;
-        
-        switch (event.type) {
-            case EventType::StreamSync:
-            case EventType::DeviceSync:
-                // Create dependencies from all prior operations to this sync
-                createSyncDependencies(event.correlation_id, event.stream_id);
-                break;
-                
-            default:
-                break;
+    // A sync must wait for every earlier operation on the other streams of
+    // its device. Since each stream is already a sequential chain, it is
+    // enough to link the sync to the latest earlier operation per stream
+    // (the frontier). This assumes per-stream operations were recorded in
+    // issue order, which is how every capture backend emits them.
+    //
+    // Devices share no sync edges, so each device's frontier is swept on
+    // its own worker and the results are merged in device order.
+    const uint32_t n = static_cast<uint32_t>(events_.size());
+    if (n == 0) {
+        return;
+    }
+    
+    // Dense stream slots; streams_ is ordered by device, so each device
+    // owns the contiguous slot range [device_begin[d], device_begin[d + 1])
+    std::vector<uint32_t> node_slot(n);
+    std::vector<uint32_t> slot_stream;
+    std::vector<const std::vector<uint32_t>*> slot_ops;
+    std::vector<uint32_t> device_begin;
+    slot_stream.reserve(streams_.size());
+    slot_ops.reserve(streams_.size());
+    uint32_t current_device = 0;
+    for (const auto& [key, ops] : streams_) {
+        uint32_t slot = static_cast<uint32_t>(slot_stream.size());
+        if (slot == 0 || key.first != current_device) {
+            device_begin.push_back(slot);
+            current_device = key.first;
+        }
+        slot_stream.push_back(key.second);
+        slot_ops.push_back(&ops);
+        for (uint32_t index : ops) {
+            node_slot[index] = slot;
         }
     }
-}
-
-void InstructionStreamBuilder::createSyncDependencies(uint64_t sync_corr_id, uint32_t sync_stream) {
-    // Find all operations before this sync point
-    for (const auto& node_pair : nodes_) {
-        const auto& node = node_pair.second;
+    device_begin.push_back(static_cast<uint32_t>(slot_stream.size()));
+    
+    const size_t num_devices = device_begin.size() - 1;
+    std::vector<std::vector<DependencyEdge>> per_device(num_devices);
+    
+    parallelFor(num_devices, num_threads_, [&](size_t d) {
+        const uint32_t first_slot = device_begin[d];
+        const uint32_t end_slot = device_begin[d + 1];
+        if (end_slot - first_slot < 2) {
+            return;  // A single stream only has sequential edges
+        }
         
-        // Skip same stream (handled by sequential deps) and future events
-        if (node.event.stream_id == sync_stream) {
-            continue;
+        // Device's nodes in insertion order
+        std::vector<uint32_t> order;
+        bool has_sync = false;
+        for (uint32_t slot = first_slot; slot < end_slot; ++slot) {
+            for (uint32_t index : *slot_ops[slot]) {
+                EventType type = events_[index].type;
+                has_sync = has_sync || type == EventType::StreamSync ||
+                           type == EventType::DeviceSync;
+                order.push_back(index);
+            }
+        }
+        if (!has_sync) {
+            return;
         }
+        std::sort(order.begin(), order.end());
         
-        if (node.event.timestamp < nodes_[sync_corr_id].event.timestamp) {
-            addDependency(node.event.correlation_id, sync_corr_id, 
-                          DependencyType::Synchronization,
-                          "Stream sync barrier");
+        // Visit nodes in timestamp order; traces are usually already sorted
+        const size_t count = order.size();
+        bool sorted = true;
+        for (size_t i = 1; i < count && sorted; ++i) {
+            sorted = events_[order[i - 1]].timestamp <= events_[order[i]].timestamp;
         }
+        if (!sorted) {
+            std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+                return events_[a].timestamp < events_[b].timestamp;
+            });
+        }
+        
+        // Slots below are relative to first_slot
+        std::vector<uint32_t> frontier(end_slot - first_slot, kInvalidNode);
+        std::vector<uint32_t> active_slots;
+        auto& out = per_device[d];
+        
+        // (sync slot, other slot) -> frontier node already linked to an earlier
+        // sync on the same stream; linking it again would be redundant.
+        std::unordered_map<uint64_t, uint32_t> last_linked;
+        
+        size_t i = 0;
+        while (i < count) {
+            // Operations with equal timestamps are not "before" each other
+            Timestamp ts = events_[order[i]].timestamp;
+            size_t group_end = i;
+            while (group_end < count && events_[order[group_end]].timestamp == ts) {
+                ++group_end;
+            }
+            
+            for (size_t g = i; g < group_end; ++g) {
+                uint32_t sync = order[g];
+                EventType type = events_[sync].type;
+                if (type != EventType::StreamSync && type != EventType::DeviceSync) {
+                    continue;
+                }
+                
+                uint32_t sync_slot = node_slot[sync] - first_slot;
+                for (uint32_t slot : active_slots) {
+                    // Skip same stream (handled by sequential deps)
+                    if (slot == sync_slot) {
+                        continue;
+                    }
+                    
+                    uint32_t from = frontier[slot];
+                    uint64_t key = (static_cast<uint64_t>(sync_slot) << 32) | slot;
+                    auto [it, inserted] = last_linked.emplace(key, from);
+                    if (!inserted) {
+                        if (it->second == from) {
+                            continue;
+                        }
+                        it->second = from;
+                    }
+                    
+                    out.emplace_back(from, sync, DependencyType::Synchronization,
+                                     slot_stream[first_slot + sync_slot]);
+                }
+            }
+            
+            for (size_t g = i; g < group_end; ++g) {
+                uint32_t slot = node_slot[order[g]] - first_slot;
+                if (frontier[slot] == kInvalidNode) {
+                    active_slots.push_back(slot);
+                }
+                frontier[slot] = order[g];
+            }
+            
+            i = group_end;
+        }
+    });
+    
+    appendEdges(per_device);
+}
+
+void InstructionStreamBuilder::appendEdges(const std::vector<std::vector<DependencyEdge>>& parts) {
+    size_t total = 0;
+    for (const auto& part : parts) {
+        total += part.size();
+    }
+    edges_.reserve(edges_.size() + total);
+    
+    for (const auto& part : parts) {
+        edges_.insert(edges_.end(), part.begin(), part.end());
+    }
+}
+
+void InstructionStreamBuilder::buildAdjacency() {
+    const size_t n = events_.size();
+    
+    // Counting sort of edges by endpoint; preserves edge detection order
+    out_offsets_.assign(n + 1, 0);
+    in_offsets_.assign(n + 1, 0);
+    for (const auto& edge : edges_) {
+        out_offsets_[edge.from + 1]++;
+        in_offsets_[edge.to + 1]++;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        out_offsets_[i + 1] += out_offsets_[i];
+        in_offsets_[i + 1] += in_offsets_[i];
+    }
+    
+    out_targets_.resize(edges_.size());
+    in_sources_.resize(edges_.size());
+    std::vector<uint32_t> out_pos(out_offsets_.begin(), out_offsets_.end() - 1);
+    std::vector<uint32_t> in_pos(in_offsets_.begin(), in_offsets_.end() - 1);
+    for (const auto& edge : edges_) {
+        out_targets_[out_pos[edge.from]++] = edge.to;
+        in_sources_[in_pos[edge.to]++] = edge.from;
+    }
+}
+
+uint32_t InstructionStreamBuilder::findNode(uint64_t correlation_id) const {
+    auto it = node_index_.find(correlation_id);
+    return it != node_index_.end() ? it->second : kInvalidNode;
+}
+
+std::string InstructionStreamBuilder::describe(const DependencyEdge& edge) {
+    switch (edge.type) {
+        case DependencyType::Sequential:
+            return "Sequential in stream " + std::to_string(edge.stream_id);
+        case DependencyType::Synchronization:
+            return "Stream sync barrier";
+        default:
+            return dependencyTypeToString(edge.type);
     }
 }
 
-void InstructionStreamBuilder::addDependency(uint64_t from, uint64_t to, 
-                                              DependencyType type, const std::string& desc) {
-    // Check if dependency already exists
-    for (const auto& dep : dependencies_) {
-        if (dep.from_correlation_id == from && dep.to_correlation_id == to) {
-            return;  // Already exists
+InstructionNode InstructionStreamBuilder::makeNode(uint32_t index) const {
+    InstructionNode node(events_[index]);
+    
+    if (out_offsets_.size() == events_.size() + 1) {
+        for (uint32_t e = in_offsets_[index]; e < in_offsets_[index + 1]; ++e) {
+            node.dependencies.push_back(events_[in_sources_[e]].correlation_id);
+        }
+        for (uint32_t e = out_offsets_[index]; e < out_offsets_[index + 1]; ++e) {
+            node.dependents.push_back(events_[out_targets_[e]].correlation_id);
         }
     }
     
-    dependencies_.emplace_back(from, to, type, desc);
+    return node;
 }
 
 std::vector<InstructionNode> InstructionStreamBuilder::getExecutionOrder() const {
     // Get all nodes sorted by timestamp
+    std::vector<uint32_t> order(events_.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return events_[a].timestamp < events_[b].timestamp;
+    });
+    
     std::vector<InstructionNode> result;
-    result.reserve(nodes_.size());
+    result.reserve(order.size());
     
-    for (const auto& pair : nodes_) {
-        result.push_back(pair.second);
+    for (uint32_t index : order) {
+        result.push_back(makeNode(index));
     }
     
-    std::sort(result.begin(), result.end(), 
-              [](const InstructionNode& a, const InstructionNode& b) {
-                  return a.event.timestamp < b.event.timestamp;
-              });
-    
     return result;
 }
 
 std::vector<OperationDependency> InstructionStreamBuilder::getDependencies() const {
-    return dependencies_;
+    std::vector<OperationDependency> result;
+    result.reserve(edges_.size());
+    
+    for (const auto& edge : edges_) {
+        result.emplace_back(events_[edge.from].correlation_id,
+                            events_[edge.to].correlation_id,
+                            edge.type, describe(edge));
+    }
+    
+    return result;
 }
 
 std::vector<InstructionNode> InstructionStreamBuilder::getStreamOperations(uint32_t stream_id) const {
-    std::vector<InstructionNode> result;
-    
-    auto it = streams_.find(stream_id);
-    if (it == streams_.end()) {
-        return result;
+    // The same stream ID may exist on several devices; merge in insertion order
+    std::vector<uint32_t> indices;
+    for (const auto& [key, ops] : streams_) {
+        if (key.second == stream_id) {
+            indices.insert(indices.end(), ops.begin(), ops.end());
+        }
     }
+    std::sort(indices.begin(), indices.end());
     
-    for (uint64_t corr_id : it->second) {
-        auto node_it = nodes_.find(corr_id);
-        if (node_it != nodes_.end()) {
-            result.push_back(node_it->second);
-        }
+    std::vector<InstructionNode> result;
+    result.reserve(indices.size());
+    for (uint32_t index : indices) {
+        result.push_back(makeNode(index));
     }
     
     return result;
 }
 
 bool InstructionStreamBuilder::hasDependency(uint64_t from, uint64_t to) const {
-    for (const auto& dep : dependencies_) {
-        if (dep.from_correlation_id == from && dep.to_correlation_id == to) {
-            return true;
-        }
+    uint32_t from_index = findNode(from);
+    uint32_t to_index = findNode(to);
+    if (from_index == kInvalidNode || to_index == kInvalidNode ||
+        out_offsets_.size() != events_.size() + 1) {
+        return false;
     }
-    return false;
+    
+    auto begin = out_targets_.begin() + out_offsets_[from_index];
+    auto end = out_targets_.begin() + out_offsets_[from_index + 1];
+    return std::find(begin, end, to_index) != end;
 }
 
 InstructionStreamBuilder::Statistics InstructionStreamBuilder::getStatistics() const {
     Statistics stats;
-    stats.total_operations = nodes_.size();
-    stats.total_dependencies = dependencies_.size();
+    stats.total_operations = events_.size();
+    stats.total_dependencies = edges_.size();
     
-    for (const auto& pair : nodes_) {
-        const auto& event = pair.second.event;
-        
+    for (const auto& event : events_) {
         switch (event.type) {
             case EventType::KernelLaunch:
                 stats.kernel_launches++;
@@ -199,19 +412,18 @@ std::string InstructionStreamBuilder::exportToDot() const {
     dot << "  node [shape=box];\n\n";
     
     // Nodes
-    for (const auto& pair : nodes_) {
-        const auto& node = pair.second;
-        dot << "  n" << node.event.correlation_id 
-            << " [label=\"" << node.event.name 
-            << "\\nStream " << node.event.stream_id << "\"];\n";
+    for (const auto& event : events_) {
+        dot << "  n" << event.correlation_id
+            << " [label=\"" << event.name
+            << "\\nStream " << event.stream_id << "\"];\n";
     }
     
     dot << "\n";
     
     // Edges (dependencies)
-    for (const auto& dep : dependencies_) {
-        std::string color;
-        switch (dep.type) {
+    for (const auto& edge : edges_) {
+        const char* color;
+        switch (edge.type) {
             case DependencyType::Sequential:
                 color = "black";
                 break;
@@ -223,8 +435,8 @@ std::string InstructionStreamBuilder::exportToDot() const {
                 break;
         }
         
-        dot << "  n" << dep.from_correlation_id 
-            << " -> n" << dep.to_correlation_id
+        dot << "  n" << events_[edge.from].correlation_id
+            << " -> n" << events_[edge.to].correlation_id
             << " [color=" << color << "];\n";
     }
     
@@ -234,11 +446,14 @@ std::string InstructionStreamBuilder::exportToDot() const {
 }
 
 void InstructionStreamBuilder::clear() {
-    nodes_.clear();
+    events_.clear();
+    node_index_.clear();
     streams_.clear();
-    dependencies_.clear();
-    stream_last_op_.clear();
-    pending_syncs_.clear();
+    edges_.clear();
+    out_offsets_.clear();
+    out_targets_.clear();
+    in_offsets_.clear();
+    in_sources_.clear();
 }
 
 } // namespace tracesmith
@@ -0,0 +1,181 @@
+#include "tracesmith/state/json_writer.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace tracesmith {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+/// Escape table: 0 = copy as is, 'u' = \u00XX, otherwise the escape letter
+struct EscapeTable {
+    char entries[256] = {};
+
+    constexpr EscapeTable() {
+        for (int c = 0; c < 0x20; ++c) {
+            entries[c] = 'u';
+        }
+        entries[static_cast<unsigned char>('"')] = '"';
+        entries[static_cast<unsigned char>('\\')] = '\\';
+        entries[static_cast<unsigned char>('\n')] = 'n';
+        entries[static_cast<unsigned char>('\r')] = 'r';
+        entries[static_cast<unsigned char>('\t')] = 't';
+        entries[static_cast<unsigned char>('\b')] = 'b';
+        entries[static_cast<unsigned char>('\f')] = 'f';
+    }
+};
+
+constexpr EscapeTable kEscapes;
+
+} // anonymous namespace
+
+JsonWriter::JsonWriter(bool pretty, size_t buffer_size)
+    : pretty_(pretty)
+    , flush_threshold_(buffer_size)
+{
+    // Headroom so the object that crosses the threshold does not reallocate
+    buffer_.resize(buffer_size + buffer_size / 4 + 256);
+}
+
+void JsonWriter::grow(size_t bytes) {
+    buffer_.resize(std::max(buffer_.size() * 2, size_ + bytes));
+}
+
+void JsonWriter::newline() {
+    size_t indent = depth_ * 2;
+    reserve(indent + 1);
+    put('\n');
+    std::memset(data() + size_, ' ', indent);
+    size_ += indent;
+}
+
+void JsonWriter::open(char bracket) {
+    separator();
+    reserve(1);
+    put(bracket);
+    depth_++;
+}
+
+void JsonWriter::close(char bracket) {
+    depth_--;
+    // Empty containers stay on one line
+    char last = size_ ? buffer_[size_ - 1] : flushed_last_;
+    if (pretty_ && last != '{' && last != '[') {
+        newline();
+    }
+    reserve(1);
+    put(bracket);
+}
+
+void JsonWriter::value(bool flag) {
+    separator();
+    reserve(5);
+    if (flag) {
+        putRaw("true", 4);
+    } else {
+        putRaw("false", 5);
+    }
+}
+
+void JsonWriter::value(double number, int precision) {
+    separator();
+    // JSON has no representation for NaN or infinity
+    if (!std::isfinite(number)) {
+        reserve(4);
+        putRaw("null", 4);
+        return;
+    }
+    char digits[352];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number,
+                                std::chars_format::fixed, precision);
+    size_t length = static_cast<size_t>(result.ptr - digits);
+    reserve(length);
+    putRaw(digits, length);
+}
+
+void JsonWriter::hexValue(uint64_t number) {
+    separator();
+    reserve(24);
+    putRaw("\"0x", 3);
+    auto result = std::to_chars(data() + size_, data() + size_ + 16, number, 16);
+    size_ = static_cast<size_t>(result.ptr - data());
+    put('"');
+}
+
+void JsonWriter::value(const uint32_t* numbers, size_t count) {
+    separator();
+    reserve(1);
+    put('[');
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            reserve(2);
+            put(',');
+            if (pretty_) put(' ');
+        }
+        putUint(numbers[i]);
+    }
+    reserve(1);
+    put(']');
+}
+
+void JsonWriter::putQuoted(std::string_view text) {
+    // Worst case every byte becomes \u00XX
+    reserve(text.size() * 6 + 2);
+    put('"');
+
+    // Copy unescaped runs in one go; most names need no escaping at all
+    size_t run_start = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char escape = kEscapes.entries[static_cast<unsigned char>(text[i])];
+        if (escape == 0) {
+            continue;
+        }
+        putRaw(text.data() + run_start, i - run_start);
+        run_start = i + 1;
+
+        put('\\');
+        if (escape == 'u') {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            putRaw("u00", 3);
+            put(kHexDigits[c >> 4]);
+            put(kHexDigits[c & 0xF]);
+        } else {
+            put(escape);
+        }
+    }
+    putRaw(text.data() + run_start, text.size() - run_start);
+
+    put('"');
+}
+
+void JsonWriter::appendFragment(std::string_view text) {
+    char last = size_ ? buffer_[size_ - 1] : flushed_last_;
+    if (!text.empty() && text[0] == ',' && (last == '{' || last == '[')) {
+        text.remove_prefix(1);
+    }
+    reserve(text.size());
+    putRaw(text.data(), text.size());
+    if (sink_ && size_ >= flush_threshold_) {
+        flush();
+    }
+}
+
+bool JsonWriter::flush() {
+    if (sink_ && size_ > 0) {
+        good_ = sink_(buffer_.data(), size_) && good_;
+        flushed_last_ = buffer_[size_ - 1];
+        size_ = 0;
+    }
+    return good_;
+}
+
+std::string JsonWriter::takeString() {
+    buffer_.resize(size_);
+    std::string out;
+    out.swap(buffer_);
+    size_ = 0;
+    return out;
+}
+
+} // namespace tracesmith
@@ -1,11 +1,72 @@
 #include "tracesmith/state/perfetto_exporter.hpp"
 #include "tracesmith/common/types.hpp"
-#include <sstream>
-#include <iomanip>
+#include "tracesmith/common/parallel.hpp"
 #include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef TRACESMITH_HAS_ZLIB
+#include <zlib.h>
+#endif
 
 namespace tracesmith {
 
+namespace {
+
+// Special PID for counter tracks
+constexpr uint32_t kCounterPid = 9999;
+
+// Items rendered per parallel chunk, and chunks in flight per worker
+constexpr size_t kChunkItems = 4096;
+constexpr size_t kChunksPerWorker = 2;
+
+bool hasSuffix(const std::string& str, std::string_view suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/// Sort runs on workers, then merge neighbouring runs pairwise
+template<typename T>
+void sortParallel(std::vector<T>& items, size_t num_threads) {
+    size_t runs = std::min(num_threads, items.size() / kChunkItems + 1);
+    if (runs <= 1) {
+        std::sort(items.begin(), items.end());
+        return;
+    }
+    std::vector<size_t> bounds(runs + 1);
+    for (size_t r = 0; r <= runs; ++r) {
+        bounds[r] = items.size() * r / runs;
+    }
+    parallelFor(runs, num_threads, [&](size_t r) {
+        std::sort(items.begin() + bounds[r], items.begin() + bounds[r + 1]);
+    });
+    for (size_t width = 1; width < runs; width *= 2) {
+        size_t merges = (runs + 2 * width - 1) / (2 * width);
+        parallelFor(merges, num_threads, [&](size_t m) {
+            size_t lo = m * 2 * width;
+            size_t mid = std::min(lo + width, runs);
+            size_t hi = std::min(lo + 2 * width, runs);
+            if (mid < hi) {
+                std::inplace_merge(items.begin() + bounds[lo], items.begin() + bounds[mid],
+                                   items.begin() + bounds[hi]);
+            }
+        });
+    }
+}
+
+} // anonymous namespace
+
+bool PerfettoExporter::isGzipAvailable() {
+#ifdef TRACESMITH_HAS_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
 bool PerfettoExporter::exportToFile(const std::vector<TraceEvent>& events, const std::string& output_file) {
     return exportToFile(events, {}, output_file);
 }
@@ -13,43 +74,37 @@ bool PerfettoExporter::exportToFile(const std::vector<TraceEvent>& events, const
 bool PerfettoExporter::exportToFile(const std::vector<TraceEvent>& events,
                                     const std::vector<CounterEvent>& counters,
                                     const std::string& output_file) {
-    std::ofstream out(output_file);
-    if (!out) {
+    JsonWriter json(!compact_);
+
+    if (gzip_ || hasSuffix(output_file, ".gz")) {
+#ifdef TRACESMITH_HAS_ZLIB
+        char mode[4] = {'w', 'b', static_cast<char>('0' + std::clamp(gzip_level_, 1, 9)), '\0'};
+        gzFile gz = gzopen(output_file.c_str(), mode);
+        if (!gz) {
+            return false;
+        }
+        gzbuffer(gz, 256 * 1024);
+        json.setSink([gz](const char* data, size_t size) {
+            return gzwrite(gz, data, static_cast<unsigned>(size)) == static_cast<int>(size);
+        });
+        writeDocument(json, events, counters);
+        bool ok = json.flush();
+        return gzclose(gz) == Z_OK && ok;
+#else
         return false;
+#endif
     }
-    
-    // Extract metadata from events
-    extractMetadata(events);
-    
-    writeHeader(out);
-    
-    bool first = true;
-    
-    // Write metadata events (process/thread names)
-    writeMetadataEvents(out, events, first);
-    
-    // Write counter track metadata
-    if (enable_counter_tracks_ && !counters.empty()) {
-        writeCounterTrackMetadata(out, counters, first);
-    }
-    
-    // Write trace events
-    for (const auto& event : events) {
-        writeEvent(out, event, first);
-    }
-    
-    // Write counter events
-    if (enable_counter_tracks_ && !counters.empty()) {
-        writeCounterEvents(out, counters, first);
-    }
-    
-    // Write flow events for dependencies
-    if (enable_flow_events_) {
-        writeFlowEvents(out, events, first);
+
+    FILE* file = std::fopen(output_file.c_str(), "wb");
+    if (!file) {
+        return false;
     }
-    
-    writeFooter(out);
-    return true;
+    json.setSink([file](const char* data, size_t size) {
+        return std::fwrite(data, 1, size, file) == size;
+    });
+    writeDocument(json, events, counters);
+    bool ok = json.flush();
+    return std::fclose(file) == 0 && ok;
 }
 
 std::string PerfettoExporter::exportToString(const std::vector<TraceEvent>& events) {
@@ -58,185 +113,200 @@ std::string PerfettoExporter::exportToString(const std::vector<TraceEvent>& even
 
 std::string PerfettoExporter::exportToString(const std::vector<TraceEvent>& events,
                                              const std::vector<CounterEvent>& counters) {
-    // Use string stream to build output
-    std::ostringstream temp_file;
-    
+    // No sink: the writer accumulates the whole document
+    JsonWriter json(!compact_, events.size() * (compact_ ? 256 : 448) + 4096);
+    writeDocument(json, events, counters);
+    return json.takeString();
+}
+
+void PerfettoExporter::writeDocument(JsonWriter& json, const std::vector<TraceEvent>& events,
+                                     const std::vector<CounterEvent>& counters) {
     // Extract metadata from events
     extractMetadata(events);
-    
-    writeHeader(temp_file);
-    
-    bool first = true;
-    
-    // Write metadata events
-    writeMetadataEvents(temp_file, events, first);
-    
+
+    json.beginObject();
+    json.key("traceEvents");
+    json.beginArray();
+
+    // Write metadata events (process/thread names)
+    writeMetadataEvents(json);
+
     // Write counter track metadata
     if (enable_counter_tracks_ && !counters.empty()) {
-        writeCounterTrackMetadata(temp_file, counters, first);
+        writeCounterTrackMetadata(json, counters);
     }
-    
+
     // Write trace events
-    for (const auto& event : events) {
-        writeEvent(temp_file, event, first);
-    }
-    
+    writeChunked(json, events.size(), [&](JsonWriter& out, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            writeEvent(out, events[i]);
+        }
+    });
+
     // Write counter events
     if (enable_counter_tracks_ && !counters.empty()) {
-        writeCounterEvents(temp_file, counters, first);
+        writeCounterEvents(json, counters);
     }
-    
-    // Write flow events
+
+    // Write flow events for dependencies
     if (enable_flow_events_) {
-        writeFlowEvents(temp_file, events, first);
+        writeFlowEvents(json, events);
     }
-    
-    writeFooter(temp_file);
-    
-    return temp_file.str();
-}
 
-void PerfettoExporter::writeHeader(std::ostream& out) {
-    out << "{\n";
-    out << "  \"traceEvents\": [\n";
+    json.endArray();
+    writeFooter(json);
+    json.endObject();
 }
 
-void PerfettoExporter::writeEvent(std::ostream& out, const TraceEvent& event, bool& first) {
-    if (!first) {
-        out << ",\n";
+void PerfettoExporter::writeChunked(JsonWriter& json, size_t count,
+                                    const std::function<void(JsonWriter&, size_t, size_t)>& write_range) {
+    size_t num_threads = resolveThreadCount(num_threads_);
+    if (num_threads <= 1 || count <= kChunkItems) {
+        write_range(json, 0, count);
+        return;
+    }
+
+    // Render a bounded wave of chunks at a time so memory stays flat
+    size_t num_chunks = (count + kChunkItems - 1) / kChunkItems;
+    size_t wave = num_threads * kChunksPerWorker;
+    std::vector<JsonWriter> chunks;
+    chunks.reserve(wave);
+    for (size_t i = 0; i < std::min(wave, num_chunks); ++i) {
+        chunks.emplace_back(json.pretty(), 1 << 20);
+    }
+
+    for (size_t first = 0; first < num_chunks; first += wave) {
+        size_t in_flight = std::min(wave, num_chunks - first);
+        parallelFor(in_flight, num_threads, [&](size_t i) {
+            size_t begin = (first + i) * kChunkItems;
+            size_t end = std::min(count, begin + kChunkItems);
+            chunks[i].resumeAfterElement(json.depth());
+            write_range(chunks[i], begin, end);
+        });
+        for (size_t i = 0; i < in_flight; ++i) {
+            json.appendFragment(chunks[i].fragment());
+        }
     }
-    first = false;
-    
-    out << "    {\n";
-    out << "      \"name\": \"" << event.name << "\",\n";
-    out << "      \"cat\": \"" << getEventCategory(event.type) << "\",\n";
-    out << "      \"ph\": \"" << getEventPhase(event.type) << "\",\n";
-    out << "      \"ts\": " << eventToMicroseconds(event.timestamp) << ",\n";
-    out << "      \"pid\": " << event.device_id << ",\n";
-    out << "      \"tid\": " << event.stream_id;
-    
+}
+
+void PerfettoExporter::writeEvent(JsonWriter& json, const TraceEvent& event) {
+    json.beginObject();
+    json.key("name"); json.value(event.name);
+    json.key("cat"); json.literalValue(getEventCategory(event.type));
+    json.key("ph"); json.literalValue(getEventPhase(event.type));
+    json.key("ts"); json.value(eventToMicroseconds(event.timestamp));
+    json.key("pid"); json.value(event.device_id);
+    json.key("tid"); json.value(event.stream_id);
+
     // Add duration if available (must come before args)
     if (event.duration > 0) {
-        out << ",\n      \"dur\": " << (event.duration / 1000);
+        json.key("dur"); json.value(event.duration / 1000);
     }
-    
+
+    json.key("args");
+    json.beginObject();
+
     // Use GPU track names if enabled
-    out << ",\n      \"args\": {\n";
     if (enable_gpu_tracks_) {
-        out << "        \"track_name\": \"" << getGPUTrackName(event.type) << "\"";
+        json.key("track_name"); json.literalValue(getGPUTrackName(event.type));
     }
-    
+
     // Add correlation ID for flow events
     if (enable_flow_events_ && event.correlation_id != 0) {
-        if (enable_gpu_tracks_) {
-            out << ",\n        \"correlation_id\": " << event.correlation_id;
-        } else {
-            out << "\n        \"correlation_id\": " << event.correlation_id;
-        }
+        json.key("correlation_id"); json.value(event.correlation_id);
     }
-    
+
     // Write detailed args
-    writeEventArgs(out, event);
-    
-    out << "\n      }\n";
-    out << "    }";
+    writeEventArgs(json, event);
+
+    json.endObject();
+    json.endObject();
 }
 
-void PerfettoExporter::writeFooter(std::ostream& out) {
-    out << "\n  ],\n";
-    out << "  \"displayTimeUnit\": \"ns\",\n";
-    out << "  \"otherData\": {\n";
-    out << "    \"version\": \"TraceSmith v" 
-        << VERSION_MAJOR << "." << VERSION_MINOR << "." << VERSION_PATCH << "\"\n";
-    out << "  }\n";
-    out << "}\n";
+void PerfettoExporter::writeFooter(JsonWriter& json) {
+    json.key("displayTimeUnit"); json.value("ns");
+    json.key("otherData");
+    json.beginObject();
+    json.key("version");
+    json.value("TraceSmith v" + std::to_string(VERSION_MAJOR) + "." +
+               std::to_string(VERSION_MINOR) + "." + std::to_string(VERSION_PATCH));
+    json.endObject();
 }
 
-void PerfettoExporter::writeCounterTrackMetadata(std::ostream& out, const std::vector<CounterEvent>& counters, bool& first) {
+void PerfettoExporter::writeCounterTrackMetadata(JsonWriter& json, const std::vector<CounterEvent>& counters) {
     // Collect unique counter names
     counter_names_.clear();
     for (const auto& counter : counters) {
         counter_names_.insert(counter.counter_name);
     }
-    
+
     // Use a separate process for counter tracks to keep them organized
-    const uint32_t counter_pid = 9999; // Special PID for counter tracks
-    
-    // Write process metadata for counter tracks
-    if (!first) {
-        out << ",\n";
-    }
-    first = false;
-    
-    out << "    {\n";
-    out << "      \"name\": \"process_name\",\n";
-    out << "      \"ph\": \"M\",\n";
-    out << "      \"pid\": " << counter_pid << ",\n";
-    out << "      \"args\": {\n";
-    out << "        \"name\": \"Performance Counters\"\n";
-    out << "      }\n";
-    out << "    }";
-    
+    json.beginObject();
+    json.key("name"); json.value("process_name");
+    json.key("ph"); json.value("M");
+    json.key("pid"); json.value(kCounterPid);
+    json.key("args");
+    json.beginObject();
+    json.key("name"); json.value("Performance Counters");
+    json.endObject();
+    json.endObject();
+
     // Write thread metadata for each counter track
     uint32_t counter_tid = 1;
     for (const auto& name : counter_names_) {
-        if (!first) {
-            out << ",\n";
-        }
-        first = false;
-        
-        out << "    {\n";
-        out << "      \"name\": \"thread_name\",\n";
-        out << "      \"ph\": \"M\",\n";
-        out << "      \"pid\": " << counter_pid << ",\n";
-        out << "      \"tid\": " << counter_tid << ",\n";
-        out << "      \"args\": {\n";
-        out << "        \"name\": \"" << name << "\"\n";
-        out << "      }\n";
-        out << "    }";
-        
+        json.beginObject();
+        json.key("name"); json.value("thread_name");
+        json.key("ph"); json.value("M");
+        json.key("pid"); json.value(kCounterPid);
+        json.key("tid"); json.value(counter_tid);
+        json.key("args");
+        json.beginObject();
+        json.key("name"); json.value(name);
+        json.endObject();
+        json.endObject();
+
         counter_tid++;
     }
 }
 
-void PerfettoExporter::writeCounterEvents(std::ostream& out, const std::vector<CounterEvent>& counters, bool& first) {
-    const uint32_t counter_pid = 9999; // Same as in writeCounterTrackMetadata
-    
-    // Build a map of counter name -> tid
-    std::map<std::string, uint32_t> name_to_tid;
+void PerfettoExporter::writeCounterEvents(JsonWriter& json, const std::vector<CounterEvent>& counters) {
+    // Build a map of counter name -> tid (same order as the track metadata)
+    std::unordered_map<std::string, uint32_t> name_to_tid;
     uint32_t tid = 1;
     for (const auto& name : counter_names_) {
         name_to_tid[name] = tid++;
     }
-    
+
     // Write counter events
-    for (const auto& counter : counters) {
-        if (!first) {
-            out << ",\n";
-        }
-        first = false;
-        
-        out << "    {\n";
-        out << "      \"name\": \"" << counter.counter_name << "\",\n";
-        out << "      \"cat\": \"counter\",\n";
-        out << "      \"ph\": \"C\",\n"; // Counter event
-        out << "      \"ts\": " << eventToMicroseconds(counter.timestamp) << ",\n";
-        out << "      \"pid\": " << counter_pid << ",\n";
-        out << "      \"tid\": " << name_to_tid[counter.counter_name] << ",\n";
-        out << "      \"args\": {\n";
-        out << "        \"" << counter.counter_name << "\": " << std::fixed << std::setprecision(2) << counter.value;
-        
-        // Add unit if present
-        if (!counter.unit.empty()) {
-            out << ",\n        \"unit\": \"" << counter.unit << "\"";
+    writeChunked(json, counters.size(), [&](JsonWriter& out, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            writeCounter(out, counters[i], name_to_tid.find(counters[i].counter_name)->second);
         }
-        
-        out << "\n      }\n";
-        out << "    }";
+    });
+}
+
+void PerfettoExporter::writeCounter(JsonWriter& json, const CounterEvent& counter, uint32_t tid) {
+    json.beginObject();
+    json.key("name"); json.value(counter.counter_name);
+    json.key("cat"); json.literalValue("counter");
+    json.key("ph"); json.literalValue("C");  // Counter event
+    json.key("ts"); json.value(eventToMicroseconds(counter.timestamp));
+    json.key("pid"); json.value(kCounterPid);
+    json.key("tid"); json.value(tid);
+    json.key("args");
+    json.beginObject();
+    json.key(counter.counter_name); json.value(counter.value, 2);
+
+    // Add unit if present
+    if (!counter.unit.empty()) {
+        json.key("unit"); json.value(counter.unit);
     }
+
+    json.endObject();
+    json.endObject();
 }
 
-std::string PerfettoExporter::getEventPhase(EventType type) {
+const char* PerfettoExporter::getEventPhase(EventType type) {
     // Perfetto phases:
     // B = Begin, E = End, X = Complete, i = Instant
     // s = Async Start, f = Async Finish
@@ -261,7 +331,7 @@ std::string PerfettoExporter::getEventPhase(EventType type) {
     }
 }
 
-std::string PerfettoExporter::getEventCategory(EventType type) {
+const char* PerfettoExporter::getEventCategory(EventType type) {
     switch (type) {
         case EventType::KernelLaunch:
         case EventType::KernelComplete:
@@ -290,7 +360,7 @@ uint64_t PerfettoExporter::eventToMicroseconds(Timestamp ns) {
     return ns / 1000; // Convert nanoseconds to microseconds
 }
 
-std::string PerfettoExporter::getGPUTrackName(EventType type) {
+const char* PerfettoExporter::getGPUTrackName(EventType type) {
     switch (type) {
         case EventType::KernelLaunch:
         case EventType::KernelComplete:
@@ -318,169 +388,154 @@ std::string PerfettoExporter::getGPUTrackName(EventType type) {
     }
 }
 
-void PerfettoExporter::writeEventArgs(std::ostream& out, const TraceEvent& event) {
-    // Write basic event metadata
-    out << ",\n        \"event_type\": \"" << static_cast<int>(event.type) << "\"";
-    out << ",\n        \"device_id\": " << event.device_id;
-    out << ",\n        \"stream_id\": " << event.stream_id;
-    
+void PerfettoExporter::writeEventArgs(JsonWriter& json, const TraceEvent& event) {
+    // Write basic event metadata (event_type stays a string for compatibility)
+    char type_digits[12];
+    auto type_end = std::to_chars(type_digits, type_digits + sizeof(type_digits), static_cast<int>(event.type)).ptr;
+    json.key("event_type"); json.literalValue(std::string_view(type_digits, static_cast<size_t>(type_end - type_digits)));
+    json.key("device_id"); json.value(event.device_id);
+    json.key("stream_id"); json.value(event.stream_id);
+
     // Kineto-inspired additions
     if (event.thread_id != 0) {
-        out << ",\n        \"thread_id\": " << event.thread_id;
+        json.key("thread_id"); json.value(event.thread_id);
     }
-    
+
     // Export flow information if present
     if (event.flow_info.id != 0) {
-        out << ",\n        \"flow_id\": " << event.flow_info.id;
-        out << ",\n        \"flow_type\": " << static_cast<int>(event.flow_info.type);
-        out << ",\n        \"flow_start\": " << (event.flow_info.is_start ? "true" : "false");
+        json.key("flow_id"); json.value(event.flow_info.id);
+        json.key("flow_type"); json.value(static_cast<int32_t>(event.flow_info.type));
+        json.key("flow_start"); json.value(event.flow_info.is_start);
     }
-    
+
     // Export metadata if present
-    if (!event.metadata.empty()) {
-        for (const auto& [key, value] : event.metadata) {
-            out << ",\n        \"" << key << "\": \"" << value << "\"";
-        }
+    for (const auto& [key, value] : event.metadata) {
+        json.key(key); json.value(value);
     }
-    
+
     // Memory-specific parameters
     if (event.memory_params) {
-        out << ",\n        \"size_bytes\": " << event.memory_params->size_bytes;
-        out << ",\n        \"src_address\": \"0x" << std::hex << event.memory_params->src_address << std::dec << "\"";
-        out << ",\n        \"dst_address\": \"0x" << std::hex << event.memory_params->dst_address << std::dec << "\"";
+        json.key("size_bytes"); json.value(event.memory_params->size_bytes);
+        json.key("src_address"); json.hexValue(event.memory_params->src_address);
+        json.key("dst_address"); json.hexValue(event.memory_params->dst_address);
     }
-    
+
     // Kernel-specific parameters
     if (event.kernel_params) {
-        out << ",\n        \"grid_dim\": [" 
-            << event.kernel_params->grid_x << ", "
-            << event.kernel_params->grid_y << ", "
-            << event.kernel_params->grid_z << "]";
-        out << ",\n        \"block_dim\": [" 
-            << event.kernel_params->block_x << ", "
-            << event.kernel_params->block_y << ", "
-            << event.kernel_params->block_z << "]";
-        out << ",\n        \"shared_memory_bytes\": " << event.kernel_params->shared_mem_bytes;
-        out << ",\n        \"registers_per_thread\": " << event.kernel_params->registers_per_thread;
+        const auto& kp = *event.kernel_params;
+        const uint32_t grid[3] = {kp.grid_x, kp.grid_y, kp.grid_z};
+        const uint32_t block[3] = {kp.block_x, kp.block_y, kp.block_z};
+        json.key("grid_dim"); json.value(grid, 3);
+        json.key("block_dim"); json.value(block, 3);
+        json.key("shared_memory_bytes"); json.value(kp.shared_mem_bytes);
+        json.key("registers_per_thread"); json.value(kp.registers_per_thread);
     }
 }
 
 void PerfettoExporter::extractMetadata(const std::vector<TraceEvent>& events) {
     device_ids_.clear();
-    stream_ids_.clear();
-    
+    stream_devices_.clear();
+
+    // Ordered sets only see each (device, stream) pair once
+    std::unordered_set<uint64_t> seen;
     for (const auto& event : events) {
-        device_ids_.insert(event.device_id);
-        stream_ids_.insert(event.stream_id);
+        uint64_t pair = (static_cast<uint64_t>(event.device_id) << 32) | event.stream_id;
+        if (seen.insert(pair).second) {
+            device_ids_.insert(event.device_id);
+            stream_devices_.emplace(event.stream_id, event.device_id);
+        }
     }
 }
 
-void PerfettoExporter::writeMetadataEvents(std::ostream& out, const std::vector<TraceEvent>& events, bool& first) {
+void PerfettoExporter::writeMetadataEvents(JsonWriter& json) {
     // Write process name metadata for each device
     for (uint32_t device_id : device_ids_) {
-        if (!first) {
-            out << ",\n";
-        }
-        first = false;
-        
-        out << "    {\n";
-        out << "      \"name\": \"process_name\",\n";
-        out << "      \"ph\": \"M\",\n";
-        out << "      \"pid\": " << device_id << ",\n";
-        out << "      \"args\": {\n";
-        out << "        \"name\": \"GPU Device " << device_id << "\"\n";
-        out << "      }\n";
-        out << "    }";
+        json.beginObject();
+        json.key("name"); json.value("process_name");
+        json.key("ph"); json.value("M");
+        json.key("pid"); json.value(device_id);
+        json.key("args");
+        json.beginObject();
+        json.key("name"); json.value("GPU Device " + std::to_string(device_id));
+        json.endObject();
+        json.endObject();
     }
-    
-    // Write thread name metadata for each stream
-    for (uint32_t stream_id : stream_ids_) {
-        if (!first) {
-            out << ",\n";
-        }
-        first = false;
-        
-        // Find device for this stream
-        uint32_t device_id = 0;
-        for (const auto& event : events) {
-            if (event.stream_id == stream_id) {
-                device_id = event.device_id;
-                break;
-            }
-        }
-        
-        out << "    {\n";
-        out << "      \"name\": \"thread_name\",\n";
-        out << "      \"ph\": \"M\",\n";
-        out << "      \"pid\": " << device_id << ",\n";
-        out << "      \"tid\": " << stream_id << ",\n";
-        out << "      \"args\": {\n";
-        out << "        \"name\": \"Stream " << stream_id << "\"\n";
-        out << "      }\n";
-        out << "    }";
+
+    // Write thread name metadata for each stream (on the first device it appears on)
+    for (const auto& [stream_id, device_id] : stream_devices_) {
+        json.beginObject();
+        json.key("name"); json.value("thread_name");
+        json.key("ph"); json.value("M");
+        json.key("pid"); json.value(device_id);
+        json.key("tid"); json.value(stream_id);
+        json.key("args");
+        json.beginObject();
+        json.key("name"); json.value("Stream " + std::to_string(stream_id));
+        json.endObject();
+        json.endObject();
     }
 }
 
-void PerfettoExporter::writeFlowEvents(std::ostream& out, const std::vector<TraceEvent>& events, bool& first) {
-    // Build correlation map (correlation_id -> events)
-    std::map<uint64_t, std::vector<const TraceEvent*>> correlation_map;
-    
-    for (const auto& event : events) {
-        if (event.correlation_id != 0) {
-            correlation_map[event.correlation_id].push_back(&event);
+void PerfettoExporter::writeFlowEvents(JsonWriter& json, const std::vector<TraceEvent>& events) {
+    // Group correlated events by ID with a sort over compact keys (no
+    // per-ID allocations); ties on timestamp keep event order
+    struct FlowKey {
+        uint64_t id;
+        Timestamp timestamp;
+        size_t index;
+        bool operator<(const FlowKey& other) const {
+            if (id != other.id) return id < other.id;
+            if (timestamp != other.timestamp) return timestamp < other.timestamp;
+            return index < other.index;
         }
-    }
-    
-    // Write flow events for correlated events
-    for (const auto& [correlation_id, correlated_events] : correlation_map) {
-        if (correlated_events.size() < 2) {
-            continue; // Need at least 2 events to form a flow
+    };
+    std::vector<FlowKey> correlated;
+    for (size_t i = 0; i < events.size(); ++i) {
+        if (events[i].correlation_id != 0) {
+            correlated.push_back({events[i].correlation_id, events[i].timestamp, i});
         }
-        
-        // Sort by timestamp
-        auto sorted_events = correlated_events;
-        std::sort(sorted_events.begin(), sorted_events.end(),
-                  [](const TraceEvent* a, const TraceEvent* b) {
-                      return a->timestamp < b->timestamp;
-                  });
-        
-        // Create flow from first to last event
-        const TraceEvent* start_event = sorted_events.front();
-        const TraceEvent* end_event = sorted_events.back();
-        
-        // Flow start
-        if (!first) {
-            out << ",\n";
+    }
+    sortParallel(correlated, resolveThreadCount(num_threads_));
+
+    // Earliest and latest event of each group with at least two events
+    struct Flow {
+        uint64_t id;
+        size_t first;
+        size_t last;
+    };
+    std::vector<Flow> flows;
+    for (size_t begin = 0; begin < correlated.size();) {
+        size_t end = begin + 1;
+        uint64_t id = correlated[begin].id;
+        while (end < correlated.size() && correlated[end].id == id) {
+            end++;
         }
-        first = false;
-        
-        out << "    {\n";
-        out << "      \"name\": \"Dependency\",\n";
-        out << "      \"cat\": \"flow\",\n";
-        out << "      \"ph\": \"s\",\n"; // Flow start
-        out << "      \"ts\": " << eventToMicroseconds(start_event->timestamp) << ",\n";
-        out << "      \"pid\": " << start_event->device_id << ",\n";
-        out << "      \"tid\": " << start_event->stream_id << ",\n";
-        out << "      \"id\": " << correlation_id << ",\n";
-        out << "      \"bp\": \"e\"\n"; // Binding point: enclosing
-        out << "    }";
-        
-        // Flow end
-        if (!first) {
-            out << ",\n";
+        if (end - begin >= 2) {  // Need at least 2 events to form a flow
+            flows.push_back({id, correlated[begin].index, correlated[end - 1].index});
         }
-        
-        out << "    {\n";
-        out << "      \"name\": \"Dependency\",\n";
-        out << "      \"cat\": \"flow\",\n";
-        out << "      \"ph\": \"f\",\n"; // Flow finish
-        out << "      \"ts\": " << eventToMicroseconds(end_event->timestamp) << ",\n";
-        out << "      \"pid\": " << end_event->device_id << ",\n";
-        out << "      \"tid\": " << end_event->stream_id << ",\n";
-        out << "      \"id\": " << correlation_id << ",\n";
-        out << "      \"bp\": \"e\"\n";
-        out << "    }";
+        begin = end;
     }
+
+    auto write_flow = [&](JsonWriter& out, const char* phase, const TraceEvent& event, uint64_t id) {
+        out.beginObject();
+        out.key("name"); out.literalValue("Dependency");
+        out.key("cat"); out.literalValue("flow");
+        out.key("ph"); out.literalValue(phase);
+        out.key("ts"); out.value(eventToMicroseconds(event.timestamp));
+        out.key("pid"); out.value(event.device_id);
+        out.key("tid"); out.value(event.stream_id);
+        out.key("id"); out.value(id);
+        out.key("bp"); out.literalValue("e");  // Binding point: enclosing
+        out.endObject();
+    };
+
+    // Create flow from first to last event of each group
+    writeChunked(json, flows.size(), [&](JsonWriter& out, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            write_flow(out, "s", events[flows[i].first], flows[i].id);  // Flow start
+            write_flow(out, "f", events[flows[i].last], flows[i].id);   // Flow finish
+        }
+    });
 }
 
 } // namespace tracesmith
@@ -1,8 +1,20 @@
 #include "tracesmith/state/perfetto_proto_exporter.hpp"
 #include "tracesmith/state/perfetto_exporter.hpp"
+#include "tracesmith/state/perfetto_proto_writer.hpp"
+#include "tracesmith/common/parallel.hpp"
+#include <chrono>
+#include <cerrno>
 #include <fstream>
 #include <iostream>
 #include <cstring>
+#include <unordered_map>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 namespace tracesmith {
 
@@ -26,12 +38,6 @@ PerfettoProtoExporter::PerfettoProtoExporter(Format format)
         impl_ = std::make_unique<PerfettoImpl>();
         // ProtoZero doesn't require explicit initialization
     }
-#else
-    // Force JSON if SDK not available
-    if (format == Format::PROTOBUF) {
-        std::cerr << "Warning: Perfetto SDK not enabled, falling back to JSON format\n";
-        format_ = Format::JSON;
-    }
 #endif
 }
 
@@ -39,149 +45,280 @@ PerfettoProtoExporter::~PerfettoProtoExporter() {
     // ProtoZero version doesn't need cleanup
 }
 
+bool PerfettoProtoExporter::isProtoFile(const std::string& output_file) {
+    // C++17 compatible suffix check
+    auto has_suffix = [](const std::string& str, const std::string& suffix) {
+        return str.size() >= suffix.size() && 
+               str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    
+    return has_suffix(output_file, ".perfetto-trace") || 
+           has_suffix(output_file, ".pftrace");
+}
+
 bool PerfettoProtoExporter::exportToFile(
     const std::vector<TraceEvent>& events,
     const std::string& output_file)
 {
-#ifdef TRACESMITH_PERFETTO_SDK_ENABLED
+    return exportToFile(events, {}, output_file);
+}
+
+bool PerfettoProtoExporter::exportToFile(
+    const std::vector<TraceEvent>& events,
+    const std::vector<CounterEvent>& counters,
+    const std::string& output_file)
+{
     // Auto-detect format from file extension
-    bool use_proto = false;
-    if (format_ == Format::PROTOBUF) {
-        // C++17 compatible suffix check
-        auto has_suffix = [](const std::string& str, const std::string& suffix) {
-            return str.size() >= suffix.size() && 
-                   str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
-        };
-        
-        if (has_suffix(output_file, ".perfetto-trace") || 
-            has_suffix(output_file, ".pftrace")) {
-            use_proto = true;
-        }
-    }
-    
-    if (use_proto && isSDKAvailable()) {
-        // Use Perfetto SDK protobuf export
-        auto proto_data = exportToProto(events);
-        
+    if (format_ == Format::PROTOBUF && isProtoFile(output_file)) {
         std::ofstream out(output_file, std::ios::binary);
         if (!out) {
             std::cerr << "Failed to open output file: " << output_file << "\n";
             return false;
         }
         
-        out.write(reinterpret_cast<const char*>(proto_data.data()), 
-                 proto_data.size());
-        return out.good();
+        // Stream packets out so the encoded trace is never held whole
+        PerfettoProtoWriter writer;
+        return writeProto(events, counters, writer, &out);
     }
-#endif
     
-    // Fallback to JSON export
+    if (!counters.empty()) {
+        PerfettoExporter json_exporter;
+        json_exporter.setParallelism(num_threads_);
+        return json_exporter.exportToFile(events, counters, output_file);
+    }
     return exportToJSON(events, output_file);
 }
 
-#ifdef TRACESMITH_PERFETTO_SDK_ENABLED
-
-// ProtoZero-based implementation - direct protobuf writing
 std::vector<uint8_t> PerfettoProtoExporter::exportToProto(
     const std::vector<TraceEvent>& events)
 {
-    using namespace perfetto::protos::pbzero;
+    return exportToProto(events, {});
+}
+
+std::vector<uint8_t> PerfettoProtoExporter::exportToProto(
+    const std::vector<TraceEvent>& events,
+    const std::vector<CounterEvent>& counters)
+{
+    PerfettoProtoWriter writer;
+    writeProto(events, counters, writer, nullptr);
+    return writer.takeData();
+}
+
+namespace {
+
+// Flush threshold when streaming to a file
+constexpr size_t kFlushBytes = 4 * 1024 * 1024;
+
+// Live streaming: drains an event waits for its flow partner, and the most
+// events held at once
+constexpr uint64_t kFlowHoldDrains = 8;
+constexpr size_t kMaxHeldFlows = 16384;
+
+// Events per parallel chunk, and chunks per worker in each wave
+constexpr size_t kChunkEvents = 4096;
+constexpr size_t kChunksPerWorker = 2;
+
+// Track UUIDs: one process track per device, one thread track per
+// stream, one counter track per counter name (disjoint high bits)
+uint64_t processUuid(uint32_t device_id) {
+    return (uint64_t(1) << 61) | device_id;
+}
+
+uint64_t threadUuid(uint32_t device_id, uint32_t stream_id) {
+    return (uint64_t(1) << 62) | (static_cast<uint64_t>(device_id) << 32) | stream_id;
+}
+
+// Flows link the earliest and latest events sharing a correlation ID
+struct FlowEnds {
+    size_t first;
+    size_t last;
+    size_t count;
+};
+
+using FlowMap = std::unordered_map<uint64_t, FlowEnds>;
+
+/// Per-writer scratch vectors reused across events
+struct EventScratch {
+    std::vector<ProtoAnnotation> annotations;
+    std::vector<uint64_t> flow_ids;
+    std::vector<uint64_t> terminating_flow_ids;
+};
+
+/// Flow role of an event: true in the first field starts its correlation
+/// ID's flow, true in the second terminates it
+std::pair<bool, bool> flowRole(const FlowMap& flows, const TraceEvent& event, size_t index) {
+    if (event.correlation_id == 0) {
+        return {false, false};
+    }
+    const FlowEnds& ends = flows.find(event.correlation_id)->second;
+    if (ends.count < 2 || ends.first == ends.last) {
+        return {false, false};
+    }
+    return {ends.first == index, ends.last == index};
+}
+
+void writeEvent(PerfettoProtoWriter& writer, const TraceEvent& event,
+                const std::string& category, const PerfettoProtoWriter::InternedIds& ids,
+                std::pair<bool, bool> flow_role, EventScratch& scratch) {
+    auto& annotations = scratch.annotations;
+    auto& flow_ids = scratch.flow_ids;
+    auto& terminating_flow_ids = scratch.terminating_flow_ids;
+    annotations.clear();
+    flow_ids.clear();
+    terminating_flow_ids.clear();
+    
+    if (flow_role.first) flow_ids.push_back(event.correlation_id);
+    if (flow_role.second) terminating_flow_ids.push_back(event.correlation_id);
+    
+    // Debug annotations for additional data
+    if (event.kernel_params.has_value()) {
+        const auto& kp = event.kernel_params.value();
+        annotations.push_back(ProtoAnnotation::ofString("grid_dim",
+            "[" + std::to_string(kp.grid_x) + "," + std::to_string(kp.grid_y) + "," +
+            std::to_string(kp.grid_z) + "]"));
+        annotations.push_back(ProtoAnnotation::ofString("block_dim",
+            "[" + std::to_string(kp.block_x) + "," + std::to_string(kp.block_y) + "," +
+            std::to_string(kp.block_z) + "]"));
+    }
+    
+    if (event.memory_params.has_value()) {
+        annotations.push_back(ProtoAnnotation::ofUint("size_bytes",
+                                                      event.memory_params->size_bytes));
+    }
     
-    // Create in-memory buffer for protobuf output
-    protozero::HeapBuffered<perfetto::protos::pbzero::Trace> trace;
+    // Add thread_id from Kineto schema
+    if (event.thread_id != 0) {
+        annotations.push_back(ProtoAnnotation::ofUint("thread_id", event.thread_id));
+    }
     
-    uint32_t sequence_id = 1;
+    // Add metadata key-value pairs
+    for (const auto& [key, value] : event.metadata) {
+        annotations.push_back(ProtoAnnotation::ofString(key, value));
+    }
     
-    // Write each event as a TracePacket
+    uint64_t track = threadUuid(event.device_id, event.stream_id);
+    if (event.duration > 0) {
+        writer.writeSlice(track, event.timestamp, event.duration, event.name, category, ids,
+                          annotations, flow_ids, terminating_flow_ids);
+    } else {
+        writer.writeInstant(track, event.timestamp, event.name, category, ids,
+                            annotations, flow_ids, terminating_flow_ids);
+    }
+}
+
+} // anonymous namespace
+
+bool PerfettoProtoExporter::writeProto(
+    const std::vector<TraceEvent>& events,
+    const std::vector<CounterEvent>& counters,
+    PerfettoProtoWriter& writer,
+    std::ostream* out) const
+{
+    std::unordered_map<uint32_t, bool> devices;
+    std::unordered_map<uint64_t, bool> streams;
     for (const auto& event : events) {
-        auto* packet = trace->add_packet();
-        
-        // Set timestamp (in nanoseconds)
-        packet->set_timestamp(event.timestamp);
-        
-        // Set trusted sequence ID
-        packet->set_trusted_packet_sequence_id(sequence_id);
-        
-        // Create TrackEvent
-        auto* track_event = packet->set_track_event();
-        
-        // Set event name
-        track_event->set_name(event.name);
-        
-        // Set event type
-        auto perfetto_type = mapEventTypeToPerfetto(event.type);
-        switch (perfetto_type) {
-            case PerfettoEventType::SliceBegin:
-                track_event->set_type(TrackEvent::TYPE_SLICE_BEGIN);
-                break;
-            case PerfettoEventType::SliceEnd:
-                track_event->set_type(TrackEvent::TYPE_SLICE_END);
-                break;
-            case PerfettoEventType::Instant:
-                track_event->set_type(TrackEvent::TYPE_INSTANT);
-                break;
-            case PerfettoEventType::Counter:
-                track_event->set_type(TrackEvent::TYPE_COUNTER);
-                if (event.duration > 0) {
-                    track_event->set_counter_value(static_cast<int64_t>(event.duration));
-                }
-                break;
+        if (devices.emplace(event.device_id, true).second) {
+            writer.addProcessTrack(processUuid(event.device_id), event.device_id,
+                                   "GPU Device " + std::to_string(event.device_id));
         }
-        
-        // Set track UUID (based on device_id and stream_id)
-        uint64_t track_uuid = (static_cast<uint64_t>(event.device_id) << 32) | event.stream_id;
-        track_event->set_track_uuid(track_uuid);
-        
-        // Add category
-        track_event->add_categories(getEventCategory(event.type).c_str());
-        
-        // Add debug annotations for additional data
-        if (event.kernel_params.has_value()) {
-            const auto& kp = event.kernel_params.value();
-            
-            auto* grid_ann = track_event->add_debug_annotations();
-            grid_ann->set_name("grid_dim");
-            std::string grid_str = "[" + std::to_string(kp.grid_x) + "," + 
-                                  std::to_string(kp.grid_y) + "," + 
-                                  std::to_string(kp.grid_z) + "]";
-            grid_ann->set_string_value(grid_str);
+        uint64_t stream = threadUuid(event.device_id, event.stream_id);
+        if (streams.emplace(stream, true).second) {
+            writer.addThreadTrack(stream, processUuid(event.device_id), event.device_id,
+                                  event.stream_id, "Stream " + std::to_string(event.stream_id));
+        }
+    }
+    
+    FlowMap flows;
+    for (size_t i = 0; i < events.size(); ++i) {
+        uint64_t id = events[i].correlation_id;
+        if (id == 0) continue;
+        auto [it, inserted] = flows.emplace(id, FlowEnds{i, i, 0});
+        FlowEnds& ends = it->second;
+        ends.count++;
+        if (!inserted) {
+            if (events[i].timestamp < events[ends.first].timestamp) ends.first = i;
+            if (events[i].timestamp >= events[ends.last].timestamp) ends.last = i;
+        }
+    }
+    
+    size_t num_threads = resolveThreadCount(num_threads_);
+    if (num_threads <= 1 || events.size() <= kChunkEvents) {
+        EventScratch scratch;
+        for (size_t i = 0; i < events.size(); ++i) {
+            const auto& event = events[i];
+            const std::string& category = getEventCategory(event.type);
+            writeEvent(writer, event, category, writer.intern(event.name, category),
+                       flowRole(flows, event, i), scratch);
             
-            auto* block_ann = track_event->add_debug_annotations();
-            block_ann->set_name("block_dim");
-            std::string block_str = "[" + std::to_string(kp.block_x) + "," + 
-                                   std::to_string(kp.block_y) + "," + 
-                                   std::to_string(kp.block_z) + "]";
-            block_ann->set_string_value(block_str);
+            if (out && writer.size() >= kFlushBytes && !writer.flushTo(*out)) {
+                return false;
+            }
         }
+    } else {
+        // Packets are independently framed, so chunks encoded on separate
+        // writers concatenate into the serial byte stream. Interning stays
+        // on this writer (IDs depend on first-use order) and is resolved
+        // for a wave before its chunks are encoded.
+        size_t num_chunks = (events.size() + kChunkEvents - 1) / kChunkEvents;
+        size_t wave = num_threads * kChunksPerWorker;
+        std::vector<PerfettoProtoWriter> chunk_writers(std::min(wave, num_chunks));
+        std::vector<EventScratch> scratch(chunk_writers.size());
+        std::vector<PerfettoProtoWriter::InternedIds> ids;
         
-        if (event.memory_params.has_value()) {
-            const auto& mp = event.memory_params.value();
+        for (size_t first = 0; first < num_chunks; first += wave) {
+            size_t chunks = std::min(wave, num_chunks - first);
+            size_t begin = first * kChunkEvents;
+            size_t end = std::min(events.size(), (first + chunks) * kChunkEvents);
+            
+            ids.resize(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                ids[i - begin] = writer.intern(events[i].name, getEventCategory(events[i].type));
+            }
+            
+            uint32_t sequence_id = writer.sequenceId();
+            bool state_cleared = writer.incrementalStateCleared();
+            parallelFor(chunks, num_threads, [&](size_t c) {
+                // Earlier chunks of the wave have cleared state by the time
+                // this one is appended, as every event packet needs it
+                PerfettoProtoWriter& chunk_writer = chunk_writers[c];
+                chunk_writer.continueSequence(sequence_id, c > 0 || state_cleared);
+                size_t chunk_begin = (first + c) * kChunkEvents;
+                size_t chunk_end = std::min(events.size(), chunk_begin + kChunkEvents);
+                for (size_t i = chunk_begin; i < chunk_end; ++i) {
+                    writeEvent(chunk_writer, events[i], getEventCategory(events[i].type),
+                               ids[i - begin], flowRole(flows, events[i], i), scratch[c]);
+                }
+            });
             
-            auto* size_ann = track_event->add_debug_annotations();
-            size_ann->set_name("size_bytes");
-            size_ann->set_uint_value(mp.size_bytes);
+            for (size_t c = 0; c < chunks; ++c) {
+                writer.append(chunk_writers[c]);
+                if (out && writer.size() >= kFlushBytes && !writer.flushTo(*out)) {
+                    return false;
+                }
+            }
         }
-        
-        // Add thread_id from Kineto schema
-        if (event.thread_id != 0) {
-            auto* tid_ann = track_event->add_debug_annotations();
-            tid_ann->set_name("thread_id");
-            tid_ann->set_uint_value(event.thread_id);
+    }
+    
+    // Counter samples
+    std::unordered_map<std::string, uint64_t> counter_tracks;
+    for (const auto& counter : counters) {
+        auto [it, inserted] = counter_tracks.emplace(
+            counter.counter_name, (uint64_t(1) << 60) | counter_tracks.size());
+        if (inserted) {
+            writer.addCounterTrack(it->second, 0, counter.counter_name, counter.unit);
         }
+        writer.writeCounter(it->second, counter.timestamp, counter.value);
         
-        // Add metadata key-value pairs
-        for (const auto& [key, value] : event.metadata) {
-            auto* meta_ann = track_event->add_debug_annotations();
-            meta_ann->set_name(key);
-            meta_ann->set_string_value(value);
+        if (out && writer.size() >= kFlushBytes && !writer.flushTo(*out)) {
+            return false;
         }
     }
     
-    // Serialize to binary
-    std::vector<uint8_t> result = trace.SerializeAsArray();
-    return result;
+    return out ? writer.flushTo(*out) : true;
 }
 
+#ifdef TRACESMITH_PERFETTO_SDK_ENABLED
+
 bool PerfettoProtoExporter::initializeTracingSession(const TracingConfig& /*config*/) {
     // Real-time tracing not implemented in ProtoZero version
     // Use exportToProto() for offline export instead
@@ -249,55 +386,343 @@ PerfettoProtoExporter::mapEventTypeToPerfetto(EventType type) {
     }
 }
 
-std::string PerfettoProtoExporter::getEventCategory(EventType type) {
+#endif // TRACESMITH_PERFETTO_SDK_ENABLED
+
+const std::string& PerfettoProtoExporter::getEventCategory(EventType type) {
+    static const std::string kernel = "gpu_kernel";
+    static const std::string memory = "gpu_memory";
+    static const std::string stream = "gpu_stream";
+    static const std::string sync = "gpu_sync";
+    static const std::string other = "gpu_other";
+    
     switch (type) {
         case EventType::KernelLaunch:
         case EventType::KernelComplete:
-            return "gpu_kernel";
+            return kernel;
         case EventType::MemcpyH2D:
         case EventType::MemcpyD2H:
         case EventType::MemcpyD2D:
         case EventType::MemsetDevice:
         case EventType::MemAlloc:
         case EventType::MemFree:
-            return "gpu_memory";
+            return memory;
         case EventType::StreamCreate:
         case EventType::StreamDestroy:
         case EventType::StreamSync:
-            return "gpu_stream";
+            return stream;
         case EventType::EventRecord:
         case EventType::EventSync:
         case EventType::DeviceSync:
-            return "gpu_sync";
+            return sync;
         default:
-            return "gpu_other";
+            return other;
     }
 }
 
-#endif // TRACESMITH_PERFETTO_SDK_ENABLED
-
 bool PerfettoProtoExporter::exportToJSON(
     const std::vector<TraceEvent>& events,
     const std::string& output_file)
 {
     // Use existing JSON exporter
     PerfettoExporter json_exporter;
+    json_exporter.setParallelism(num_threads_);
     return json_exporter.exportToFile(events, output_file);
 }
 
+// PerfettoLiveStreamer implementation
+
+PerfettoLiveStreamer::PerfettoLiveStreamer(RingBuffer<TraceEvent>& events,
+                                           RingBuffer<CounterEvent>& counters)
+    : events_(events)
+    , counters_(counters)
+    , writer_(std::make_unique<PerfettoProtoWriter>())
+{
+}
+
+PerfettoLiveStreamer::~PerfettoLiveStreamer() {
+    stop();
+    closeOutput();
+}
+
+bool PerfettoLiveStreamer::openFile(const std::string& path) {
+    closeOutput();
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        std::cerr << "Failed to open live trace file: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PerfettoLiveStreamer::connectSocket(const std::string& path) {
+    closeOutput();
+#ifdef _WIN32
+    std::cerr << "Live trace sockets are not supported on Windows\n";
+    return false;
+#else
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << "\n";
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "Failed to connect to " << path << ": " << std::strerror(errno) << "\n";
+        ::close(fd);
+        return false;
+    }
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    socket_fd_ = fd;
+    return true;
+#endif
+}
+
+bool PerfettoLiveStreamer::start(uint32_t flush_interval_ms) {
+    if (isRunning() || (!file_ && socket_fd_ < 0)) {
+        return false;
+    }
+    flush_interval_ms_ = flush_interval_ms > 0 ? flush_interval_ms : 1;
+    drain_stop_ = false;
+    io_stop_ = false;
+    io_thread_ = std::thread(&PerfettoLiveStreamer::ioLoop, this);
+    drain_thread_ = std::thread(&PerfettoLiveStreamer::drainLoop, this);
+    return true;
+}
+
+void PerfettoLiveStreamer::stop() {
+    if (!isRunning()) {
+        return;
+    }
+    
+    // The drain thread does a final pass before exiting
+    {
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        drain_stop_ = true;
+    }
+    drain_cv_.notify_all();
+    drain_thread_.join();
+    
+    // Then the I/O thread finishes the last batch
+    {
+        std::lock_guard<std::mutex> lock(io_mutex_);
+        io_stop_ = true;
+    }
+    io_cv_.notify_all();
+    io_thread_.join();
+    
+    closeOutput();
+}
+
+PerfettoLiveStreamer::Statistics PerfettoLiveStreamer::getStatistics() const {
+    Statistics stats;
+    stats.events_written = events_written_.load(std::memory_order_relaxed);
+    stats.counters_written = counters_written_.load(std::memory_order_relaxed);
+    stats.packets_written = packets_written_.load(std::memory_order_relaxed);
+    stats.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+    stats.flushes = flushes_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void PerfettoLiveStreamer::drainLoop() {
+    auto interval = std::chrono::milliseconds(flush_interval_ms_);
+    auto next = std::chrono::steady_clock::now() + interval;
+    
+    std::unique_lock<std::mutex> lock(drain_mutex_);
+    while (!drain_cv_.wait_until(lock, next, [this] { return drain_stop_; })) {
+        lock.unlock();
+        drainOnce(false);
+        lock.lock();
+        
+        // Fixed cadence; skip missed ticks rather than bursting
+        next += interval;
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) {
+            next = now + interval;
+        }
+    }
+    lock.unlock();
+    drainOnce(true);
+}
+
+void PerfettoLiveStreamer::drainOnce(bool final) {
+    PerfettoProtoWriter& writer = *writer_;
+    uint64_t packets_before = writer.packetCount();
+    drain_count_++;
+    
+    event_batch_.clear();
+    events_.popBatch(event_batch_, events_.capacity());
+    counter_batch_.clear();
+    counters_.popBatch(counter_batch_, counters_.capacity());
+    
+    EventScratch scratch;
+    size_t events_written = 0;
+    auto write = [&](const TraceEvent& event, std::pair<bool, bool> flow_role) {
+        const std::string& category = PerfettoProtoExporter::getEventCategory(event.type);
+        writeEvent(writer, event, category, writer.intern(event.name, category),
+                   flow_role, scratch);
+        events_written++;
+    };
+    
+    for (auto& event : event_batch_) {
+        if (devices_.insert(event.device_id).second) {
+            writer.addProcessTrack(processUuid(event.device_id), event.device_id,
+                                   "GPU Device " + std::to_string(event.device_id));
+        }
+        uint64_t stream = threadUuid(event.device_id, event.stream_id);
+        if (streams_.insert(stream).second) {
+            writer.addThreadTrack(stream, processUuid(event.device_id), event.device_id,
+                                  event.stream_id, "Stream " + std::to_string(event.stream_id));
+        }
+        
+        // Arrival order decides flows: hold the first event of a pair
+        // until the second arrives
+        if (event.correlation_id == 0) {
+            write(event, {false, false});
+            continue;
+        }
+        auto held = held_flows_.find(event.correlation_id);
+        if (held != held_flows_.end()) {
+            write(held->second.event, {true, false});
+            write(event, {false, true});
+            held_flows_.erase(held);
+            continue;
+        }
+        uint64_t sequence = ++held_sequence_;
+        held_order_.emplace_back(event.correlation_id, sequence);
+        held_flows_.emplace(event.correlation_id,
+                            HeldEvent{std::move(event), sequence, drain_count_});
+    }
+    
+    // Give up on partners that are late, too many, or will never come
+    while (!held_order_.empty()) {
+        auto [id, sequence] = held_order_.front();
+        auto held = held_flows_.find(id);
+        if (held != held_flows_.end() && held->second.sequence == sequence) {
+            if (!final && held_flows_.size() <= kMaxHeldFlows &&
+                drain_count_ - held->second.drain < kFlowHoldDrains) {
+                break;
+            }
+            write(held->second.event, {false, false});
+            held_flows_.erase(held);
+        }
+        held_order_.pop_front();
+    }
+    
+    for (const auto& counter : counter_batch_) {
+        auto [it, inserted] = counter_tracks_.emplace(
+            counter.counter_name, (uint64_t(1) << 60) | counter_tracks_.size());
+        if (inserted) {
+            writer.addCounterTrack(it->second, 0, counter.counter_name, counter.unit);
+        }
+        writer.writeCounter(it->second, counter.timestamp, counter.value);
+    }
+    
+    events_written_.fetch_add(events_written, std::memory_order_relaxed);
+    counters_written_.fetch_add(counter_batch_.size(), std::memory_order_relaxed);
+    packets_written_.fetch_add(writer.packetCount() - packets_before, std::memory_order_relaxed);
+    
+    if (writer.size() > 0) {
+        submit();
+    }
+}
+
+void PerfettoLiveStreamer::submit() {
+    std::unique_lock<std::mutex> lock(io_mutex_);
+    // Back pressure: wait for the previous batch, never hold more than two
+    io_cv_.wait(lock, [this] { return !back_busy_; });
+    writer_->swapData(back_);
+    back_busy_ = true;
+    lock.unlock();
+    io_cv_.notify_all();
+}
+
+void PerfettoLiveStreamer::ioLoop() {
+    std::unique_lock<std::mutex> lock(io_mutex_);
+    while (true) {
+        io_cv_.wait(lock, [this] { return back_busy_ || io_stop_; });
+        if (!back_busy_) {
+            return;
+        }
+        
+        // The drain thread does not touch back_ while it is busy
+        lock.unlock();
+        if (!writeOutput(back_.data(), back_.size())) {
+            good_.store(false, std::memory_order_relaxed);
+        }
+        bytes_written_.fetch_add(back_.size(), std::memory_order_relaxed);
+        flushes_.fetch_add(1, std::memory_order_relaxed);
+        back_.clear();
+        lock.lock();
+        
+        back_busy_ = false;
+        io_cv_.notify_all();
+    }
+}
+
+bool PerfettoLiveStreamer::writeOutput(const uint8_t* data, size_t size) {
+    if (!good()) {
+        return false;
+    }
+    if (file_) {
+        // Flush so a reader following the file sees whole batches
+        return std::fwrite(data, 1, size, file_) == size && std::fflush(file_) == 0;
+    }
+#ifndef _WIN32
+    int flags = 0;
+#ifdef MSG_NOSIGNAL
+    flags = MSG_NOSIGNAL;
+#endif
+    while (size > 0) {
+        ssize_t sent = ::send(socket_fd_, data, size, flags);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PerfettoLiveStreamer::closeOutput() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+#ifndef _WIN32
+    if (socket_fd_ >= 0) {
+        ::close(socket_fd_);
+        socket_fd_ = -1;
+    }
+#endif
+}
+
 // TracingSession implementation (v0.3.0)
 bool TracingSession::exportToFile(const std::string& filename, bool use_protobuf) {
-    if (state_ == State::Running) {
+    // In live mode the streamer owns the buffers until stop()
+    if (state_ == State::Running && !streamer_) {
         flushEvents();
         flushCounters();
     }
     
-    if (use_protobuf && PerfettoProtoExporter::isSDKAvailable()) {
+    if (use_protobuf) {
         PerfettoProtoExporter exporter(PerfettoProtoExporter::Format::PROTOBUF);
-        return exporter.exportToFile(flushed_events_, filename);
+        return exporter.exportToFile(flushed_events_, flushed_counters_, filename);
     } else {
         PerfettoExporter exporter;
-        return exporter.exportToFile(flushed_events_, filename);
+        return exporter.exportToFile(flushed_events_, flushed_counters_, filename);
     }
 }
 
@@ -0,0 +1,374 @@
+#include "tracesmith/state/perfetto_proto_writer.hpp"
+#include <cstring>
+
+namespace tracesmith {
+
+// ============================================================================
+// ProtoEncoder
+// ============================================================================
+
+namespace {
+
+/// Bytes reserved for a nested message length (redundant varint)
+constexpr size_t kNestedLengthBytes = 4;
+
+} // anonymous namespace
+
+void ProtoEncoder::writeVarint(uint64_t value) {
+    if (value < 0x80) {
+        buffer_.push_back(static_cast<uint8_t>(value));
+        return;
+    }
+    uint8_t bytes[10];
+    size_t count = 0;
+    while (value >= 0x80) {
+        bytes[count++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = static_cast<uint8_t>(value);
+    buffer_.insert(buffer_.end(), bytes, bytes + count);
+}
+
+void ProtoEncoder::writeTag(uint32_t field, uint32_t wire_type) {
+    writeVarint((static_cast<uint64_t>(field) << 3) | wire_type);
+}
+
+void ProtoEncoder::addVarint(uint32_t field, uint64_t value) {
+    writeTag(field, pftrace::WIRE_VARINT);
+    writeVarint(value);
+}
+
+void ProtoEncoder::addSignedVarint(uint32_t field, int64_t value) {
+    // int64 fields use two's complement, not zigzag
+    addVarint(field, static_cast<uint64_t>(value));
+}
+
+void ProtoEncoder::addDouble(uint32_t field, double value) {
+    writeTag(field, pftrace::WIRE_FIXED64);
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+    buffer_.insert(buffer_.end(), bytes, bytes + 8);
+}
+
+void ProtoEncoder::addString(uint32_t field, const std::string& value) {
+    writeTag(field, pftrace::WIRE_BYTES);
+    writeVarint(value.size());
+    buffer_.insert(buffer_.end(), value.begin(), value.end());
+}
+
+size_t ProtoEncoder::beginNested(uint32_t field) {
+    writeTag(field, pftrace::WIRE_BYTES);
+    size_t token = buffer_.size();
+    buffer_.resize(buffer_.size() + kNestedLengthBytes);
+    return token;
+}
+
+void ProtoEncoder::endNested(size_t token) {
+    size_t length = buffer_.size() - token - kNestedLengthBytes;
+    for (size_t i = 0; i < kNestedLengthBytes; ++i) {
+        uint8_t byte = static_cast<uint8_t>((length >> (7 * i)) & 0x7F);
+        if (i + 1 < kNestedLengthBytes) {
+            byte |= 0x80;
+        }
+        buffer_[token + i] = byte;
+    }
+}
+
+// ============================================================================
+// ProtoAnnotation
+// ============================================================================
+
+ProtoAnnotation ProtoAnnotation::ofUint(std::string name, uint64_t value) {
+    ProtoAnnotation annotation;
+    annotation.name = std::move(name);
+    annotation.kind = Kind::Uint;
+    annotation.uint_value = value;
+    return annotation;
+}
+
+ProtoAnnotation ProtoAnnotation::ofInt(std::string name, int64_t value) {
+    ProtoAnnotation annotation;
+    annotation.name = std::move(name);
+    annotation.kind = Kind::Int;
+    annotation.int_value = value;
+    return annotation;
+}
+
+ProtoAnnotation ProtoAnnotation::ofDouble(std::string name, double value) {
+    ProtoAnnotation annotation;
+    annotation.name = std::move(name);
+    annotation.kind = Kind::Double;
+    annotation.double_value = value;
+    return annotation;
+}
+
+ProtoAnnotation ProtoAnnotation::ofString(std::string name, std::string value) {
+    ProtoAnnotation annotation;
+    annotation.name = std::move(name);
+    annotation.kind = Kind::String;
+    annotation.string_value = std::move(value);
+    return annotation;
+}
+
+// ============================================================================
+// PerfettoProtoWriter
+// ============================================================================
+
+PerfettoProtoWriter::PerfettoProtoWriter(uint32_t sequence_id)
+    : sequence_id_(sequence_id) {
+    buffer_.reserve(64 * 1024);
+}
+
+size_t PerfettoProtoWriter::beginPacket(ProtoEncoder& encoder, Timestamp timestamp,
+                                        bool needs_state) {
+    size_t token = encoder.beginNested(pftrace::TRACE_PACKET);
+    if (timestamp != 0) {
+        encoder.addVarint(pftrace::PACKET_TIMESTAMP, timestamp);
+    }
+    encoder.addVarint(pftrace::PACKET_SEQUENCE_ID, sequence_id_);
+
+    if (needs_state) {
+        uint32_t flags = pftrace::SEQ_NEEDS_INCREMENTAL_STATE;
+        if (!state_cleared_) {
+            flags |= pftrace::SEQ_INCREMENTAL_STATE_CLEARED;
+            state_cleared_ = true;
+        }
+        encoder.addVarint(pftrace::PACKET_SEQUENCE_FLAGS, flags);
+    }
+    return token;
+}
+
+void PerfettoProtoWriter::endPacket(ProtoEncoder& encoder, size_t token) {
+    encoder.endNested(token);
+    packet_count_++;
+}
+
+void PerfettoProtoWriter::addProcessTrack(uint64_t uuid, uint32_t pid, const std::string& name) {
+    ProtoEncoder encoder(buffer_);
+    size_t packet = beginPacket(encoder, 0, false);
+    size_t track = encoder.beginNested(pftrace::PACKET_TRACK_DESCRIPTOR);
+    encoder.addVarint(pftrace::TRACK_UUID, uuid);
+
+    size_t process = encoder.beginNested(pftrace::TRACK_PROCESS);
+    encoder.addVarint(pftrace::PROCESS_PID, pid);
+    encoder.addString(pftrace::PROCESS_NAME, name);
+    encoder.endNested(process);
+
+    encoder.endNested(track);
+    endPacket(encoder, packet);
+}
+
+void PerfettoProtoWriter::addThreadTrack(uint64_t uuid, uint64_t parent_uuid, uint32_t pid,
+                                         uint32_t tid, const std::string& name) {
+    ProtoEncoder encoder(buffer_);
+    size_t packet = beginPacket(encoder, 0, false);
+    size_t track = encoder.beginNested(pftrace::PACKET_TRACK_DESCRIPTOR);
+    encoder.addVarint(pftrace::TRACK_UUID, uuid);
+    if (parent_uuid != 0) {
+        encoder.addVarint(pftrace::TRACK_PARENT_UUID, parent_uuid);
+    }
+
+    size_t thread = encoder.beginNested(pftrace::TRACK_THREAD);
+    encoder.addVarint(pftrace::THREAD_PID, pid);
+    encoder.addVarint(pftrace::THREAD_TID, tid);
+    encoder.addString(pftrace::THREAD_NAME, name);
+    encoder.endNested(thread);
+
+    encoder.endNested(track);
+    endPacket(encoder, packet);
+}
+
+void PerfettoProtoWriter::addCounterTrack(uint64_t uuid, uint64_t parent_uuid,
+                                          const std::string& name, const std::string& unit) {
+    ProtoEncoder encoder(buffer_);
+    size_t packet = beginPacket(encoder, 0, false);
+    size_t track = encoder.beginNested(pftrace::PACKET_TRACK_DESCRIPTOR);
+    encoder.addVarint(pftrace::TRACK_UUID, uuid);
+    if (parent_uuid != 0) {
+        encoder.addVarint(pftrace::TRACK_PARENT_UUID, parent_uuid);
+    }
+    encoder.addString(pftrace::TRACK_NAME, name);
+
+    size_t counter = encoder.beginNested(pftrace::TRACK_COUNTER);
+    if (!unit.empty()) {
+        encoder.addString(pftrace::COUNTER_UNIT_NAME, unit);
+    }
+    encoder.endNested(counter);
+
+    encoder.endNested(track);
+    endPacket(encoder, packet);
+}
+
+PerfettoProtoWriter::InternedIds PerfettoProtoWriter::intern(const std::string& name,
+                                                             const std::string& category) {
+    InternedIds ids;
+    auto name_it = name_iids_.emplace(name, name_iids_.size() + 1);
+    ids.name_iid = name_it.first->second;
+    ids.new_name = name_it.second;
+    auto category_it = category_iids_.emplace(category, category_iids_.size() + 1);
+    ids.category_iid = category_it.first->second;
+    ids.new_category = category_it.second;
+    return ids;
+}
+
+void PerfettoProtoWriter::writeTrackEvent(uint64_t track_uuid, Timestamp timestamp, uint32_t type,
+                                          const std::string* name, const std::string* category,
+                                          const InternedIds& ids,
+                                          const std::vector<ProtoAnnotation>* annotations,
+                                          const std::vector<uint64_t>* flow_ids,
+                                          const std::vector<uint64_t>* terminating_flow_ids,
+                                          const double* counter_value) {
+    // New interned entries ride along in this packet
+    uint64_t name_iid = ids.name_iid;
+    uint64_t category_iid = ids.category_iid;
+    bool new_name = name && ids.new_name;
+    bool new_category = category && ids.new_category;
+
+    ProtoEncoder encoder(buffer_);
+    size_t packet = beginPacket(encoder, timestamp, true);
+
+    if (new_name || new_category) {
+        size_t interned = encoder.beginNested(pftrace::PACKET_INTERNED_DATA);
+        if (new_category) {
+            size_t entry = encoder.beginNested(pftrace::INTERNED_EVENT_CATEGORIES);
+            encoder.addVarint(pftrace::INTERNED_IID, category_iid);
+            encoder.addString(pftrace::INTERNED_NAME, *category);
+            encoder.endNested(entry);
+        }
+        if (new_name) {
+            size_t entry = encoder.beginNested(pftrace::INTERNED_EVENT_NAMES);
+            encoder.addVarint(pftrace::INTERNED_IID, name_iid);
+            encoder.addString(pftrace::INTERNED_NAME, *name);
+            encoder.endNested(entry);
+        }
+        encoder.endNested(interned);
+    }
+
+    size_t event = encoder.beginNested(pftrace::PACKET_TRACK_EVENT);
+    encoder.addVarint(pftrace::EVENT_TYPE, type);
+    encoder.addVarint(pftrace::EVENT_TRACK_UUID, track_uuid);
+    if (category) {
+        encoder.addVarint(pftrace::EVENT_CATEGORY_IIDS, category_iid);
+    }
+    if (name) {
+        encoder.addVarint(pftrace::EVENT_NAME_IID, name_iid);
+    }
+    if (counter_value) {
+        encoder.addDouble(pftrace::EVENT_DOUBLE_COUNTER_VALUE, *counter_value);
+    }
+
+    if (annotations) {
+        for (const auto& annotation : *annotations) {
+            size_t entry = encoder.beginNested(pftrace::EVENT_DEBUG_ANNOTATIONS);
+            encoder.addString(pftrace::ANNOTATION_NAME, annotation.name);
+            switch (annotation.kind) {
+                case ProtoAnnotation::Kind::Uint:
+                    encoder.addVarint(pftrace::ANNOTATION_UINT_VALUE, annotation.uint_value);
+                    break;
+                case ProtoAnnotation::Kind::Int:
+                    encoder.addSignedVarint(pftrace::ANNOTATION_INT_VALUE, annotation.int_value);
+                    break;
+                case ProtoAnnotation::Kind::Double:
+                    encoder.addDouble(pftrace::ANNOTATION_DOUBLE_VALUE, annotation.double_value);
+                    break;
+                case ProtoAnnotation::Kind::String:
+                    encoder.addString(pftrace::ANNOTATION_STRING_VALUE, annotation.string_value);
+                    break;
+            }
+            encoder.endNested(entry);
+        }
+    }
+
+    if (flow_ids) {
+        for (uint64_t id : *flow_ids) {
+            encoder.addVarint(pftrace::EVENT_FLOW_IDS, id);
+        }
+    }
+    if (terminating_flow_ids) {
+        for (uint64_t id : *terminating_flow_ids) {
+            encoder.addVarint(pftrace::EVENT_TERMINATING_FLOW_IDS, id);
+        }
+    }
+
+    encoder.endNested(event);
+    endPacket(encoder, packet);
+}
+
+void PerfettoProtoWriter::writeSlice(uint64_t track_uuid, Timestamp timestamp, Timestamp duration,
+                                     const std::string& name, const std::string& category,
+                                     const std::vector<ProtoAnnotation>& annotations,
+                                     const std::vector<uint64_t>& flow_ids,
+                                     const std::vector<uint64_t>& terminating_flow_ids) {
+    writeSlice(track_uuid, timestamp, duration, name, category, intern(name, category),
+               annotations, flow_ids, terminating_flow_ids);
+}
+
+void PerfettoProtoWriter::writeSlice(uint64_t track_uuid, Timestamp timestamp, Timestamp duration,
+                                     const std::string& name, const std::string& category,
+                                     const InternedIds& ids,
+                                     const std::vector<ProtoAnnotation>& annotations,
+                                     const std::vector<uint64_t>& flow_ids,
+                                     const std::vector<uint64_t>& terminating_flow_ids) {
+    writeTrackEvent(track_uuid, timestamp, pftrace::TYPE_SLICE_BEGIN, &name, &category, ids,
+                    &annotations, &flow_ids, &terminating_flow_ids, nullptr);
+    writeTrackEvent(track_uuid, timestamp + duration, pftrace::TYPE_SLICE_END, nullptr, nullptr,
+                    InternedIds(), nullptr, nullptr, nullptr, nullptr);
+}
+
+void PerfettoProtoWriter::writeInstant(uint64_t track_uuid, Timestamp timestamp,
+                                       const std::string& name, const std::string& category,
+                                       const std::vector<ProtoAnnotation>& annotations,
+                                       const std::vector<uint64_t>& flow_ids,
+                                       const std::vector<uint64_t>& terminating_flow_ids) {
+    writeInstant(track_uuid, timestamp, name, category, intern(name, category),
+                 annotations, flow_ids, terminating_flow_ids);
+}
+
+void PerfettoProtoWriter::writeInstant(uint64_t track_uuid, Timestamp timestamp,
+                                       const std::string& name, const std::string& category,
+                                       const InternedIds& ids,
+                                       const std::vector<ProtoAnnotation>& annotations,
+                                       const std::vector<uint64_t>& flow_ids,
+                                       const std::vector<uint64_t>& terminating_flow_ids) {
+    writeTrackEvent(track_uuid, timestamp, pftrace::TYPE_INSTANT, &name, &category, ids,
+                    &annotations, &flow_ids, &terminating_flow_ids, nullptr);
+}
+
+void PerfettoProtoWriter::writeCounter(uint64_t track_uuid, Timestamp timestamp, double value) {
+    writeTrackEvent(track_uuid, timestamp, pftrace::TYPE_COUNTER, nullptr, nullptr,
+                    InternedIds(), nullptr, nullptr, nullptr, &value);
+}
+
+void PerfettoProtoWriter::append(PerfettoProtoWriter& other) {
+    buffer_.insert(buffer_.end(), other.buffer_.begin(), other.buffer_.end());
+    packet_count_ += other.packet_count_;
+    state_cleared_ = state_cleared_ || other.state_cleared_;
+    other.buffer_.clear();
+    other.packet_count_ = 0;
+}
+
+void PerfettoProtoWriter::resetIncrementalState() {
+    name_iids_.clear();
+    category_iids_.clear();
+    state_cleared_ = false;
+}
+
+bool PerfettoProtoWriter::flushTo(std::ostream& out) {
+    out.write(reinterpret_cast<const char*>(buffer_.data()),
+              static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+    return out.good();
+}
+
+std::vector<uint8_t> PerfettoProtoWriter::takeData() {
+    std::vector<uint8_t> data;
+    data.swap(buffer_);
+    buffer_.reserve(64 * 1024);
+    return data;
+}
+
+} // namespace tracesmith
@@ -6,6 +6,7 @@
  */
 
 #include "tracesmith/tracy/tracy_exporter.hpp"
+#include "tracesmith/tracy/tracy_gpu_context.hpp"
 
 #ifdef TRACY_ENABLE
 #include <tracy/Tracy.hpp>
@@ -42,6 +43,7 @@ TracyExporter::TracyExporter(TracyExporter&& other) noexcept
     , gpu_zones_emitted_(other.gpu_zones_emitted_.load())
     , query_id_counter_(other.query_id_counter_.load())
     , gpu_contexts_(std::move(other.gpu_contexts_))
+    , zone_contexts_(std::move(other.zone_contexts_))
     , configured_plots_(std::move(other.configured_plots_))
 {
     other.initialized_ = false;
@@ -56,6 +58,7 @@ TracyExporter& TracyExporter::operator=(TracyExporter&& other) noexcept {
         gpu_zones_emitted_.store(other.gpu_zones_emitted_.load());
         query_id_counter_.store(other.query_id_counter_.load());
         gpu_contexts_ = std::move(other.gpu_contexts_);
+        zone_contexts_ = std::move(other.zone_contexts_);
         configured_plots_ = std::move(other.configured_plots_);
         other.initialized_ = false;
     }
@@ -94,6 +97,8 @@ void TracyExporter::shutdown() {
     {
         std::lock_guard<std::mutex> lock(gpu_context_mutex_);
         gpu_contexts_.clear();
+        zone_contexts_.clear();
+        zone_batches_.clear();
     }
     
     initialized_ = false;
@@ -112,34 +117,29 @@ void TracyExporter::emitEvent(const TraceEvent& event) {
         return;
     }
     
-    // Filter events based on configuration
-    bool should_emit = false;
-    switch (event.type) {
+    if (shouldEmit(event.type)) {
+        emitTraceEventInternal(event);
+        events_emitted_.fetch_add(1);
+    }
+}
+
+bool TracyExporter::shouldEmit(EventType type) const {
+    switch (type) {
         case EventType::KernelLaunch:
         case EventType::KernelComplete:
-            should_emit = config_.emit_kernel_events;
-            break;
+            return config_.emit_kernel_events;
         case EventType::MemcpyH2D:
         case EventType::MemcpyD2H:
         case EventType::MemcpyD2D:
-            should_emit = config_.emit_memcpy_events;
-            break;
+            return config_.emit_memcpy_events;
         case EventType::StreamSync:
         case EventType::DeviceSync:
-            should_emit = config_.emit_sync_events;
-            break;
+            return config_.emit_sync_events;
         case EventType::MemAlloc:
         case EventType::MemFree:
-            should_emit = config_.emit_alloc_events;
-            break;
+            return config_.emit_alloc_events;
         default:
-            should_emit = true;
-            break;
-    }
-    
-    if (should_emit) {
-        emitTraceEventInternal(event);
-        events_emitted_.fetch_add(1);
+            return true;
     }
 }
 
@@ -166,9 +166,60 @@ void TracyExporter::exportEvents(const std::vector<TraceEvent>& events) {
         return;
     }
     
-    for (const auto& event : events) {
-        emitEvent(event);
+    if (!config_.enable_gpu_zones) {
+        for (const auto& event : events) {
+            emitEvent(event);
+        }
+        return;
+    }
+    
+    uint64_t emitted = 0;
+    uint64_t zones = 0;
+    {
+        std::lock_guard<std::mutex> lock(gpu_context_mutex_);
+        for (auto& batch : zone_batches_) {
+            batch.events.clear();
+        }
+        
+        // Group GPU work per device; consecutive events usually share one
+        ZoneBatch* current = nullptr;
+        for (const auto& event : events) {
+            if (!shouldEmit(event.type)) {
+                continue;
+            }
+            if (!isGpuTimelineEvent(event.type)) {
+                emitTraceEventInternal(event);
+                emitted++;
+                continue;
+            }
+            if (!current || current->device_id != event.device_id) {
+                auto it = std::find_if(zone_batches_.begin(), zone_batches_.end(),
+                                       [&](const ZoneBatch& batch) {
+                                           return batch.device_id == event.device_id;
+                                       });
+                if (it == zone_batches_.end()) {
+                    ZoneBatch batch;
+                    batch.device_id = event.device_id;
+                    batch.context = zoneContextLocked(event.device_id);
+                    zone_batches_.push_back(std::move(batch));
+                    it = zone_batches_.end() - 1;
+                }
+                current = &*it;
+            }
+            current->events.push_back(&event);
+        }
+        
+        for (auto& batch : zone_batches_) {
+            if (batch.events.empty()) {
+                continue;
+            }
+            batch.context->emitGpuZones(batch.events.data(), batch.events.size());
+            zones += batch.events.size();
+        }
     }
+    
+    events_emitted_.fetch_add(emitted + zones);
+    gpu_zones_emitted_.fetch_add(zones);
 }
 
 void TracyExporter::exportTraceRecord(const TraceRecord& record) {
@@ -383,6 +434,20 @@ void TracyExporter::setupDefaultPlots() {
 #endif
 }
 
+TracyGpuContext* TracyExporter::zoneContextLocked(uint32_t device_id) {
+    auto it = zone_contexts_.find(device_id);
+    if (it != zone_contexts_.end()) {
+        return it->second;
+    }
+    
+    // Contexts are owned by the global registry and live for the process
+    TracyGpuContext* context = &getOrCreateGpuContext(
+        config_.gpu_context_name + " " + std::to_string(device_id),
+        GpuContextType::Generic, device_id);
+    zone_contexts_[device_id] = context;
+    return context;
+}
+
 uint32_t TracyExporter::allocateQueryId() {
     return query_id_counter_.fetch_add(2);
 }
@@ -18,6 +18,30 @@
 namespace tracesmith {
 namespace tracy {
 
+namespace {
+
+/// Timeline color for a GPU event type
+uint32_t zoneColor(EventType type) {
+    switch (type) {
+        case EventType::KernelLaunch:
+        case EventType::KernelComplete:
+            return 0xFF4444; // Red
+        case EventType::MemcpyH2D:
+            return 0x4444FF; // Blue
+        case EventType::MemcpyD2H:
+            return 0xFF44FF; // Magenta
+        case EventType::MemcpyD2D:
+            return 0x44FFFF; // Cyan
+        case EventType::StreamSync:
+        case EventType::DeviceSync:
+            return 0x8844FF; // Purple
+        default:
+            return 0x888888; // Gray
+    }
+}
+
+} // anonymous namespace
+
 // =============================================================================
 // Source Location Cache
 // =============================================================================
@@ -28,10 +52,14 @@ TracyGpuContext::SourceLocationCache& TracyGpuContext::getSourceLocationCache()
 }
 
 ::tracy::SourceLocationData* TracyGpuContext::SourceLocationCache::getOrCreate(
-    const std::string& name, uint32_t color) {
-#ifdef TRACY_ENABLE
+    std::string_view name, uint32_t color) {
     std::lock_guard<std::mutex> lock(mutex);
-    
+    return getOrCreateLocked(name, color);
+}
+
+::tracy::SourceLocationData* TracyGpuContext::SourceLocationCache::getOrCreateLocked(
+    std::string_view name, uint32_t color) {
+#ifdef TRACY_ENABLE
     auto it = locations.find(name);
     if (it != locations.end()) {
         return it->second;
@@ -40,7 +68,8 @@ TracyGpuContext::SourceLocationCache& TracyGpuContext::getSourceLocationCache()
     // Allocate persistent storage for the source location
     // Tracy requires these to remain valid for the lifetime of the profiler
     char* name_copy = new char[name.size() + 1];
-    std::strcpy(name_copy, name.c_str());
+    std::memcpy(name_copy, name.data(), name.size());
+    name_copy[name.size()] = '\0';
     
     auto* loc = new ::tracy::SourceLocationData{
         name_copy,      // name
@@ -50,7 +79,7 @@ TracyGpuContext::SourceLocationCache& TracyGpuContext::getSourceLocationCache()
         color           // color
     };
     
-    locations[name] = loc;
+    locations[std::string_view(name_copy, name.size())] = loc;
     return loc;
 #else
     (void)name;
@@ -200,8 +229,8 @@ void TracyGpuContext::emitZoneInternal(const char* zone_name, size_t name_len,
     if (!isValid()) return;
     
     // Get or create source location
-    std::string name_str(zone_name, name_len);
-    auto* src_loc = getSourceLocationCache().getOrCreate(name_str, color);
+    auto* src_loc = getSourceLocationCache().getOrCreate(
+        std::string_view(zone_name, name_len), color);
     
     // Allocate query IDs
     uint16_t query_id = allocateQueryId();
@@ -211,6 +240,25 @@ void TracyGpuContext::emitZoneInternal(const char* zone_name, size_t name_len,
         thread_id = ::tracy::GetThreadHandle();
     }
     
+    writeZone(src_loc, query_id, cpu_start, cpu_end, gpu_start, gpu_end, thread_id);
+    zones_emitted_.fetch_add(1);
+#else
+    (void)zone_name;
+    (void)name_len;
+    (void)cpu_start;
+    (void)cpu_end;
+    (void)gpu_start;
+    (void)gpu_end;
+    (void)thread_id;
+    (void)color;
+#endif
+}
+
+void TracyGpuContext::writeZone(const ::tracy::SourceLocationData* src_loc, uint16_t query_id,
+                                 int64_t cpu_start, int64_t cpu_end,
+                                 int64_t gpu_start, int64_t gpu_end,
+                                 uint32_t thread_id) {
+#ifdef TRACY_ENABLE
     // Emit GPU zone begin
     {
         auto* item = ::tracy::Profiler::QueueSerial();
@@ -252,17 +300,14 @@ void TracyGpuContext::emitZoneInternal(const char* zone_name, size_t name_len,
         ::tracy::MemWrite(&item->gpuTime.context, context_id_);
         ::tracy::Profiler::QueueSerialFinish();
     }
-    
-    zones_emitted_.fetch_add(1);
 #else
-    (void)zone_name;
-    (void)name_len;
+    (void)src_loc;
+    (void)query_id;
     (void)cpu_start;
     (void)cpu_end;
     (void)gpu_start;
     (void)gpu_end;
     (void)thread_id;
-    (void)color;
 #endif
 }
 
@@ -279,30 +324,7 @@ void TracyGpuContext::emitGpuZone(const char* zone_name,
 }
 
 void TracyGpuContext::emitGpuZone(const TraceEvent& event) {
-    // Determine color based on event type
-    uint32_t color = 0;
-    switch (event.type) {
-        case EventType::KernelLaunch:
-        case EventType::KernelComplete:
-            color = 0xFF4444; // Red
-            break;
-        case EventType::MemcpyH2D:
-            color = 0x4444FF; // Blue
-            break;
-        case EventType::MemcpyD2H:
-            color = 0xFF44FF; // Magenta
-            break;
-        case EventType::MemcpyD2D:
-            color = 0x44FFFF; // Cyan
-            break;
-        case EventType::StreamSync:
-        case EventType::DeviceSync:
-            color = 0x8844FF; // Purple
-            break;
-        default:
-            color = 0x888888; // Gray
-            break;
-    }
+    uint32_t color = zoneColor(event.type);
     
     // Calculate timestamps
     int64_t cpu_start = static_cast<int64_t>(event.timestamp);
@@ -319,24 +341,60 @@ void TracyGpuContext::emitGpuZone(const TraceEvent& event) {
 }
 
 void TracyGpuContext::emitGpuZones(const std::vector<TraceEvent>& events) {
+    std::vector<const TraceEvent*> gpu_events;
+    gpu_events.reserve(events.size());
     for (const auto& event : events) {
         // Only emit GPU-related events
-        switch (event.type) {
-            case EventType::KernelLaunch:
-            case EventType::KernelComplete:
-            case EventType::MemcpyH2D:
-            case EventType::MemcpyD2H:
-            case EventType::MemcpyD2D:
-            case EventType::MemsetDevice:
-            case EventType::StreamSync:
-            case EventType::DeviceSync:
-                emitGpuZone(event);
-                break;
-            default:
-                // Skip non-GPU events
-                break;
+        if (isGpuTimelineEvent(event.type)) {
+            gpu_events.push_back(&event);
         }
     }
+    emitGpuZones(gpu_events.data(), gpu_events.size());
+}
+
+void TracyGpuContext::emitGpuZones(const TraceEvent* const* events, size_t count) {
+#ifdef TRACY_ENABLE
+    if (!isValid() || count == 0) return;
+    
+    // Resolve all source locations first, under one lock. Runs of the same
+    // kernel are common, so repeat names skip the hash lookup.
+    thread_local std::vector<const ::tracy::SourceLocationData*> locations;
+    locations.resize(count);
+    {
+        auto& cache = getSourceLocationCache();
+        std::lock_guard<std::mutex> lock(cache.mutex);
+        std::string_view previous_name;
+        const ::tracy::SourceLocationData* previous = nullptr;
+        for (size_t i = 0; i < count; ++i) {
+            std::string_view name = events[i]->name;
+            if (!previous || name != previous_name) {
+                previous = cache.getOrCreateLocked(name, zoneColor(events[i]->type));
+                previous_name = name;
+            }
+            locations[i] = previous;
+        }
+    }
+    
+    // One pair of query IDs per zone, reserved together
+    uint16_t query_id = query_counter_.fetch_add(static_cast<uint16_t>(count * 2));
+    uint32_t current_thread = ::tracy::GetThreadHandle();
+    
+    for (size_t i = 0; i < count; ++i) {
+        const TraceEvent& event = *events[i];
+        int64_t cpu_start = static_cast<int64_t>(event.timestamp);
+        int64_t cpu_end = cpu_start + static_cast<int64_t>(event.duration);
+        uint32_t thread_id = event.thread_id != 0 ? event.thread_id : current_thread;
+        
+        // CPU timestamps stand in for GPU timestamps, as in emitGpuZone()
+        writeZone(locations[i], query_id, cpu_start, cpu_end, cpu_start, cpu_end, thread_id);
+        query_id = static_cast<uint16_t>(query_id + 2);
+    }
+    
+    zones_emitted_.fetch_add(count);
+#else
+    (void)events;
+    (void)count;
+#endif
 }
 
 // =============================================================================
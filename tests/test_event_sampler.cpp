@@ -0,0 +1,265 @@
+#include <gtest/gtest.h>
+#include <tracesmith/capture/profiler.hpp>
+#include <thread>
+#include <vector>
+
+using namespace tracesmith;
+
+namespace {
+
+TraceEvent makeEvent(const std::string& name, Timestamp timestamp = 0, uint64_t duration = 0,
+                     EventType type = EventType::KernelLaunch) {
+    TraceEvent event(type, timestamp);
+    event.name = name;
+    event.duration = duration;
+    return event;
+}
+
+SamplingRule excludeRule(const std::string& pattern) {
+    SamplingRule rule;
+    rule.pattern = pattern;
+    rule.exclude = true;
+    return rule;
+}
+
+} // anonymous namespace
+
+// ============================================================
+// Matching
+// ============================================================
+
+TEST(EventSamplerTest, PassesEverythingByDefault) {
+    EventSampler sampler;
+    sampler.configure(ProfilerConfig());
+    EXPECT_FALSE(sampler.isActive());
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(sampler.admit(makeEvent("kernel")));
+    }
+    auto totals = sampler.totals();
+    EXPECT_EQ(totals.seen, 10u);
+    EXPECT_EQ(totals.kept, 10u);
+}
+
+TEST(EventSamplerTest, GlobsMatchWholeNames) {
+    ProfilerConfig config;
+    config.sampling.rules = {excludeRule("gemm_*"), excludeRule("*_bwd"),
+                             excludeRule("conv?d*bias*"), excludeRule("relu")};
+    EventSampler sampler;
+    sampler.configure(config);
+
+    EXPECT_FALSE(sampler.admit(makeEvent("gemm_")));
+    EXPECT_FALSE(sampler.admit(makeEvent("gemm_128x128")));
+    EXPECT_FALSE(sampler.admit(makeEvent("attention_bwd")));
+    EXPECT_FALSE(sampler.admit(makeEvent("conv2d_bias_relu")));
+    EXPECT_FALSE(sampler.admit(makeEvent("conv3dbias")));
+    EXPECT_FALSE(sampler.admit(makeEvent("relu")));
+
+    EXPECT_TRUE(sampler.admit(makeEvent("sgemm_nn")));
+    EXPECT_TRUE(sampler.admit(makeEvent("attention_bwd_v2")));
+    EXPECT_TRUE(sampler.admit(makeEvent("conv2d")));
+    EXPECT_TRUE(sampler.admit(makeEvent("conv12d_bias")));
+    EXPECT_TRUE(sampler.admit(makeEvent("relu6")));
+    EXPECT_TRUE(sampler.admit(makeEvent("")));
+
+    EXPECT_EQ(sampler.totals().filtered, 6u);
+}
+
+TEST(EventSamplerTest, FirstMatchingRuleDecides) {
+    SamplingRule keep_memcpy;
+    keep_memcpy.pattern = "*";
+    keep_memcpy.type = EventType::MemcpyH2D;
+
+    ProfilerConfig config;
+    config.sampling.rules = {excludeRule("debug_*"), keep_memcpy, excludeRule("*")};
+    EventSampler sampler;
+    sampler.configure(config);
+
+    EXPECT_FALSE(sampler.admit(makeEvent("debug_copy", 0, 0, EventType::MemcpyH2D)));
+    EXPECT_TRUE(sampler.admit(makeEvent("copy", 0, 0, EventType::MemcpyH2D)));
+    EXPECT_FALSE(sampler.admit(makeEvent("copy", 0, 0, EventType::MemcpyD2H)));
+    EXPECT_FALSE(sampler.admit(makeEvent("kernel")));
+}
+
+TEST(EventSamplerTest, TypeSwitchesFilterEvents) {
+    ProfilerConfig config;
+    config.capture_memcpy = false;
+    config.capture_alloc = false;
+    EventSampler sampler;
+    sampler.configure(config);
+    EXPECT_TRUE(sampler.isActive());
+
+    EXPECT_TRUE(sampler.admit(makeEvent("kernel")));
+    EXPECT_FALSE(sampler.admit(makeEvent("copy", 0, 0, EventType::MemcpyD2D)));
+    EXPECT_FALSE(sampler.admit(makeEvent("alloc", 0, 0, EventType::MemAlloc)));
+    EXPECT_TRUE(sampler.admit(makeEvent("sync", 0, 0, EventType::StreamSync)));
+
+    auto totals = sampler.totals();
+    EXPECT_EQ(totals.seen, 4u);
+    EXPECT_EQ(totals.kept, 2u);
+    EXPECT_EQ(totals.filtered, 2u);
+}
+
+// ============================================================
+// Sampling and counters
+// ============================================================
+
+TEST(EventSamplerTest, SamplesOneInNPerNameWithExactCounts) {
+    SamplingRule rule;
+    rule.pattern = "elementwise_*";
+    rule.sample_every = 4;
+    rule.keep_slower_than_ns = 1000;
+    ProfilerConfig config;
+    config.sampling.rules.push_back(rule);
+    EventSampler sampler;
+    sampler.configure(config);
+
+    // 100 fast events of each of two names, plus 5 slow ones of the first
+    size_t kept_add = 0, kept_mul = 0;
+    for (int i = 0; i < 100; ++i) {
+        kept_add += sampler.admit(makeEvent("elementwise_add", i * 10, 10));
+        kept_mul += sampler.admit(makeEvent("elementwise_mul", i * 10, 20));
+    }
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(sampler.admit(makeEvent("elementwise_add", 2000 + i, 5000)));
+    }
+    EXPECT_EQ(kept_add, 25u);
+    EXPECT_EQ(kept_mul, 25u);
+
+    auto by_name = sampler.countersByName();
+    const SamplingCounters& add = by_name.at("elementwise_add");
+    EXPECT_EQ(add.seen, 105u);
+    EXPECT_EQ(add.kept, 30u);
+    EXPECT_EQ(add.kept_slow, 5u);
+    EXPECT_EQ(add.sampled_out, 75u);
+    EXPECT_EQ(add.dropped_duration_ns, 750u);
+    EXPECT_DOUBLE_EQ(add.weight(), 4.0);
+
+    // Re-weighted counts are exact: slow events count once, the rest by weight
+    EXPECT_DOUBLE_EQ(add.kept_slow + (add.kept - add.kept_slow) * add.weight(), 105.0);
+
+    auto totals = sampler.totals();
+    EXPECT_EQ(totals.seen, 205u);
+    EXPECT_EQ(totals.kept, 55u);
+    EXPECT_EQ(totals.sampled_out, 150u);
+    EXPECT_EQ(totals.dropped_duration_ns, 750u + 75u * 20u);
+
+    sampler.reset();
+    EXPECT_EQ(sampler.totals().seen, 0u);
+    EXPECT_TRUE(sampler.countersByName().empty());
+    EXPECT_TRUE(sampler.admit(makeEvent("elementwise_add")));  // Counter restarts
+}
+
+TEST(EventSamplerTest, RateLimitsPerNameOnEventTimestamps) {
+    SamplingRule rule;
+    rule.pattern = "*";
+    rule.max_per_second = 100;
+    rule.keep_slower_than_ns = 1000000;
+    ProfilerConfig config;
+    config.sampling.rules.push_back(rule);
+    EventSampler sampler;
+    sampler.configure(config);
+
+    // 1000 launches in one second of device time: a full bucket of 100,
+    // then 100 more as it refills
+    const Timestamp start = 5000000000ull;
+    size_t kept = 0;
+    for (int i = 0; i < 1000; ++i) {
+        kept += sampler.admit(makeEvent("launch", start + i * 1000000ull, 100));
+    }
+    EXPECT_NEAR(static_cast<double>(kept), 200.0, 1.0);
+
+    // Another name has its own bucket; slow events bypass the limit
+    EXPECT_TRUE(sampler.admit(makeEvent("other", start + 999000000ull, 100)));
+    EXPECT_TRUE(sampler.admit(makeEvent("launch", start + 999000000ull, 2000000)));
+
+    auto counters = sampler.countersByName().at("launch");
+    EXPECT_EQ(counters.seen, 1001u);
+    EXPECT_EQ(counters.kept, kept + 1);
+    EXPECT_EQ(counters.rate_limited, 1000u - kept);
+    EXPECT_EQ(counters.kept_slow, 1u);
+}
+
+TEST(EventSamplerTest, ConcurrentAdmitKeepsExactCounts) {
+    SamplingRule rule;
+    rule.pattern = "k*";
+    rule.sample_every = 10;
+    ProfilerConfig config;
+    config.sampling.rules.push_back(rule);
+    EventSampler sampler;
+    sampler.configure(config);
+
+    const int threads = 4;
+    const int per_thread = 20000;
+    std::vector<std::thread> workers;
+    std::vector<size_t> kept(threads, 0);
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < per_thread; ++i) {
+                kept[t] += sampler.admit(makeEvent(i % 2 ? "k_even" : "k_odd", i, 1));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    size_t total_kept = 0;
+    for (size_t k : kept) {
+        total_kept += k;
+    }
+    auto totals = sampler.totals();
+    EXPECT_EQ(totals.seen, static_cast<uint64_t>(threads * per_thread));
+    EXPECT_EQ(totals.kept, total_kept);
+    EXPECT_EQ(total_kept, static_cast<size_t>(threads * per_thread / 10));
+    EXPECT_EQ(totals.kept + totals.sampled_out, totals.seen);
+}
+
+TEST(EventSamplerTest, CountersMergeAcrossThreadsAndShards) {
+    const int threads = 4;
+    const int per_thread = 4000;  // 250 events per name
+    auto run = [&](EventSampler& sampler) {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                for (int i = 0; i < per_thread; ++i) {
+                    sampler.admit(makeEvent("kernel_" + std::to_string((t * per_thread + i) % 64)));
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    };
+
+    // No rules: counted without per-name state
+    EventSampler pass;
+    pass.configure(ProfilerConfig());
+    run(pass);
+    EXPECT_EQ(pass.totals().seen, static_cast<uint64_t>(threads * per_thread));
+    EXPECT_EQ(pass.totals().kept, static_cast<uint64_t>(threads * per_thread));
+    EXPECT_TRUE(pass.countersByName().empty());
+
+    // 64 names spread over the shards; per-name counts still add up
+    SamplingRule rule;
+    rule.pattern = "kernel_*";
+    rule.sample_every = 5;
+    ProfilerConfig config;
+    config.sampling.rules.push_back(rule);
+    EventSampler sampler;
+    sampler.configure(config);
+    run(sampler);
+
+    auto by_name = sampler.countersByName();
+    EXPECT_EQ(by_name.size(), 64u);
+    uint64_t seen = 0, kept = 0;
+    for (const auto& entry : by_name) {
+        seen += entry.second.seen;
+        kept += entry.second.kept;
+    }
+    auto totals = sampler.totals();
+    EXPECT_EQ(totals.seen, static_cast<uint64_t>(threads * per_thread));
+    EXPECT_EQ(seen, totals.seen);
+    EXPECT_EQ(kept, totals.kept);
+    EXPECT_EQ(totals.kept, static_cast<uint64_t>(threads * per_thread / 5));
+}
@@ -0,0 +1,286 @@
+#include <gtest/gtest.h>
+#include <tracesmith/capture/memory_profiler.hpp>
+#include <tracesmith/format/sbt_format.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace tracesmith;
+
+// ============================================================
+// Live allocation table
+// ============================================================
+
+TEST(MemoryProfilerTest, InternedNamesAreStable) {
+    MemoryProfiler profiler;
+    uint32_t caching = profiler.internName("caching");
+    EXPECT_EQ(profiler.internName("caching"), caching);
+    EXPECT_NE(profiler.internName("activations"), caching);
+    EXPECT_EQ(profiler.nameOf(caching), "caching");
+    EXPECT_EQ(profiler.nameOf(999999), "");
+    
+    // Pre-interned and string overloads record the same names
+    profiler.start();
+    profiler.recordAlloc(0x1000, 256, 0, caching, profiler.internName("weights"));
+    profiler.recordAlloc(0x2000, 512, 1, "caching", "weights");
+    profiler.clear();
+    EXPECT_EQ(profiler.internName("caching"), caching);  // IDs survive clear()
+    
+    profiler.recordAlloc(0x3000, 64, 0, "caching", "grads");
+    auto live = profiler.getLiveAllocations();
+    ASSERT_EQ(live.size(), 1u);
+    EXPECT_EQ(live[0].allocator, "caching");
+    EXPECT_EQ(live[0].tag, "grads");
+}
+
+TEST(MemoryProfilerTest, ConcurrentAllocFreeKeepsExactCounts) {
+    MemoryProfiler profiler;
+    profiler.start();
+    
+    constexpr int kThreads = 8;
+    constexpr uint64_t kOpsPerThread = 20000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&profiler, t]() {
+            std::string allocator = "pool_" + std::to_string(t % 2);
+            for (uint64_t i = 0; i < kOpsPerThread; ++i) {
+                uint64_t ptr = (static_cast<uint64_t>(t) << 40) | (i * 512);
+                profiler.recordAlloc(ptr, 512, 0, allocator);
+                // Keep every 100th allocation live
+                if (i % 100 != 0) {
+                    profiler.recordFree(ptr);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    profiler.stop();
+    
+    const uint64_t live = kThreads * (kOpsPerThread / 100);
+    EXPECT_EQ(profiler.getLiveAllocationCount(), live);
+    EXPECT_EQ(profiler.getCurrentUsage(), live * 512);
+    
+    auto report = profiler.generateReport();
+    EXPECT_EQ(report.total_allocations, kThreads * kOpsPerThread);
+    EXPECT_EQ(report.total_frees, kThreads * kOpsPerThread - live);
+    EXPECT_EQ(report.allocator_stats.size(), 2u);
+    EXPECT_EQ(report.allocator_stats["pool_0"].current_usage, live * 512 / 2);
+    
+    auto snapshot = profiler.takeSnapshot();
+    EXPECT_EQ(snapshot.live_allocations, live);
+    EXPECT_EQ(snapshot.allocator_usage["pool_1"], live * 512 / 2);
+}
+
+// ============================================================
+// Freed-allocation aggregates
+// ============================================================
+
+TEST(MemoryProfilerTest, LogHistogramBucketsBoundValues) {
+    LogHistogram histogram;
+    for (uint64_t value : std::vector<uint64_t>{0, 7, 8, 1000, 123456789, UINT64_MAX}) {
+        size_t index = LogHistogram::bucketIndex(value);
+        ASSERT_LT(index, LogHistogram::kBucketCount);
+        EXPECT_LE(LogHistogram::bucketLowerBound(index), value);
+        EXPECT_GE(LogHistogram::bucketUpperBound(index), value);
+    }
+    
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        histogram.record(i);
+    }
+    EXPECT_EQ(histogram.total_count, 1000u);
+    uint64_t p50 = histogram.valueAtPercentile(50);
+    EXPECT_GE(p50, 500u);
+    EXPECT_LE(p50, 500u + 500u / 8);
+    EXPECT_EQ(histogram.valueAtPercentile(100), 1000u);
+    EXPECT_EQ(histogram.valueAtPercentile(0), 1u);
+}
+
+TEST(MemoryProfilerTest, StreamingStatsMatchFullHistory) {
+    MemoryProfiler::Config streaming_config;
+    streaming_config.streaming_stats = true;
+    streaming_config.freed_sample_size = 128;
+    MemoryProfiler full;
+    MemoryProfiler streaming(streaming_config);
+    
+    for (MemoryProfiler* profiler : {&full, &streaming}) {
+        profiler->start();
+        for (uint64_t i = 0; i < 10000; ++i) {
+            uint64_t ptr = 0x10000 + i * 64;
+            profiler->recordAlloc(ptr, 64 + (i % 4) * 64, 0,
+                                  i % 2 ? "caching" : "default", i % 3 ? "" : "weights");
+            if (i % 10 != 0) {
+                profiler->recordFree(ptr);
+            }
+        }
+        profiler->stop();
+    }
+    
+    auto a = full.generateReport();
+    auto b = streaming.generateReport();
+    EXPECT_EQ(a.total_frees, b.total_frees);
+    EXPECT_EQ(a.min_allocation_size, b.min_allocation_size);
+    EXPECT_EQ(a.max_allocation_size, b.max_allocation_size);
+    EXPECT_DOUBLE_EQ(a.avg_allocation_size, b.avg_allocation_size);
+    EXPECT_EQ(a.allocation_size_histogram, b.allocation_size_histogram);
+    EXPECT_EQ(b.size_histogram.total_count, 10000u);
+    EXPECT_EQ(b.lifetime_histogram.total_count, 9000u);
+    EXPECT_EQ(b.allocator_stats["caching"].frees, 5000u);
+    EXPECT_EQ(b.tag_stats["weights"].frees + b.tag_stats[""].frees, 9000u);
+    EXPECT_EQ(b.tag_stats["weights"].current_usage, a.tag_stats["weights"].current_usage);
+    
+    // Only the reservoir is kept in streaming mode
+    EXPECT_TRUE(a.freed_samples.empty());
+    EXPECT_GE(b.freed_samples.size(), 128u);
+    EXPECT_LE(b.freed_samples.size(), 128u + MemoryProfiler::shardCount());
+    for (const auto& sample : b.freed_samples) {
+        EXPECT_FALSE(sample.is_live());
+    }
+    EXPECT_LT(streaming.toMemoryEvents().size(), full.toMemoryEvents().size());
+}
+
+TEST(MemoryProfilerTest, StreamingStatsSpillFullHistoryToSBT) {
+    std::string path = "test_memory_spill.sbt";
+    MemoryProfiler::Config config;
+    config.streaming_stats = true;
+    config.freed_sample_size = 16;
+    config.freed_spill_path = path;
+    
+    {
+        MemoryProfiler profiler(config);
+        profiler.start();
+        for (uint64_t i = 0; i < 1000; ++i) {
+            profiler.recordAlloc(0x1000 + i * 256, 256, 1, "caching", "acts");
+            profiler.recordFree(0x1000 + i * 256, 1);
+        }
+        profiler.stop();
+    }
+    
+    SBTReader reader(path);
+    ASSERT_TRUE(reader.isOpen());
+    TraceRecord record;
+    ASSERT_TRUE(reader.readAll(record));
+    ASSERT_EQ(record.size(), 1000u);
+    uint64_t total = 0;
+    for (const auto& event : record.events()) {
+        EXPECT_EQ(event.type, EventType::MemFree);
+        EXPECT_EQ(event.name, "caching/acts");
+        EXPECT_EQ(event.device_id, 1u);
+        ASSERT_TRUE(event.memory_params.has_value());
+        total += event.memory_params->size_bytes;
+    }
+    EXPECT_EQ(total, 1000u * 256);
+    std::remove(path.c_str());
+}
+
+// ============================================================
+// Address-ordered free space
+// ============================================================
+
+TEST(MemoryProfilerTest, AddressSpaceMapTracksHoles) {
+    AddressSpaceMap map;
+    for (uint64_t i = 0; i < 8; ++i) {
+        map.insert(0x1000 + i * 0x100, 0x100);
+    }
+    EXPECT_EQ(map.info().free_block_count, 0u);
+    
+    // Free two adjacent blocks and one more: holes of 0x200 and 0x100
+    map.erase(0x1200);
+    map.erase(0x1300);
+    map.erase(0x1500);
+    auto info = map.info();
+    EXPECT_EQ(info.total_free_bytes, 0x300u);
+    EXPECT_EQ(info.largest_free_block, 0x200u);
+    EXPECT_EQ(info.free_block_count, 2u);
+    EXPECT_DOUBLE_EQ(info.fragmentation_ratio, 1.0 / 3.0);
+    
+    // Filling the gap between holes merges them
+    map.erase(0x1400);
+    info = map.info();
+    EXPECT_EQ(info.free_block_count, 1u);
+    EXPECT_EQ(info.largest_free_block, 0x400u);
+    EXPECT_DOUBLE_EQ(info.fragmentation_ratio, 0.0);
+    
+    // Reinsert partially and erase the edge blocks: span shrinks
+    map.insert(0x1200, 0x80);
+    map.erase(0x1000);
+    map.erase(0x1700);
+    info = map.info();
+    EXPECT_EQ(info.free_block_count, 1u);
+    EXPECT_EQ(info.total_free_bytes, 0x380u);
+    EXPECT_EQ(map.blockCount(), 3u);
+}
+
+TEST(MemoryProfilerTest, FragmentationPerPoolAndInCounters) {
+    MemoryProfiler::Config config;
+    config.track_fragmentation = true;
+    MemoryProfiler profiler(config);
+    profiler.start();
+    for (uint64_t i = 0; i < 10; ++i) {
+        profiler.recordAlloc(0x10000 + i * 0x1000, 0x1000, 0, "caching");
+        profiler.recordAlloc(0x100000 + i * 0x1000, 0x1000, 1, "caching");
+    }
+    // Device 0: free every other block
+    for (uint64_t i = 1; i < 10; i += 2) {
+        profiler.recordFree(0x10000 + i * 0x1000, 0);
+    }
+    profiler.stop();
+    
+    auto device0 = profiler.getFragmentation(0, "caching");
+    EXPECT_EQ(device0.free_block_count, 4u);  // Block 9 is at the edge
+    EXPECT_EQ(device0.largest_free_block, 0x1000u);
+    EXPECT_DOUBLE_EQ(device0.fragmentation_ratio, 0.75);
+    EXPECT_EQ(profiler.getFragmentation(1, "caching").free_block_count, 0u);
+    EXPECT_EQ(profiler.getFragmentation(0, "unknown").free_block_count, 0u);
+    
+    auto report = profiler.generateReport();
+    EXPECT_EQ(report.fragmentation.total_free_bytes, 0x4000u);
+    EXPECT_EQ(report.pool_fragmentation.size(), 2u);
+    EXPECT_EQ(report.pool_fragmentation["0:caching"].free_block_count, 4u);
+    
+    bool found = false;
+    for (const auto& counter : profiler.toCounterEvents()) {
+        if (counter.counter_name == "Memory Fragmentation" && counter.value > 0) {
+            EXPECT_DOUBLE_EQ(counter.value, 75.0);
+            found = true;
+        }
+    }
+    EXPECT_TRUE(found);
+}
+
+// ============================================================
+// Timeline sampler
+// ============================================================
+
+TEST(MemoryProfilerTest, SamplerFillsBoundedTimeline) {
+    MemoryProfiler::Config config;
+    config.snapshot_interval_ms = 1;
+    config.max_timeline_samples = 8;
+    MemoryProfiler profiler(config);
+    
+    std::atomic<int> callbacks{0};
+    profiler.setSnapshotCallback([&callbacks](const MemorySnapshot&) { callbacks++; });
+    
+    profiler.start();
+    for (uint64_t i = 0; i < 100; ++i) {
+        profiler.recordAlloc(0x1000 + i * 64, 64);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    profiler.stop();
+    
+    // Ring keeps only the newest samples, oldest first, ending with stop()
+    auto timeline = profiler.getTimeline();
+    ASSERT_EQ(timeline.size(), 8u);
+    EXPECT_GT(callbacks.load(), 8);
+    for (size_t i = 1; i < timeline.size(); ++i) {
+        EXPECT_LE(timeline[i - 1].timestamp, timeline[i].timestamp);
+    }
+    EXPECT_EQ(timeline.back().live_allocations, 100u);
+    EXPECT_EQ(timeline.back().live_bytes, 6400u);
+    EXPECT_EQ(timeline.back().total_allocated, 6400u);
+    
+    EXPECT_EQ(profiler.toCounterEvents().size(),
+              8 * MemoryProfiler::snapshotCounters(timeline.back()).size());
+    EXPECT_EQ(profiler.generateReport().timeline.size(), 8u);
+}
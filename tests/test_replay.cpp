@@ -0,0 +1,1067 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <tracesmith/replay/stream_scheduler.hpp>
+#include <tracesmith/replay/replay_engine.hpp>
+#include <tracesmith/replay/parallel_executor.hpp>
+#include <tracesmith/replay/pacing_timer.hpp>
+#include <tracesmith/replay/replay_simulator.hpp>
+#include <tracesmith/replay/determinism_checker.hpp>
+#include <tracesmith/replay/frame_capture.hpp>
+#include <tracesmith/replay/chunk_store.hpp>
+#include <tracesmith/replay/capture_file.hpp>
+#include <tracesmith/format/sbt_format.hpp>
+#include <tracesmith/state/perfetto_exporter.hpp>
+
+using namespace tracesmith;
+
+namespace {
+
+StreamOperation makeOperation(size_t id, uint32_t stream, Timestamp ts,
+                              std::vector<size_t> deps = {}) {
+    TraceEvent event(EventType::KernelLaunch, ts);
+    event.stream_id = stream;
+    event.name = "op_" + std::to_string(id);
+    StreamOperation op(event, id);
+    op.depends_on = std::move(deps);
+    return op;
+}
+
+std::vector<size_t> drain(StreamScheduler& scheduler) {
+    std::vector<size_t> order;
+    while (StreamOperation* op = scheduler.getNextOperation()) {
+        order.push_back(op->operation_id);
+        scheduler.markCompleted(op->operation_id);
+    }
+    return order;
+}
+
+} // namespace
+
+// ============================================================
+// StreamScheduler
+// ============================================================
+
+TEST(StreamSchedulerTest, TimestampOrderWithinDependencies) {
+    StreamScheduler scheduler(SchedulingPolicy::Priority);
+    scheduler.addOperation(makeOperation(0, 0, 100));
+    scheduler.addOperation(makeOperation(1, 1, 50));
+    scheduler.addOperation(makeOperation(2, 0, 60, {0}));  // Earlier, but waits on 0
+    scheduler.addOperation(makeOperation(3, 1, 300, {1}));
+    
+    EXPECT_EQ(scheduler.readyCount(), 2u);
+    EXPECT_EQ(scheduler.pendingCount(), 4u);
+    
+    EXPECT_EQ(drain(scheduler), (std::vector<size_t>{1, 0, 2, 3}));
+    EXPECT_TRUE(scheduler.allCompleted());
+    EXPECT_EQ(scheduler.pendingCount(), 0u);
+    EXPECT_EQ(scheduler.readyCount(), 0u);
+}
+
+TEST(StreamSchedulerTest, ForwardDependenciesAndSparseIds) {
+    StreamScheduler scheduler;
+    // 7 depends on an operation that is only added afterwards
+    scheduler.addOperation(makeOperation(7, 0, 10, {1000000}));
+    scheduler.addOperation(makeOperation(1000000, 1, 20));
+    
+    auto order = drain(scheduler);
+    EXPECT_EQ(order, (std::vector<size_t>{1000000, 7}));
+    EXPECT_TRUE(scheduler.allCompleted());
+}
+
+TEST(StreamSchedulerTest, OutOfOrderCompletionAndDeadlock) {
+    StreamScheduler scheduler;
+    scheduler.addOperation(makeOperation(0, 0, 10));
+    scheduler.addOperation(makeOperation(1, 1, 20));
+    scheduler.addOperation(makeOperation(2, 2, 30, {99}));  // Never satisfied
+    
+    // Completing the non-head op must not leave it selectable
+    scheduler.markCompleted(1);
+    scheduler.markCompleted(1);
+    EXPECT_EQ(scheduler.readyCount(), 1u);
+    EXPECT_EQ(scheduler.getNextOperation()->operation_id, 0u);
+    scheduler.markCompleted(0);
+    
+    EXPECT_EQ(scheduler.getNextOperation(), nullptr);
+    EXPECT_FALSE(scheduler.allCompleted());
+    EXPECT_EQ(scheduler.pendingCount(), 1u);
+    
+    auto stats = scheduler.getStatistics();
+    EXPECT_EQ(stats.completed_operations, 2u);
+    EXPECT_EQ(stats.blocked_operations, 1u);
+}
+
+TEST(StreamSchedulerTest, RoundRobinCyclesStreams) {
+    StreamScheduler scheduler(SchedulingPolicy::RoundRobin);
+    // Stream 0 has three ready ops with the earliest timestamps
+    scheduler.addOperation(makeOperation(0, 0, 1));
+    scheduler.addOperation(makeOperation(1, 0, 2));
+    scheduler.addOperation(makeOperation(2, 0, 3));
+    scheduler.addOperation(makeOperation(3, 1, 10));
+    scheduler.addOperation(makeOperation(4, 1, 11));
+    scheduler.addOperation(makeOperation(5, 2, 20, {3}));
+    
+    EXPECT_EQ(drain(scheduler), (std::vector<size_t>{0, 3, 1, 4, 5, 2}));
+}
+
+TEST(StreamSchedulerTest, PriorityPolicyUsesStreamPriorities) {
+    StreamScheduler scheduler(SchedulingPolicy::Priority);
+    scheduler.setStreamPriority(1, 5);
+    scheduler.addOperation(makeOperation(0, 0, 1));
+    scheduler.addOperation(makeOperation(1, 1, 50));
+    scheduler.addOperation(makeOperation(2, 0, 2));
+    scheduler.addOperation(makeOperation(3, 1, 60, {1}));
+    
+    EXPECT_EQ(scheduler.streamPriority(1), 5);
+    EXPECT_EQ(scheduler.streamPriority(7), 0);
+    EXPECT_EQ(drain(scheduler), (std::vector<size_t>{1, 3, 0, 2}));
+}
+
+TEST(StreamSchedulerTest, PolicyChangeRequeuesReadyOps) {
+    StreamScheduler scheduler(SchedulingPolicy::Priority);
+    scheduler.addOperation(makeOperation(0, 0, 1));
+    scheduler.addOperation(makeOperation(1, 0, 2));
+    scheduler.addOperation(makeOperation(2, 1, 3));
+    
+    scheduler.setPolicy(SchedulingPolicy::RoundRobin);
+    EXPECT_EQ(drain(scheduler), (std::vector<size_t>{0, 2, 1}));
+}
+
+TEST(ReplayEngineTest, OriginalTimingPacesDispatch) {
+    // 20 ops spread over 40ms of captured time, replayed at 2x speed
+    std::vector<TraceEvent> events;
+    for (uint64_t i = 0; i < 20; ++i) {
+        TraceEvent event(EventType::KernelLaunch, 1000000 + i * 2000000);
+        event.stream_id = static_cast<uint32_t>(i % 2);
+        event.correlation_id = i + 1;
+        events.push_back(event);
+    }
+    
+    ReplayEngine engine;
+    engine.loadEvents(events);
+    
+    ReplayConfig config;
+    config.mode = ReplayMode::DryRun;
+    config.scheduling = SchedulingPolicy::OriginalTiming;
+    config.time_scale = 2.0;
+    auto result = engine.replay(config);
+    
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(result.operations_executed, events.size());
+    EXPECT_GE(result.replay_duration, 19000000u);
+    EXPECT_EQ(result.dispatch_jitter.samples, events.size());
+    EXPECT_LE(result.dispatch_jitter.p50, result.dispatch_jitter.max);
+}
+
+TEST(PacingTimerTest, JitterStatsUseFixedMemory) {
+    // Unpaced waits are late by the time since start(), which only grows
+    PacingTimer timer(0.0);
+    PacingTimer other(0.0);
+    timer.start(0);
+    other.start(0);
+    for (int i = 0; i < 200000; ++i) {
+        timer.waitUntil(0);
+    }
+    other.waitUntil(0);
+    timer.merge(other);
+    
+    auto stats = timer.jitterStats();
+    EXPECT_EQ(stats.samples, 200001u);
+    EXPECT_LE(stats.p50, stats.p99);
+    EXPECT_LE(stats.p99, stats.max);
+    EXPECT_LE(stats.mean, stats.max);
+    EXPECT_GT(stats.max, 0u);
+    EXPECT_LT(sizeof(PacingTimer), 16384u);
+}
+
+TEST(ReplayEngineTest, DryRunReplaysAllOperations) {
+    std::vector<TraceEvent> events;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        TraceEvent event(i % 100 == 99 ? EventType::DeviceSync : EventType::KernelLaunch,
+                         1000 + i * 10);
+        event.stream_id = static_cast<uint32_t>(i % 4);
+        event.correlation_id = i + 1;
+        events.push_back(event);
+    }
+    
+    ReplayEngine engine;
+    engine.loadEvents(events);
+    
+    ReplayConfig config;
+    config.mode = ReplayMode::DryRun;
+    auto result = engine.replay(config);
+    
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(result.operations_executed, events.size());
+    EXPECT_EQ(result.operations_total, events.size());
+    EXPECT_EQ(result.dispatch_jitter.samples, 0u);
+    EXPECT_TRUE(result.errors.empty());
+    EXPECT_EQ(result.dependency_violations, 0u);
+}
+
+TEST(ReplayEngineTest, DefaultConfigMultiStreamIsDeterministic) {
+    // Two streams interleaved in capture order; RoundRobin alternates
+    // between them, which must not count as an order violation
+    std::vector<TraceEvent> events;
+    for (uint64_t i = 0; i < 8; ++i) {
+        TraceEvent k(EventType::KernelLaunch, 1000 + (i < 4 ? i : i + 100) * 10);
+        k.name = "k" + std::to_string(i);
+        k.stream_id = i < 4 ? 0 : 1;
+        k.correlation_id = i + 1;
+        events.push_back(k);
+    }
+    
+    ReplayEngine engine;
+    engine.loadEvents(events);
+    ReplayConfig config;
+    config.mode = ReplayMode::DryRun;
+    auto result = engine.replay(config);
+    
+    EXPECT_TRUE(result.success);
+    EXPECT_TRUE(result.deterministic);
+    EXPECT_EQ(result.order_violations, 0u);
+    EXPECT_EQ(result.operations_executed, events.size());
+}
+
+TEST(DeterminismCheckerTest, OrderIsValidatedPerStream) {
+    DeterminismChecker checker;
+    std::vector<StreamOperation> ops = {
+        makeOperation(0, 0, 100), makeOperation(1, 0, 200),
+        makeOperation(2, 1, 150), makeOperation(3, 1, 250),
+    };
+    for (const auto& op : ops) {
+        checker.recordOriginal(op);
+    }
+    for (size_t i : {2, 0, 3, 1}) {     // Streams interleaved differently
+        checker.recordReplayed(ops[i]);
+    }
+    EXPECT_TRUE(checker.validateOrder());
+    
+    checker.reset();
+    for (const auto& op : ops) {
+        checker.recordOriginal(op);
+    }
+    for (size_t i : {1, 0, 2, 3}) {     // Stream 0 reordered
+        checker.recordReplayed(ops[i]);
+    }
+    EXPECT_FALSE(checker.validateOrder());
+    EXPECT_EQ(checker.getViolations().order_violations.size(), 2u);
+}
+
+TEST(ReplayEngineTest, StreamingReplayContinuesPastFailures) {
+    std::string file = (std::filesystem::temp_directory_path() / "tracesmith_streaming_failure.sbt").string();
+    
+    std::vector<TraceEvent> events;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        TraceEvent event(EventType::KernelLaunch, 1000 + i * 10);
+        event.name = i == 150 ? "bad" : "op";
+        event.stream_id = static_cast<uint32_t>(i % 2);
+        event.correlation_id = i + 1;
+        events.push_back(event);
+    }
+    {
+        SBTWriter writer(file);
+        writer.writeEvents(events);
+        writer.finalize();
+    }
+    
+    ReplayConfig config;
+    config.mode = ReplayMode::DryRun;
+    config.streaming_window = 100;
+    config.on_execute = [](const StreamOperation& op) { return op.event.name != "bad"; };
+    
+    // Op 150 fails and blocks the rest of stream 0 in its window (24 ops);
+    // later windows still run
+    ReplayEngine engine;
+    auto result = engine.replayStreaming(file, config);
+    EXPECT_FALSE(result.success);
+    EXPECT_EQ(result.operations_failed, 1u);
+    EXPECT_EQ(result.windows, 10u);
+    EXPECT_EQ(result.operations_executed, 1000u - 1 - 24);
+    
+    config.pause_on_error = true;
+    result = engine.replayStreaming(file, config);
+    EXPECT_EQ(result.operations_failed, 1u);
+    EXPECT_EQ(result.windows, 2u);
+    EXPECT_LT(result.operations_executed, 200u);
+    
+    std::filesystem::remove(file);
+}
+
+TEST(ReplayEngineTest, ParallelStreamsOverlap) {
+    // 4 streams x 3 kernels, then a device sync and one more kernel per stream.
+    // Executor sleeps duration/1000, so each kernel takes ~3ms.
+    std::vector<TraceEvent> events;
+    uint64_t corr = 1;
+    Timestamp ts = 1000;
+    for (int round = 0; round < 4; ++round) {
+        if (round == 3) {
+            TraceEvent sync(EventType::DeviceSync, ts);
+            sync.correlation_id = corr++;
+            events.push_back(sync);
+        }
+        for (uint32_t stream = 0; stream < 4; ++stream) {
+            TraceEvent k(EventType::KernelLaunch, ts);
+            k.stream_id = stream;
+            k.duration = 3000000000ull;
+            k.correlation_id = corr++;
+            events.push_back(k);
+        }
+        ts += 3000000000ull;
+    }
+    
+    ReplayEngine engine;
+    engine.loadEvents(events);
+    
+    ReplayConfig config;
+    config.parallel_streams = true;
+    auto result = engine.replay(config);
+    
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(result.operations_executed, events.size());
+    EXPECT_EQ(result.worker_threads, 4u);
+    EXPECT_TRUE(result.warnings.empty());
+    EXPECT_EQ(result.dependency_violations, 0u);
+    EXPECT_GT(result.original_overlap, 0.9);
+    EXPECT_GT(result.achieved_overlap, 0.5);
+}
+
+TEST(ReplayEngineTest, ParallelFailuresMatchSerial) {
+    // 4 streams x 8 kernels with a device sync halfway; one kernel on
+    // stream 1 fails before the sync
+    std::vector<TraceEvent> events;
+    uint64_t corr = 1;
+    Timestamp ts = 1000;
+    for (int round = 0; round < 8; ++round) {
+        if (round == 4) {
+            TraceEvent sync(EventType::DeviceSync, ts);
+            sync.name = "sync";
+            sync.correlation_id = corr++;
+            events.push_back(sync);
+        }
+        for (uint32_t stream = 0; stream < 4; ++stream) {
+            TraceEvent k(EventType::KernelLaunch, ts);
+            k.name = (round == 2 && stream == 1) ? "bad" : "op";
+            k.stream_id = stream;
+            k.correlation_id = corr++;
+            events.push_back(k);
+        }
+        ts += 1000;
+    }
+    
+    ReplayEngine engine;
+    engine.loadEvents(events);
+    
+    ReplayConfig config;
+    config.mode = ReplayMode::DryRun;
+    config.on_execute = [](const StreamOperation& op) { return op.event.name != "bad"; };
+    auto serial = engine.replay(config);
+    
+    config.parallel_streams = true;
+    auto parallel = engine.replay(config);
+    
+    EXPECT_FALSE(serial.success);
+    EXPECT_EQ(serial.operations_failed, 1u);
+    EXPECT_LT(serial.operations_executed, events.size() - 1);
+    EXPECT_EQ(parallel.operations_failed, serial.operations_failed);
+    EXPECT_EQ(parallel.operations_executed, serial.operations_executed);
+    EXPECT_EQ(parallel.dependency_violations, 0u);
+    EXPECT_EQ(parallel.errors, serial.errors);
+    
+    // pause_on_error stops dispatch at the first failure on every worker
+    config.pause_on_error = true;
+    parallel = engine.replay(config);
+    EXPECT_EQ(parallel.operations_failed, 1u);
+    EXPECT_EQ(parallel.errors.size(), 1u);
+    EXPECT_LE(parallel.operations_executed, serial.operations_executed);
+}
+
+TEST(ReplayEngineTest, StreamingReplayMatchesInMemory) {
+    std::string file = (std::filesystem::temp_directory_path() / "tracesmith_streaming_replay.sbt").string();
+    
+    std::vector<TraceEvent> events;
+    for (uint64_t i = 0; i < 5000; ++i) {
+        TraceEvent event(i % 300 == 299 ? EventType::DeviceSync : EventType::KernelLaunch,
+                         1000 + i * 10);
+        event.name = "op";
+        event.stream_id = static_cast<uint32_t>(i % 4);
+        event.correlation_id = i + 1;
+        events.push_back(event);
+    }
+    {
+        SBTWriter writer(file);
+        writer.writeEvents(events);
+        writer.finalize();
+    }
+    
+    ReplayConfig config;
+    config.mode = ReplayMode::DryRun;
+    config.streaming_window = 256;
+    
+    ReplayEngine engine;
+    auto streamed = engine.replayStreaming(file, config);
+    EXPECT_TRUE(streamed.success);
+    EXPECT_EQ(streamed.operations_total, events.size());
+    EXPECT_EQ(streamed.operations_executed, events.size());
+    EXPECT_EQ(streamed.dependency_violations, 0u);
+    EXPECT_GE(streamed.windows, events.size() / 512);
+    EXPECT_TRUE(streamed.errors.empty());
+    
+    ASSERT_TRUE(engine.loadTrace(file));
+    auto loaded = engine.replay(config);
+    EXPECT_EQ(loaded.operations_executed, streamed.operations_executed);
+    EXPECT_EQ(loaded.windows, 0u);
+    
+    config.mode = ReplayMode::StreamSpecific;
+    config.stream_id = 2;
+    EXPECT_EQ(engine.replayStreaming(file, config).operations_executed, events.size() / 4);
+    
+    EXPECT_FALSE(engine.replayStreaming("/nonexistent.sbt", config).success);
+    std::filesystem::remove(file);
+}
+
+TEST(ParallelReplayExecutorTest, RejectsCycles) {
+    std::vector<StreamOperation> ops = {
+        makeOperation(0, 0, 10, {1}),  // Waits on a later op in its own stream
+        makeOperation(1, 0, 20),
+    };
+    
+    ParallelReplayExecutor executor(true);
+    size_t completions = 0;
+    EXPECT_FALSE(executor.run(ops, ReplayConfig(), [&](size_t, bool) { completions++; }));
+    EXPECT_FALSE(executor.lastError().empty());
+    EXPECT_EQ(completions, 0u);
+    
+    ops[0].depends_on = {42};
+    EXPECT_FALSE(executor.run(ops, ReplayConfig(), [&](size_t, bool) { completions++; }));
+    
+    ops[0].depends_on.clear();
+    ops[1].depends_on = {0};
+    EXPECT_TRUE(executor.run(ops, ReplayConfig(), [&](size_t, bool) { completions++; }));
+    EXPECT_EQ(completions, 2u);
+}
+
+// ============================================================
+// ReplaySimulator
+// ============================================================
+
+namespace {
+
+TraceEvent makeTimedEvent(EventType type, const std::string& name, uint32_t stream,
+                          Timestamp ts, Timestamp duration) {
+    TraceEvent event(type, ts);
+    event.name = name;
+    event.stream_id = stream;
+    event.duration = duration;
+    return event;
+}
+
+ReplayConfig simulationConfig() {
+    ReplayConfig config;
+    config.mode = ReplayMode::Simulate;
+    return config;
+}
+
+} // namespace
+
+TEST(ReplaySimulatorTest, UnchangedModelReproducesCapture) {
+    ReplayEngine engine;
+    engine.loadEvents({
+        makeTimedEvent(EventType::KernelLaunch, "a", 0, 1000, 100),
+        makeTimedEvent(EventType::MemcpyH2D, "copy", 1, 1000, 250),
+        makeTimedEvent(EventType::KernelLaunch, "b", 0, 1150, 100),  // 50ns launch gap
+        makeTimedEvent(EventType::DeviceSync, "sync", 0, 1250, 0),
+        makeTimedEvent(EventType::KernelLaunch, "c", 0, 1260, 40),
+    });
+    
+    auto result = engine.replay(simulationConfig());
+    EXPECT_TRUE(result.success);
+    EXPECT_EQ(result.operations_executed, 5u);
+    EXPECT_EQ(result.captured_makespan, 300u);
+    // Sync waits for the copy (ends at 250), then c keeps its 10ns gap
+    EXPECT_EQ(result.simulated_makespan, 300u);
+    
+    const auto& sim = engine.getSimulation();
+    EXPECT_EQ(sim.start[2], 150u);
+    EXPECT_EQ(sim.end[3], 250u);
+}
+
+TEST(ReplaySimulatorTest, CopyEngineContentionAndScaling) {
+    std::vector<TraceEvent> events;
+    for (uint32_t stream = 0; stream < 3; ++stream) {
+        events.push_back(makeTimedEvent(EventType::MemcpyH2D, "h2d", stream, 1000, 100));
+    }
+    
+    ReplayEngine engine;
+    engine.loadEvents(events);
+    
+    auto config = simulationConfig();
+    EXPECT_EQ(engine.replay(config).simulated_makespan, 100u);
+    
+    config.simulation.copy_engines = 1;
+    auto contended = engine.replay(config);
+    EXPECT_EQ(contended.simulated_makespan, 300u);
+    EXPECT_EQ(engine.getSimulation().contention_wait_time, 300u);
+    
+    auto model = std::make_shared<ScaledCostModel>();
+    model->setTypeScale(EventType::MemcpyH2D, 0.5);
+    config.simulation.cost_model = model;
+    EXPECT_EQ(engine.replay(config).simulated_makespan, 150u);
+    
+    model->setNameScale("h2d", 2.0);  // Name beats type
+    EXPECT_EQ(engine.replay(config).simulated_makespan, 600u);
+}
+
+TEST(ReplaySimulatorTest, StreamAssignmentAndTimelineExport) {
+    std::vector<TraceEvent> events;
+    for (uint32_t i = 0; i < 4; ++i) {
+        auto event = makeTimedEvent(EventType::KernelLaunch, "gemm", 0, 1000 + i * 100, 100);
+        event.correlation_id = i;
+        events.push_back(event);
+    }
+    
+    ReplayEngine engine;
+    engine.loadEvents(events);
+    
+    auto config = simulationConfig();
+    config.simulation.preserve_gaps = false;
+    EXPECT_EQ(engine.replay(config).simulated_makespan, 400u);
+    
+    // What if the same work were spread over four streams?
+    config.simulation.stream_assignment = [](const StreamOperation& op) {
+        return static_cast<uint32_t>(op.event.correlation_id % 4);
+    };
+    auto result = engine.replay(config);
+    EXPECT_EQ(result.simulated_makespan, 100u);
+    EXPECT_GT(result.achieved_overlap, 0.99);
+    
+    auto timeline = engine.getSimulatedTimeline();
+    ASSERT_EQ(timeline.size(), 4u);
+    EXPECT_EQ(timeline[3].stream_id, 3u);
+    EXPECT_EQ(timeline[3].timestamp, 1000u);
+    
+    PerfettoExporter exporter;
+    EXPECT_NE(exporter.exportToString(timeline).find("gemm"), std::string::npos);
+}
+
+// ============================================================
+// DeterminismChecker
+// ============================================================
+
+TEST(DeterminismCheckerTest, DependenciesValidatedBySequence) {
+    DeterminismChecker checker;
+    std::vector<StreamOperation> ops = {
+        makeOperation(0, 0, 100),
+        makeOperation(1, 0, 200, {0}),
+        makeOperation(2, 1, 300, {1}),
+    };
+    for (auto& op : ops) {
+        op.executed = true;
+        op.execution_time = 5000;  // Same timestamp: sequence breaks the tie
+        checker.recordOriginal(op);
+        checker.recordReplayed(op);
+    }
+    EXPECT_TRUE(checker.validateOrder());
+    EXPECT_TRUE(checker.validateDependencies());
+    EXPECT_TRUE(checker.diff().identical());
+    
+    // Op 2 ran before op 1
+    checker.reset();
+    for (const auto& op : ops) {
+        checker.recordOriginal(op);
+    }
+    for (size_t i : {0, 2, 1}) {
+        checker.recordReplayed(ops[i]);
+    }
+    EXPECT_FALSE(checker.validateDependencies());
+    ASSERT_EQ(checker.getViolations().dependency_violations.size(), 1u);
+    EXPECT_EQ(checker.getViolations().dependency_violations[0],
+              "Dependency violation: operation 2 executed before dependency 1");
+}
+
+TEST(DeterminismCheckerTest, DiffReportsDivergenceLcsAndReorders) {
+    DeterminismChecker checker;
+    std::vector<StreamOperation> ops;
+    for (size_t i = 0; i < 6; ++i) {
+        ops.push_back(makeOperation(i, static_cast<uint32_t>(i % 2), 100 * (i + 1)));
+        checker.recordOriginal(ops.back());
+    }
+    
+    // Replay: 0 1 3 2 4, op 5 missing, unknown op 9 extra.
+    // 3 and 2 are on different streams, so no stream saw a reorder.
+    for (size_t i : {0, 1, 3, 2, 4}) {
+        checker.recordReplayed(ops[i]);
+    }
+    checker.recordReplayed(makeOperation(9, 0, 900));
+    
+    auto diff = checker.diff();
+    EXPECT_FALSE(diff.identical());
+    EXPECT_EQ(diff.first_divergence, 2u);
+    EXPECT_EQ(diff.expected, "op_2 (stream 0)");
+    EXPECT_EQ(diff.actual, "op_3 (stream 1)");
+    EXPECT_EQ(diff.matched_operations, 5u);
+    EXPECT_EQ(diff.missing_operations, 1u);
+    EXPECT_EQ(diff.extra_operations, 1u);
+    EXPECT_EQ(diff.common_subsequence.size(), 4u);
+    EXPECT_EQ(diff.reorderedOperations(), 1u);
+    EXPECT_EQ(diff.stream_reorders[0], 0u);
+    EXPECT_EQ(diff.stream_reorders[1], 0u);
+    
+    // Swap two ops on the same stream
+    checker.reset();
+    for (const auto& op : ops) {
+        checker.recordOriginal(op);
+    }
+    for (size_t i : {0, 1, 4, 3, 2, 5}) {
+        checker.recordReplayed(ops[i]);
+    }
+    diff = checker.diff();
+    EXPECT_EQ(diff.stream_reorders[0], 1u);
+    EXPECT_EQ(diff.stream_reorders[1], 0u);
+    EXPECT_NE(diff.summary().find("stream 0: 1"), std::string::npos);
+}
+
+TEST(DeterminismCheckerTest, CompareFilesStreamsBatches) {
+    auto dir = std::filesystem::temp_directory_path();
+    std::string original_file = (dir / "tracesmith_diff_original.sbt").string();
+    std::string replayed_file = (dir / "tracesmith_diff_replayed.sbt").string();
+    
+    std::vector<TraceEvent> events;
+    for (size_t i = 0; i < 100; ++i) {
+        TraceEvent event(EventType::KernelLaunch, 1000 + i * 10);
+        event.name = (i % 3 == 0) ? "gemm" : "relu";  // Repeated names
+        event.stream_id = static_cast<uint32_t>(i % 4);
+        events.push_back(event);
+    }
+    auto write = [](const std::string& file, const std::vector<TraceEvent>& trace) {
+        SBTWriter writer(file);
+        writer.writeEvents(trace);
+        writer.finalize();
+    };
+    
+    write(original_file, events);
+    auto replayed = events;
+    std::swap(replayed[42], replayed[46]);  // Same stream (2): one reorder
+    replayed.pop_back();
+    write(replayed_file, replayed);
+    
+    DeterminismDiff diff;
+    std::string error;
+    ASSERT_TRUE(DeterminismChecker::compareFiles(original_file, replayed_file, diff, &error, 16));
+    EXPECT_EQ(diff.original_count, 100u);
+    EXPECT_EQ(diff.replayed_count, 99u);
+    EXPECT_EQ(diff.first_divergence, 42u);
+    EXPECT_EQ(diff.matched_operations, 99u);
+    EXPECT_EQ(diff.missing_operations, 1u);
+    EXPECT_EQ(diff.stream_reorders[2], 1u);
+    EXPECT_EQ(diff.reorderedOperations(), 2u);  // 43..45 sit between the swapped pair
+    
+    ASSERT_TRUE(DeterminismChecker::compareFiles(original_file, original_file, diff));
+    EXPECT_TRUE(diff.identical());
+    
+    EXPECT_FALSE(DeterminismChecker::compareFiles(original_file, "/nonexistent.sbt", diff, &error));
+    EXPECT_FALSE(error.empty());
+    
+    std::filesystem::remove(original_file);
+    std::filesystem::remove(replayed_file);
+}
+
+// ============================================================
+// FrameCapture
+// ============================================================
+
+namespace {
+
+ResourceState makeBuffer(uint64_t id, uint64_t size) {
+    ResourceState buffer;
+    buffer.resource_id = id;
+    buffer.type = ResourceType::Buffer;
+    buffer.name = "buffer_" + std::to_string(id);
+    buffer.size = size;
+    return buffer;
+}
+
+DrawCallInfo makeDraw(uint64_t id) {
+    DrawCallInfo draw;
+    draw.call_id = id;
+    draw.name = "draw_" + std::to_string(id);
+    return draw;
+}
+
+} // namespace
+
+TEST(FrameCaptureTest, DeltaSnapshotsShareUnchangedResources) {
+    FrameCaptureConfig config;
+    config.capture_buffer_contents = true;
+    FrameCapture capture(config);
+    
+    for (uint64_t id = 1; id <= 100; ++id) {
+        capture.recordResourceCreate(makeBuffer(id, 4096));
+    }
+    std::vector<uint8_t> bytes(4096, 0xAB);
+    capture.recordResourceUpdate(1, bytes.data(), bytes.size());
+    
+    capture.triggerCapture();
+    capture.onFrameEnd();  // Armed -> capturing
+    
+    // 50 draws; only draw 10 touches a buffer (resource 7)
+    for (uint64_t draw = 0; draw < 50; ++draw) {
+        if (draw == 10) {
+            bytes.assign(4096, 0xCD);
+            capture.recordResourceUpdate(7, bytes.data(), bytes.size());
+            capture.recordResourceBind(7, false, true);
+        }
+        capture.recordDrawCall(makeDraw(draw));
+    }
+    capture.onFrameEnd();
+    
+    const CapturedFrame* frame = capture.getFrame(1);
+    ASSERT_NE(frame, nullptr);
+    ASSERT_EQ(frame->state_deltas.size(), 50u);
+    EXPECT_EQ(frame->resource_versions, 1u);
+    EXPECT_EQ(frame->state_deltas[10].changed.size(), 1u);
+    EXPECT_TRUE(frame->state_deltas[9].changed.empty());
+    
+    // Before and after the change
+    auto before = frame->getResourceVersionAt(7, 9);
+    auto after = frame->getResourceVersionAt(7, 10);
+    ASSERT_TRUE(before && after);
+    EXPECT_NE(before, after);
+    EXPECT_EQ(before, frame->initial_state.at(7));
+    EXPECT_FALSE(before->bound_as_output);
+    EXPECT_TRUE(after->bound_as_output);
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(capture.readResourceData(*after, contents));
+    ASSERT_EQ(contents.size(), 4096u);
+    EXPECT_EQ(contents[0], 0xCD);
+    EXPECT_EQ(frame->getResourceVersionAt(7, 49), after);
+    EXPECT_EQ(frame->final_state.at(7), after);
+    
+    // Unchanged resources are one shared version, contents included
+    EXPECT_EQ(frame->getResourceVersionAt(1, 49), frame->initial_state.at(1));
+    EXPECT_EQ(frame->final_state.at(1), frame->initial_state.at(1));
+    EXPECT_EQ(capture.getResource(1)->contents, frame->initial_state.at(1)->contents);
+    
+    auto state = capture.getResourceStateAt(1, 10, 7);
+    ASSERT_TRUE(state.has_value());
+    EXPECT_TRUE(state->bound_as_output);
+    EXPECT_FALSE(capture.getResourceStateAt(1, 999, 7).has_value());
+    EXPECT_FALSE(capture.getResourceStateAt(1, 10, 999).has_value());
+}
+
+TEST(FrameCaptureTest, CapturedVersionsAreImmutable) {
+    FrameCapture capture;
+    capture.recordResourceCreate(makeBuffer(1, 64));
+    capture.triggerCapture();
+    capture.onFrameEnd();
+    capture.recordDrawCall(makeDraw(0));
+    capture.onFrameEnd();
+    
+    // Modifying after the capture must not change the captured frame
+    capture.recordResourceBind(1, true, false);
+    EXPECT_TRUE(capture.getResource(1)->bound_as_input);
+    
+    const CapturedFrame* frame = capture.getFrame(1);
+    ASSERT_NE(frame, nullptr);
+    EXPECT_FALSE(frame->final_state.at(1)->bound_as_input);
+    EXPECT_FALSE(frame->getResourceStateAt(1, 0)->bound_as_input);
+    
+    // A resource created mid-frame does not exist before its first draw
+    FrameCapture late;
+    late.triggerCapture();
+    late.onFrameEnd();
+    late.recordDrawCall(makeDraw(0));
+    late.recordResourceCreate(makeBuffer(5, 64));
+    late.recordDrawCall(makeDraw(1));
+    late.onFrameEnd();
+    EXPECT_FALSE(late.getFrame(1)->getResourceStateAt(5, 0).has_value());
+    EXPECT_TRUE(late.getFrame(1)->getResourceStateAt(5, 1).has_value());
+}
+
+TEST(FrameCaptureTest, BufferContentsAreDeduplicated) {
+    FrameCaptureConfig config;
+    config.capture_buffer_contents = true;
+    config.chunk_store.chunk_size = 1024;
+    FrameCapture capture(config);
+    
+    capture.recordResourceCreate(makeBuffer(1, 8192));
+    capture.recordResourceCreate(makeBuffer(2, 8192));
+    std::vector<uint8_t> bytes(8192, 0x11);
+    capture.recordResourceUpdate(1, bytes.data(), bytes.size());
+    capture.recordResourceUpdate(2, bytes.data(), bytes.size());  // Same contents
+    
+    // A 4-byte write only stores the one chunk it touches
+    uint32_t value = 0xDEADBEEF;
+    capture.recordResourceUpdate(2, 5000, &value, sizeof(value));
+    
+    auto stats = capture.getChunkStore().getStatistics();
+    EXPECT_EQ(stats.unique_chunks, 2u);
+    EXPECT_EQ(stats.stored_bytes, 2048u);
+    EXPECT_GT(stats.dedupRatio(), 7.0);
+    
+    std::vector<uint8_t> contents;
+    ASSERT_TRUE(capture.readResourceData(*capture.getResource(2), contents));
+    ASSERT_EQ(contents.size(), 8192u);
+    uint32_t read_back = 0;
+    std::memcpy(&read_back, contents.data() + 5000, sizeof(read_back));
+    EXPECT_EQ(read_back, value);
+    EXPECT_EQ(contents[4999], 0x11);
+    EXPECT_EQ(contents[5004], 0x11);
+    
+    // The populated store keeps its chunk size; other settings still apply
+    FrameCaptureConfig changed = config;
+    changed.chunk_store.chunk_size = 4096;
+    changed.frames_to_capture = 3;
+    capture.setConfig(changed);
+    EXPECT_EQ(capture.getConfig().chunk_store.chunk_size, 1024u);
+    EXPECT_EQ(capture.getConfig().frames_to_capture, 3u);
+}
+
+TEST(FrameCaptureTest, CaptureFileLoadsDrawCallsLazily) {
+    std::string file = (std::filesystem::temp_directory_path() / "tracesmith_capture.tsfc").string();
+    
+    FrameCaptureConfig config;
+    config.capture_buffer_contents = true;
+    config.frames_to_capture = 2;
+    config.chunk_store.chunk_size = 256;
+    FrameCapture capture(config);
+    for (uint64_t id = 1; id <= 4; ++id) {
+        capture.recordResourceCreate(makeBuffer(id, 1024));
+    }
+    std::vector<uint8_t> bytes(1024, 0x42);
+    capture.recordResourceUpdate(1, bytes.data(), bytes.size());
+    
+    capture.triggerCapture();
+    capture.onFrameEnd();
+    for (uint64_t frame = 0; frame < 2; ++frame) {
+        TraceEvent event(EventType::KernelLaunch, 1000 + frame);
+        event.name = "kernel";
+        event.kernel_params = KernelParams();
+        event.kernel_params->grid_x = 8;
+        event.metadata["pass"] = "shadow";
+        capture.recordEvent(event);
+        for (uint64_t draw = 0; draw < 20; ++draw) {
+            if (draw == 5) {
+                bytes[700] = static_cast<uint8_t>(frame + 1);
+                capture.recordResourceUpdate(1, bytes.data(), bytes.size());
+            }
+            DrawCallInfo info = makeDraw(frame * 100 + draw);
+            info.vertex_count = 3;
+            info.vertex_offset = -7;
+            info.input_resources = {1, 2};
+            capture.recordDrawCall(info);
+        }
+        capture.onFrameEnd();
+    }
+    ASSERT_TRUE(capture.saveCapture(file));
+    
+    CaptureFileReader reader(file);
+    ASSERT_TRUE(reader.isValid()) << reader.lastError();
+    ASSERT_EQ(reader.frames().size(), 2u);
+    EXPECT_EQ(reader.drawCallIds(2).size(), 20u);
+    EXPECT_EQ(reader.drawCallIds(2).front(), 100u);
+    
+    DrawCallInfo draw;
+    std::vector<ResourceState> changed;
+    ASSERT_TRUE(reader.readDrawCall(1, 5, draw, &changed));
+    EXPECT_EQ(draw.name, "draw_5");
+    EXPECT_EQ(draw.vertex_offset, -7);
+    EXPECT_EQ(draw.input_resources, (std::vector<uint64_t>{1, 2}));
+    ASSERT_EQ(changed.size(), 1u);
+    EXPECT_EQ(changed[0].resource_id, 1u);
+    EXPECT_FALSE(reader.readDrawCall(1, 999, draw));
+    
+    // State and contents match the in-memory capture at every draw
+    for (uint64_t frame = 1; frame <= 2; ++frame) {
+        for (uint64_t call : {uint64_t{0}, uint64_t{4}, uint64_t{5}, uint64_t{19}}) {
+            uint64_t call_id = (frame - 1) * 100 + call;
+            auto expected = capture.getResourceStateAt(frame, call_id, 1);
+            auto actual = reader.readResourceStateAt(frame, call_id, 1);
+            ASSERT_TRUE(expected && actual);
+            EXPECT_EQ(actual->contents, expected->contents);
+            
+            std::vector<uint8_t> expected_bytes, actual_bytes;
+            ASSERT_TRUE(capture.readResourceData(*expected, expected_bytes));
+            ASSERT_TRUE(reader.readResourceData(*actual, actual_bytes));
+            EXPECT_EQ(actual_bytes, expected_bytes);
+        }
+    }
+    auto unchanged = reader.readResourceStateAt(2, 110, 3);
+    ASSERT_TRUE(unchanged.has_value());
+    EXPECT_EQ(unchanged->name, "buffer_3");
+    EXPECT_FALSE(reader.readResourceStateAt(2, 110, 99).has_value());
+    
+    // Full frame load
+    CapturedFrame loaded;
+    ASSERT_TRUE(reader.loadFrame(2, loaded));
+    const CapturedFrame* original = capture.getFrame(2);
+    EXPECT_EQ(loaded.draw_calls.size(), original->draw_calls.size());
+    EXPECT_EQ(loaded.resource_versions, original->resource_versions);
+    EXPECT_EQ(loaded.initial_state.size(), original->initial_state.size());
+    ASSERT_EQ(loaded.events.size(), 1u);
+    EXPECT_EQ(loaded.events[0].metadata.at("pass"), "shadow");
+    ASSERT_TRUE(loaded.events[0].kernel_params.has_value());
+    EXPECT_EQ(loaded.events[0].kernel_params->grid_x, 8u);
+    EXPECT_EQ(loaded.getResourceVersionAt(1, 105)->contents,
+              original->getResourceVersionAt(1, 105)->contents);
+    
+    std::filesystem::remove(file);
+    CaptureFileReader missing(file);
+    EXPECT_FALSE(missing.isValid());
+}
+
+TEST(FrameCaptureTest, CorruptCaptureIndexIsRejected) {
+    std::string file = (std::filesystem::temp_directory_path() / "tracesmith_corrupt.tsfc").string();
+    
+    FrameCaptureConfig config;
+    config.capture_buffer_contents = true;
+    config.chunk_store.chunk_size = 256;
+    FrameCapture capture(config);
+    capture.recordResourceCreate(makeBuffer(1, 1024));
+    std::vector<uint8_t> bytes(1024, 0x42);
+    capture.recordResourceUpdate(1, bytes.data(), bytes.size());
+    capture.triggerCapture();
+    capture.onFrameEnd();
+    for (uint64_t draw = 0; draw < 4; ++draw) {
+        bytes[draw] = static_cast<uint8_t>(draw);
+        capture.recordResourceUpdate(1, bytes.data(), bytes.size());
+        capture.recordDrawCall(makeDraw(draw));
+    }
+    capture.onFrameEnd();
+    ASSERT_TRUE(capture.saveCapture(file));
+    
+    std::vector<char> original;
+    {
+        std::ifstream in(file, std::ios::binary);
+        original.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    CaptureFileHeader header;
+    ASSERT_GE(original.size(), sizeof(header));
+    std::memcpy(&header, original.data(), sizeof(header));
+    ASSERT_GE(header.chunk_count, 1u);
+    ASSERT_GE(header.version_count, 2u);
+    
+    // Index layout: chunk entries (id, offset, u32 size), then version offsets
+    const size_t chunk_size_at = header.index_offset + 16;
+    const size_t versions_at = header.index_offset + header.chunk_count * 20;
+    auto rewrite = [&](size_t at, const void* value, size_t size) {
+        std::vector<char> data = original;
+        std::memcpy(data.data() + at, value, size);
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    };
+    
+    // Version offsets that go backwards or past the end fail at load
+    uint64_t backwards = 0;
+    std::memcpy(&backwards, original.data() + versions_at, sizeof(backwards));
+    backwards--;
+    rewrite(versions_at + 8, &backwards, sizeof(backwards));
+    EXPECT_FALSE(CaptureFileReader(file).isValid());
+    
+    uint64_t past_end = original.size() + 1;
+    rewrite(versions_at + header.version_count * 8, &past_end, sizeof(past_end));
+    {
+        CaptureFileReader reader(file);
+        EXPECT_FALSE(reader.isValid());
+        EXPECT_EQ(reader.lastError(), "Corrupt frame capture index");
+    }
+    
+    // An oversized chunk fails the read instead of allocating for it
+    uint32_t huge = UINT32_MAX;
+    rewrite(chunk_size_at, &huge, sizeof(huge));
+    {
+        CaptureFileReader reader(file);
+        ASSERT_TRUE(reader.isValid()) << reader.lastError();
+        bool all_read = true;
+        for (uint64_t draw = 0; draw < 4; ++draw) {
+            auto state = reader.readResourceStateAt(1, draw, 1);
+            ASSERT_TRUE(state.has_value());
+            std::vector<uint8_t> data;
+            all_read = reader.readResourceData(*state, data) && all_read;
+        }
+        EXPECT_FALSE(all_read);
+        EXPECT_NE(reader.lastError().find("exceeds file size"), std::string::npos);
+    }
+    
+    std::filesystem::remove(file);
+}
+
+// ============================================================
+// ChunkStore
+// ============================================================
+
+TEST(ChunkStoreTest, HashMatchesXxh64) {
+    EXPECT_EQ(hashBytes("", 0), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(hashBytes("abc", 3), 0x44BC2CF5AD770999ULL);
+}
+
+TEST(ChunkStoreTest, PatchGrowsAndKeepsUntouchedChunks) {
+    ChunkStore::Config config;
+    config.chunk_size = 16;
+    ChunkStore store(config);
+    
+    std::vector<uint8_t> bytes(40);
+    for (size_t i = 0; i < bytes.size(); ++i) bytes[i] = static_cast<uint8_t>(i);
+    ChunkList base = store.put(bytes.data(), bytes.size());
+    ASSERT_EQ(base.chunks.size(), 3u);
+    EXPECT_EQ(base.size, 40u);
+    
+    // Write past the end: the tail chunk is rebuilt, the gap is zero
+    std::vector<uint8_t> tail(4, 0xFF);
+    ChunkList grown = store.patch(base, 50, tail.data(), tail.size());
+    EXPECT_EQ(grown.size, 54u);
+    ASSERT_EQ(grown.chunks.size(), 4u);
+    EXPECT_EQ(grown.chunks[0], base.chunks[0]);
+    EXPECT_EQ(grown.chunks[1], base.chunks[1]);
+    
+    std::vector<uint8_t> expected = bytes;
+    expected.resize(50, 0);
+    expected.insert(expected.end(), tail.begin(), tail.end());
+    std::vector<uint8_t> out;
+    ASSERT_TRUE(store.read(grown, out));
+    EXPECT_EQ(out, expected);
+    
+    // The original list is still readable
+    ASSERT_TRUE(store.read(base, out));
+    EXPECT_EQ(out, bytes);
+    
+    ChunkList unknown;
+    unknown.chunks.push_back(12345);
+    unknown.size = 16;
+    EXPECT_FALSE(store.read(unknown, out));
+}
+
+TEST(ChunkStoreTest, SpillsToDiskAndReadsBack) {
+    std::string spill = (std::filesystem::temp_directory_path() / "tracesmith_chunk_spill.bin").string();
+    ChunkStore::Config config;
+    config.chunk_size = 256;
+    config.max_resident_bytes = 1024;
+    config.spill_path = spill;
+    
+    std::vector<ChunkList> lists;
+    std::vector<std::vector<uint8_t>> buffers;
+    {
+        ChunkStore store(config);
+        for (int i = 0; i < 20; ++i) {
+            buffers.emplace_back(1000, static_cast<uint8_t>(i));
+            lists.push_back(store.put(buffers.back().data(), buffers.back().size()));
+        }
+        // Re-putting spilled contents is still recognized as a duplicate
+        ChunkList again = store.put(buffers[0].data(), buffers[0].size());
+        EXPECT_EQ(again, lists[0]);
+        
+        auto stats = store.getStatistics();
+        EXPECT_LE(stats.resident_bytes, 1024u);
+        EXPECT_GT(stats.spilled_bytes, 0u);
+        EXPECT_EQ(stats.resident_bytes + stats.spilled_bytes, stats.stored_bytes);
+        
+        std::vector<uint8_t> out;
+        for (size_t i = 0; i < lists.size(); ++i) {
+            ASSERT_TRUE(store.read(lists[i], out));
+            EXPECT_EQ(out, buffers[i]);
+        }
+        EXPECT_TRUE(std::filesystem::exists(spill));
+    }
+    EXPECT_FALSE(std::filesystem::exists(spill));
+}
@@ -0,0 +1,886 @@
+#include <gtest/gtest.h>
+#include <tracesmith/state/gpu_state_machine.hpp>
+#include <tracesmith/state/instruction_stream.hpp>
+#include <tracesmith/state/critical_path.hpp>
+#include <tracesmith/state/json_writer.hpp>
+#include <tracesmith/state/perfetto_exporter.hpp>
+#include <tracesmith/state/perfetto_proto_exporter.hpp>
+#include <tracesmith/state/perfetto_proto_writer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace tracesmith;
+
+namespace {
+
+std::vector<TraceEvent> makeMultiStreamEvents(size_t count, uint32_t num_streams) {
+    std::vector<TraceEvent> events;
+    events.reserve(count);
+    
+    for (size_t i = 0; i < count; ++i) {
+        TraceEvent event;
+        switch (i % 5) {
+            case 0: event.type = EventType::KernelLaunch; break;
+            case 1: event.type = EventType::KernelComplete; break;
+            case 2: event.type = EventType::MemcpyH2D; break;
+            case 3: event.type = EventType::KernelLaunch; break;
+            default: event.type = (i % 50 == 4) ? EventType::StreamSync : EventType::MemcpyD2H; break;
+        }
+        event.name = "op_" + std::to_string(i);
+        event.timestamp = 1000 + i * 100;
+        event.duration = 50 + (i % 7) * 10;
+        event.stream_id = static_cast<uint32_t>((i * 7) % num_streams);
+        event.device_id = event.stream_id % 2;
+        event.correlation_id = i + 1;
+        events.push_back(event);
+    }
+    
+    return events;
+}
+
+} // namespace
+
+// ============================================================
+// GPUStateMachine
+// ============================================================
+
+TEST(GPUStateMachineTest, ParallelMatchesSerial) {
+    auto events = makeMultiStreamEvents(5000, 16);
+    
+    GPUStateMachine serial;
+    serial.processEvents(events);
+    
+    GPUStateMachine parallel;
+    parallel.setParallelism(4);
+    parallel.processEvents(events);
+    
+    auto hs = serial.exportHistory();
+    auto hp = parallel.exportHistory();
+    ASSERT_EQ(hs.size(), hp.size());
+    
+    for (size_t i = 0; i < hs.size(); ++i) {
+        EXPECT_EQ(hs[i].device_id, hp[i].device_id);
+        EXPECT_EQ(hs[i].stream_id, hp[i].stream_id);
+        ASSERT_EQ(hs[i].transitions.size(), hp[i].transitions.size());
+        for (size_t j = 0; j < hs[i].transitions.size(); ++j) {
+            EXPECT_EQ(hs[i].transitions[j].from, hp[i].transitions[j].from);
+            EXPECT_EQ(hs[i].transitions[j].to, hp[i].transitions[j].to);
+            EXPECT_EQ(hs[i].transitions[j].when, hp[i].transitions[j].when);
+            EXPECT_EQ(hs[i].transitions[j].reason, hp[i].transitions[j].reason);
+        }
+    }
+    
+    EXPECT_EQ(serial.getStatistics().total_events, parallel.getStatistics().total_events);
+    EXPECT_EQ(serial.getStatistics().total_transitions, parallel.getStatistics().total_transitions);
+}
+
+// ============================================================
+// InstructionStreamBuilder
+// ============================================================
+
+TEST(InstructionStreamTest, SequentialAndSyncDependencies) {
+    InstructionStreamBuilder builder;
+    
+    TraceEvent k1(EventType::KernelLaunch, 100);
+    k1.stream_id = 0;
+    k1.correlation_id = 1;
+    TraceEvent k2(EventType::KernelLaunch, 200);
+    k2.stream_id = 0;
+    k2.correlation_id = 2;
+    TraceEvent k3(EventType::KernelLaunch, 150);
+    k3.stream_id = 1;
+    k3.correlation_id = 3;
+    TraceEvent sync(EventType::DeviceSync, 300);
+    sync.stream_id = 0;
+    sync.correlation_id = 4;
+    
+    builder.addEvents({k1, k2, k3, sync});
+    builder.analyze();
+    
+    EXPECT_TRUE(builder.hasDependency(1, 2));
+    EXPECT_TRUE(builder.hasDependency(2, 4));
+    EXPECT_TRUE(builder.hasDependency(3, 4));
+    EXPECT_FALSE(builder.hasDependency(1, 3));
+}
+
+TEST(InstructionStreamTest, RepeatedCorrelationIdMovesStream) {
+    InstructionStreamBuilder builder;
+    
+    TraceEvent a(EventType::KernelLaunch, 100);
+    a.stream_id = 0;
+    a.correlation_id = 1;
+    TraceEvent b(EventType::KernelLaunch, 200);
+    b.stream_id = 0;
+    b.correlation_id = 2;
+    TraceEvent c(EventType::KernelLaunch, 300);
+    c.stream_id = 0;
+    c.correlation_id = 3;
+    TraceEvent d(EventType::KernelLaunch, 150);
+    d.stream_id = 1;
+    d.correlation_id = 4;
+    builder.addEvents({a, b, c, d});
+    
+    // Re-record 2 on stream 1; it sorts before 4 there by insertion order
+    b.stream_id = 1;
+    builder.addEvent(b);
+    builder.analyze();
+    
+    auto s0 = builder.getStreamOperations(0);
+    ASSERT_EQ(s0.size(), 2u);
+    EXPECT_EQ(s0[0].event.correlation_id, 1u);
+    EXPECT_EQ(s0[1].event.correlation_id, 3u);
+    
+    auto s1 = builder.getStreamOperations(1);
+    ASSERT_EQ(s1.size(), 2u);
+    EXPECT_EQ(s1[0].event.correlation_id, 2u);
+    EXPECT_EQ(s1[1].event.correlation_id, 4u);
+    
+    EXPECT_TRUE(builder.hasDependency(1, 3));
+    EXPECT_TRUE(builder.hasDependency(2, 4));
+    EXPECT_FALSE(builder.hasDependency(1, 2));
+    EXPECT_FALSE(builder.hasDependency(2, 3));
+    EXPECT_EQ(builder.getStatistics().total_dependencies, 2u);
+    
+    // Moving the only operation off a stream drops the stream
+    a.stream_id = 1;
+    c.stream_id = 1;
+    builder.addEvent(a);
+    builder.addEvent(c);
+    EXPECT_TRUE(builder.getStreamOperations(0).empty());
+    EXPECT_EQ(builder.getStreamOperations(1).size(), 4u);
+}
+
+TEST(InstructionStreamTest, ParallelMatchesSerial) {
+    auto events = makeMultiStreamEvents(3000, 16);
+    
+    InstructionStreamBuilder serial;
+    serial.addEvents(events);
+    serial.analyze();
+    
+    InstructionStreamBuilder parallel;
+    parallel.setParallelism(4);
+    parallel.addEvents(events);
+    parallel.analyze();
+    
+    auto ds = serial.getDependencies();
+    auto dp = parallel.getDependencies();
+    ASSERT_EQ(ds.size(), dp.size());
+    for (size_t i = 0; i < ds.size(); ++i) {
+        EXPECT_EQ(ds[i].from_correlation_id, dp[i].from_correlation_id);
+        EXPECT_EQ(ds[i].to_correlation_id, dp[i].to_correlation_id);
+        EXPECT_EQ(ds[i].type, dp[i].type);
+        EXPECT_EQ(ds[i].description, dp[i].description);
+    }
+}
+
+TEST(InstructionStreamTest, StreamsAndSyncsArePerDevice) {
+    InstructionStreamBuilder builder;
+    
+    auto op = [](EventType type, Timestamp ts, uint32_t device, uint32_t stream, uint64_t corr) {
+        TraceEvent event(type, ts);
+        event.device_id = device;
+        event.stream_id = stream;
+        event.correlation_id = corr;
+        return event;
+    };
+    
+    // Stream 0 exists on both devices; the sync on device 0 must not wait
+    // for device 1 and the two stream-0 chains must stay separate
+    builder.addEvents({
+        op(EventType::KernelLaunch, 100, 0, 0, 1),
+        op(EventType::KernelLaunch, 110, 1, 0, 2),
+        op(EventType::KernelLaunch, 120, 0, 1, 3),
+        op(EventType::KernelLaunch, 130, 1, 1, 4),
+        op(EventType::DeviceSync, 200, 0, 0, 5),
+        op(EventType::KernelLaunch, 210, 1, 0, 6),
+    });
+    builder.setParallelism(2);
+    builder.analyze();
+    
+    EXPECT_TRUE(builder.hasDependency(1, 5));
+    EXPECT_TRUE(builder.hasDependency(2, 6));
+    EXPECT_TRUE(builder.hasDependency(3, 5));
+    EXPECT_FALSE(builder.hasDependency(1, 2));
+    EXPECT_FALSE(builder.hasDependency(2, 5));
+    EXPECT_FALSE(builder.hasDependency(4, 5));
+    EXPECT_FALSE(builder.hasDependency(5, 6));
+    EXPECT_EQ(builder.getStatistics().total_dependencies, 3u);
+    
+    auto stream0 = builder.getStreamOperations(0);
+    ASSERT_EQ(stream0.size(), 4u);
+    EXPECT_EQ(stream0[0].event.correlation_id, 1u);
+    EXPECT_EQ(stream0[1].event.correlation_id, 2u);
+    EXPECT_EQ(stream0[2].event.correlation_id, 5u);
+    EXPECT_EQ(stream0[3].event.correlation_id, 6u);
+}
+
+TEST(InstructionStreamTest, SyncLinksOnlyToStreamFrontier) {
+    InstructionStreamBuilder builder;
+    uint64_t corr = 1;
+    std::vector<TraceEvent> events;
+    
+    // Three streams with four kernels each, then two back-to-back device syncs
+    for (int i = 0; i < 4; ++i) {
+        for (uint32_t stream = 0; stream < 3; ++stream) {
+            TraceEvent k(EventType::KernelLaunch, 100 + corr * 10);
+            k.stream_id = stream;
+            k.correlation_id = corr++;
+            events.push_back(k);
+        }
+    }
+    TraceEvent sync1(EventType::DeviceSync, 1000);
+    sync1.stream_id = 0;
+    sync1.correlation_id = 100;
+    TraceEvent sync2(EventType::DeviceSync, 2000);
+    sync2.stream_id = 0;
+    sync2.correlation_id = 101;
+    events.push_back(sync1);
+    events.push_back(sync2);
+    
+    builder.addEvents(events);
+    builder.analyze();
+    
+    // Latest kernels on streams 1 and 2 are correlation IDs 11 and 12
+    EXPECT_TRUE(builder.hasDependency(11, 100));
+    EXPECT_TRUE(builder.hasDependency(12, 100));
+    EXPECT_FALSE(builder.hasDependency(2, 100));
+    EXPECT_FALSE(builder.hasDependency(5, 100));
+    
+    // Nothing new ran on other streams, so the second sync is only sequential
+    EXPECT_TRUE(builder.hasDependency(100, 101));
+    EXPECT_FALSE(builder.hasDependency(11, 101));
+    
+    // 11 sequential edges (including sync1 -> sync2) + 2 sync edges
+    EXPECT_EQ(builder.getStatistics().total_dependencies, 13u);
+    
+    auto deps = builder.getDependencies();
+    ASSERT_FALSE(deps.empty());
+    EXPECT_EQ(deps.front().description, "Sequential in stream 0");
+    EXPECT_EQ(deps.back().description, "Stream sync barrier");
+    
+    auto order = builder.getExecutionOrder();
+    ASSERT_EQ(order.size(), events.size());
+    EXPECT_EQ(order.back().event.correlation_id, 101u);
+    EXPECT_EQ(order.back().dependencies.size(), 1u);
+}
+
+// ============================================================
+// CriticalPathAnalyzer
+// ============================================================
+
+namespace {
+
+TraceEvent makeOp(EventType type, const std::string& name, uint32_t stream,
+                  uint64_t corr, Timestamp ts, Timestamp duration) {
+    TraceEvent event(type, ts);
+    event.name = name;
+    event.stream_id = stream;
+    event.correlation_id = corr;
+    event.duration = duration;
+    return event;
+}
+
+} // namespace
+
+TEST(CriticalPathTest, PathSlackAndWhatIf) {
+    // Stream 0: A [0,100) -> B [100,300) -> sync at 300
+    // Stream 1: C [0,50), joined by the sync
+    InstructionStreamBuilder graph;
+    graph.addEvents({
+        makeOp(EventType::KernelLaunch, "A", 0, 1, 1000, 100),
+        makeOp(EventType::KernelLaunch, "C", 1, 2, 1000, 50),
+        makeOp(EventType::KernelLaunch, "B", 0, 3, 1100, 200),
+        makeOp(EventType::DeviceSync, "sync", 0, 4, 1300, 0),
+    });
+    graph.analyze();
+    
+    CriticalPathAnalyzer analyzer(graph);
+    auto result = analyzer.analyze();
+    
+    EXPECT_EQ(result.makespan, 300u);
+    EXPECT_EQ(result.unreachable_nodes, 0u);
+    ASSERT_EQ(result.path.size(), 3u);
+    EXPECT_EQ(result.path[0].name, "A");
+    EXPECT_EQ(result.path[1].name, "B");
+    EXPECT_EQ(result.path[2].name, "sync");
+    EXPECT_EQ(result.path_busy_time, 300u);
+    
+    EXPECT_EQ(result.slack[graph.findNode(1)], 0u);
+    EXPECT_EQ(result.slack[graph.findNode(2)], 250u);
+    
+    auto faster_b = analyzer.whatIf("B", 2.0);
+    EXPECT_EQ(faster_b.affected_operations, 1u);
+    EXPECT_EQ(faster_b.predicted_makespan, 200u);
+    EXPECT_EQ(faster_b.reduction(), 100u);
+    
+    // C is off the critical path, so speeding it up changes nothing
+    EXPECT_EQ(analyzer.whatIf("C", 2.0).reduction(), 0u);
+    EXPECT_EQ(analyzer.whatIf("missing", 2.0).affected_operations, 0u);
+    
+    auto ranked = analyzer.rankSpeedups(2.0, 10);
+    ASSERT_FALSE(ranked.empty());
+    EXPECT_EQ(ranked.front().name, "B");
+}
+
+TEST(CriticalPathTest, GapsArePreserved) {
+    // Host launched B 40ns after A finished; that gap stays on the path
+    InstructionStreamBuilder graph;
+    graph.addEvents({
+        makeOp(EventType::KernelLaunch, "A", 0, 1, 1000, 100),
+        makeOp(EventType::KernelLaunch, "B", 0, 2, 1140, 60),
+    });
+    graph.analyze();
+    
+    CriticalPathAnalyzer analyzer(graph);
+    auto result = analyzer.analyze();
+    
+    EXPECT_EQ(result.makespan, 200u);
+    EXPECT_EQ(result.path_gap_time, 40u);
+    EXPECT_EQ(analyzer.whatIf("A", 2.0).predicted_makespan, 150u);
+}
+
+// ============================================================
+// PerfettoProtoWriter
+// ============================================================
+
+namespace {
+
+/// One decoded protobuf field; bytes fields keep their payload
+struct ProtoField {
+    uint32_t field = 0;
+    uint32_t wire_type = 0;
+    uint64_t value = 0;
+    std::vector<uint8_t> bytes;
+};
+
+uint64_t readVarint(const std::vector<uint8_t>& data, size_t& pos) {
+    uint64_t value = 0;
+    for (int shift = 0; pos < data.size(); shift += 7) {
+        uint8_t byte = data[pos++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    return value;
+}
+
+std::vector<ProtoField> decodeMessage(const std::vector<uint8_t>& data) {
+    std::vector<ProtoField> fields;
+    size_t pos = 0;
+    while (pos < data.size()) {
+        ProtoField f;
+        uint64_t tag = readVarint(data, pos);
+        f.field = static_cast<uint32_t>(tag >> 3);
+        f.wire_type = static_cast<uint32_t>(tag & 7);
+        if (f.wire_type == pftrace::WIRE_VARINT) {
+            f.value = readVarint(data, pos);
+        } else if (f.wire_type == pftrace::WIRE_FIXED64) {
+            std::memcpy(&f.value, data.data() + pos, 8);
+            pos += 8;
+        } else {
+            size_t length = readVarint(data, pos);
+            EXPECT_LE(pos + length, data.size());
+            f.bytes.assign(data.begin() + pos, data.begin() + pos + length);
+            pos += length;
+        }
+        fields.push_back(std::move(f));
+    }
+    EXPECT_EQ(pos, data.size());
+    return fields;
+}
+
+const ProtoField* findField(const std::vector<ProtoField>& fields, uint32_t field) {
+    for (const auto& f : fields) {
+        if (f.field == field) return &f;
+    }
+    return nullptr;
+}
+
+std::vector<std::vector<ProtoField>> decodePackets(const std::vector<uint8_t>& trace) {
+    std::vector<std::vector<ProtoField>> packets;
+    for (const auto& f : decodeMessage(trace)) {
+        EXPECT_EQ(f.field, pftrace::TRACE_PACKET);
+        packets.push_back(decodeMessage(f.bytes));
+    }
+    return packets;
+}
+
+} // namespace
+
+TEST(PerfettoProtoWriterTest, EncodesVarintsAndNestedLengths) {
+    std::vector<uint8_t> buffer;
+    ProtoEncoder encoder(buffer);
+    size_t token = encoder.beginNested(5);
+    encoder.addVarint(1, 300);
+    encoder.addString(2, "gemm");
+    encoder.endNested(token);
+    
+    auto outer = decodeMessage(buffer);
+    ASSERT_EQ(outer.size(), 1u);
+    EXPECT_EQ(outer[0].field, 5u);
+    auto inner = decodeMessage(outer[0].bytes);
+    ASSERT_EQ(inner.size(), 2u);
+    EXPECT_EQ(inner[0].value, 300u);
+    EXPECT_EQ(std::string(inner[1].bytes.begin(), inner[1].bytes.end()), "gemm");
+}
+
+TEST(PerfettoProtoWriterTest, InternsNamesOncePerIncrementalState) {
+    PerfettoProtoWriter writer(7);
+    writer.addProcessTrack(1, 0, "GPU 0");
+    writer.addThreadTrack(2, 1, 0, 3, "Stream 3");
+    for (int i = 0; i < 3; ++i) {
+        writer.writeSlice(2, 1000 + i * 100, 50, "gemm", "gpu_kernel");
+    }
+    writer.resetIncrementalState();
+    writer.writeInstant(2, 2000, "gemm", "gpu_kernel");
+    
+    auto packets = decodePackets(writer.data());
+    ASSERT_EQ(packets.size(), 2u + 6u + 1u);
+    EXPECT_EQ(writer.packetCount(), packets.size());
+    
+    size_t interned_packets = 0;
+    std::vector<uint64_t> flags;
+    for (const auto& packet : packets) {
+        EXPECT_EQ(findField(packet, pftrace::PACKET_SEQUENCE_ID)->value, 7u);
+        if (findField(packet, pftrace::PACKET_INTERNED_DATA)) interned_packets++;
+        if (const auto* f = findField(packet, pftrace::PACKET_SEQUENCE_FLAGS)) {
+            flags.push_back(f->value);
+        }
+    }
+    
+    // Once for the first slice, once again after the reset
+    EXPECT_EQ(interned_packets, 2u);
+    ASSERT_EQ(flags.size(), 7u);
+    uint64_t cleared = pftrace::SEQ_INCREMENTAL_STATE_CLEARED | pftrace::SEQ_NEEDS_INCREMENTAL_STATE;
+    EXPECT_EQ(flags[0], cleared);
+    EXPECT_EQ(flags[1], uint64_t(pftrace::SEQ_NEEDS_INCREMENTAL_STATE));
+    EXPECT_EQ(flags[6], cleared);
+    
+    // Slice end carries only type and track
+    auto end_event = decodeMessage(findField(packets[3], pftrace::PACKET_TRACK_EVENT)->bytes);
+    EXPECT_EQ(findField(end_event, pftrace::EVENT_TYPE)->value, uint64_t(pftrace::TYPE_SLICE_END));
+    EXPECT_EQ(findField(end_event, pftrace::EVENT_NAME_IID), nullptr);
+    EXPECT_EQ(findField(packets[3], pftrace::PACKET_TIMESTAMP)->value, 1050u);
+}
+
+TEST(PerfettoProtoWriterTest, ExporterWritesTracksFlowsAndCounters) {
+    std::vector<TraceEvent> events = {
+        makeOp(EventType::KernelLaunch, "launch", 0, 9, 1000, 10),
+        makeOp(EventType::KernelLaunch, "kernel", 1, 9, 1200, 80),
+        makeOp(EventType::Marker, "marker", 1, 0, 1500, 0),
+    };
+    std::vector<CounterEvent> counters = {
+        CounterEvent("SM Occupancy", 0.75, 1100, "%"),
+        CounterEvent("SM Occupancy", 0.5, 1300, "%"),
+    };
+    
+    PerfettoProtoExporter exporter(PerfettoProtoExporter::Format::PROTOBUF);
+    auto packets = decodePackets(exporter.exportToProto(events, counters));
+    
+    size_t thread_tracks = 0, counter_tracks = 0;
+    size_t begins = 0, ends = 0, instants = 0, counter_values = 0;
+    uint64_t flow_start = 0, flow_end = 0;
+    double last_counter = 0.0;
+    for (const auto& packet : packets) {
+        if (const auto* track = findField(packet, pftrace::PACKET_TRACK_DESCRIPTOR)) {
+            auto descriptor = decodeMessage(track->bytes);
+            if (findField(descriptor, pftrace::TRACK_THREAD)) thread_tracks++;
+            if (findField(descriptor, pftrace::TRACK_COUNTER)) counter_tracks++;
+        }
+        const auto* track_event = findField(packet, pftrace::PACKET_TRACK_EVENT);
+        if (!track_event) continue;
+        auto event = decodeMessage(track_event->bytes);
+        switch (findField(event, pftrace::EVENT_TYPE)->value) {
+            case pftrace::TYPE_SLICE_BEGIN: begins++; break;
+            case pftrace::TYPE_SLICE_END: ends++; break;
+            case pftrace::TYPE_INSTANT: instants++; break;
+            case pftrace::TYPE_COUNTER: {
+                counter_values++;
+                const auto* value = findField(event, pftrace::EVENT_DOUBLE_COUNTER_VALUE);
+                std::memcpy(&last_counter, &value->value, sizeof(double));
+                break;
+            }
+        }
+        if (const auto* f = findField(event, pftrace::EVENT_FLOW_IDS)) flow_start = f->value;
+        if (const auto* f = findField(event, pftrace::EVENT_TERMINATING_FLOW_IDS)) flow_end = f->value;
+    }
+    
+    EXPECT_EQ(thread_tracks, 2u);
+    EXPECT_EQ(counter_tracks, 1u);
+    EXPECT_EQ(begins, 2u);
+    EXPECT_EQ(ends, 2u);
+    EXPECT_EQ(instants, 1u);
+    EXPECT_EQ(counter_values, 2u);
+    EXPECT_DOUBLE_EQ(last_counter, 0.5);
+    EXPECT_EQ(flow_start, 9u);
+    EXPECT_EQ(flow_end, 9u);
+}
+
+TEST(PerfettoProtoWriterTest, ParallelExportMatchesSerial) {
+    // Repeated names across chunks exercise interning; pairs form flows
+    auto events = makeMultiStreamEvents(9000, 8);
+    for (size_t i = 0; i < events.size(); ++i) {
+        events[i].name = "op_" + std::to_string(i % 6000);
+        events[i].correlation_id = i / 2 + 1;
+        if (i % 3 == 0) events[i].duration = 0;
+    }
+    std::vector<CounterEvent> counters = {CounterEvent("SM Occupancy", 0.5, 1000, "%")};
+    
+    PerfettoProtoExporter exporter;
+    for (size_t count : {size_t(4096), size_t(4097), size_t(9000)}) {
+        std::vector<TraceEvent> subset(events.begin(), events.begin() + count);
+        exporter.setParallelism(1);
+        auto serial = exporter.exportToProto(subset, counters);
+        for (size_t threads : {size_t(2), size_t(3)}) {
+            exporter.setParallelism(threads);
+            EXPECT_EQ(exporter.exportToProto(subset, counters), serial)
+                << count << " events, " << threads << " threads";
+        }
+    }
+}
+
+namespace {
+
+/// Slice/instant events and flow endpoints in a decoded trace
+struct LiveTraceSummary {
+    size_t events = 0;
+    size_t counters = 0;
+    size_t flow_starts = 0;
+    size_t flow_ends = 0;
+    size_t thread_tracks = 0;
+};
+
+LiveTraceSummary summarizeTrace(const std::vector<uint8_t>& trace) {
+    LiveTraceSummary summary;
+    for (const auto& packet : decodePackets(trace)) {
+        if (const auto* track = findField(packet, pftrace::PACKET_TRACK_DESCRIPTOR)) {
+            if (findField(decodeMessage(track->bytes), pftrace::TRACK_THREAD)) {
+                summary.thread_tracks++;
+            }
+        }
+        const auto* track_event = findField(packet, pftrace::PACKET_TRACK_EVENT);
+        if (!track_event) continue;
+        auto event = decodeMessage(track_event->bytes);
+        uint64_t type = findField(event, pftrace::EVENT_TYPE)->value;
+        if (type == pftrace::TYPE_SLICE_BEGIN || type == pftrace::TYPE_INSTANT) summary.events++;
+        if (type == pftrace::TYPE_COUNTER) summary.counters++;
+        if (findField(event, pftrace::EVENT_FLOW_IDS)) summary.flow_starts++;
+        if (findField(event, pftrace::EVENT_TERMINATING_FLOW_IDS)) summary.flow_ends++;
+    }
+    return summary;
+}
+
+std::vector<uint8_t> readBinaryFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)),
+                                std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+TEST(PerfettoLiveStreamerTest, StreamsToFileWhileRunning) {
+    std::string path = "test_live_stream.perfetto-trace";
+    TracingConfig config;
+    config.live_streaming = true;
+    config.output_file = path;
+    config.flush_interval_ms = 5;
+    
+    auto events = makeMultiStreamEvents(300, 4);
+    for (size_t i = 0; i < events.size(); ++i) {
+        events[i].correlation_id = i / 2 + 1;
+    }
+    
+    TracingSession session;
+    ASSERT_TRUE(session.start(config));
+    EXPECT_EQ(session.getMode(), TracingSession::Mode::Live);
+    for (size_t i = 0; i < 100; ++i) {
+        session.emit(events[i]);
+    }
+    session.emitCounter("SM Occupancy", 0.5, 1000);
+    
+    // Packets reach the file while the session is still running
+    std::vector<uint8_t> partial;
+    for (int attempt = 0; attempt < 400 && summarizeTrace(partial).events < 100; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        size_t complete = session.bytesStreamed();
+        partial = readBinaryFile(path);
+        partial.resize(std::min(partial.size(), complete));
+    }
+    EXPECT_TRUE(session.isActive());
+    EXPECT_EQ(summarizeTrace(partial).events, 100u);
+    
+    for (size_t i = 100; i < events.size(); ++i) {
+        session.emit(events[i]);
+    }
+    session.stop();
+    
+    auto trace = readBinaryFile(path);
+    std::remove(path.c_str());
+    EXPECT_EQ(session.getStatistics().bytes_streamed, trace.size());
+    EXPECT_TRUE(session.getEvents().empty());
+    
+    auto summary = summarizeTrace(trace);
+    EXPECT_EQ(summary.events, events.size());
+    EXPECT_EQ(summary.counters, 1u);
+    EXPECT_EQ(summary.flow_starts, events.size() / 2);
+    EXPECT_EQ(summary.flow_ends, events.size() / 2);
+    EXPECT_EQ(summary.thread_tracks, 4u);
+}
+
+TEST(PerfettoLiveStreamerTest, UnmatchedCorrelationIdsAreWrittenWithoutFlows) {
+    std::string path = "test_live_stream_unmatched.perfetto-trace";
+    TracingConfig config;
+    config.live_streaming = true;
+    config.output_file = path;
+    config.flush_interval_ms = 5;
+    
+    // Every ID is unique: no event has a partner
+    auto events = makeMultiStreamEvents(100, 2);
+    for (size_t i = 0; i < events.size(); ++i) {
+        events[i].correlation_id = i + 1;
+    }
+    
+    TracingSession session;
+    ASSERT_TRUE(session.start(config));
+    for (const auto& event : events) {
+        session.emit(event);
+    }
+    
+    // Held events are given up on while the session runs
+    std::vector<uint8_t> partial;
+    for (int attempt = 0; attempt < 400 && summarizeTrace(partial).events < events.size(); ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        size_t complete = session.bytesStreamed();
+        partial = readBinaryFile(path);
+        partial.resize(std::min(partial.size(), complete));
+    }
+    EXPECT_TRUE(session.isActive());
+    EXPECT_EQ(summarizeTrace(partial).events, events.size());
+    
+    // Matched pairs after that still form flows
+    events = makeMultiStreamEvents(10, 2);
+    for (size_t i = 0; i < events.size(); ++i) {
+        events[i].correlation_id = 1000 + i / 2;
+        session.emit(events[i]);
+    }
+    session.stop();
+    
+    auto summary = summarizeTrace(readBinaryFile(path));
+    std::remove(path.c_str());
+    EXPECT_EQ(summary.events, 110u);
+    EXPECT_EQ(summary.flow_starts, 5u);
+    EXPECT_EQ(summary.flow_ends, 5u);
+}
+
+#ifndef _WIN32
+TEST(PerfettoLiveStreamerTest, StreamsToUnixSocket) {
+    std::string path = "/tmp/tracesmith_live_" + std::to_string(::getpid()) + ".sock";
+    ::unlink(path.c_str());
+    
+    int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_GE(server, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    ASSERT_EQ(::bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(::listen(server, 1), 0);
+    
+    // Reader collects everything until the session closes the connection
+    std::vector<uint8_t> received;
+    std::thread reader([&] {
+        int client = ::accept(server, nullptr, nullptr);
+        if (client < 0) return;
+        uint8_t chunk[4096];
+        ssize_t n;
+        while ((n = ::read(client, chunk, sizeof(chunk))) > 0) {
+            received.insert(received.end(), chunk, chunk + n);
+        }
+        ::close(client);
+    });
+    
+    TracingConfig config;
+    config.live_streaming = true;
+    config.socket_path = path;
+    config.flush_interval_ms = 5;
+    
+    TracingSession session;
+    ASSERT_TRUE(session.start(config));
+    auto events = makeMultiStreamEvents(200, 2);
+    for (const auto& event : events) {
+        session.emit(event);
+    }
+    session.stop();
+    reader.join();
+    ::close(server);
+    ::unlink(path.c_str());
+    
+    EXPECT_EQ(summarizeTrace(received).events, events.size());
+    EXPECT_EQ(session.getStatistics().bytes_streamed, received.size());
+    
+    // Nobody listening: the session does not start
+    EXPECT_FALSE(session.start(config));
+    EXPECT_EQ(session.getState(), TracingSession::State::Stopped);
+}
+#endif
+
+// ============================================================
+// JsonWriter / PerfettoExporter
+// ============================================================
+
+TEST(JsonWriterTest, EscapesStringsAndFormatsNumbers) {
+    JsonWriter json(false);
+    json.beginObject();
+    json.key("name"); json.value("say \"hi\"\n\\ \x01");
+    json.key(std::string("we\"ird")); json.value(uint64_t(18446744073709551615ULL));
+    json.key("neg"); json.value(int64_t(-42));
+    json.key("ratio"); json.value(0.756, 2);
+    json.key("nan"); json.value(std::numeric_limits<double>::quiet_NaN(), 2);
+    json.key("addr"); json.hexValue(0xdeadbeef);
+    json.key("empty"); json.beginArray(); json.endArray();
+    const uint32_t dims[3] = {128, 1, 1};
+    json.key("dims"); json.value(dims, 3);
+    json.endObject();
+    
+    EXPECT_EQ(json.takeString(),
+              "{\"name\":\"say \\\"hi\\\"\\n\\\\ \\u0001\","
+              "\"we\\\"ird\":18446744073709551615,\"neg\":-42,\"ratio\":0.76,"
+              "\"nan\":null,\"addr\":\"0xdeadbeef\",\"empty\":[],\"dims\":[128,1,1]}");
+}
+
+TEST(JsonWriterTest, PrettyIndentsAndSinkReceivesChunks) {
+    JsonWriter pretty(true);
+    pretty.beginObject();
+    pretty.key("a"); pretty.beginArray();
+    pretty.value(uint64_t(1));
+    pretty.beginObject(); pretty.endObject();
+    pretty.endArray();
+    pretty.endObject();
+    EXPECT_EQ(pretty.takeString(), "{\n  \"a\": [\n    1,\n    {}\n  ]\n}");
+    
+    // A tiny buffer forces flushes mid-array; separators must survive them
+    std::string sink_output;
+    size_t chunks = 0;
+    JsonWriter json(false, 64);
+    json.setSink([&](const char* data, size_t size) {
+        sink_output.append(data, size);
+        chunks++;
+        return true;
+    });
+    std::string expected = "[";
+    json.beginArray();
+    for (uint64_t i = 0; i < 100; ++i) {
+        json.beginObject();
+        json.key("i"); json.value(i);
+        json.endObject();
+        expected += (i ? ",{\"i\":" : "{\"i\":") + std::to_string(i) + "}";
+    }
+    json.endArray();
+    EXPECT_TRUE(json.flush());
+    EXPECT_EQ(sink_output, expected + "]");
+    EXPECT_GT(chunks, 10u);
+}
+
+TEST(PerfettoExporterTest, CompactMatchesPrettyAndEscapesNames) {
+    std::vector<TraceEvent> events = makeMultiStreamEvents(200, 4);
+    events[5].name = "kernel<\"float\">\n";
+    events[6].metadata["op"] = "conv\\2d";
+    
+    PerfettoExporter exporter;
+    exporter.setEnableGPUTracks(false);
+    std::string pretty = exporter.exportToString(events);
+    exporter.setCompact(true);
+    std::string compact = exporter.exportToString(events);
+    
+    EXPECT_LT(compact.size(), pretty.size());
+    EXPECT_EQ(compact.find('\n'), std::string::npos);
+    EXPECT_NE(compact.find("\"kernel<\\\"float\\\">\\n\""), std::string::npos);
+    EXPECT_NE(compact.find("\"op\":\"conv\\\\2d\""), std::string::npos);
+    
+    // Removing pretty-printing whitespace outside strings yields the compact form
+    std::string stripped;
+    bool in_string = false;
+    for (size_t i = 0; i < pretty.size(); ++i) {
+        char c = pretty[i];
+        if (in_string) {
+            stripped += c;
+            if (c == '\\') {
+                stripped += pretty[++i];
+            } else if (c == '"') {
+                in_string = false;
+            }
+        } else if (c == '"') {
+            in_string = true;
+            stripped += c;
+        } else if (c != ' ' && c != '\n') {
+            stripped += c;
+        }
+    }
+    EXPECT_EQ(stripped, compact);
+}
+
+TEST(PerfettoExporterTest, StreamsToFileAndGzip) {
+    auto events = makeMultiStreamEvents(5000, 4);
+    std::vector<CounterEvent> counters = {CounterEvent("SM Occupancy", 0.5, 1000, "%")};
+    
+    PerfettoExporter exporter;
+    exporter.setCompact(true);
+    std::string expected = exporter.exportToString(events, counters);
+    
+    std::string path = "test_perfetto_export.json";
+    ASSERT_TRUE(exporter.exportToFile(events, counters, path));
+    std::ifstream in(path, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::remove(path.c_str());
+    EXPECT_EQ(contents, expected);
+    
+    if (!PerfettoExporter::isGzipAvailable()) {
+        GTEST_SKIP() << "Built without zlib";
+    }
+    std::string gz_path = "test_perfetto_export.json.gz";
+    ASSERT_TRUE(exporter.exportToFile(events, counters, gz_path));
+    std::ifstream gz(gz_path, std::ios::binary | std::ios::ate);
+    auto gz_size = static_cast<size_t>(gz.tellg());
+    gz.seekg(0);
+    unsigned char magic[2] = {};
+    gz.read(reinterpret_cast<char*>(magic), 2);
+    gz.close();
+    std::remove(gz_path.c_str());
+    EXPECT_EQ(magic[0], 0x1f);
+    EXPECT_EQ(magic[1], 0x8b);
+    EXPECT_LT(gz_size, expected.size() / 4);
+}
+
+TEST(PerfettoExporterTest, ParallelMatchesSerial) {
+    auto events = makeMultiStreamEvents(9000, 8);
+    for (size_t i = 0; i < events.size(); ++i) {
+        events[i].correlation_id = i / 2 + 1;
+    }
+    std::vector<CounterEvent> counters;
+    for (size_t i = 0; i < 5000; ++i) {
+        counters.emplace_back(i % 2 ? "SM Occupancy" : "Bandwidth", double(i), 1000 + i * 10, "%");
+    }
+    
+    // Chunk boundaries, a single chunk, and no events at all
+    for (size_t count : {size_t(0), size_t(100), size_t(4096), size_t(4097), size_t(9000)}) {
+        std::vector<TraceEvent> subset(events.begin(), events.begin() + count);
+        for (bool compact : {false, true}) {
+            PerfettoExporter exporter;
+            exporter.setCompact(compact);
+            std::string serial = exporter.exportToString(subset, counters);
+            exporter.setParallelism(3);
+            EXPECT_EQ(exporter.exportToString(subset, counters), serial)
+                << count << " events, compact=" << compact;
+        }
+    }
+}
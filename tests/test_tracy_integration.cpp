@@ -16,6 +16,9 @@
 #include "tracesmith/tracy/tracy_importer.hpp"
 #include "tracesmith/common/types.hpp"
 
+#include <algorithm>
+#include <chrono>
+
 using namespace tracesmith;
 using namespace tracesmith::tracy;
 
@@ -236,6 +239,107 @@ TEST_F(TracyExporterTest, ExportMultipleEvents) {
     }
 }
 
+TEST_F(TracyExporterTest, BatchedExportGroupsGpuZones) {
+    TracyExporter exporter(config_);
+    exporter.initialize();
+    
+    // Kernels and copies interleaved across two devices, plus host events
+    std::vector<TraceEvent> events;
+    for (int i = 0; i < 12; ++i) {
+        TraceEvent event;
+        event.type = (i % 3 == 0) ? EventType::MemcpyH2D : EventType::KernelLaunch;
+        event.name = "kernel_" + std::to_string(i % 4);
+        event.timestamp = getCurrentTimestamp();
+        event.duration = 1000;
+        event.device_id = i % 2;
+        events.push_back(event);
+    }
+    TraceEvent marker;
+    marker.type = EventType::Marker;
+    marker.name = "step";
+    events.push_back(marker);
+    
+    exporter.exportEvents(events);
+    exporter.exportEvents(events);
+    
+    if (isTracyEnabled()) {
+        EXPECT_EQ(exporter.eventsEmitted(), 26u);
+        EXPECT_EQ(exporter.gpuZonesEmitted(), 24u);
+    }
+}
+
+TEST_F(TracyExporterTest, BatchedExportHonoursFilters) {
+    config_.emit_memcpy_events = false;
+    TracyExporter exporter(config_);
+    exporter.initialize();
+    
+    std::vector<TraceEvent> events(4);
+    events[0].type = EventType::KernelLaunch;
+    events[1].type = EventType::MemcpyD2H;
+    events[2].type = EventType::MemcpyH2D;
+    events[3].type = EventType::KernelComplete;
+    
+    exporter.exportEvents(events);
+    
+    if (isTracyEnabled()) {
+        EXPECT_EQ(exporter.eventsEmitted(), 2u);
+        EXPECT_EQ(exporter.gpuZonesEmitted(), 2u);
+    }
+}
+
+// Compares per-event emission with the batched path; run with
+// --gtest_filter='*Throughput*' to see the rates
+TEST_F(TracyExporterTest, BatchedExportThroughput) {
+    constexpr size_t kEvents = 200000;
+    constexpr int kNames = 64;
+    constexpr int kDevices = 4;
+    
+    std::vector<TraceEvent> events(kEvents);
+    Timestamp base = getCurrentTimestamp();
+    for (size_t i = 0; i < kEvents; ++i) {
+        events[i].type = EventType::KernelLaunch;
+        events[i].name = "kernel_" + std::to_string(i % kNames);
+        events[i].timestamp = base + i * 2000;
+        events[i].duration = 1500;
+        events[i].device_id = static_cast<uint32_t>((i / 256) % kDevices);
+        events[i].thread_id = 1;
+    }
+    
+    TracyExporter per_event(config_);
+    per_event.initialize();
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& event : events) {
+        per_event.emitEvent(event);
+    }
+    double per_event_s = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    TracyExporter batched(config_);
+    batched.initialize();
+    constexpr size_t kBatch = 4096;
+    std::vector<TraceEvent> batch;
+    batch.reserve(kBatch);
+    double batched_s = 0.0;
+    for (size_t offset = 0; offset < kEvents; offset += kBatch) {
+        size_t end = std::min(kEvents, offset + kBatch);
+        batch.assign(events.begin() + offset, events.begin() + end);
+        start = std::chrono::steady_clock::now();
+        batched.exportEvents(batch);
+        batched_s += std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+    
+    std::printf("[ BENCH    ] %zu kernel events: per-event %.0f ev/s, batched %.0f ev/s\n",
+                kEvents, kEvents / std::max(per_event_s, 1e-9),
+                kEvents / std::max(batched_s, 1e-9));
+    
+    if (isTracyEnabled()) {
+        EXPECT_EQ(per_event.eventsEmitted(), kEvents);
+        EXPECT_EQ(batched.eventsEmitted(), kEvents);
+        EXPECT_EQ(batched.gpuZonesEmitted(), kEvents);
+    }
+}
+
 TEST_F(TracyExporterTest, CreateGpuContext) {
     TracyExporter exporter(config_);
     exporter.initialize();
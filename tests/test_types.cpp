@@ -2,9 +2,13 @@
 #include <tracesmith/common/types.hpp>
 #include <tracesmith/state/perfetto_proto_exporter.hpp>
 #include <tracesmith/common/xray_importer.hpp>
+#include <tracesmith/common/xray_symbol_resolver.hpp>
 #include <tracesmith/capture/bpf_types.hpp>
 #include <thread>
 #include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 using namespace tracesmith;
 
@@ -555,6 +559,395 @@ TEST(XRayImporterTest, XRayEntryTypes) {
     EXPECT_EQ(static_cast<uint8_t>(XRayEntryType::TypedEvent), 4);
 }
 
+namespace {
+
+// Builds XRay logs in the layout the LLVM runtime writes
+struct XRayLogBuilder {
+    std::vector<uint8_t> bytes;
+    
+    template<typename T>
+    static void put(std::vector<uint8_t>& out, T value) {
+        const auto* raw = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), raw, raw + sizeof(T));
+    }
+    
+    void header(uint16_t version, uint16_t type, uint64_t frequency) {
+        put(bytes, version);
+        put(bytes, type);
+        put(bytes, uint32_t(3));  // Constant, non-stop TSC
+        put(bytes, frequency);
+        bytes.resize(32, 0);
+    }
+    
+    static void metadata(std::vector<uint8_t>& out, uint8_t kind,
+                         const std::vector<uint8_t>& payload = {}) {
+        out.push_back(static_cast<uint8_t>((kind << 1) | 1));
+        out.insert(out.end(), payload.begin(), payload.end());
+        out.resize(out.size() + 15 - payload.size(), 0);
+    }
+    
+    static void function(std::vector<uint8_t>& out, uint32_t kind,
+                         uint32_t function_id, uint32_t tsc_delta) {
+        put(out, (function_id << 4) | (kind << 1));
+        put(out, tsc_delta);
+    }
+    
+    /// FDR buffer preamble: NewBuffer, walltime, pid and NewCPUId
+    static std::vector<uint8_t> fdrBuffer(int32_t thread_id, uint64_t base_tsc) {
+        std::vector<uint8_t> body, payload;
+        put(payload, thread_id);
+        metadata(body, 0, payload);
+        metadata(body, 4);
+        metadata(body, 9);
+        payload.clear();
+        put(payload, uint16_t(1));
+        put(payload, base_tsc);
+        metadata(body, 2, payload);
+        return body;
+    }
+    
+    /// Append a buffer behind its BufferExtents record
+    void appendBuffer(const std::vector<uint8_t>& body) {
+        std::vector<uint8_t> payload;
+        put(payload, uint64_t(body.size()));
+        metadata(bytes, 7, payload);
+        bytes.insert(bytes.end(), body.begin(), body.end());
+    }
+};
+
+std::vector<uint8_t> makeFDRLog() {
+    XRayLogBuilder log;
+    log.header(5, 1, 1000000000);  // 1 GHz: TSC ticks are nanoseconds
+    
+    // Thread 10: func 1 is entered in one buffer and exits in the next,
+    // and the later buffer is written first
+    auto second = XRayLogBuilder::fdrBuffer(10, 2000);
+    XRayLogBuilder::function(second, 1, 1, 0);
+    log.appendBuffer(second);
+    
+    auto first = XRayLogBuilder::fdrBuffer(10, 1000);
+    XRayLogBuilder::function(first, 0, 1, 0);
+    XRayLogBuilder::function(first, 0, 2, 100);
+    XRayLogBuilder::function(first, 1, 2, 50);
+    
+    // Thread 20: a custom event between records, then a TSC rebase
+    auto other = XRayLogBuilder::fdrBuffer(20, 1050);
+    XRayLogBuilder::function(other, 0, 3, 0);
+    std::vector<uint8_t> payload;
+    XRayLogBuilder::put(payload, int32_t(4));
+    XRayLogBuilder::put(payload, int32_t(10));
+    XRayLogBuilder::metadata(other, 5, payload);
+    other.insert(other.end(), {'d', 'a', 't', 'a'});
+    XRayLogBuilder::function(other, 1, 3, 40);
+    payload.clear();
+    XRayLogBuilder::put(payload, uint64_t(5000));
+    XRayLogBuilder::metadata(other, 3, payload);
+    XRayLogBuilder::function(other, 0, 4, 0);
+    XRayLogBuilder::function(other, 2, 4, 5);
+    
+    log.appendBuffer(first);
+    log.appendBuffer(other);
+    
+    // Thread 30
+    auto third = XRayLogBuilder::fdrBuffer(30, 1100);
+    XRayLogBuilder::function(third, 0, 5, 0);
+    XRayLogBuilder::function(third, 1, 5, 7);
+    log.appendBuffer(third);
+    
+    return log.bytes;
+}
+
+} // anonymous namespace
+
+TEST(XRayImporterTest, DecodesFDRThreadsAndMergesByTimestamp) {
+    auto log = makeFDRLog();
+    XRayImporter importer;
+    auto events = importer.importBuffer(log.data(), log.size());
+    
+    struct Expected { const char* name; uint64_t ts; uint64_t duration; uint32_t thread; };
+    const Expected expected[] = {
+        {"func_1", 1000, 1000, 10},
+        {"func_3", 1050, 50, 20},
+        {"func_2", 1100, 50, 10},   // Ties go to the thread seen first
+        {"func_5", 1100, 7, 30},
+        {"func_4", 5000, 5, 20},
+    };
+    ASSERT_EQ(events.size(), 5u);
+    for (size_t i = 0; i < events.size(); ++i) {
+        EXPECT_EQ(events[i].name, expected[i].name) << i;
+        EXPECT_EQ(events[i].timestamp, expected[i].ts) << i;
+        EXPECT_EQ(events[i].duration, expected[i].duration) << i;
+        EXPECT_EQ(events[i].thread_id, expected[i].thread) << i;
+        EXPECT_EQ(events[i].correlation_id, i);
+    }
+    
+    const auto& stats = importer.getStatistics();
+    EXPECT_EQ(stats.records_read, 10u);
+    EXPECT_EQ(stats.records_converted, 5u);
+    EXPECT_EQ(stats.custom_events, 1u);
+    EXPECT_EQ(importer.getHeader().type, 1);
+    EXPECT_TRUE(importer.getRawRecords().empty());
+}
+
+TEST(XRayImporterTest, ParallelFDRDecodeMatchesSerial) {
+    auto log = makeFDRLog();
+    XRayImporter::Config config;
+    config.filter_short_calls = true;
+    config.min_duration_ns = 10;
+    
+    XRayImporter serial(config);
+    auto expected = serial.importBuffer(log.data(), log.size());
+    
+    XRayImporter parallel(config);
+    parallel.setParallelism(4);
+    auto events = parallel.importBuffer(log.data(), log.size());
+    
+    ASSERT_EQ(events.size(), expected.size());
+    EXPECT_EQ(events.size(), 3u);  // func_5 and func_4 are too short
+    EXPECT_EQ(parallel.getStatistics().records_filtered, 2u);
+    for (size_t i = 0; i < events.size(); ++i) {
+        EXPECT_EQ(events[i].name, expected[i].name);
+        EXPECT_EQ(events[i].timestamp, expected[i].timestamp);
+        EXPECT_EQ(events[i].duration, expected[i].duration);
+        EXPECT_EQ(events[i].thread_id, expected[i].thread_id);
+        EXPECT_EQ(events[i].metadata, expected[i].metadata);
+    }
+}
+
+TEST(XRayImporterTest, MapsLLVMBasicModeFile) {
+    XRayLogBuilder log;
+    log.header(3, 0, 2000000000);  // 2 GHz
+    
+    // Two threads interleaved: 7 calls 1 -> 2, 8 calls 3
+    auto record = [&](uint8_t type, int32_t function_id, uint64_t tsc, uint32_t thread_id) {
+        XRayLogBuilder::put(log.bytes, uint16_t(0));
+        log.bytes.push_back(2);     // CPU
+        log.bytes.push_back(type);
+        XRayLogBuilder::put(log.bytes, function_id);
+        XRayLogBuilder::put(log.bytes, tsc);
+        XRayLogBuilder::put(log.bytes, thread_id);
+        XRayLogBuilder::put(log.bytes, uint32_t(99));  // PID
+        log.bytes.resize(log.bytes.size() + 8, 0);
+    };
+    record(0, 1, 100, 7);
+    record(3, 3, 150, 8);
+    record(0, 2, 200, 7);
+    record(1, 2, 400, 7);
+    record(2, 3, 450, 8);
+    record(1, 1, 1000, 7);
+    
+    std::string path = "/tmp/tracesmith_test_basic.xray";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(log.bytes.data()), log.bytes.size());
+    }
+    
+    XRayImporter::Config config;
+    config.keep_raw_records = true;
+    XRayImporter importer(config);
+    auto events = importer.importFile(path);
+    std::remove(path.c_str());
+    
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].name, "func_1");
+    EXPECT_EQ(events[0].timestamp, 50u);
+    EXPECT_EQ(events[0].duration, 450u);
+    EXPECT_EQ(events[1].name, "func_3");
+    EXPECT_EQ(events[1].thread_id, 8u);
+    EXPECT_EQ(events[1].duration, 150u);
+    EXPECT_EQ(events[2].name, "func_2");
+    EXPECT_EQ(events[2].metadata.at("cpu_id"), "2");
+    
+    EXPECT_EQ(importer.getRawRecords().size(), 6u);
+    EXPECT_EQ(importer.getHeader().cycle_frequency, 2000000000u);
+}
+
+namespace {
+
+// Minimal linked ELF64 with an XRay instrumentation map and a symbol table:
+// ns::foo() (two sleds), plain (one sled) and an unnamed function
+void writeXRayBinary(const std::string& path) {
+    std::vector<uint8_t> out(64, 0);
+    auto align = [&]() { out.resize((out.size() + 7) & ~size_t(7), 0); };
+    
+    // Explicit sizes keep the embedded and trailing NULs
+    const std::string shstrtab("\0.shstrtab\0xray_instr_map\0.symtab\0.strtab", 42);
+    const std::string strtab("\0_ZN2ns3fooEv\0plain", 20);
+    
+    uint64_t shstrtab_offset = out.size();
+    out.insert(out.end(), shstrtab.begin(), shstrtab.end());
+    align();
+    
+    // Sleds (version 2) store the function relative to their own field
+    const uint64_t map_address = 0x2000;
+    const uint64_t sled_functions[] = {0x1000, 0x1000, 0x1040, 0x1100};
+    uint64_t map_offset = out.size();
+    for (size_t i = 0; i < 4; ++i) {
+        uint64_t field = map_address + i * 32 + 8;
+        XRayLogBuilder::put(out, sled_functions[i] + 0x10 - (field - 8));
+        XRayLogBuilder::put(out, sled_functions[i] - field);
+        out.push_back(i == 1 ? 1 : 0);  // Kind
+        out.push_back(1);               // Always instrument
+        out.push_back(2);               // Version
+        out.resize(out.size() + 13, 0);
+    }
+    
+    uint64_t symtab_offset = out.size();
+    out.resize(out.size() + 24, 0);     // Null symbol
+    auto symbol = [&](uint32_t name, uint64_t value, uint64_t size) {
+        XRayLogBuilder::put(out, name);
+        out.push_back(0x12);            // Global function
+        out.push_back(0);
+        XRayLogBuilder::put(out, uint16_t(1));
+        XRayLogBuilder::put(out, value);
+        XRayLogBuilder::put(out, size);
+    };
+    symbol(14, 0x1040, 0x20);
+    symbol(1, 0x1000, 0x40);
+    
+    uint64_t strtab_offset = out.size();
+    out.insert(out.end(), strtab.begin(), strtab.end());
+    align();
+    
+    uint64_t section_offset = out.size();
+    auto section = [&](uint32_t name, uint32_t type, uint64_t address, uint64_t offset,
+                       uint64_t size, uint32_t link, uint64_t entsize) {
+        XRayLogBuilder::put(out, name);
+        XRayLogBuilder::put(out, type);
+        XRayLogBuilder::put(out, uint64_t(0));
+        XRayLogBuilder::put(out, address);
+        XRayLogBuilder::put(out, offset);
+        XRayLogBuilder::put(out, size);
+        XRayLogBuilder::put(out, link);
+        XRayLogBuilder::put(out, uint32_t(0));
+        XRayLogBuilder::put(out, uint64_t(8));
+        XRayLogBuilder::put(out, entsize);
+    };
+    section(0, 0, 0, 0, 0, 0, 0);
+    section(1, 3, 0, shstrtab_offset, shstrtab.size(), 0, 0);
+    section(11, 1, map_address, map_offset, 4 * 32, 0, 0);
+    section(26, 2, 0, symtab_offset, 3 * 24, 4, 24);
+    section(34, 3, 0, strtab_offset, strtab.size(), 0, 0);
+    
+    const uint8_t ident[16] = {0x7f, 'E', 'L', 'F', 2, 1, 1};
+    std::memcpy(out.data(), ident, sizeof(ident));
+    auto patch = [&](size_t offset, auto value) {
+        std::memcpy(out.data() + offset, &value, sizeof(value));
+    };
+    patch(16, uint16_t(3));             // Shared object (PIE)
+    patch(18, uint16_t(62));            // x86-64
+    patch(40, section_offset);
+    patch(52, uint16_t(64));
+    patch(58, uint16_t(64));
+    patch(60, uint16_t(5));
+    patch(62, uint16_t(1));
+    
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(out.data()), out.size());
+}
+
+} // anonymous namespace
+
+TEST(XRaySymbolResolverTest, ResolvesFunctionIdsFromInstrumentationMap) {
+    std::string path = "/tmp/tracesmith_test_xray_binary";
+    writeXRayBinary(path);
+    std::string cache = XRaySymbolResolver::cachePath(path);
+    std::remove(cache.c_str());
+    
+    XRaySymbolResolver resolver;
+    ASSERT_TRUE(resolver.load(path)) << resolver.error();
+    ASSERT_EQ(resolver.functionCount(), 3u);
+    ASSERT_NE(resolver.functionName(1), nullptr);
+    EXPECT_EQ(*resolver.functionName(1), "ns::foo()");
+    ASSERT_NE(resolver.functionName(2), nullptr);
+    EXPECT_EQ(*resolver.functionName(2), "plain");
+    EXPECT_EQ(resolver.functionName(3), nullptr);   // No symbol covers it
+    EXPECT_EQ(resolver.functionAddress(3), 0x1100u);
+    EXPECT_EQ(resolver.functionName(0), nullptr);
+    EXPECT_EQ(resolver.functionName(4), nullptr);
+    
+    // load() left a cache next to the binary
+    XRaySymbolResolver cached;
+    ASSERT_TRUE(cached.loadCache(cache, path)) << cached.error();
+    ASSERT_EQ(cached.functionCount(), 3u);
+    EXPECT_EQ(*cached.functionName(1), "ns::foo()");
+    EXPECT_EQ(cached.functionAddress(2), 0x1040u);
+    
+    std::remove(cache.c_str());
+    std::remove(path.c_str());
+}
+
+TEST(XRaySymbolResolverTest, RejectsFilesWithoutInstrumentationMap) {
+    std::string path = "/tmp/tracesmith_test_not_elf";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << "not an ELF binary";
+    }
+    XRaySymbolResolver resolver;
+    EXPECT_FALSE(resolver.loadBinary(path));
+    EXPECT_FALSE(resolver.error().empty());
+    EXPECT_EQ(resolver.functionCount(), 0u);
+    EXPECT_EQ(XRaySymbolResolver::forBinary(path, false), nullptr);
+    std::remove(path.c_str());
+}
+
+TEST(XRaySymbolResolverTest, CorruptCountsFailWithoutAllocating) {
+    std::string path = "/tmp/tracesmith_test_xray_corrupt";
+    writeXRayBinary(path);
+    std::string cache = XRaySymbolResolver::cachePath(path);
+    std::remove(cache.c_str());
+    
+    XRaySymbolResolver resolver;
+    ASSERT_TRUE(resolver.load(path)) << resolver.error();
+    auto patch = [](const std::string& file, std::streamoff offset, auto value) {
+        std::fstream out(file, std::ios::binary | std::ios::in | std::ios::out);
+        out.seekp(offset);
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    
+    // A huge function count in the cache: load() falls back to the binary
+    patch(cache, 32, uint32_t(0xFFFFFFFF));
+    XRaySymbolResolver cached;
+    EXPECT_FALSE(cached.loadCache(cache, path));
+    EXPECT_NE(cached.error().find("truncated"), std::string::npos);
+    ASSERT_TRUE(cached.load(path)) << cached.error();
+    EXPECT_EQ(cached.functionCount(), 3u);
+    
+    // A huge xray_instr_map size (section 2 of the section headers)
+    uint64_t section_offset = 0;
+    {
+        std::ifstream in(path, std::ios::binary);
+        in.seekg(40);
+        in.read(reinterpret_cast<char*>(&section_offset), sizeof(section_offset));
+    }
+    patch(path, static_cast<std::streamoff>(section_offset + 2 * 64 + 32), uint64_t(1) << 60);
+    XRaySymbolResolver corrupt;
+    EXPECT_FALSE(corrupt.loadBinary(path));
+    EXPECT_NE(corrupt.error().find("xray_instr_map"), std::string::npos);
+    
+    std::remove(cache.c_str());
+    std::remove(path.c_str());
+}
+
+TEST(XRayImporterTest, NamesFunctionsFromSymbolFile) {
+    std::string path = "/tmp/tracesmith_test_xray_named";
+    writeXRayBinary(path);
+    
+    XRayImporter::Config config;
+    config.symbol_file = path;
+    config.use_symbol_cache = false;
+    XRayImporter importer(config);
+    auto log = makeFDRLog();
+    auto events = importer.importBuffer(log.data(), log.size());
+    std::remove(path.c_str());
+    
+    ASSERT_EQ(events.size(), 5u);
+    EXPECT_EQ(events[0].name, "ns::foo()");
+    EXPECT_EQ(events[1].name, "xray_func_3");   // Unnamed function
+    EXPECT_EQ(events[2].name, "plain");
+    EXPECT_EQ(events[3].name, "xray_func_5");   // Not in the map
+}
+
 // ============================================================
 // BPF Types Tests (v0.4.0)
 // ============================================================